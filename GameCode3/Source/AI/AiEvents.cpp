@@ -55,7 +55,7 @@ bool AiEventListener::HandleEvent( IEventData const & event )
 	if (EvtData_AiSteer::sk_EventType == event.VGetEventType())
 	{
 		const EvtData_AiSteer& evtData = static_cast<const EvtData_AiSteer&>(event);
-		g_pApp->m_pGame->VGetGamePhysics()->VRotateY(evtData.m_id,evtData.m_angleRadians,evtData.m_timeMs);
+		g_pApp->GetCurrentGame()->VGetGamePhysics()->VRotateY(evtData.m_id,evtData.m_angleRadians,evtData.m_timeMs);
 		return true;
 	}
 
@@ -66,6 +66,13 @@ public:
 		in >> m_timeMs;
 	}
 
+	explicit EvtData_AiSteer(BinaryInStream& in)
+	{
+		m_id = in.ReadU32();
+		m_angleRadians = in.ReadFloat();
+		m_timeMs = in.ReadFloat();
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_AiSteer (m_id, m_angleRadians, m_timeMs) );
@@ -73,6 +80,13 @@ public:
 
 	virtual const EventType& VGetEventType(void) const { return sk_EventType; }
 
+	virtual void VSerializeBinary(BinaryOutStream& out) const
+	{
+		out.WriteU32(m_id);
+		out.WriteFloat(m_angleRadians);
+		out.WriteFloat(m_timeMs);
+	}
+
 	virtual LuaObject VGetLuaEventData(void) const
 	{
 		assert( ( true == m_bHasLuaEventData ) && "Can't get lua event data because it hasn't been built yet!  Call BulidLuaEventData() first!" );
@@ -84,7 +98,7 @@ public:
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Set appropriate data.
@@ -461,7 +461,7 @@ PathingNode* PathingGraph::FindRandomNode(void)
 	unsigned int numNodes = (unsigned int)m_nodes.size();
 
 	// choose a random node
-	unsigned int node = g_pApp->m_pGame->GetRNG().Random(numNodes);
+	unsigned int node = g_pApp->GetCurrentGame()->GetRNG().Random(numNodes);
 	
 	// if we're in the lower half of the node list, start from the bottom
 	if (node <= numNodes / 2)
@@ -101,5 +101,5 @@ void StateMachine::SetState(const std::string& stateName)
 
 	// attach the state process
 	if (m_pCurrState)
-		g_pApp->m_pGame->AttachProcess(m_pCurrState);
+		g_pApp->GetCurrentGame()->AttachProcess(m_pCurrState);
 }
@@ -63,6 +63,7 @@ Could be a function call - or it could be the internet.
 #include "GameCode.h"
 #include "LuaPlus/LuaObject.h"
 #include "Actors.h"
+#include "EventManager/BinaryStream.h"
 #include "Physics/Physics.h"
 #include "SceneGraph/SceneNodes.h"
 
@@ -191,6 +192,43 @@ void ActorParams::VSerialize(std::ostrstream &out) const
 	out << m_OnDestroyLuaFunctionName << " ";
 }
 
+//
+// ActorParams::VInitBinary
+//
+//   m_Type has already been read by CreateFromBinaryStream(), and
+//   m_Size isn't sent at all - the constructor of the right class
+//   already knows it.
+//
+bool ActorParams::VInitBinary(BinaryInStream &in)
+{
+	if (in.ReadBool())
+	{
+		m_Id = static_cast<ActorId>(in.ReadU32());
+	}
+	in.ReadFloats(&m_Pos.x, 3);
+	in.ReadFloats(&m_Color.r, 4);
+	in.ReadString(m_OnCreateLuaFunctionName, sk_MaxFuncName);
+	in.ReadString(m_OnDestroyLuaFunctionName, sk_MaxFuncName);
+	return in.IsOk();
+}
+
+//
+// ActorParams::VSerializeBinary
+//
+void ActorParams::VSerializeBinary(BinaryOutStream &out) const
+{
+	out.WriteI32(m_Type);
+	out.WriteBool(m_Id.valid());
+	if (m_Id.valid())
+	{
+		out.WriteU32(*m_Id);
+	}
+	out.WriteFloats(&m_Pos.x, 3);
+	out.WriteFloats(&m_Color.r, 4);
+	out.WriteString(m_OnCreateLuaFunctionName);
+	out.WriteString(m_OnDestroyLuaFunctionName);
+}
+
 
 
 
@@ -276,6 +314,29 @@ void SphereParams::VSerialize(std::ostrstream &out) const
 	out << m_Force << " ";
 }
 
+bool SphereParams::VInitBinary(BinaryInStream &in)
+{
+	if (ActorParams::VInitBinary(in))
+	{
+		m_Type=AT_Sphere;
+		m_Radius = in.ReadFloat();
+		m_Segments = in.ReadI32();
+		in.ReadFloats(&m_NormalDir.x, 3);
+		m_Force = in.ReadFloat();
+		return in.IsOk();
+	}
+	return false;
+}
+
+void SphereParams::VSerializeBinary(BinaryOutStream &out) const
+{
+	ActorParams::VSerializeBinary(out);
+	out.WriteFloat(m_Radius);
+	out.WriteI32(m_Segments);
+	out.WriteFloats(&m_NormalDir.x, 3);
+	out.WriteFloat(m_Force);
+}
+
 shared_ptr<IActor> SphereParams::VCreate(BaseGameLogic *logic)
 {
 	Mat4x4 mat;
@@ -445,13 +506,34 @@ void TeapotParams::VSerialize(std::ostrstream &out) const
 {
 	ActorParams::VSerialize(out);
 	out << m_Length << " ";
-	out << m_ViewId;
+	out << m_ViewId << " ";
 	for (int i=0; i<4; ++i)
 		for (int j=0; j<4; ++j)
 			out << m_Mat.m[i][j] << " ";
 
 }
 
+bool TeapotParams::VInitBinary(BinaryInStream &in)
+{
+	if (ActorParams::VInitBinary(in))
+	{
+		m_Type=AT_Teapot;
+		m_Length = in.ReadFloat();
+		m_ViewId = in.ReadU32();
+		in.ReadFloats(&m_Mat.m[0][0], 16);
+		return in.IsOk();
+	}
+	return false;
+}
+
+void TeapotParams::VSerializeBinary(BinaryOutStream &out) const
+{
+	ActorParams::VSerializeBinary(out);
+	out.WriteFloat(m_Length);
+	out.WriteU32(m_ViewId);
+	out.WriteFloats(&m_Mat.m[0][0], 16);
+}
+
 //
 // TeapotParams::VCreate				- Chapter 19, page 693
 //
@@ -609,6 +691,25 @@ void TestObjectParams::VSerialize(std::ostrstream &out) const
 
 }
 
+bool TestObjectParams::VInitBinary(BinaryInStream &in)
+{
+	if (ActorParams::VInitBinary(in))
+	{
+		m_Type=AT_TestObject;
+		m_Squashed = in.ReadBool();
+		in.ReadFloats(&m_Mat.m[0][0], 16);
+		return in.IsOk();
+	}
+	return false;
+}
+
+void TestObjectParams::VSerializeBinary(BinaryOutStream &out) const
+{
+	ActorParams::VSerializeBinary(out);
+	out.WriteBool(m_Squashed);
+	out.WriteFloats(&m_Mat.m[0][0], 16);
+}
+
 shared_ptr<IActor> TestObjectParams::VCreate(BaseGameLogic *logic)
 {
 	Mat4x4 mat;
@@ -785,6 +886,27 @@ void GridParams::VSerialize(std::ostrstream &out) const
 			out << m_Mat.m[i][j] << " ";
 }
 
+bool GridParams::VInitBinary(BinaryInStream &in)
+{
+	if (ActorParams::VInitBinary(in))
+	{
+		m_Type=AT_Grid;
+		in.ReadString(m_Texture, sk_MaxTextureNameLen);
+		m_Squares = in.ReadU32();
+		in.ReadFloats(&m_Mat.m[0][0], 16);
+		return in.IsOk();
+	}
+	return false;
+}
+
+void GridParams::VSerializeBinary(BinaryOutStream &out) const
+{
+	ActorParams::VSerializeBinary(out);
+	out.WriteString(m_Texture);
+	out.WriteU32(m_Squares);
+	out.WriteFloats(&m_Mat.m[0][0], 16);
+}
+
 shared_ptr<IActor> GridParams::VCreate(BaseGameLogic *logic)
 {
 	Mat4x4 mat;
@@ -891,6 +1013,27 @@ void GenericMeshObjectParams::VSerialize(std::ostrstream &out) const
 			out << m_Mat.m[i][j] << " ";
 }
 
+bool GenericMeshObjectParams::VInitBinary(BinaryInStream &in)
+{
+	if (ActorParams::VInitBinary(in))
+	{
+		m_Type=AT_GenericMeshObject;
+		in.ReadString(m_XFileName, sk_MaxFileNameLen);
+		in.ReadString(m_FXFileName, sk_MaxFileNameLen);
+		in.ReadFloats(&m_Mat.m[0][0], 16);
+		return in.IsOk();
+	}
+	return false;
+}
+
+void GenericMeshObjectParams::VSerializeBinary(BinaryOutStream &out) const
+{
+	ActorParams::VSerializeBinary(out);
+	out.WriteString(m_XFileName);
+	out.WriteString(m_FXFileName);
+	out.WriteFloats(&m_Mat.m[0][0], 16);
+}
+
 shared_ptr<IActor> GenericMeshObjectParams::VCreate(BaseGameLogic *logic)
 {
 	Mat4x4 mat;
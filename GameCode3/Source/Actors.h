@@ -104,6 +104,8 @@ enum ActorType
 
 class BaseGameLogic;
 class SceneNode;
+class BinaryOutStream;
+class BinaryInStream;
 
 
 struct ActorParams
@@ -124,10 +126,15 @@ struct ActorParams
 	virtual bool VInit(std::istrstream &in);
 	virtual void VSerialize(std::ostrstream &out) const;
 
+	// The binary form of the above - see BinaryStream.h.
+	virtual bool VInitBinary(BinaryInStream &in);
+	virtual void VSerializeBinary(BinaryOutStream &out) const;
+
 	typedef std::deque< std::string > TErrorMessageList;
 	virtual bool VInit( LuaObject srcData, TErrorMessageList & errorMessages );
 
 	static ActorParams *CreateFromStream(std::istrstream &in);
+	static ActorParams *CreateFromBinaryStream(BinaryInStream &in);
 	static ActorParams *CreateFromLuaObj( LuaObject srcData );
 
 	virtual shared_ptr<IActor> VCreate(BaseGameLogic *logic) { shared_ptr<IActor> p; return p; }
@@ -147,6 +154,8 @@ struct SphereParams : public ActorParams
 	virtual bool VInit(std::istrstream &in);
 	virtual bool VInit( LuaObject srcData, TErrorMessageList & errorMessages );
 	virtual void VSerialize(std::ostrstream &out) const;
+	virtual bool VInitBinary(BinaryInStream &in);
+	virtual void VSerializeBinary(BinaryOutStream &out) const;
 	virtual shared_ptr<IActor> VCreate(BaseGameLogic *logic);
 	virtual shared_ptr<SceneNode> VCreateSceneNode(shared_ptr<Scene> pScene);
 };
@@ -162,6 +171,8 @@ struct TeapotParams : public ActorParams
 	virtual bool VInit(std::istrstream &in);
 	virtual bool VInit( LuaObject srcData, TErrorMessageList & errorMessages );
 	virtual void VSerialize(std::ostrstream &out) const;
+	virtual bool VInitBinary(BinaryInStream &in);
+	virtual void VSerializeBinary(BinaryOutStream &out) const;
 	virtual shared_ptr<IActor> VCreate(BaseGameLogic *logic);
 	virtual shared_ptr<SceneNode> VCreateSceneNode(shared_ptr<Scene> pScene);
 };
@@ -191,6 +202,8 @@ struct TestObjectParams : public ActorParams
 	virtual bool VInit(std::istrstream &in);
 	virtual bool VInit( LuaObject srcData, TErrorMessageList & errorMessages );
 	virtual void VSerialize(std::ostrstream &out) const;
+	virtual bool VInitBinary(BinaryInStream &in);
+	virtual void VSerializeBinary(BinaryOutStream &out) const;
 	virtual shared_ptr<IActor> VCreate(BaseGameLogic *logic);
 	virtual shared_ptr<SceneNode> VCreateSceneNode(shared_ptr<Scene> pScene);
 };
@@ -208,6 +221,8 @@ struct GridParams : public ActorParams
 	virtual bool VInit(std::istrstream &in);
 	virtual bool VInit( LuaObject srcData, TErrorMessageList & errorMessages );
 	virtual void VSerialize(std::ostrstream &out) const;
+	virtual bool VInitBinary(BinaryInStream &in);
+	virtual void VSerializeBinary(BinaryOutStream &out) const;
 	virtual shared_ptr<IActor> VCreate(BaseGameLogic *logic);
 	virtual shared_ptr<SceneNode> VCreateSceneNode(shared_ptr<Scene> pScene);
 };
@@ -224,6 +239,8 @@ struct GenericMeshObjectParams : public ActorParams
 	virtual bool VInit(std::istrstream &in);
 	virtual bool VInit( LuaObject srcData, TErrorMessageList & errorMessages );
 	virtual void VSerialize(std::ostrstream &out) const;
+	virtual bool VInitBinary(BinaryInStream &in);
+	virtual void VSerializeBinary(BinaryOutStream &out) const;
 	virtual shared_ptr<IActor> VCreate(BaseGameLogic *logic);
 	virtual shared_ptr<SceneNode> VCreateSceneNode(shared_ptr<Scene> pScene);
 
@@ -49,12 +49,12 @@
 
 
 #include "GameCodeStd.h"
-#include "string.h"
+#include "String.h"
 void RemoveFirstLine(std::wstring &src, std::wstring &result)
 {
 	int breakPosition = (int)src.find('\n');
 	result = _T("");
-	if(breakPosition != std::string.npos)	//if found...
+	if(breakPosition != std::wstring::npos)	//if found...
 	{
 		int len = (int)src.length();
 		result = src.substr(0, breakPosition);
@@ -102,7 +102,7 @@ int CountLines(const std::wstring &s)
 	{
 		++lines;
 		breakPos = (int)s.find('\n', breakPos+1);
-	} while (breakPos != std::string.npos);
+	} while (breakPos != std::wstring::npos);
 
 	return lines;
 }	
@@ -111,6 +111,9 @@ int CountLines(const std::wstring &s)
 
 
 
+// The conversions go through the Win32 code page functions, so
+// headless builds ( see ..\Headless ) go without them.
+#ifdef WIN32
 
 //-----------------------------------------------------------------------------
 // Name: AnsiToWideCch()
@@ -257,6 +260,8 @@ HRESULT WideToGenericCch( TCHAR* tstrDestination, const WCHAR* wstrSource,
 #endif
 }
 
+#endif
+
 void *
 HashedString::hash_name( char const * pIdentStr )
 {
@@ -0,0 +1,329 @@
+#pragma once
+//========================================================================
+// BinaryStream.h : Fixed-width, little-endian event serialization
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class BinaryOutStream		- not in the book
+//  class BinaryInStream		- not in the book
+//========================================================================
+
+#include <string>
+#include <vector>
+#include <string.h>
+
+
+// BinaryOutStream Description
+//
+// The writing half of the binary form of an event - see
+// IEventData::VSerializeBinary(). Every value has a fixed width and
+// is written little-endian whatever the machine is, so the bytes mean
+// the same thing to every reader:
+//
+//	integers	1, 2, 4 or 8 bytes
+//	float		4 bytes, the IEEE bits as a u32
+//	double		8 bytes, the IEEE bits as a u64
+//	bool		1 byte
+//	string		u32 length, then the characters - no terminator
+//	wstring		u32 length, then each character as a u16
+//
+// The buffer only grows, so a stream that's Clear()ed and reused
+// stops allocating once it has seen its biggest event.
+
+class BinaryOutStream
+{
+public:
+	BinaryOutStream() : m_Size( 0 ) { }
+
+	void Clear( void ) { m_Size = 0; }
+
+	char const * GetData( void ) const { return m_Size ? &m_Buffer[0] : NULL; }
+	unsigned int GetSize( void ) const { return m_Size; }
+
+	void WriteU8( unsigned char value )
+	{
+		*Grow( 1 ) = static_cast< char >( value );
+	}
+
+	void WriteU16( unsigned short value )
+	{
+		unsigned char * p = reinterpret_cast< unsigned char * >( Grow( 2 ) );
+		p[0] = static_cast< unsigned char >( value );
+		p[1] = static_cast< unsigned char >( value >> 8 );
+	}
+
+	void WriteU32( unsigned long value )
+	{
+		unsigned char * p = reinterpret_cast< unsigned char * >( Grow( 4 ) );
+		p[0] = static_cast< unsigned char >( value );
+		p[1] = static_cast< unsigned char >( value >> 8 );
+		p[2] = static_cast< unsigned char >( value >> 16 );
+		p[3] = static_cast< unsigned char >( value >> 24 );
+	}
+
+	void WriteU64( unsigned __int64 value )
+	{
+		WriteU32( static_cast< unsigned long >( value ) );
+		WriteU32( static_cast< unsigned long >( value >> 32 ) );
+	}
+
+	void WriteI32( int value )			{ WriteU32( static_cast< unsigned long >( value ) ); }
+	void WriteBool( bool value )		{ WriteU8( value ? 1 : 0 ); }
+
+	void WriteFloat( float value )
+	{
+		unsigned int bits;
+		memcpy( &bits, &value, sizeof( bits ) );
+		WriteU32( bits );
+	}
+
+	void WriteDouble( double value )
+	{
+		unsigned __int64 bits;
+		memcpy( &bits, &value, sizeof( bits ) );
+		WriteU64( bits );
+	}
+
+	// For Vec3, Mat4x4, Color and friends, which are all plain runs
+	// of floats.
+	void WriteFloats( float const * pValues, unsigned int count )
+	{
+		for ( unsigned int i = 0; i < count; ++i )
+			WriteFloat( pValues[i] );
+	}
+
+	void WriteString( char const * pString )
+	{
+		WriteString( pString, static_cast< unsigned int >( strlen( pString ) ) );
+	}
+
+	void WriteString( std::string const & str )
+	{
+		WriteString( str.data(), static_cast< unsigned int >( str.length() ) );
+	}
+
+	void WriteString( char const * pChars, unsigned int length )
+	{
+		WriteU32( length );
+		WriteBytes( pChars, length );
+	}
+
+	void WriteWString( std::wstring const & str )
+	{
+		WriteU32( static_cast< unsigned long >( str.length() ) );
+		for ( std::wstring::size_type i = 0; i < str.length(); ++i )
+			WriteU16( static_cast< unsigned short >( str[i] ) );
+	}
+
+	void WriteBytes( void const * pData, unsigned int size )
+	{
+		if ( size )
+			memcpy( Grow( size ), pData, size );
+	}
+
+private:
+	char * Grow( unsigned int size )
+	{
+		unsigned int const offset = m_Size;
+		m_Size += size;
+		if ( m_Size > m_Buffer.size() )
+			m_Buffer.resize( m_Size < 64 ? 64 : m_Size * 2 );
+		return &m_Buffer[offset];
+	}
+
+	std::vector< char > m_Buffer;
+	unsigned int m_Size;
+};
+
+
+// BinaryInStream Description
+//
+// Reads back what a BinaryOutStream wrote. It doesn't own the bytes.
+//
+// Running off the end, or a string longer than what's left, marks
+// the stream as failed; from then on every read returns zero or
+// empty, so an event constructor can read all its fields without
+// checking each one and the caller checks IsOk() once at the end.
+
+class BinaryInStream
+{
+public:
+	BinaryInStream( void const * pData, unsigned int size )
+		: m_pData( static_cast< unsigned char const * >( pData ) )
+		, m_Size( size )
+		, m_Pos( 0 )
+		, m_bFailed( false )
+	{
+	}
+
+	bool IsOk( void ) const { return !m_bFailed; }
+
+	// For readers that find bytes that make no sense.
+	void SetFailed( void ) { m_bFailed = true; }
+
+	unsigned int GetRemaining( void ) const { return m_Size - m_Pos; }
+
+	unsigned char ReadU8( void )
+	{
+		unsigned char const * p = Take( 1 );
+		return p ? p[0] : 0;
+	}
+
+	unsigned short ReadU16( void )
+	{
+		unsigned char const * p = Take( 2 );
+		if ( !p )
+			return 0;
+		return static_cast< unsigned short >( p[0] | ( p[1] << 8 ) );
+	}
+
+	unsigned long ReadU32( void )
+	{
+		unsigned char const * p = Take( 4 );
+		if ( !p )
+			return 0;
+		return static_cast< unsigned long >( p[0] )
+			| ( static_cast< unsigned long >( p[1] ) << 8 )
+			| ( static_cast< unsigned long >( p[2] ) << 16 )
+			| ( static_cast< unsigned long >( p[3] ) << 24 );
+	}
+
+	unsigned __int64 ReadU64( void )
+	{
+		unsigned __int64 const low = ReadU32();
+		unsigned __int64 const high = ReadU32();
+		return low | ( high << 32 );
+	}
+
+	int ReadI32( void )		{ return static_cast< int >( ReadU32() ); }
+	bool ReadBool( void )	{ return ReadU8() != 0; }
+
+	float ReadFloat( void )
+	{
+		unsigned int const bits = static_cast< unsigned int >( ReadU32() );
+		float value;
+		memcpy( &value, &bits, sizeof( value ) );
+		return value;
+	}
+
+	double ReadDouble( void )
+	{
+		unsigned __int64 const bits = ReadU64();
+		double value;
+		memcpy( &value, &bits, sizeof( value ) );
+		return value;
+	}
+
+	void ReadFloats( float * pValues, unsigned int count )
+	{
+		for ( unsigned int i = 0; i < count; ++i )
+			pValues[i] = ReadFloat();
+	}
+
+	void ReadString( std::string & str )
+	{
+		unsigned long const length = ReadU32();
+		unsigned char const * p = Take( length );
+		if ( p )
+			str.assign( reinterpret_cast< char const * >( p ), length );
+		else
+			str.clear();
+	}
+
+	// Into a fixed char array, as ActorParams keeps its names. A
+	// string that wouldn't fit with its terminator fails the stream.
+	void ReadString( char * pBuffer, unsigned int bufferSize )
+	{
+		unsigned long const length = ReadU32();
+		if ( length >= bufferSize )
+			m_bFailed = true;
+
+		unsigned char const * p = Take( length );
+		if ( p )
+		{
+			memcpy( pBuffer, p, length );
+			pBuffer[length] = 0;
+		}
+		else if ( bufferSize )
+		{
+			pBuffer[0] = 0;
+		}
+	}
+
+	void ReadWString( std::wstring & str )
+	{
+		unsigned long const length = ReadU32();
+		str.clear();
+		if ( length > GetRemaining() / 2 )
+		{
+			m_bFailed = true;
+			return;
+		}
+
+		str.reserve( length );
+		for ( unsigned long i = 0; i < length; ++i )
+			str += static_cast< wchar_t >( ReadU16() );
+	}
+
+	void ReadBytes( void * pData, unsigned int size )
+	{
+		unsigned char const * p = Take( size );
+		if ( p )
+			memcpy( pData, p, size );
+		else
+			memset( pData, 0, size );
+	}
+
+private:
+	unsigned char const * Take( unsigned long size )
+	{
+		if ( m_bFailed || size > m_Size - m_Pos )
+		{
+			m_bFailed = true;
+			return NULL;
+		}
+
+		unsigned char const * p = m_pData + m_Pos;
+		m_Pos += size;
+		return p;
+	}
+
+	unsigned char const * m_pData;
+	unsigned int m_Size;
+	unsigned int m_Pos;
+	bool m_bFailed;
+};
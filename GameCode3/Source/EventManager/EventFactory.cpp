@@ -0,0 +1,150 @@
+//========================================================================
+// EventFactory.cpp : Builds events from their serialized form
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventFactory			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "EventFactory.h"
+
+
+//
+// EventFactory::GetStreamCreators
+//
+//   A function static, so registering from another file's static
+//   initializer can't beat the map into existence.
+//
+EventFactory::StreamCreatorMap & EventFactory::GetStreamCreators( void )
+{
+	static StreamCreatorMap s_StreamCreators;
+	return s_StreamCreators;
+}
+
+//
+// EventFactory::AddStreamCreator
+//
+void EventFactory::AddStreamCreator( EventType const & eventType, StreamCreator creator )
+{
+	StreamCreatorMap & creators = GetStreamCreators();
+
+	StreamCreatorMap::const_iterator it = creators.find( eventType.getHashValue() );
+	if ( it != creators.end() )
+	{
+		assert( it->second == creator && "Two event classes registered for the same event type!" );
+		return;
+	}
+
+	creators.insert( std::make_pair( eventType.getHashValue(), creator ) );
+}
+
+//
+// EventFactory::CanCreate
+//
+bool EventFactory::CanCreate( unsigned long eventType )
+{
+	StreamCreatorMap const & creators = GetStreamCreators();
+	return creators.find( eventType ) != creators.end();
+}
+
+//
+// EventFactory::CreateFromStream
+//
+IEventDataPtr EventFactory::CreateFromStream( unsigned long eventType, std::istrstream & in )
+{
+	StreamCreatorMap const & creators = GetStreamCreators();
+
+	StreamCreatorMap::const_iterator it = creators.find( eventType );
+	if ( it == creators.end() )
+		return IEventDataPtr();
+
+	return (*it->second)( in );
+}
+
+//
+// EventFactory::GetBinaryCreators
+//
+EventFactory::BinaryCreatorMap & EventFactory::GetBinaryCreators( void )
+{
+	static BinaryCreatorMap s_BinaryCreators;
+	return s_BinaryCreators;
+}
+
+//
+// EventFactory::AddBinaryCreator
+//
+void EventFactory::AddBinaryCreator( EventType const & eventType, BinaryCreator creator )
+{
+	BinaryCreatorMap & creators = GetBinaryCreators();
+
+	BinaryCreatorMap::const_iterator it = creators.find( eventType.getHashValue() );
+	if ( it != creators.end() )
+	{
+		assert( it->second == creator && "Two event classes registered for the same event type!" );
+		return;
+	}
+
+	creators.insert( std::make_pair( eventType.getHashValue(), creator ) );
+}
+
+//
+// EventFactory::CanCreateFromBinary
+//
+bool EventFactory::CanCreateFromBinary( unsigned long eventType )
+{
+	BinaryCreatorMap const & creators = GetBinaryCreators();
+	return creators.find( eventType ) != creators.end();
+}
+
+//
+// EventFactory::CreateFromBinary
+//
+IEventDataPtr EventFactory::CreateFromBinary( unsigned long eventType, BinaryInStream & in )
+{
+	BinaryCreatorMap const & creators = GetBinaryCreators();
+
+	BinaryCreatorMap::const_iterator it = creators.find( eventType );
+	if ( it == creators.end() )
+		return IEventDataPtr();
+
+	IEventDataPtr event = (*it->second)( in );
+	if ( !in.IsOk() )
+		return IEventDataPtr();
+
+	return event;
+}
@@ -0,0 +1,122 @@
+#pragma once
+//========================================================================
+// EventFactory.h : Builds events from their serialized form
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventFactory			- not in the book
+//========================================================================
+
+#include <map>
+#include "EventManager.h"
+
+
+// EventFactory Description
+//
+// Builds an event from its serialized form given only its type.
+// RemoteEventSocket::CreateEvent() does this with a chain of
+// string compares; anything else that reads events back - the
+// event journal, for one - registers the types it can rebuild
+// here instead, next to where they're registered with the
+// EventManager:
+//
+//		EventFactory::RegisterStreamCreator< EvtData_Move_Actor >();
+//
+// The event class needs a constructor taking the std::istrstream
+// that its VSerialize() output is read from.
+//
+// The binary form works the same way - RegisterBinaryCreator<T>()
+// needs a constructor taking the BinaryInStream that
+// VSerializeBinary() wrote, and Register<T>() does both.
+
+class EventFactory
+{
+public:
+	typedef IEventDataPtr (*StreamCreator)( std::istrstream & in );
+	typedef IEventDataPtr (*BinaryCreator)( BinaryInStream & in );
+
+	template <class T>
+	static void RegisterStreamCreator( void )
+	{
+		AddStreamCreator( T::sk_EventType, &CreateFromStreamFor<T> );
+	}
+
+	template <class T>
+	static void RegisterBinaryCreator( void )
+	{
+		AddBinaryCreator( T::sk_EventType, &CreateFromBinaryFor<T> );
+	}
+
+	template <class T>
+	static void Register( void )
+	{
+		RegisterStreamCreator<T>();
+		RegisterBinaryCreator<T>();
+	}
+
+	static bool CanCreate( unsigned long eventType );
+	static bool CanCreateFromBinary( unsigned long eventType );
+
+	// Returns an empty pointer if the type isn't registered.
+	static IEventDataPtr CreateFromStream( unsigned long eventType, std::istrstream & in );
+
+	// Returns an empty pointer if the type isn't registered, or if
+	// the bytes didn't make a whole event.
+	static IEventDataPtr CreateFromBinary( unsigned long eventType, BinaryInStream & in );
+
+private:
+	template <class T>
+	static IEventDataPtr CreateFromStreamFor( std::istrstream & in )
+	{
+		return IEventDataPtr( GCC_NEW T( in ) );
+	}
+
+	template <class T>
+	static IEventDataPtr CreateFromBinaryFor( BinaryInStream & in )
+	{
+		return IEventDataPtr( GCC_NEW T( in ) );
+	}
+
+	static void AddStreamCreator( EventType const & eventType, StreamCreator creator );
+	static void AddBinaryCreator( EventType const & eventType, BinaryCreator creator );
+
+	typedef std::map< unsigned long, StreamCreator > StreamCreatorMap;
+	static StreamCreatorMap & GetStreamCreators( void );
+
+	typedef std::map< unsigned long, BinaryCreator > BinaryCreatorMap;
+	static BinaryCreatorMap & GetBinaryCreators( void );
+};
@@ -0,0 +1,500 @@
+//========================================================================
+// EventJournal.cpp : Binary event recording and replay
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventJournal			- not in the book
+//  class EventJournalPlayer	- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "EventJournal.h"
+#include "EventFactory.h"
+
+#include <algorithm>
+
+using namespace EventJournalFormat;
+
+
+namespace
+{
+	void PutU32( unsigned char * p, unsigned long value )
+	{
+		p[0] = static_cast< unsigned char >( value );
+		p[1] = static_cast< unsigned char >( value >> 8 );
+		p[2] = static_cast< unsigned char >( value >> 16 );
+		p[3] = static_cast< unsigned char >( value >> 24 );
+	}
+
+	void PutU64( unsigned char * p, unsigned __int64 value )
+	{
+		PutU32( p, static_cast< unsigned long >( value ) );
+		PutU32( p + 4, static_cast< unsigned long >( value >> 32 ) );
+	}
+
+	unsigned long GetU32( unsigned char const * p )
+	{
+		return static_cast< unsigned long >( p[0] )
+			| ( static_cast< unsigned long >( p[1] ) << 8 )
+			| ( static_cast< unsigned long >( p[2] ) << 16 )
+			| ( static_cast< unsigned long >( p[3] ) << 24 );
+	}
+
+	unsigned __int64 GetU64( unsigned char const * p )
+	{
+		return static_cast< unsigned __int64 >( GetU32( p ) )
+			| ( static_cast< unsigned __int64 >( GetU32( p + 4 ) ) << 32 );
+	}
+}
+
+
+//
+// EventJournal::EventJournal
+//
+EventJournal::EventJournal( unsigned int ringSize )
+	: m_pFile( NULL )
+	, m_pRing( NULL )
+	, m_RingSize( 1024 )
+	, m_WritePos( 0 )
+	, m_ReadPos( 0 )
+	, m_bQuit( false )
+	, m_hWriterThread( NULL )
+	, m_hDataReady( NULL )
+	, m_hSpaceFree( NULL )
+	, m_StartTicks( 0 )
+	, m_RecordCount( 0 )
+	, m_StallCount( 0 )
+{
+	// a power of two, so the ring positions can wrap freely
+	while ( m_RingSize < ringSize )
+		m_RingSize <<= 1;
+
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency( &freq );
+	m_Frequency = freq.QuadPart;
+}
+
+//
+// EventJournal::~EventJournal
+//
+EventJournal::~EventJournal()
+{
+	Close();
+}
+
+//
+// EventJournal::Open
+//
+bool EventJournal::Open( char const * const pFileName )
+{
+	Close();
+
+	m_pFile = fopen( pFileName, "wb" );
+	if ( !m_pFile )
+		return false;
+
+	unsigned char header[kHeaderSize];
+	PutU32( header, kMagic );
+	PutU32( header + 4, kVersion );
+	fwrite( header, sizeof(header), 1, m_pFile );
+
+	m_pRing = GCC_NEW char[m_RingSize];
+	m_WritePos = 0;
+	m_ReadPos = 0;
+	m_bQuit = false;
+	m_NamedTypes.clear();
+	m_RecordCount = 0;
+	m_StallCount = 0;
+
+	LARGE_INTEGER now;
+	QueryPerformanceCounter( &now );
+	m_StartTicks = now.QuadPart;
+
+	m_hDataReady = CreateEvent( NULL, FALSE, FALSE, NULL );
+	m_hSpaceFree = CreateEvent( NULL, FALSE, FALSE, NULL );
+
+	m_hWriterThread = CreateThread(
+				 NULL,         // default security attributes
+				 0,            // default stack size
+				 (LPTHREAD_START_ROUTINE) WriterProc,
+				 this,         // thread parameter is a pointer to the journal
+				 0,            // default creation flags
+				 NULL);        // receive thread identifier
+
+	if ( m_hWriterThread == NULL )
+	{
+		assert( 0 && "Could not create the event journal writer!" );
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+//
+// EventJournal::Close
+//
+//   Waits for the writer to empty the ring, so the file is complete
+//   when this returns.
+//
+void EventJournal::Close( void )
+{
+	if ( m_hWriterThread )
+	{
+		m_bQuit = true;
+		SetEvent( m_hDataReady );
+		WaitForSingleObject( m_hWriterThread, INFINITE );
+		CloseHandle( m_hWriterThread );
+		m_hWriterThread = NULL;
+	}
+
+	if ( m_hDataReady )
+	{
+		CloseHandle( m_hDataReady );
+		m_hDataReady = NULL;
+	}
+
+	if ( m_hSpaceFree )
+	{
+		CloseHandle( m_hSpaceFree );
+		m_hSpaceFree = NULL;
+	}
+
+	if ( m_pFile )
+	{
+		fclose( m_pFile );
+		m_pFile = NULL;
+	}
+
+	SAFE_DELETE_ARRAY( m_pRing );
+}
+
+//
+// EventJournal::GetTime
+//
+unsigned __int64 EventJournal::GetTime( void ) const
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter( &now );
+	return static_cast< unsigned __int64 >( ( now.QuadPart - m_StartTicks ) * 1000000 / m_Frequency );
+}
+
+//
+// EventJournal::RecordEvent
+//
+void EventJournal::RecordEvent( eRecordKind kind, IEventData const & event, bool nested )
+{
+	if ( !m_pFile )
+		return;
+
+	EventType const & eventType = event.VGetEventType();
+	unsigned long const typeHash = eventType.getHashValue();
+
+	if ( m_NamedTypes.insert( std::make_pair( typeHash, true ) ).second )
+	{
+		WriteRecord( kRecord_TypeName, typeHash,
+			eventType.getStr().c_str(), static_cast< unsigned int >( eventType.getStr().length() ) );
+	}
+
+	m_Payload.Clear();
+	event.VSerializeBinary( m_Payload );
+
+	unsigned char const flags = static_cast< unsigned char >( nested ? kRecord_Nested : 0 );
+	WriteRecord( static_cast< unsigned char >( kind | flags ), typeHash,
+		m_Payload.GetData(), m_Payload.GetSize() );
+}
+
+//
+// EventJournal::RecordTick
+//
+void EventJournal::RecordTick( void )
+{
+	if ( !m_pFile )
+		return;
+
+	WriteRecord( kRecord_Tick, 0, NULL, 0 );
+}
+
+//
+// EventJournal::WriteRecord
+//
+void EventJournal::WriteRecord( unsigned char kind, unsigned long eventType,
+	void const * pPayload, unsigned int payloadSize )
+{
+	if ( kRecordHeaderSize + payloadSize > m_RingSize )
+	{
+		assert( 0 && "Event is too big for the journal's ring buffer!" );
+		return;
+	}
+
+	unsigned char header[kRecordHeaderSize];
+	header[0] = kind;
+	PutU64( header + 1, GetTime() );
+	PutU32( header + 9, eventType );
+	PutU32( header + 13, payloadSize );
+
+	Append( header, sizeof(header) );
+	if ( payloadSize )
+		Append( pPayload, payloadSize );
+
+	++m_RecordCount;
+
+	SetEvent( m_hDataReady );
+}
+
+//
+// EventJournal::Append
+//
+void EventJournal::Append( void const * pData, unsigned int size )
+{
+	unsigned int const writePos = static_cast< unsigned int >( m_WritePos );
+
+	bool stalled = false;
+	while ( m_RingSize - ( writePos - static_cast< unsigned int >( m_ReadPos ) ) < size )
+	{
+		// the writer is behind - make sure it's awake, then wait
+		if ( !stalled )
+		{
+			++m_StallCount;
+			stalled = true;
+		}
+		SetEvent( m_hDataReady );
+		WaitForSingleObject( m_hSpaceFree, 10 );
+	}
+
+	unsigned int const offset = writePos & ( m_RingSize - 1 );
+	unsigned int const firstPart = std::min( size, m_RingSize - offset );
+
+	memcpy( m_pRing + offset, pData, firstPart );
+	memcpy( m_pRing, static_cast< char const * >( pData ) + firstPart, size - firstPart );
+
+	// publish the bytes only after they've been copied
+	InterlockedExchange( &m_WritePos, static_cast< LONG >( writePos + size ) );
+}
+
+//
+// EventJournal::WriterProc
+//
+DWORD WINAPI EventJournal::WriterProc( LPVOID lpParam )
+{
+	EventJournal * pJournal = static_cast< EventJournal * >( lpParam );
+
+	while ( true )
+	{
+		unsigned int const readPos = static_cast< unsigned int >( pJournal->m_ReadPos );
+		unsigned int const writePos = static_cast< unsigned int >(
+			InterlockedCompareExchange( &pJournal->m_WritePos, 0, 0 ) );
+		unsigned int const used = writePos - readPos;
+
+		if ( used == 0 )
+		{
+			if ( pJournal->m_bQuit )
+				break;
+
+			WaitForSingleObject( pJournal->m_hDataReady, 100 );
+			continue;
+		}
+
+		unsigned int const offset = readPos & ( pJournal->m_RingSize - 1 );
+		unsigned int const firstPart = std::min( used, pJournal->m_RingSize - offset );
+
+		fwrite( pJournal->m_pRing + offset, firstPart, 1, pJournal->m_pFile );
+		if ( used > firstPart )
+			fwrite( pJournal->m_pRing, used - firstPart, 1, pJournal->m_pFile );
+
+		InterlockedExchange( &pJournal->m_ReadPos, static_cast< LONG >( readPos + used ) );
+		SetEvent( pJournal->m_hSpaceFree );
+	}
+
+	fflush( pJournal->m_pFile );
+	return TRUE;
+}
+
+
+//
+// EventJournalPlayer::EventJournalPlayer
+//
+EventJournalPlayer::EventJournalPlayer()
+	: m_Duration( 0 )
+{
+	memset( &m_Stats, 0, sizeof(m_Stats) );
+}
+
+//
+// EventJournalPlayer::Open
+//
+bool EventJournalPlayer::Open( char const * const pFileName )
+{
+	m_Journal.clear();
+	m_TypeNames.clear();
+	m_Duration = 0;
+
+	FILE * pFile = fopen( pFileName, "rb" );
+	if ( !pFile )
+		return false;
+
+	fseek( pFile, 0, SEEK_END );
+	long const fileSize = ftell( pFile );
+	fseek( pFile, 0, SEEK_SET );
+
+	if ( fileSize < kHeaderSize )
+	{
+		fclose( pFile );
+		return false;
+	}
+
+	m_Journal.resize( fileSize );
+	size_t const bytesRead = fread( &m_Journal[0], 1, fileSize, pFile );
+	fclose( pFile );
+
+	unsigned char const * pHeader = reinterpret_cast< unsigned char const * >( &m_Journal[0] );
+	if ( bytesRead != static_cast< size_t >( fileSize )
+		|| GetU32( pHeader ) != kMagic
+		|| GetU32( pHeader + 4 ) != kVersion )
+	{
+		m_Journal.clear();
+		return false;
+	}
+
+	return true;
+}
+
+//
+// EventJournalPlayer::Play
+//
+//   Returns false if the journal ends part way through a record -
+//   everything before that point has still been played.
+//
+bool EventJournalPlayer::Play( IEventManager & eventManager, bool includeNested )
+{
+	memset( &m_Stats, 0, sizeof(m_Stats) );
+
+	if ( m_Journal.empty() )
+		return false;
+
+	unsigned char const * const pBegin = reinterpret_cast< unsigned char const * >( &m_Journal[0] );
+	unsigned char const * const pEnd = pBegin + m_Journal.size();
+	unsigned char const * p = pBegin + kHeaderSize;
+
+	bool complete = true;
+
+	while ( p < pEnd )
+	{
+		if ( pEnd - p < kRecordHeaderSize )
+		{
+			complete = false;
+			break;
+		}
+
+		unsigned char const kind = p[0];
+		unsigned __int64 const time = GetU64( p + 1 );
+		unsigned long const eventType = GetU32( p + 9 );
+		unsigned int const payloadSize = GetU32( p + 13 );
+		char const * const pPayload = reinterpret_cast< char const * >( p + kRecordHeaderSize );
+
+		if ( static_cast< unsigned int >( pEnd - p ) - kRecordHeaderSize < payloadSize )
+		{
+			complete = false;
+			break;
+		}
+
+		p += kRecordHeaderSize + payloadSize;
+		m_Duration = time;
+
+		switch ( kind & kRecord_KindMask )
+		{
+			case kRecord_TypeName:
+				m_TypeNames[eventType] = std::string( pPayload, payloadSize );
+				break;
+
+			case kRecord_Tick:
+				eventManager.VTick( IEventManager::kINFINITE );
+				++m_Stats.m_Ticks;
+				break;
+
+			case kRecord_Queued:
+			case kRecord_Triggered:
+			{
+				if ( ( kind & kRecord_Nested ) && !includeNested )
+				{
+					++m_Stats.m_SkippedNested;
+					break;
+				}
+
+				BinaryInStream in( pPayload, payloadSize );
+				IEventDataPtr event = EventFactory::CreateFromBinary( eventType, in );
+				if ( !event )
+				{
+					++m_Stats.m_Unknown;
+					break;
+				}
+
+				if ( ( kind & kRecord_KindMask ) == kRecord_Queued )
+				{
+					eventManager.VQueueEvent( event );
+					++m_Stats.m_Queued;
+				}
+				else
+				{
+					eventManager.VTrigger( *event );
+					++m_Stats.m_Triggered;
+				}
+				break;
+			}
+
+			default:
+				assert( 0 && "Unknown record in the event journal!" );
+				break;
+		}
+	}
+
+	// anything queued after the last recorded tick
+	eventManager.VTick( IEventManager::kINFINITE );
+
+	return complete;
+}
+
+//
+// EventJournalPlayer::GetTypeName
+//
+std::string EventJournalPlayer::GetTypeName( unsigned long eventType ) const
+{
+	std::map< unsigned long, std::string >::const_iterator it = m_TypeNames.find( eventType );
+	if ( it == m_TypeNames.end() )
+		return std::string();
+	return it->second;
+}
@@ -0,0 +1,194 @@
+#pragma once
+//========================================================================
+// EventJournal.h : Binary event recording and replay
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventJournal			- not in the book
+//  class EventJournalPlayer	- not in the book
+//========================================================================
+
+#include <vector>
+#include <map>
+#include "EventManager.h"
+
+
+// Journal file layout - everything little-endian:
+//
+//	header	'G','C','E','J', u32 version
+//	record	u8 kind, u64 time in microseconds since Open(),
+//			u32 event type hash, u32 payload size, payload
+//
+// The first time a type shows up it's preceded by a kRecord_TypeName
+// record whose payload is the type's name, so a journal can be read
+// without the code that wrote it.
+
+namespace EventJournalFormat
+{
+	enum
+	{
+		kMagic = 0x4a454347,		// "GCEJ"
+		kVersion = 2,				// 1 had VSerialize() text payloads
+		kHeaderSize = 8,
+		kRecordHeaderSize = 17
+	};
+
+	enum eRecordKind
+	{
+		kRecord_TypeName = 0,
+		kRecord_Queued = 1,
+		kRecord_Triggered = 2,
+		kRecord_Tick = 3,			// VTick() started processing
+
+		kRecord_KindMask = 0x0f,
+		kRecord_Nested = 0x80		// sent from inside a listener
+	};
+}
+
+
+// EventJournal Description
+//
+// Records every event sent through the EventManager to a binary
+// file, for regression tests and for replaying real traffic into
+// the listeners. Attach it with EventManager::SetJournal().
+//
+// Recording is done on the main thread by copying the record into
+// a ring buffer; a writer thread empties the ring to disk. If the
+// disk falls behind the ring fills up and the main thread waits -
+// nothing is ever dropped. GetStallCount() says how often that
+// happened; make the ring bigger if it's not zero.
+//
+// The payload is the event's VSerializeBinary() output, which every
+// event class has to provide.
+
+class EventJournal : public boost::noncopyable
+{
+public:
+	enum { kDefaultRingSize = 4 * 1024 * 1024 };
+
+	// ringSize is rounded up to a power of two.
+	explicit EventJournal( unsigned int ringSize = kDefaultRingSize );
+	~EventJournal();
+
+	bool Open( char const * const pFileName );
+	void Close( void );
+	bool IsOpen( void ) const { return m_pFile != NULL; }
+
+	// --- called by the EventManager ---
+
+	void RecordEvent( EventJournalFormat::eRecordKind kind, IEventData const & event, bool nested );
+	void RecordTick( void );
+
+	unsigned int GetRecordCount( void ) const { return m_RecordCount; }
+	unsigned int GetStallCount( void ) const { return m_StallCount; }
+
+private:
+	void WriteRecord( unsigned char kind, unsigned long eventType,
+		void const * pPayload, unsigned int payloadSize );
+
+	// Copies bytes into the ring, waiting for room if it has to.
+	void Append( void const * pData, unsigned int size );
+
+	unsigned __int64 GetTime( void ) const;
+
+	static DWORD WINAPI WriterProc( LPVOID lpParam );
+
+	FILE *         m_pFile;
+	char *         m_pRing;
+	unsigned int   m_RingSize;
+	volatile LONG  m_WritePos;		// bytes ever appended - main thread only
+	volatile LONG  m_ReadPos;		// bytes ever written - writer thread only
+	volatile bool  m_bQuit;
+
+	HANDLE         m_hWriterThread;
+	HANDLE         m_hDataReady;	// auto-reset, wakes the writer
+	HANDLE         m_hSpaceFree;	// auto-reset, wakes a waiting Append()
+
+	LONGLONG       m_StartTicks;
+	LONGLONG       m_Frequency;
+
+	std::map< unsigned long, bool > m_NamedTypes;
+	BinaryOutStream m_Payload;		// reused, so recording doesn't allocate
+	unsigned int   m_RecordCount;
+	unsigned int   m_StallCount;
+};
+
+
+// EventJournalPlayer Description
+//
+// Feeds a journal back into an event manager as fast as it will
+// go - no timing, no rendering, just the events in the order they
+// were sent, with a VTick() wherever the original one processed the
+// queue. Events are rebuilt through the EventFactory, so only types
+// registered there come back; the rest are counted and skipped.
+//
+// Events a listener sent while handling another are marked nested.
+// By default they're skipped, since the same listeners will send
+// them again. Play them too when the listeners that sent them
+// aren't attached - e.g. benchmarking one listener on its own.
+
+class EventJournalPlayer : public boost::noncopyable
+{
+public:
+	struct Stats
+	{
+		unsigned int m_Queued;
+		unsigned int m_Triggered;
+		unsigned int m_Ticks;
+		unsigned int m_SkippedNested;
+		unsigned int m_Unknown;			// no EventFactory creator, or a bad payload
+	};
+
+	EventJournalPlayer();
+
+	// Reads the whole journal into memory.
+	bool Open( char const * const pFileName );
+
+	bool Play( IEventManager & eventManager, bool includeNested = false );
+
+	Stats const & GetStats( void ) const { return m_Stats; }
+	unsigned __int64 GetDurationMicroseconds( void ) const { return m_Duration; }
+
+	// Name recorded for a type, or an empty string.
+	std::string GetTypeName( unsigned long eventType ) const;
+
+private:
+	std::vector< char > m_Journal;
+	std::map< unsigned long, std::string > m_TypeNames;
+	unsigned __int64 m_Duration;	// time of the last record
+	Stats m_Stats;
+};
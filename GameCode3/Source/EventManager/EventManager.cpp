@@ -44,33 +44,27 @@
 #include <cstring>
 
 #include "EventManager.h"
-#include "../GameCode.h"
 
-//--
-
-
-//Serializes the event data into the LuaObject.
-void EmptyEventData::VBuildLuaEventData(void)
-{
-	assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
-	//Get the global state.
-	LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+static IEventManager * g_pEventMgr = NULL;
 
-	//We just set a nil object.
-	m_LuaEventData.AssignNil( pState );
+// SetThreadCurrent()'s, for each thread
+#ifdef WIN32
+static __declspec(thread) IEventManager * t_pThreadEventMgr = NULL;
+#else
+static __thread IEventManager * t_pThreadEventMgr = NULL;
+#endif
 
-	//Now we've "got data".
-	m_bHasLuaEventData = true;
+IEventManager * IEventManager::Get()
+{
+	return t_pThreadEventMgr ? t_pThreadEventMgr : g_pEventMgr;
 }
 
-
-
-static IEventManager * g_pEventMgr = NULL;
-
-IEventManager * IEventManager::Get()
+IEventManager * IEventManager::SetThreadCurrent( IEventManager * pManager )
 {
-	return g_pEventMgr;
+	IEventManager * const pWas = t_pThreadEventMgr;
+	t_pThreadEventMgr = pManager;
+	return pWas;
 }
 
 IEventManager::IEventManager(
@@ -85,6 +79,8 @@ IEventManager::~IEventManager()
 {
 	if ( g_pEventMgr == this )
 		g_pEventMgr = NULL;
+	if ( t_pThreadEventMgr == this )
+		t_pThreadEventMgr = NULL;
 }
 
 //--
@@ -129,6 +125,27 @@ bool safeAbortEvent( EventType const & inType,
 	return IEventManager::Get()->VAbortEvent( inType, allOfType );
 }
 
+IEventManager::TimerId safeQueEventAfter( IEventDataPtr const & inEvent,
+					 unsigned long delayMillis )
+{
+	assert(IEventManager::Get() && _T("No event manager!"));
+	IEventManager * pManager = IEventManager::Get();
+	return pManager->VQueueEventAt( inEvent, pManager->VGetTime() + delayMillis );
+}
+
+IEventManager::TimerId safeQueEventPeriodic( IEventDataPtr const & inEvent,
+					 unsigned long periodMillis )
+{
+	assert(IEventManager::Get() && _T("No event manager!"));
+	return IEventManager::Get()->VQueueEventPeriodic( inEvent, periodMillis );
+}
+
+bool safeCancelTimer( IEventManager::TimerId timerId )
+{
+	assert(IEventManager::Get() && _T("No event manager!"));
+	return IEventManager::Get()->VCancelTimer( timerId );
+}
+
 bool safeTickEventManager( unsigned long maxMillis /*= kINFINITE*/ )
 {
 	assert(IEventManager::Get() && _T("No event manager!"));
@@ -49,10 +49,11 @@
 #include <boost/shared_ptr.hpp>
 #include <strstream>
 //#include "..\GameCode.h"
-#include "..\Scripting\LuaStateManager.h"
-#include "..\DumbStuff\String.h"
+#include "../Scripting/LuaStateManager.h"
+#include "../DumbStuff/String.h"
 
-#include "..\Multicore\CriticalSection.h"
+#include "../Multicore/CriticalSection.h"
+#include "BinaryStream.h"
 
 
 /*
@@ -127,8 +128,26 @@ public:
 	virtual float VGetTimeStamp() const = 0;
 	virtual void VSerialize(std::ostrstream &out) const = 0;
 
+	// The same thing with fixed-width, little-endian fields, for
+	// anything that cares about speed or size. It's read back by a
+	// constructor taking a BinaryInStream - see EventFactory.
+	virtual void VSerializeBinary(BinaryOutStream &out) const = 0;
+
 	// added for the Multicore chapter
 	virtual IEventDataPtr VCopy() const = 0;
+
+	// Events that only matter in their latest state ( e.g. where an
+	// actor is ) return true and fill in a key. Queueing one while an
+	// event of the same type and key is still pending drops the
+	// pending one, and the new one goes on the end of the queue.
+	virtual bool VGetCoalesceKey( unsigned int & key ) const = 0;
+
+	// Events that only matter to players near one actor ( e.g. it
+	// moved, or fired ) return true and fill in its id, and aren't
+	// sent to remote players too far away to see it - see
+	// InterestManager. Anything every player has to hear about, like
+	// an actor being made, returns false.
+	virtual bool VGetInterestActor( unsigned int & actorId ) const = 0;
 };
 
 
@@ -171,6 +190,22 @@ public:
 	{
 	};
 
+	// There's no VSerializeBinary() default - an event that wrote
+	// nothing would go on the wire, or into the journal, with no
+	// way to read it back. Every event class writes its own.
+
+	//Most events are never coalesced.
+	virtual bool VGetCoalesceKey( unsigned int & key ) const
+	{
+		return false;
+	}
+
+	//Most events go to everybody.
+	virtual bool VGetInterestActor( unsigned int & actorId ) const
+	{
+		return false;
+	}
+
 protected:
 	const float m_TimeStamp;
 	bool m_bHasLuaEventData;	//We will build that *only if necessary* (i.e., there is a script-side listener).
@@ -187,6 +222,11 @@ public:
 
 	virtual ~EmptyEventData()	{ }
 
+	// The type is all there is to it.
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+	}
+
 	//Called when sending the event data over to the script-side listener.
 	virtual LuaObject VGetLuaEventData(void) const
 	{
@@ -220,6 +260,12 @@ public:
 
 	const T GetValue() { return m_Value; }
 
+	// T is a plain value, so its bytes are the whole event.
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteBytes( &m_Value, sizeof(m_Value) );
+	}
+
 	virtual LuaObject VGetLuaEventData(void) const
 	{
 		assert( ( true == m_bHasLuaEventData ) && "Can't get lua event data because it hasn't been built yet!  Call BulidLuaEventData() first!" );
@@ -230,10 +276,6 @@ public:
 	{
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
-		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
-		//m_LuaEventData.AssignNewTable( pState );
-
 		m_bHasLuaEventData = true;
 	}
 };
@@ -262,6 +304,9 @@ public:
 		return IEventDataPtr (GCC_NEW EvtData_ScriptEvtData ( m_EventType, m_LuaEventData ) ); 
 	}
 
+	// The Lua table, as SerializeLuaTableBinary() writes it.
+	virtual void VSerializeBinary(BinaryOutStream &out) const;
+
 	virtual LuaObject VGetLuaEventData(void) const
 	{
 		assert( ( true == m_bHasLuaEventData ) && "Can't get lua event data because it hasn't been built yet!  Call BulidLuaEventData() first!" );
@@ -305,6 +350,24 @@ public:
 
 	virtual char const * GetName(void) = 0;
 
+	// Return 'true' to declare that HandleEvent() is thread-safe
+	// and touches no game state owned by the main thread. Queued
+	// events are then handed to this listener from a worker
+	// thread, in queue order, alongside the serial listeners.
+	//
+	// A parallel-safe listener can't eat an event - its return
+	// value is ignored, and a serial listener eating an event
+	// does not stop it from seeing that event. VTrigger() still
+	// calls it synchronously, on the triggering thread, but only
+	// once it's through the events VTick() has already given it -
+	// so it's never inside HandleEvent() on two threads at once,
+	// and still sees events in the order they were sent.
+
+	virtual bool IsParallelSafe(void) const
+	{
+		return false;
+	}
+
 	// Return 'false' to indicate that this listener did NOT
 	// consume the event, ( and it should continue to be
 	// propogated )
@@ -312,23 +375,27 @@ public:
 	// return 'true' to indicate that this listener consumed the
 	//event, ( and it should NOT continue to be propgated )
 
-	virtual bool HandleEvent( IEventData const & event ) = 0
-	{		
-		// Note: while HandleEvent() MUST be implemented in all
-		// derivative classes, (as this function is pure-virtual
-		// and thus the hook for IEventListener being an
-		// interface definition) a base implementation is
-		// provided here to make it easier to wire up do-nothing
-		// stubs that can easily be wired to log the
-		// unhandled-event (once logging is available)
-
-		// HandleEvent() functioning should be kept as brief as
-		// possible as multiple events will need to be evaluated
-		// per-frame in many cases.
-		return true;
-	}
+	virtual bool HandleEvent( IEventData const & event ) = 0;
 };
 
+// Defined out of the class - a pure virtual with a body inside the
+// class is a Visual C++ extension other compilers reject.
+inline bool IEventListener::HandleEvent( IEventData const & event )
+{		
+	// Note: while HandleEvent() MUST be implemented in all
+	// derivative classes, (as this function is pure-virtual
+	// and thus the hook for IEventListener being an
+	// interface definition) a base implementation is
+	// provided here to make it easier to wire up do-nothing
+	// stubs that can easily be wired to log the
+	// unhandled-event (once logging is available)
+
+	// HandleEvent() functioning should be kept as brief as
+	// possible as multiple events will need to be evaluated
+	// per-frame in many cases.
+	return true;
+}
+
 
 // IEventManager Description
 //
@@ -359,14 +426,25 @@ public:
 
 	enum eConstants
 	{
-		kINFINITE = 0xffffffff
+		kINFINITE = 0xffffffff,
+		kInvalidTimer = 0
 	};
 
+	// Handle to a pending VQueueEventAt() or VQueueEventPeriodic().
+	typedef unsigned int TimerId;
+
 	explicit IEventManager( char const * const pName,
 									   bool setAsGlobal );
 	
 	virtual ~IEventManager();
 
+	// Makes pManager the one the safe* functions use on the calling
+	// thread, rather than the global one, until it's set back - NULL
+	// goes back to the global one. Returns what it replaced, so it can
+	// be. This is how each game in a process full of them has its own
+	// - see GameInstance.
+	static IEventManager * SetThreadCurrent( IEventManager * pManager );
+
 	// Register a handler for a specific event type, implicitly
 	// the event type will be added to the known event types if
 	// not already known.
@@ -424,6 +502,29 @@ public:
 	virtual bool VAbortEvent ( EventType const & inType,
 							  bool allOfType = false ) = 0;
 
+	// Timed events - the event is held until the given time on the
+	// event manager's clock ( VGetTime(), in milliseconds ), then
+	// queued as if by VQueueEvent() at the start of the next
+	// VTick(), so it's handled that same tick. A periodic event is
+	// queued every 'periodMillis' from one period after it's set up,
+	// as a VCopy() each time, until it's cancelled.
+	//
+	// These replace waiting on a CWaitProcess or counting
+	// milliseconds by hand for something that just needs to happen
+	// later.
+	//
+	// returns kInvalidTimer if the event type is bad, otherwise an
+	// id for VCancelTimer(). Cancelling returns false if the timer
+	// had already fired ( and wasn't periodic ) or was cancelled.
+
+	virtual TimerId VQueueEventAt ( IEventDataPtr const & inEvent,
+								  unsigned long atMillis ) = 0;
+	virtual TimerId VQueueEventPeriodic ( IEventDataPtr const & inEvent,
+								  unsigned long periodMillis ) = 0;
+	virtual bool VCancelTimer ( TimerId timerId ) = 0;
+
+	virtual unsigned long VGetTime ( void ) const = 0;
+
 	// Allow for processing of any queued messages, optionally
 	// specify a processing time limit so that the event
 	// processing does not take too long. Note the danger of
@@ -448,7 +549,8 @@ public:
 private:
 
 	// internal use only accessor for the static methods in the
-	// helper to use to get the active global instance.
+	// helper to use to get the active global instance - or the
+	// calling thread's, if it's been given one.
 
 	static IEventManager * Get();
 
@@ -470,10 +572,15 @@ private:
 	friend bool threadSafeQueEvent( IEventDataPtr const & inEvent );
 
 	friend bool safeAbortEvent( EventType const & inType,
-								bool allOfType = false );
+								bool allOfType );
+
+	friend IEventManager::TimerId safeQueEventAfter( IEventDataPtr const & inEvent,
+								unsigned long delayMillis );
+	friend IEventManager::TimerId safeQueEventPeriodic( IEventDataPtr const & inEvent,
+								unsigned long periodMillis );
+	friend bool safeCancelTimer( IEventManager::TimerId timerId );
 
-	friend bool safeTickEventManager( unsigned long maxMillis =
-								IEventManager::kINFINITE );
+	friend bool safeTickEventManager( unsigned long maxMillis );
 
 	friend bool safeValidateEventType( EventType const & inType );
 
@@ -483,6 +590,9 @@ private:
 // Lastly, these methods are used for easy-access methods to carry
 // out basic operations without needing to pass around a pointer-to
 // ( or some other construct ) for sharing a global event manager.
+//
+// The default arguments live here rather than on the friend
+// declarations above, where only Visual C++ allows them.
 
 bool safeAddListener( EventListenerPtr const & inHandler,
 					  EventType const & inType );
@@ -496,10 +606,16 @@ bool safeQueEvent( IEventDataPtr const & inEvent );
 bool threadSafeQueEvent( IEventDataPtr const & inEvent );
 
 bool safeAbortEvent( EventType const & inType,
-					 bool allOfType /* = false */ );
+					 bool allOfType = false );
+
+IEventManager::TimerId safeQueEventAfter( IEventDataPtr const & inEvent,
+					 unsigned long delayMillis );
+IEventManager::TimerId safeQueEventPeriodic( IEventDataPtr const & inEvent,
+					 unsigned long periodMillis );
+bool safeCancelTimer( IEventManager::TimerId timerId );
 
 bool safeTickEventManager( unsigned long maxMillis
-					/* = IEventManager::kINFINITE */ );
+					= IEventManager::kINFINITE );
 
 bool safeValidateEventType( EventType const & inType );
 
@@ -41,7 +41,6 @@
 
 #include "GameCodeStd.h"
 
-#include "../GameCode.h"
 #include "EventManagerImpl.h"
 
 // EventManager
@@ -53,28 +52,13 @@ EventManager::EventManager(
 	char const * const pName,
 	bool setAsGlobal )
 	: IEventManager( pName, setAsGlobal ),
-	  m_activeQueue(0)
+	  m_activeQueue(0),
+	  m_Timers( GetTickCount() ),
+	  m_coalescedTotal(0),
+	  m_pDispatchPool(NULL),
+	  m_pJournal(NULL),
+	  m_DispatchDepth(0)
 {
-	//Open up access to script.
-	{
-		// Note that this is slightly different than in the book, since the
-		// Lua chapter was AFTER the event manager chapter.
-
-		//Create our metatable...
-		m_MetaTable = g_pApp->m_pLuaStateManager->GetGlobalState()->GetGlobals().CreateTable("EventManager");
-		m_MetaTable.SetObject("__index", m_MetaTable);
-		
-		m_MetaTable.RegisterObjectDirect( "TriggerEvent", (EventManager *)0, &EventManager::TriggerEventFromScript );
-		m_MetaTable.RegisterObjectDirect( "RegisterEventType", (EventManager *)0, &EventManager::RegisterScriptEventType );
-		m_MetaTable.RegisterObjectDirect( "AddScriptListener", (EventManager *)0, &EventManager::AddScriptListener );
-		m_MetaTable.RegisterObjectDirect( "RemoveScriptListener", (EventManager *)0, &EventManager::RemoveScriptListener );
-		m_MetaTable.RegisterObjectDirect( "AddScriptActorListener", (EventManager *)0, &EventManager::AddScriptActorListener );
-		m_MetaTable.RegisterObjectDirect( "RemoveScriptActorListener", (EventManager *)0, &EventManager::RemoveScriptActorListener );
-		
-		LuaObject luaStateManObj = g_pApp->m_pLuaStateManager->GetGlobalState()->BoxPointer(this);
-		luaStateManObj.SetMetaTable(m_MetaTable);
-		g_pApp->m_pLuaStateManager->GetGlobalState()->GetGlobals().SetObject("EventManager", luaStateManObj);
-	}
 }
 
 
@@ -84,6 +68,9 @@ EventManager::EventManager(
 EventManager::~EventManager()
 {
 	m_activeQueue = 0;
+
+	WaitForParallelDispatch();
+	SAFE_DELETE( m_pDispatchPool );
 }
 
 //
@@ -158,6 +145,13 @@ bool EventManager::VAddListener (
 
 	evlTable.push_back( inListener );
 
+	// parallel-safe listeners need somewhere to run
+
+	if ( inListener->IsParallelSafe() && ( NULL == m_pDispatchPool ) )
+	{
+		m_pDispatchPool = GCC_NEW ThreadPool();
+	}
+
 	return true;
 }
 
@@ -227,6 +221,12 @@ bool EventManager::VTrigger (
 	if ( ! VValidateType( inEvent.VGetEventType() ) )
 		return false;
 
+	if ( m_Profiler.IsEnabled() )
+		m_Profiler.RecordEvent( inEvent.VGetEventType() );
+
+	if ( m_pJournal )
+		m_pJournal->RecordEvent( EventJournalFormat::kRecord_Triggered, inEvent, m_DispatchDepth > 0 );
+
 	EventListenerMap::const_iterator itWC = m_registry.find( 0 );
 
 	if ( itWC != m_registry.end() )
@@ -238,7 +238,7 @@ bool EventManager::VTrigger (
 		for ( EventListenerTable::const_iterator it2 = table.begin(),
 				  it2End = table.end(); it2 != it2End; it2++ )
 		{
-			(*it2)->HandleEvent( inEvent );
+			CallListener( *it2, inEvent );
 		}
 	}
 	
@@ -256,9 +256,10 @@ bool EventManager::VTrigger (
 			  it2End = table.end(); it2 != it2End; it2++ )
 	{
 		EventListenerPtr listener = *it2;
-		if ( listener->HandleEvent( inEvent ) )
+		if ( CallListener( listener, inEvent ) && !listener->IsParallelSafe() )
 		{
 			// only set to true, if processing eats the messages
+			// (parallel-safe listeners never eat)
 			processed = true;
 		}
 	}
@@ -298,8 +299,41 @@ bool EventManager::VQueueEvent ( IEventDataPtr const & inEvent )
 			return false;
 		}
 	}
+
+	if ( m_pJournal )
+		m_pJournal->RecordEvent( EventJournalFormat::kRecord_Queued, *inEvent, m_DispatchDepth > 0 );
+
+	EventQueue & evtQueue = m_queues[m_activeQueue];
+
+	unsigned int coalesceKey = 0;
+
+	if ( inEvent->VGetCoalesceKey( coalesceKey ) )
+	{
+		CoalesceKey const key( inEvent->VGetEventType().getHashValue(), coalesceKey );
+
+		CoalesceIndex::iterator itPending = m_coalesceIndex.find( key );
+
+		if ( itPending != m_coalesceIndex.end() )
+		{
+			// last writer wins - the stale one's dropped and the
+			// newer event goes to the back of the line, so it's
+			// never handled ahead of anything queued after it
+
+			evtQueue.erase( itPending->second );
+			evtQueue.push_back( inEvent );
+			itPending->second = --evtQueue.end();
+
+			++m_coalescedCounts[ key.first ];
+			++m_coalescedTotal;
+			return true;
+		}
+
+		evtQueue.push_back( inEvent );
+		m_coalesceIndex.insert( std::make_pair( key, --evtQueue.end() ) );
+		return true;
+	}
 	
-	m_queues[m_activeQueue].push_back( inEvent );
+	evtQueue.push_back( inEvent );
 	
 	return true;
 }
@@ -348,11 +382,14 @@ bool EventManager::VAbortEvent ( EventType const & inType,
 
 	EventQueue &evtQueue = m_queues[m_activeQueue];
 
-	for ( EventQueue::iterator it = evtQueue.begin(),
-			  itEnd = evtQueue.end(); it != itEnd; it++ )
+	// note: the iterator is only advanced in the loop body, since
+	// erase() already hands back the next one
+
+	for ( EventQueue::iterator it = evtQueue.begin(); it != evtQueue.end(); )
 	{
 		if ( (*it)->VGetEventType() == inType )
 		{
+			UnindexCoalescedEvent( it );
 			it = evtQueue.erase(it);
 			rc = true;
 			if ( !allOfType )
@@ -367,6 +404,48 @@ bool EventManager::VAbortEvent ( EventType const & inType,
 	return rc;
 }
 
+//
+// EventManager::VQueueEventAt				- not in the book
+//
+IEventManager::TimerId EventManager::VQueueEventAt ( IEventDataPtr const & inEvent,
+								   unsigned long atMillis )
+{
+	if ( ! VValidateType( inEvent->VGetEventType() ) )
+		return kInvalidTimer;
+
+	return m_Timers.Schedule( inEvent, atMillis );
+}
+
+//
+// EventManager::VQueueEventPeriodic		- not in the book
+//
+IEventManager::TimerId EventManager::VQueueEventPeriodic ( IEventDataPtr const & inEvent,
+								   unsigned long periodMillis )
+{
+	assert( periodMillis > 0 && "A periodic event needs a period!" );
+
+	if ( ! VValidateType( inEvent->VGetEventType() ) || 0 == periodMillis )
+		return kInvalidTimer;
+
+	return m_Timers.Schedule( inEvent, VGetTime() + periodMillis, periodMillis );
+}
+
+//
+// EventManager::VCancelTimer				- not in the book
+//
+bool EventManager::VCancelTimer ( TimerId timerId )
+{
+	return m_Timers.Cancel( timerId );
+}
+
+//
+// EventManager::VGetTime					- not in the book
+//
+unsigned long EventManager::VGetTime ( void ) const
+{
+	return GetTickCount();
+}
+
 
 //
 // EventManager::VTick			- Chapter 10, page 296
@@ -391,6 +470,16 @@ bool EventManager::VTick ( unsigned long maxMillis )
 
 	EventListenerMap::const_iterator itWC = m_registry.find( 0 );
 
+	// parallel-safe listeners may still be chewing on the last
+	// tick's events - let them finish so each one sees its events
+	// in order
+
+	WaitForParallelDispatch();
+
+	bool const bProfiling = m_Profiler.IsEnabled();
+	EventProfiler::Ticks const tickStart = bProfiling ? EventProfiler::Now() : 0;
+	unsigned int realtimeEvents = 0;
+
 	// This section added to handle events from other threads
 	// Check out Chapter 18
 	// --------------------------------------------------------
@@ -399,6 +488,7 @@ bool EventManager::VTick ( unsigned long maxMillis )
 	while (m_RealtimeEventQueue.try_pop(rte))
 	{
 		VQueueEvent(rte);
+		++realtimeEvents;
 
 		curMs = GetTickCount();
 		if ( maxMillis != IEventManager::kINFINITE )
@@ -412,6 +502,28 @@ bool EventManager::VTick ( unsigned long maxMillis )
 	}
 	// --------------------------------------------------------
 
+	EventProfiler::Ticks const drainEnd = bProfiling ? EventProfiler::Now() : 0;
+
+	// timed events that have come due join the queue here, ahead
+	// of the swap, so they're handled this tick - and go through
+	// VQueueEvent() so the journal sees them as ordinary queued
+	// events
+
+	m_Timers.Advance( VGetTime(), m_ExpiredTimerEvents );
+
+	for ( std::vector< IEventDataPtr >::const_iterator itTimer = m_ExpiredTimerEvents.begin();
+		  itTimer != m_ExpiredTimerEvents.end(); ++itTimer )
+	{
+		VQueueEvent( *itTimer );
+	}
+	m_ExpiredTimerEvents.clear();
+
+	// recorded after the drain, so a replay queues the realtime
+	// events before it ticks - as happened here
+
+	if ( m_pJournal )
+		m_pJournal->RecordTick();
+
 	// swap active queues, make sure new queue is empty after the
 	// swap ...
 	
@@ -421,6 +533,12 @@ bool EventManager::VTick ( unsigned long maxMillis )
 
 	m_queues[m_activeQueue].clear();
 
+	// the index pointed into the queue we're about to process
+	m_coalesceIndex.clear();
+
+	unsigned int const queueDepth = bProfiling
+		? static_cast< unsigned int >( m_queues[queueToProcess].size() ) : 0;
+
 	// now process as many events as we can ( possibly time
 	// limited ) ... always do AT LEAST one event, if ANY are
 	// available ...
@@ -433,6 +551,9 @@ bool EventManager::VTick ( unsigned long maxMillis )
 		
 		EventType const & eventType = event->VGetEventType();
 
+		if ( bProfiling )
+			m_Profiler.RecordEvent( eventType );
+
 		EventListenerMap::const_iterator itListeners =
 			m_registry.find( eventType.getHashValue() );
 
@@ -446,7 +567,10 @@ bool EventManager::VTick ( unsigned long maxMillis )
 					  it2 = table.begin(), it2End = table.end();
 				  it2 != it2End; it2++ )
 			{
-				(*it2)->HandleEvent( *event );
+				if ( (*it2)->IsParallelSafe() )
+					BatchParallelEvent( *it2, event );
+				else
+					CallListener( *it2, *event );
 			}
 		}
 
@@ -457,13 +581,23 @@ bool EventManager::VTick ( unsigned long maxMillis )
 		unsigned int const kEventId = itListeners->first;
 		EventListenerTable const & table = itListeners->second;
 
+		// once a serial listener eats the event the rest of the
+		// serial listeners are skipped, but parallel-safe ones
+		// still get it
+
+		bool eaten = false;
+
 		for ( EventListenerTable::const_iterator
 				  it = table.begin(), end = table.end();
 			  it != end ; it++ )
 		{
-			if ( (*it)->HandleEvent( *event ) )
+			if ( (*it)->IsParallelSafe() )
 			{
-				break;
+				BatchParallelEvent( *it, event );
+			}
+			else if ( !eaten && CallListener( *it, *event ) )
+			{
+				eaten = true;
 			}
 		}
 
@@ -486,6 +620,9 @@ bool EventManager::VTick ( unsigned long maxMillis )
 	// Note: to preserver sequencing, go bottom-up on the
 	// raminder, inserting them at the head of the active
 	// queue...
+	//
+	// A leftover that has since been superseded by a newer event
+	// with the same coalescing key is dropped instead.
 
 	bool queueFlushed = ( m_queues[queueToProcess].size() == 0 );
 
@@ -497,15 +634,233 @@ bool EventManager::VTick ( unsigned long maxMillis )
 
 			m_queues[queueToProcess].pop_back();
 
+			unsigned int coalesceKey = 0;
+
+			if ( event->VGetCoalesceKey( coalesceKey ) )
+			{
+				CoalesceKey const key( event->VGetEventType().getHashValue(), coalesceKey );
+
+				if ( m_coalesceIndex.find( key ) != m_coalesceIndex.end() )
+				{
+					++m_coalescedCounts[ key.first ];
+					++m_coalescedTotal;
+					continue;
+				}
+
+				m_queues[m_activeQueue].push_front( event );
+				m_coalesceIndex.insert( std::make_pair( key, m_queues[m_activeQueue].begin() ) );
+				continue;
+			}
+
 			m_queues[m_activeQueue].push_front( event );
 		}
 	}
+
+	// the parallel-safe work runs alongside the rest of the frame,
+	// and is waited on at the top of the next tick
+
+	DispatchParallelBatch();
+
+	if ( bProfiling )
+		m_Profiler.RecordTick( queueDepth, realtimeEvents, tickStart, drainEnd, EventProfiler::Now() );
 	
 	// all done, this pass
 	
 	return queueFlushed;
 }
 
+//
+// EventManager::UnindexCoalescedEvent
+//
+// Called before a pending event is erased from the active queue,
+// so the coalescing index never points at a dead list node.
+//
+void EventManager::UnindexCoalescedEvent( EventQueue::iterator const & itEvent )
+{
+	unsigned int coalesceKey = 0;
+
+	if ( !(*itEvent)->VGetCoalesceKey( coalesceKey ) )
+		return;
+
+	CoalesceKey const key( (*itEvent)->VGetEventType().getHashValue(), coalesceKey );
+
+	CoalesceIndex::iterator itIndex = m_coalesceIndex.find( key );
+
+	if ( ( itIndex != m_coalesceIndex.end() ) && ( itIndex->second == itEvent ) )
+		m_coalesceIndex.erase( itIndex );
+}
+
+//
+// EventManager::GetCoalescedEventCount
+//
+unsigned int EventManager::GetCoalescedEventCount( void ) const
+{
+	return m_coalescedTotal;
+}
+
+unsigned int EventManager::GetCoalescedEventCount( EventType const & eventType ) const
+{
+	CoalescedCountMap::const_iterator it =
+		m_coalescedCounts.find( eventType.getHashValue() );
+
+	if ( it == m_coalescedCounts.end() )
+		return 0;
+
+	return it->second;
+}
+
+void EventManager::ResetCoalescedEventCounts( void )
+{
+	m_coalescedCounts.clear();
+	m_coalescedTotal = 0;
+}
+
+//
+// EventManager::BatchParallelEvent
+//
+// Adds an event to the listener's parallel job for this tick,
+// starting a new job if this is the first one it has seen.
+//
+void EventManager::BatchParallelEvent(
+	EventListenerPtr const & listener, IEventDataPtr const & event )
+{
+	ParallelDispatchJobPtr & job = m_ParallelBatch[ listener.get() ];
+
+	if ( !job )
+		job.reset( GCC_NEW ParallelDispatchJob( listener,
+			m_Profiler.IsEnabled() ? &m_Profiler : NULL ) );
+
+	job->AddEvent( event );
+}
+
+//
+// EventManager::DispatchParallelBatch
+//
+// Hands this tick's jobs to the worker pool. Different listeners
+// run side by side; a single listener's events stay in one job.
+//
+void EventManager::DispatchParallelBatch( void )
+{
+	if ( m_ParallelBatch.empty() )
+		return;
+
+	assert( m_pDispatchPool && "Parallel-safe listener registered without a dispatch pool!" );
+
+	assert( m_ParallelRunning.empty() && "The last tick's parallel jobs haven't been waited on!" );
+
+	for ( ParallelDispatchBatch::const_iterator it = m_ParallelBatch.begin(),
+			  itEnd = m_ParallelBatch.end(); it != itEnd; it++ )
+	{
+		m_pDispatchPool->Submit( it->second );
+	}
+
+	m_ParallelRunning.swap( m_ParallelBatch );
+}
+
+//
+// EventManager::WaitForParallelDispatch
+//
+void EventManager::WaitForParallelDispatch( void )
+{
+	if ( m_pDispatchPool )
+		m_pDispatchPool->WaitForAll();
+
+	m_ParallelRunning.clear();
+}
+
+//
+// EventManager::FinishParallelJobs
+//
+// A listener triggered from a serial listener in the middle of
+// VTick() can have a job still being built - that one's run right
+// here, since nothing else has it yet. Any later events this tick
+// start a new job.
+//
+void EventManager::FinishParallelJobs( IEventListener * pListener ) const
+{
+	ParallelDispatchBatch::iterator it = m_ParallelRunning.find( pListener );
+	if ( it != m_ParallelRunning.end() )
+	{
+		it->second->Wait();
+		m_ParallelRunning.erase( it );
+	}
+
+	it = m_ParallelBatch.find( pListener );
+	if ( it != m_ParallelBatch.end() )
+	{
+		ParallelDispatchJobPtr const job = it->second;
+		m_ParallelBatch.erase( it );
+		job->VRun();
+	}
+}
+
+//
+// EventManager::ParallelDispatchJob::VRun
+//
+// Runs on a worker thread. The events are shared_ptr's, so they
+// live until the last job holding them lets go.
+//
+void EventManager::ParallelDispatchJob::VRun()
+{
+	for ( std::vector< IEventDataPtr >::const_iterator it = m_Events.begin(),
+			  itEnd = m_Events.end(); it != itEnd; it++ )
+	{
+		if ( m_pProfiler )
+		{
+			EventProfiler::Ticks const start = EventProfiler::Now();
+			m_Listener->HandleEvent( **it );
+			m_pProfiler->RecordHandler( m_Listener.get(), (*it)->VGetEventType(),
+				start, EventProfiler::Now() );
+		}
+		else
+		{
+			m_Listener->HandleEvent( **it );
+		}
+	}
+
+	boost::mutex::scoped_lock lock( m_DoneMutex );
+	m_bDone = true;
+	m_Done.notify_all();
+}
+
+//
+// EventManager::ParallelDispatchJob::Wait
+//
+void EventManager::ParallelDispatchJob::Wait()
+{
+	boost::mutex::scoped_lock lock( m_DoneMutex );
+	while ( !m_bDone )
+		m_Done.wait( lock );
+}
+
+//
+// EventManager::CallListener
+//
+bool EventManager::CallListener( EventListenerPtr const & listener, IEventData const & event ) const
+{
+	if ( listener->IsParallelSafe() )
+		FinishParallelJobs( listener.get() );
+
+	++m_DispatchDepth;
+
+	bool result;
+
+	if ( !m_Profiler.IsEnabled() )
+	{
+		result = listener->HandleEvent( event );
+	}
+	else
+	{
+		EventProfiler::Ticks const start = EventProfiler::Now();
+		result = listener->HandleEvent( event );
+		m_Profiler.RecordHandler( listener.get(), event.VGetEventType(), start, EventProfiler::Now() );
+	}
+
+	--m_DispatchDepth;
+
+	return result;
+}
+
 // --- information lookup functions ---
 
 //
@@ -604,210 +959,6 @@ EventTypeList EventManager::GetTypeList ( void ) const
 	return result;
 }
 
-//--
-// EventManager::AddScriptListener						- Chapter 11, page 336
-//
-// Creates a script-side event listener, given an appropriate Lua function.
-bool EventManager::AddScriptListener( char const * const pEventName, LuaObject callbackFunction )
-{
-	//Ensure this event type exists.
-	const EventType testEventType( pEventName );
-	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
-	if ( m_typeList.end() == typeIter )
-	{
-		assert( 0 && "Attempted to listen to an event type that wasn't registered!" );
-		return false;
-	}
-
-	const unsigned int eventID = testEventType.getHashValue();
-
-	//OK, valid event type.  Make sure this isn't a duplicate.
-	ScriptEventListenerMap::const_iterator mapIter = m_ScriptEventListenerMap.find( eventID );
-	while ( m_ScriptEventListenerMap.end() != mapIter )
-	{
-		//Iterate through and ensure no duplicates.
-		const ScriptEventListenerPtr evtListener = mapIter->second;
-		const LuaObject & evtObj = evtListener->GetHandlerFunction();
-		if ( evtObj == callbackFunction )
-		{
-			assert( 0 && "Attempted to listen to the same event handler twice!" );
-			return false;
-		}
-		++mapIter;
-	}
-
-	//Now let's rez up a new script listener.
-	ScriptEventListenerPtr listener( GCC_NEW ScriptEventListener( callbackFunction ) );
-
-	m_ScriptEventListenerMap.insert( std::make_pair( eventID, listener ) );
-
-	const bool bSuccess = VAddListener( listener, testEventType );
-	return bSuccess;
-}
-
-//--
-// EventManager::RemoveScriptListener
-// Removes a script-side listener.
-bool EventManager::RemoveScriptListener( const char *const pEventName, LuaObject callbackFunction )
-{
-	//Ensure this event type exists.
-	const EventType testEventType( pEventName );
-	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
-	if ( m_typeList.end() == typeIter )
-	{
-		assert( 0 && "Attempted to remove a listener for an event type that doesn't exist!" );
-		return false;
-	}
-
-	const unsigned int eventID = testEventType.getHashValue();
-
-	//OK, now ensure it exists in the multimap.
-	bool bFound = false;
-	ScriptEventListenerMap::iterator mapIter = m_ScriptEventListenerMap.find( eventID );
-	while ( m_ScriptEventListenerMap.end() != mapIter )
-	{
-		const ScriptEventListenerPtr evtListener = mapIter->second;
-		const LuaObject & evtObj = evtListener->GetHandlerFunction();
-		if ( evtObj == callbackFunction )
-		{
-			bFound = true;
-			break;
-		}
-		++mapIter;
-	}
-
-	if ( false == bFound )
-	{
-		assert( 0 && "Attempted to remove a script listener for an event it was never listening for!" );
-		return false;
-	}
-
-	//Remove this listener from the map.
-	const ScriptEventListenerPtr listener = mapIter->second;
-	m_ScriptEventListenerMap.erase( mapIter );
-
-	//Now remove from the "main" listener set.
-	const bool bSuccess = VDelListener( listener, testEventType );
-	return bSuccess;
-}
-
-//--
-// EventManager::AddScriptActorListener					- Chapter 11, page 341
-// Creates a script-side *ACTOR* event listener, given an appropriate Lua function.
-bool EventManager::AddScriptActorListener( char const * const pEventName, LuaObject callbackFunction, const int actorID )
-{
-	//Ensure this event type exists.
-	const EventType testEventType( pEventName );
-	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
-	if ( m_typeList.end() == typeIter )
-	{
-		assert( 0 && "Attempted to listen to an event type that wasn't registered!" );
-		return false;
-	}
-
-	const unsigned int eventID = testEventType.getHashValue();
-
-	//OK, valid event type.  Make sure this isn't a duplicate.
-	ScriptActorEventListenerMap::const_iterator mapIter = m_ScriptActorEventListenerMap.find( eventID );
-	while ( m_ScriptActorEventListenerMap.end() != mapIter )
-	{
-		//Iterate through and ensure no duplicates.
-		const ScriptActorEventListenerPtr evtListener = mapIter->second;
-		const LuaObject & evtObj = evtListener->GetHandlerFunction();
-		if ( ( evtObj == callbackFunction ) && ( actorID == evtListener->GetActorID() ) )
-		{
-			assert( 0 && "Attempted to listen to the same event handler twice for a specific actor!" );
-			return false;
-		}
-		++mapIter;
-	}
-
-	//Now let's rez up a new script listener.
-	ScriptActorEventListenerPtr listener( GCC_NEW ScriptActorEventListener( callbackFunction, actorID ) );
-
-	m_ScriptActorEventListenerMap.insert( std::make_pair( eventID, listener ) );
-
-	const bool bSuccess = VAddListener( listener, testEventType );
-	return bSuccess;
-}
-
-//--
-// EventManager::RemoveScriptActorListener
-// Removes a script-side listener for a given actor.
-bool EventManager::RemoveScriptActorListener( const char *const pEventName, LuaObject callbackFunction, const int actorID )
-{
-	//Ensure this event type exists.
-	const EventType testEventType( pEventName );
-	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
-	if ( m_typeList.end() == typeIter )
-	{
-		assert( 0 && "Attempted to remove a listener for an event type that doesn't exist!" );
-		return false;
-	}
-
-	const unsigned int eventID = testEventType.getHashValue();
-
-	//OK, now ensure it exists in the multimap.
-	bool bFound = false;
-	ScriptActorEventListenerMap::iterator mapIter = m_ScriptActorEventListenerMap.find( eventID );
-	while ( m_ScriptActorEventListenerMap.end() != mapIter )
-	{
-		const ScriptActorEventListenerPtr evtListener = mapIter->second;
-		const LuaObject & evtObj = evtListener->GetHandlerFunction();
-		if ( ( evtObj == callbackFunction ) && ( actorID == evtListener->GetActorID() ) )
-		{
-			bFound = true;
-			break;
-		}
-		++mapIter;
-	}
-
-	if ( false == bFound )
-	{
-		assert( 0 && "Attempted to remove a script listener for an actor event it was never listening for!" );
-		return false;
-	}
-
-	//Remove this listener from the map.
-	const ScriptActorEventListenerPtr listener = mapIter->second;
-	m_ScriptActorEventListenerMap.erase( mapIter );
-
-	//Now remove from the "main" listener set.
-	const bool bSuccess = VDelListener( listener, testEventType );
-	return bSuccess;
-}
-
-//--
-// EventManager::TriggerEventFromScript					- Chapter 11, page 3338
-
-bool EventManager::TriggerEventFromScript( char const * const pEventName, LuaObject luaEventData )
-{
-	const EventType eventType( pEventName );
-
-	//Look this event type up.
-	const EventTypeSet::const_iterator iter = m_typeList.find( eventType );
-	if ( iter == m_typeList.end() )
-	{
-		assert( 0 && "Attempted to trigger an event type that doesn't exist!" );
-		return false;
-	}
-
-	//This level of indirection lets us create code-side events or script-side events.
-	IRegisteredEventPtr regEvent = iter->second;
-	const bool bResult = regEvent->VTriggerEventFromScript( luaEventData );
-
-	return bResult;
-}
-
-
-// EventManager::RegisterScriptEventType			- Chapter 11, page 329
-void EventManager::RegisterScriptEventType( char const * const pEventName )
-{
-	//Create a new script-defined event object.
-	const EventType eventType( pEventName );
-	RegisterScriptEvent( eventType );
-}
-
 //--
 // EventSnooper::EventSnooper		- Chapter 11, page 351
 //
@@ -918,32 +1069,29 @@ bool EventSnooper::HandleEvent( IEventData const & event )
 }
 
 
-// EventManager::RegisterScriptEvent				- Chapter 11, page 329
-void EventManager::RegisterScriptEvent( const EventType & eventType )
-{
-	IRegisteredEventPtr metaData( GCC_NEW EventManager::ScriptDefinedEvent( eventType ) );
-	AddRegisteredEventType( eventType, metaData );
-}
-
 void EventManager::RegisterCodeOnlyEvent( const EventType & eventType )
 {
 	IRegisteredEventPtr metaData( GCC_NEW CodeOnlyDefinedEvent() );
 	AddRegisteredEventType( eventType, metaData );
 }
 
-
-// EventManager::ScriptDefinedEvent::VTriggerEventFromScript		- Chapter 11, page 329
-bool EventManager::ScriptDefinedEvent::VTriggerEventFromScript( LuaObject & srcData ) const
+//
+// EventManager::CopyCodeEventTypes				- not in the book
+//
+// The metadata's shared - it doesn't hold anything that belongs to
+// one manager.
+//
+void EventManager::CopyCodeEventTypes( EventManager const & from )
 {
-	const EvtData_ScriptEvtData scriptEvent( m_EventType, srcData );
-	return safeTriggerEvent( scriptEvent );
+	for ( EventTypeSet::const_iterator it = from.m_typeList.begin(), itEnd = from.m_typeList.end(); it != itEnd; ++it )
+	{
+		if ( it->second->GetEventMetaData() == IRegisteredEvent::kREMD_ScriptDefined )
+			continue;
+		if ( m_typeList.find( it->first ) == m_typeList.end() )
+			m_typeList.insert( *it );
+	}
 }
 
-bool EventManager::ScriptDefinedEvent::VQueueEventFromScript( LuaObject & srcData ) const
-{
-	//TODO JWC
-	return true;
-}
 
 // EventManager::AddRegisteredEventType				- Chapter 11, page 325
 void EventManager::AddRegisteredEventType( const EventType & eventType, IRegisteredEventPtr metaData )
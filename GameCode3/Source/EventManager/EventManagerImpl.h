@@ -52,7 +52,12 @@
 #include <list>
 #include <map>
 #include <set>
-#include "..\Scripting\ScriptEventListener.h"
+#include <boost/unordered_map.hpp>
+#include "../Scripting/ScriptEventListener.h"
+#include "../Multicore/ThreadPool.h"
+#include "EventProfiler.h"
+#include "EventJournal.h"
+#include "TimerWheel.h"
 
 
 // EventManager Description
@@ -73,6 +78,12 @@ public:
 
 	virtual ~EventManager();
 
+	// Makes the EventManager callable from Lua - call it right after
+	// construction. Lives in EventManagerScript.cpp, and is the only
+	// thing that needs a LuaStateManager up and running.
+
+	void RegisterScriptInterface( void );
+
 	// --- primary use functions --- make it work ---
 	
 	// Register a listener for a specific event type, implicitly
@@ -135,6 +146,20 @@ public:
 	virtual bool VAbortEvent ( EventType const & inType,
 					  bool allOfType );
 
+	// Hold an event until a time on VGetTime()'s clock, or queue a
+	// copy of it every period - see TimerWheel. Scheduling and
+	// cancelling don't depend on how many timers are pending, and
+	// VTick() only pays for the ones coming due.
+
+	virtual TimerId VQueueEventAt ( IEventDataPtr const & inEvent,
+					  unsigned long atMillis );
+	virtual TimerId VQueueEventPeriodic ( IEventDataPtr const & inEvent,
+					  unsigned long periodMillis );
+	virtual bool VCancelTimer ( TimerId timerId );
+
+	// GetTickCount(), the clock VTick() already runs on.
+	virtual unsigned long VGetTime ( void ) const;
+
 	// Allow for processing of any queued messages, optionally
 	// specify a processing time limit so that the event
 	// processing does not take too long. Note the danger of
@@ -172,6 +197,37 @@ public:
 	void RegisterCodeOnlyEvent( const EventType & eventType );
 	// ...for an event defined by code, but callable by script.  REQUIRES the event type to have a constructor taking a LuaObject.
 	template< class T> void RegisterEvent( const EventType & eventType );
+	// ...every type the other one has had registered from code, the
+	// same way. Script's own types aren't copied: each Lua state
+	// registers them for itself when its init.lua runs.
+	void CopyCodeEventTypes( EventManager const & from );
+
+	// Blocks until parallel-safe listeners have finished with the
+	// events handed to them by the last VTick(). VTick() calls this
+	// itself before dispatching again, so it's only needed by code
+	// that must see those listeners quiet - e.g. before tearing down
+	// something they use.
+
+	void WaitForParallelDispatch( void );
+
+	// Number of queued events dropped because a newer event with
+	// the same coalescing key replaced them - in total, or for one
+	// event type.
+
+	unsigned int GetCoalescedEventCount( void ) const;
+	unsigned int GetCoalescedEventCount( EventType const & eventType ) const;
+	void ResetCoalescedEventCounts( void );
+
+	// Per-type counts and per-listener timings - does nothing
+	// until it's switched on with SetEnabled() or BeginCapture().
+
+	EventProfiler & GetProfiler( void ) { return m_Profiler; }
+
+	// Every event queued or triggered from now on is recorded in
+	// the journal, until this is called again with NULL. The
+	// journal isn't owned, and must outlive its use here.
+
+	void SetJournal( EventJournal * pJournal ) { m_pJournal = pJournal; }
 
 private:
 	
@@ -329,7 +385,94 @@ private:
 
 	ThreadSafeEventQueue m_RealtimeEventQueue;
 
-	// ALL SCRIPT-RELATED FUNCTIONS
+	TimerWheel        m_Timers;				// events waiting for their time
+	std::vector< IEventDataPtr > m_ExpiredTimerEvents;	// kept to save
+											// allocating each tick
+
+	// Coalescing - pending events that declared a coalescing key,
+	// indexed by ( event type, key ), so a newer one can find and
+	// drop them. Only the active queue is indexed.
+
+	typedef std::pair< unsigned long, unsigned int >			CoalesceKey;
+	typedef boost::unordered_map< CoalesceKey, EventQueue::iterator >	CoalesceIndex;
+	typedef std::map< unsigned long, unsigned int >				CoalescedCountMap;
+
+	// Drops the event from the index, if it's the one indexed.
+	void UnindexCoalescedEvent( EventQueue::iterator const & itEvent );
+
+	CoalesceIndex     m_coalesceIndex;
+	CoalescedCountMap m_coalescedCounts;	// per event type
+	unsigned int      m_coalescedTotal;
+
+	// Parallel dispatch - every parallel-safe listener gets one job
+	// per tick holding its events in queue order, so a listener is
+	// never inside HandleEvent() on two workers at once.
+
+	class ParallelDispatchJob : public IThreadPoolJob
+	{
+	public:
+		ParallelDispatchJob( EventListenerPtr const & listener, EventProfiler * pProfiler )
+			: m_Listener( listener ), m_pProfiler( pProfiler ), m_bDone( false )
+		{
+		}
+
+		void AddEvent( IEventDataPtr const & event )
+		{
+			m_Events.push_back( event );
+		}
+
+		virtual void VRun();
+
+		// Blocks until VRun() has handed over every event.
+		void Wait( void );
+
+	private:
+		EventListenerPtr m_Listener;
+		EventProfiler * m_pProfiler;
+		std::vector< IEventDataPtr > m_Events;
+
+		bool m_bDone;
+		boost::mutex m_DoneMutex;
+		boost::condition_variable m_Done;
+	};
+
+	typedef shared_ptr< ParallelDispatchJob >					ParallelDispatchJobPtr;
+	typedef std::map< IEventListener *, ParallelDispatchJobPtr >	ParallelDispatchBatch;
+
+	// Adds the event to the listener's job for this tick.
+	void BatchParallelEvent( EventListenerPtr const & listener, IEventDataPtr const & event );
+
+	// Hands the batched jobs to the worker pool without waiting.
+	void DispatchParallelBatch( void );
+
+	// Before a parallel-safe listener is called on this thread: waits
+	// for its job on the pool, and runs the one being built, so it
+	// has seen every event queued ahead of the one it's handed.
+	void FinishParallelJobs( IEventListener * pListener ) const;
+
+	mutable ParallelDispatchBatch m_ParallelBatch;	// jobs being built this tick
+	mutable ParallelDispatchBatch m_ParallelRunning;	// jobs handed to the pool,
+											// until they're waited on -
+											// mutable so VTrigger() can
+											// finish them
+	ThreadPool *m_pDispatchPool;			// created when the first
+											// parallel-safe listener
+											// is added
+
+	// Calls the listener, timing it when the profiler is on - a
+	// parallel-safe one after FinishParallelJobs().
+	bool CallListener( EventListenerPtr const & listener, IEventData const & event ) const;
+
+	mutable EventProfiler m_Profiler;	// mutable so VTrigger() can
+											// record into it
+
+	EventJournal *   m_pJournal;
+	mutable int      m_DispatchDepth;		// listener calls in progress
+											// on the main thread - an event
+											// sent while it's non-zero came
+											// from a listener
+
+	// ALL SCRIPT-RELATED FUNCTIONS ( see EventManagerScript.cpp )
 private:
 	// Registers a script-based event.
 	void RegisterScriptEventType( char const * const pEventName );
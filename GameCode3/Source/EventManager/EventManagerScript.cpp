@@ -0,0 +1,346 @@
+//========================================================================
+// EventManagerScript.cpp : The script side of the event system
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  EventManager::AddScriptListener			- Chapter 11, page 336
+//  EventManager::TriggerEventFromScript	- Chapter 11, page 338
+//  EventManager::RegisterScriptEventType	- Chapter 11, page 329
+//  EventManager::RegisterScriptEvent		- Chapter 11, page 329
+//  EventManager::ScriptDefinedEvent::VTriggerEventFromScript	- Chapter 11, page 329
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include "../GameCode.h"
+#include "EventManagerImpl.h"
+#include "Events.h"
+
+// Everything here reaches the Lua state through g_pApp, so it's kept
+// out of EventManagerImpl.cpp - that way the event system itself
+// builds without the rest of the game, as the Headless benchmarks do.
+
+
+//
+// EventManager::RegisterScriptInterface
+//
+// Opens up access to script. This used to be done by the
+// constructor, and still has to happen right after it.
+//
+void EventManager::RegisterScriptInterface( void )
+{
+	// Note that this is slightly different than in the book, since the
+	// Lua chapter was AFTER the event manager chapter.
+
+	//Create our metatable...
+	m_MetaTable = g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->GetGlobals().CreateTable("EventManager");
+	m_MetaTable.SetObject("__index", m_MetaTable);
+	
+	m_MetaTable.RegisterObjectDirect( "TriggerEvent", (EventManager *)0, &EventManager::TriggerEventFromScript );
+	m_MetaTable.RegisterObjectDirect( "RegisterEventType", (EventManager *)0, &EventManager::RegisterScriptEventType );
+	m_MetaTable.RegisterObjectDirect( "AddScriptListener", (EventManager *)0, &EventManager::AddScriptListener );
+	m_MetaTable.RegisterObjectDirect( "RemoveScriptListener", (EventManager *)0, &EventManager::RemoveScriptListener );
+	m_MetaTable.RegisterObjectDirect( "AddScriptActorListener", (EventManager *)0, &EventManager::AddScriptActorListener );
+	m_MetaTable.RegisterObjectDirect( "RemoveScriptActorListener", (EventManager *)0, &EventManager::RemoveScriptActorListener );
+	
+	LuaObject luaStateManObj = g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->BoxPointer(this);
+	luaStateManObj.SetMetaTable(m_MetaTable);
+	g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->GetGlobals().SetObject("EventManager", luaStateManObj);
+}
+
+
+//Serializes the event data into the LuaObject.
+void EmptyEventData::VBuildLuaEventData(void)
+{
+	assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
+
+	//Get the global state.
+	LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
+
+	//We just set a nil object.
+	m_LuaEventData.AssignNil( pState );
+
+	//Now we've "got data".
+	m_bHasLuaEventData = true;
+}
+
+//
+// EvtData_ScriptEvtData::VSerializeBinary		- not in the book
+//
+void EvtData_ScriptEvtData::VSerializeBinary(BinaryOutStream &out) const
+{
+	SerializeLuaTableBinary( out, m_LuaEventData );
+}
+
+
+//--
+// EventManager::AddScriptListener						- Chapter 11, page 336
+//
+// Creates a script-side event listener, given an appropriate Lua function.
+bool EventManager::AddScriptListener( char const * const pEventName, LuaObject callbackFunction )
+{
+	//Ensure this event type exists.
+	const EventType testEventType( pEventName );
+	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
+	if ( m_typeList.end() == typeIter )
+	{
+		assert( 0 && "Attempted to listen to an event type that wasn't registered!" );
+		return false;
+	}
+
+	const unsigned int eventID = testEventType.getHashValue();
+
+	//OK, valid event type.  Make sure this isn't a duplicate.
+	ScriptEventListenerMap::const_iterator mapIter = m_ScriptEventListenerMap.find( eventID );
+	const ScriptEventListenerMap::const_iterator mapEnd = m_ScriptEventListenerMap.upper_bound( eventID );
+	while ( mapEnd != mapIter )
+	{
+		//Iterate through and ensure no duplicates.
+		const ScriptEventListenerPtr evtListener = mapIter->second;
+		const LuaObject & evtObj = evtListener->GetHandlerFunction();
+		if ( evtObj == callbackFunction )
+		{
+			assert( 0 && "Attempted to listen to the same event handler twice!" );
+			return false;
+		}
+		++mapIter;
+	}
+
+	//Now let's rez up a new script listener.
+	ScriptEventListenerPtr listener( GCC_NEW ScriptEventListener( callbackFunction ) );
+
+	m_ScriptEventListenerMap.insert( std::make_pair( eventID, listener ) );
+
+	const bool bSuccess = VAddListener( listener, testEventType );
+	return bSuccess;
+}
+
+//--
+// EventManager::RemoveScriptListener
+// Removes a script-side listener.
+bool EventManager::RemoveScriptListener( const char *const pEventName, LuaObject callbackFunction )
+{
+	//Ensure this event type exists.
+	const EventType testEventType( pEventName );
+	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
+	if ( m_typeList.end() == typeIter )
+	{
+		assert( 0 && "Attempted to remove a listener for an event type that doesn't exist!" );
+		return false;
+	}
+
+	const unsigned int eventID = testEventType.getHashValue();
+
+	//OK, now ensure it exists in the multimap.
+	bool bFound = false;
+	ScriptEventListenerMap::iterator mapIter = m_ScriptEventListenerMap.find( eventID );
+	const ScriptEventListenerMap::iterator mapEnd = m_ScriptEventListenerMap.upper_bound( eventID );
+	while ( mapEnd != mapIter )
+	{
+		const ScriptEventListenerPtr evtListener = mapIter->second;
+		const LuaObject & evtObj = evtListener->GetHandlerFunction();
+		if ( evtObj == callbackFunction )
+		{
+			bFound = true;
+			break;
+		}
+		++mapIter;
+	}
+
+	if ( false == bFound )
+	{
+		assert( 0 && "Attempted to remove a script listener for an event it was never listening for!" );
+		return false;
+	}
+
+	//Remove this listener from the map.
+	const ScriptEventListenerPtr listener = mapIter->second;
+	m_ScriptEventListenerMap.erase( mapIter );
+
+	//Now remove from the "main" listener set.
+	const bool bSuccess = VDelListener( listener, testEventType );
+	return bSuccess;
+}
+
+//--
+// EventManager::AddScriptActorListener					- Chapter 11, page 341
+// Creates a script-side *ACTOR* event listener, given an appropriate Lua function.
+bool EventManager::AddScriptActorListener( char const * const pEventName, LuaObject callbackFunction, const int actorID )
+{
+	//Ensure this event type exists.
+	const EventType testEventType( pEventName );
+	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
+	if ( m_typeList.end() == typeIter )
+	{
+		assert( 0 && "Attempted to listen to an event type that wasn't registered!" );
+		return false;
+	}
+
+	const unsigned int eventID = testEventType.getHashValue();
+
+	//OK, valid event type.  Make sure this isn't a duplicate.
+	ScriptActorEventListenerMap::const_iterator mapIter = m_ScriptActorEventListenerMap.find( eventID );
+	const ScriptActorEventListenerMap::const_iterator mapEnd = m_ScriptActorEventListenerMap.upper_bound( eventID );
+	while ( mapEnd != mapIter )
+	{
+		//Iterate through and ensure no duplicates.
+		const ScriptActorEventListenerPtr evtListener = mapIter->second;
+		const LuaObject & evtObj = evtListener->GetHandlerFunction();
+		if ( ( evtObj == callbackFunction ) && ( actorID == evtListener->GetActorID() ) )
+		{
+			assert( 0 && "Attempted to listen to the same event handler twice for a specific actor!" );
+			return false;
+		}
+		++mapIter;
+	}
+
+	//Now let's rez up a new script listener.
+	ScriptActorEventListenerPtr listener( GCC_NEW ScriptActorEventListener( callbackFunction, actorID ) );
+
+	m_ScriptActorEventListenerMap.insert( std::make_pair( eventID, listener ) );
+
+	const bool bSuccess = VAddListener( listener, testEventType );
+	return bSuccess;
+}
+
+//--
+// EventManager::RemoveScriptActorListener
+// Removes a script-side listener for a given actor.
+bool EventManager::RemoveScriptActorListener( const char *const pEventName, LuaObject callbackFunction, const int actorID )
+{
+	//Ensure this event type exists.
+	const EventType testEventType( pEventName );
+	const EventTypeSet::const_iterator typeIter = m_typeList.find( testEventType );
+	if ( m_typeList.end() == typeIter )
+	{
+		assert( 0 && "Attempted to remove a listener for an event type that doesn't exist!" );
+		return false;
+	}
+
+	const unsigned int eventID = testEventType.getHashValue();
+
+	//OK, now ensure it exists in the multimap.
+	bool bFound = false;
+	ScriptActorEventListenerMap::iterator mapIter = m_ScriptActorEventListenerMap.find( eventID );
+	const ScriptActorEventListenerMap::iterator mapEnd = m_ScriptActorEventListenerMap.upper_bound( eventID );
+	while ( mapEnd != mapIter )
+	{
+		const ScriptActorEventListenerPtr evtListener = mapIter->second;
+		const LuaObject & evtObj = evtListener->GetHandlerFunction();
+		if ( ( evtObj == callbackFunction ) && ( actorID == evtListener->GetActorID() ) )
+		{
+			bFound = true;
+			break;
+		}
+		++mapIter;
+	}
+
+	if ( false == bFound )
+	{
+		assert( 0 && "Attempted to remove a script listener for an actor event it was never listening for!" );
+		return false;
+	}
+
+	//Remove this listener from the map.
+	const ScriptActorEventListenerPtr listener = mapIter->second;
+	m_ScriptActorEventListenerMap.erase( mapIter );
+
+	//Now remove from the "main" listener set.
+	const bool bSuccess = VDelListener( listener, testEventType );
+	return bSuccess;
+}
+
+//--
+// EventManager::TriggerEventFromScript					- Chapter 11, page 3338
+
+bool EventManager::TriggerEventFromScript( char const * const pEventName, LuaObject luaEventData )
+{
+	const EventType eventType( pEventName );
+
+	//Look this event type up.
+	const EventTypeSet::const_iterator iter = m_typeList.find( eventType );
+	if ( iter == m_typeList.end() )
+	{
+		assert( 0 && "Attempted to trigger an event type that doesn't exist!" );
+		return false;
+	}
+
+	// Nobody to tell, and nothing to record - don't bother turning
+	// the table into an event.
+	if ( NULL == m_pJournal
+		&& m_registry.end() == m_registry.find( eventType.getHashValue() )
+		&& m_registry.end() == m_registry.find( 0 ) )
+	{
+		return false;
+	}
+
+	//This level of indirection lets us create code-side events or script-side events.
+	IRegisteredEventPtr regEvent = iter->second;
+	const bool bResult = regEvent->VTriggerEventFromScript( luaEventData );
+
+	return bResult;
+}
+
+
+// EventManager::RegisterScriptEventType			- Chapter 11, page 329
+void EventManager::RegisterScriptEventType( char const * const pEventName )
+{
+	//Create a new script-defined event object.
+	const EventType eventType( pEventName );
+	RegisterScriptEvent( eventType );
+}
+
+// EventManager::RegisterScriptEvent				- Chapter 11, page 329
+void EventManager::RegisterScriptEvent( const EventType & eventType )
+{
+	IRegisteredEventPtr metaData( GCC_NEW EventManager::ScriptDefinedEvent( eventType ) );
+	AddRegisteredEventType( eventType, metaData );
+}
+
+// EventManager::ScriptDefinedEvent::VTriggerEventFromScript		- Chapter 11, page 329
+bool EventManager::ScriptDefinedEvent::VTriggerEventFromScript( LuaObject & srcData ) const
+{
+	const EvtData_ScriptEvtData scriptEvent( m_EventType, srcData );
+	return safeTriggerEvent( scriptEvent );
+}
+
+bool EventManager::ScriptDefinedEvent::VQueueEventFromScript( LuaObject & srcData ) const
+{
+	//TODO JWC
+	return true;
+}
+
@@ -0,0 +1,460 @@
+//========================================================================
+// EventProfiler.cpp : Counts and timings for the event system
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventProfiler			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "EventProfiler.h"
+
+#include <algorithm>
+
+
+namespace
+{
+	// Event and listener names come from code and script, so
+	// they're escaped before they go in a JSON string.
+	void WriteJsonString( FILE * pFile, std::string const & str )
+	{
+		fputc( '"', pFile );
+		for ( std::string::const_iterator it = str.begin(), itEnd = str.end(); it != itEnd; it++ )
+		{
+			unsigned char const c = static_cast< unsigned char >( *it );
+			if ( c == '"' || c == '\\' )
+			{
+				fputc( '\\', pFile );
+				fputc( c, pFile );
+			}
+			else if ( c < 0x20 )
+			{
+				fprintf( pFile, "\\u%04x", c );
+			}
+			else
+			{
+				fputc( c, pFile );
+			}
+		}
+		fputc( '"', pFile );
+	}
+
+	bool SortByTotalTime( EventProfiler::ListenerStats const & a, EventProfiler::ListenerStats const & b )
+	{
+		return a.m_TotalTicks > b.m_TotalTicks;
+	}
+
+	bool SortByCount( EventProfiler::EventTypeStats const & a, EventProfiler::EventTypeStats const & b )
+	{
+		return a.m_Count > b.m_Count;
+	}
+}
+
+
+//
+// EventProfiler::EventProfiler
+//
+EventProfiler::EventProfiler()
+	: m_bEnabled( false )
+	, m_bCapturing( false )
+	, m_bEnabledBeforeCapture( false )
+	, m_MaxTraceEvents( 0 )
+	, m_CaptureStart( 0 )
+	, m_MainThreadId( GetCurrentThreadId() )
+{
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency( &freq );
+	m_Frequency = freq.QuadPart;
+
+	memset( &m_TickStats, 0, sizeof(m_TickStats) );
+}
+
+//
+// EventProfiler::Reset
+//
+void EventProfiler::Reset( void )
+{
+	ScopedCriticalSection locker( m_cs );
+
+	m_EventTypeStats.clear();
+	m_ListenerStats.clear();
+	memset( &m_TickStats, 0, sizeof(m_TickStats) );
+}
+
+//
+// EventProfiler::Now
+//
+EventProfiler::Ticks EventProfiler::Now( void )
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter( &now );
+	return now.QuadPart;
+}
+
+//
+// EventProfiler::TicksToMs
+//
+double EventProfiler::TicksToMs( Ticks ticks ) const
+{
+	return ( static_cast< double >( ticks ) * 1000.0 ) / static_cast< double >( m_Frequency );
+}
+
+//
+// EventProfiler::RecordEvent
+//
+void EventProfiler::RecordEvent( EventType const & eventType )
+{
+	ScopedCriticalSection locker( m_cs );
+
+	EventTypeStatsMap::iterator it = m_EventTypeStats.find( eventType.getHashValue() );
+
+	if ( it == m_EventTypeStats.end() )
+	{
+		EventTypeStats stats;
+		stats.m_Name = eventType.getStr();
+		stats.m_Count = 0;
+		it = m_EventTypeStats.insert( std::make_pair( eventType.getHashValue(), stats ) ).first;
+	}
+
+	++it->second.m_Count;
+}
+
+//
+// EventProfiler::RecordHandler
+//
+void EventProfiler::RecordHandler( IEventListener * pListener, EventType const & eventType,
+	Ticks start, Ticks end )
+{
+	Ticks const elapsed = end - start;
+
+	ScopedCriticalSection locker( m_cs );
+
+	ListenerStatsMap::iterator it = m_ListenerStats.find( pListener );
+
+	if ( it == m_ListenerStats.end() )
+	{
+		ListenerStats stats;
+		stats.m_Name = pListener->GetName();
+		stats.m_Calls = 0;
+		stats.m_TotalTicks = 0;
+		stats.m_MaxTicks = 0;
+		it = m_ListenerStats.insert( std::make_pair( pListener, stats ) ).first;
+	}
+
+	ListenerStats & stats = it->second;
+	++stats.m_Calls;
+	stats.m_TotalTicks += elapsed;
+	if ( elapsed > stats.m_MaxTicks )
+		stats.m_MaxTicks = elapsed;
+
+	if ( m_bCapturing )
+	{
+		TraceEvent traceEvent;
+		traceEvent.m_Kind = kTrace_Handler;
+		traceEvent.m_Start = start;
+		traceEvent.m_Duration = elapsed;
+		traceEvent.m_EventType = eventType.getHashValue();
+		traceEvent.m_pListener = pListener;
+		traceEvent.m_ThreadId = GetCurrentThreadId();
+		traceEvent.m_Value = 0;
+		AddTraceEvent( traceEvent );
+	}
+}
+
+//
+// EventProfiler::RecordTick
+//
+void EventProfiler::RecordTick( unsigned int queueDepth, unsigned int realtimeEvents,
+	Ticks tickStart, Ticks drainEnd, Ticks tickEnd )
+{
+	Ticks const drainTicks = drainEnd - tickStart;
+
+	ScopedCriticalSection locker( m_cs );
+
+	++m_TickStats.m_Ticks;
+	m_TickStats.m_LastQueueDepth = queueDepth;
+	if ( queueDepth > m_TickStats.m_MaxQueueDepth )
+		m_TickStats.m_MaxQueueDepth = queueDepth;
+
+	m_TickStats.m_RealtimeEvents += realtimeEvents;
+	m_TickStats.m_RealtimeDrainTicks += drainTicks;
+	if ( drainTicks > m_TickStats.m_MaxRealtimeDrainTicks )
+		m_TickStats.m_MaxRealtimeDrainTicks = drainTicks;
+
+	if ( m_bCapturing )
+	{
+		TraceEvent traceEvent;
+		traceEvent.m_EventType = 0;
+		traceEvent.m_pListener = NULL;
+		traceEvent.m_ThreadId = GetCurrentThreadId();
+
+		traceEvent.m_Kind = kTrace_Tick;
+		traceEvent.m_Start = tickStart;
+		traceEvent.m_Duration = tickEnd - tickStart;
+		traceEvent.m_Value = queueDepth;
+		AddTraceEvent( traceEvent );
+
+		traceEvent.m_Kind = kTrace_RealtimeDrain;
+		traceEvent.m_Duration = drainTicks;
+		traceEvent.m_Value = realtimeEvents;
+		AddTraceEvent( traceEvent );
+
+		traceEvent.m_Kind = kTrace_QueueDepth;
+		traceEvent.m_Duration = 0;
+		traceEvent.m_Value = queueDepth;
+		AddTraceEvent( traceEvent );
+	}
+}
+
+//
+// EventProfiler::AddTraceEvent
+//
+//   Called with m_cs held.
+//
+void EventProfiler::AddTraceEvent( TraceEvent const & traceEvent )
+{
+	if ( m_Trace.size() >= m_MaxTraceEvents )
+	{
+		// the capture is full - stop rather than wrap, so the
+		// timeline has no holes
+		StopCapture();
+		return;
+	}
+
+	m_Trace.push_back( traceEvent );
+}
+
+//
+// EventProfiler::StopCapture
+//
+//   Called with m_cs held. Puts m_bEnabled back as BeginCapture()
+//   found it, so the timing doesn't stay on for the rest of the
+//   session after one capture.
+//
+void EventProfiler::StopCapture( void )
+{
+	if ( !m_bCapturing )
+		return;
+
+	m_bCapturing = false;
+	m_bEnabled = m_bEnabledBeforeCapture;
+}
+
+//
+// EventProfiler::BeginCapture
+//
+void EventProfiler::BeginCapture( unsigned int maxTraceEvents )
+{
+	ScopedCriticalSection locker( m_cs );
+
+	// a capture that's started over keeps what was there before the
+	// first one
+	if ( !m_bCapturing )
+		m_bEnabledBeforeCapture = m_bEnabled;
+
+	m_Trace.clear();
+	m_MaxTraceEvents = maxTraceEvents;
+	m_CaptureStart = Now();
+	m_bCapturing = true;
+	m_bEnabled = true;
+}
+
+//
+// EventProfiler::EndCapture
+//
+void EventProfiler::EndCapture( void )
+{
+	ScopedCriticalSection locker( m_cs );
+
+	StopCapture();
+}
+
+//
+// EventProfiler::WriteTrace
+//
+//   Writes the Chrome trace event format - an object holding a
+//   "traceEvents" array of complete ("X") and counter ("C")
+//   events, with timestamps in microseconds from BeginCapture().
+//
+bool EventProfiler::WriteTrace( char const * const pFileName ) const
+{
+	ScopedCriticalSection locker( m_cs );
+
+	FILE * pFile = fopen( pFileName, "w" );
+	if ( !pFile )
+		return false;
+
+	double const usPerTick = 1000000.0 / static_cast< double >( m_Frequency );
+
+	fprintf( pFile, "{\"traceEvents\":[\n" );
+
+	// name the main thread so it sorts first and reads well
+	fprintf( pFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"Main\"}}",
+		static_cast< unsigned long >( m_MainThreadId ) );
+
+	for ( TraceEventList::const_iterator it = m_Trace.begin(), itEnd = m_Trace.end(); it != itEnd; it++ )
+	{
+		TraceEvent const & traceEvent = *it;
+
+		double const ts = static_cast< double >( traceEvent.m_Start - m_CaptureStart ) * usPerTick;
+		double const dur = static_cast< double >( traceEvent.m_Duration ) * usPerTick;
+		unsigned long const tid = static_cast< unsigned long >( traceEvent.m_ThreadId );
+
+		fprintf( pFile, ",\n" );
+
+		switch ( traceEvent.m_Kind )
+		{
+			case kTrace_Handler:
+			{
+				EventTypeStatsMap::const_iterator itType = m_EventTypeStats.find( traceEvent.m_EventType );
+				ListenerStatsMap::const_iterator itListener = m_ListenerStats.find( traceEvent.m_pListener );
+
+				fprintf( pFile, "{\"name\":" );
+				WriteJsonString( pFile, ( itType != m_EventTypeStats.end() ) ? itType->second.m_Name : std::string( "?" ) );
+				fprintf( pFile, ",\"cat\":\"event\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"listener\":",
+					ts, dur, tid );
+				WriteJsonString( pFile, ( itListener != m_ListenerStats.end() ) ? itListener->second.m_Name : std::string( "?" ) );
+				fprintf( pFile, "}}" );
+				break;
+			}
+
+			case kTrace_Tick:
+				fprintf( pFile, "{\"name\":\"VTick\",\"cat\":\"eventmgr\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"queueDepth\":%u}}",
+					ts, dur, tid, traceEvent.m_Value );
+				break;
+
+			case kTrace_RealtimeDrain:
+				fprintf( pFile, "{\"name\":\"RealtimeDrain\",\"cat\":\"eventmgr\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"events\":%u}}",
+					ts, dur, tid, traceEvent.m_Value );
+				break;
+
+			case kTrace_QueueDepth:
+				fprintf( pFile, "{\"name\":\"QueueDepth\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"depth\":%u}}",
+					ts, traceEvent.m_Value );
+				break;
+		}
+	}
+
+	fprintf( pFile, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+
+	bool const bOk = ( ferror( pFile ) == 0 );
+	fclose( pFile );
+	return bOk;
+}
+
+//
+// EventProfiler::GetEventTypeStats
+//
+//   Busiest event types first.
+//
+void EventProfiler::GetEventTypeStats( std::vector< EventTypeStats > & stats ) const
+{
+	ScopedCriticalSection locker( m_cs );
+
+	stats.clear();
+	stats.reserve( m_EventTypeStats.size() );
+	for ( EventTypeStatsMap::const_iterator it = m_EventTypeStats.begin(), itEnd = m_EventTypeStats.end(); it != itEnd; it++ )
+		stats.push_back( it->second );
+
+	std::sort( stats.begin(), stats.end(), SortByCount );
+}
+
+//
+// EventProfiler::GetListenerStats
+//
+//   Most expensive listeners first.
+//
+void EventProfiler::GetListenerStats( std::vector< ListenerStats > & stats ) const
+{
+	ScopedCriticalSection locker( m_cs );
+
+	stats.clear();
+	stats.reserve( m_ListenerStats.size() );
+	for ( ListenerStatsMap::const_iterator it = m_ListenerStats.begin(), itEnd = m_ListenerStats.end(); it != itEnd; it++ )
+		stats.push_back( it->second );
+
+	std::sort( stats.begin(), stats.end(), SortByTotalTime );
+}
+
+//
+// EventProfiler::GetTickStats
+//
+EventProfiler::TickStats EventProfiler::GetTickStats( void ) const
+{
+	ScopedCriticalSection locker( m_cs );
+
+	return m_TickStats;
+}
+
+//
+// EventProfiler::DumpStats
+//
+void EventProfiler::DumpStats( void ) const
+{
+	std::vector< EventTypeStats > typeStats;
+	std::vector< ListenerStats > listenerStats;
+	GetEventTypeStats( typeStats );
+	GetListenerStats( listenerStats );
+	TickStats const tickStats = GetTickStats();
+
+	char buffer[512];
+
+	OutputDebugStringA( "---- Event Profiler ----\n" );
+
+	_snprintf( buffer, sizeof(buffer)-1,
+		"Ticks %u : queue depth last %u max %u : realtime events %u drain total %.3fms max %.3fms\n",
+		tickStats.m_Ticks, tickStats.m_LastQueueDepth, tickStats.m_MaxQueueDepth,
+		tickStats.m_RealtimeEvents, TicksToMs( tickStats.m_RealtimeDrainTicks ),
+		TicksToMs( tickStats.m_MaxRealtimeDrainTicks ) );
+	buffer[sizeof(buffer)-1] = 0;
+	OutputDebugStringA( buffer );
+
+	for ( std::vector< EventTypeStats >::const_iterator it = typeStats.begin(); it != typeStats.end(); it++ )
+	{
+		_snprintf( buffer, sizeof(buffer)-1, "  event %-40s %8u\n", it->m_Name.c_str(), it->m_Count );
+		buffer[sizeof(buffer)-1] = 0;
+		OutputDebugStringA( buffer );
+	}
+
+	for ( std::vector< ListenerStats >::const_iterator it = listenerStats.begin(); it != listenerStats.end(); it++ )
+	{
+		_snprintf( buffer, sizeof(buffer)-1, "  listener %-37s %8u calls  total %9.3fms  max %7.3fms\n",
+			it->m_Name.c_str(), it->m_Calls, TicksToMs( it->m_TotalTicks ), TicksToMs( it->m_MaxTicks ) );
+		buffer[sizeof(buffer)-1] = 0;
+		OutputDebugStringA( buffer );
+	}
+}
@@ -0,0 +1,186 @@
+#pragma once
+//========================================================================
+// EventProfiler.h : Counts and timings for the event system
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventProfiler			- not in the book
+//========================================================================
+
+#include <vector>
+#include <boost/unordered_map.hpp>
+#include "EventManager.h"
+
+
+// EventProfiler Description
+//
+// Timing and counting for the EventManager. It's always compiled
+// in, but does nothing until it's enabled - the EventManager checks
+// IsEnabled() before it reads a clock, so the cost when it's off is
+// one branch per listener call.
+//
+// While enabled it keeps running totals:
+//
+//	- how many times each event type was dispatched
+//	- calls, total and worst time for each listener
+//	- queue depth at each VTick() and time spent draining the
+//	  realtime queue
+//
+// Between BeginCapture() and EndCapture() it also keeps a timeline,
+// which WriteTrace() saves in the Chrome trace format - load it in
+// chrome://tracing. The timeline is capped so a forgotten capture
+// can't eat all the memory.
+//
+// Parallel-safe listeners report from worker threads, so the
+// Record functions lock.
+
+class EventProfiler : public boost::noncopyable
+{
+public:
+	typedef LONGLONG Ticks;
+
+	enum { kDefaultMaxTraceEvents = 256 * 1024 };
+
+	struct EventTypeStats
+	{
+		std::string  m_Name;
+		unsigned int m_Count;
+	};
+
+	struct ListenerStats
+	{
+		std::string  m_Name;
+		unsigned int m_Calls;
+		Ticks        m_TotalTicks;
+		Ticks        m_MaxTicks;
+	};
+
+	struct TickStats
+	{
+		unsigned int m_Ticks;				// VTick() calls seen
+		unsigned int m_LastQueueDepth;		// events waiting at the last VTick()
+		unsigned int m_MaxQueueDepth;
+		unsigned int m_RealtimeEvents;		// pulled off the realtime queue
+		Ticks        m_RealtimeDrainTicks;	// time spent pulling them
+		Ticks        m_MaxRealtimeDrainTicks;
+	};
+
+	EventProfiler();
+
+	void SetEnabled( bool enabled ) { m_bEnabled = enabled; }
+	bool IsEnabled( void ) const { return m_bEnabled; }
+
+	// Clears the running totals, but not a capture in progress.
+	void Reset( void );
+
+	static Ticks Now( void );
+	double TicksToMs( Ticks ticks ) const;
+
+	// --- called by the EventManager ---
+
+	void RecordEvent( EventType const & eventType );
+	void RecordHandler( IEventListener * pListener, EventType const & eventType,
+		Ticks start, Ticks end );
+	void RecordTick( unsigned int queueDepth, unsigned int realtimeEvents,
+		Ticks tickStart, Ticks drainEnd, Ticks tickEnd );
+
+	// --- capture window ---
+
+	// Starts a new timeline, dropping any previous one. Turns the
+	// profiler on if it wasn't already, and EndCapture() - or the
+	// timeline filling up - turns it back off.
+	void BeginCapture( unsigned int maxTraceEvents = kDefaultMaxTraceEvents );
+	void EndCapture( void );
+	bool IsCapturing( void ) const { return m_bCapturing; }
+
+	// Writes the last capture as Chrome trace JSON.
+	bool WriteTrace( char const * const pFileName ) const;
+
+	// --- reporting ---
+
+	void GetEventTypeStats( std::vector< EventTypeStats > & stats ) const;
+	void GetListenerStats( std::vector< ListenerStats > & stats ) const;
+	TickStats GetTickStats( void ) const;
+
+	// Sends a summary to the debugger output.
+	void DumpStats( void ) const;
+
+private:
+	enum eTraceKind
+	{
+		kTrace_Handler,
+		kTrace_Tick,
+		kTrace_RealtimeDrain,
+		kTrace_QueueDepth
+	};
+
+	struct TraceEvent
+	{
+		eTraceKind      m_Kind;
+		Ticks           m_Start;
+		Ticks           m_Duration;
+		unsigned long   m_EventType;	// kTrace_Handler
+		IEventListener *m_pListener;	// kTrace_Handler
+		DWORD           m_ThreadId;
+		unsigned int    m_Value;		// kTrace_QueueDepth
+	};
+
+	void AddTraceEvent( TraceEvent const & traceEvent );
+	void StopCapture( void );
+
+	typedef boost::unordered_map< unsigned long, EventTypeStats >		EventTypeStatsMap;
+	typedef boost::unordered_map< IEventListener *, ListenerStats >	ListenerStatsMap;
+	typedef std::vector< TraceEvent >									TraceEventList;
+
+	volatile bool     m_bEnabled;
+	volatile bool     m_bCapturing;
+	bool              m_bEnabledBeforeCapture;
+	Ticks             m_Frequency;
+
+	EventTypeStatsMap m_EventTypeStats;
+	ListenerStatsMap  m_ListenerStats;	// keyed on the listener object, so
+										// two listeners with the same name
+										// are kept apart
+	TickStats         m_TickStats;
+
+	TraceEventList    m_Trace;
+	unsigned int      m_MaxTraceEvents;
+	Ticks             m_CaptureStart;
+	DWORD             m_MainThreadId;
+
+	mutable CriticalSection m_cs;
+};
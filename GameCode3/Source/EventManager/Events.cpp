@@ -40,6 +40,7 @@
 #include "GameCodeStd.h"
 
 #include "Events.h"
+#include "EventFactory.h"
 
 const EventType EvtData_New_Game::sk_EventType( "new_game" );
 const EventType EvtData_New_Actor::sk_EventType( "new_actor" );
@@ -110,6 +111,51 @@ ActorParams *ActorParams::CreateFromStream(std::istrstream &in)
 
 }
 
+//
+// ActorParams::CreateFromBinaryStream
+//
+//   The binary twin of CreateFromStream(). The bytes may have come
+//   off the wire, so nonsense fails the stream rather than asserting.
+//
+ActorParams *ActorParams::CreateFromBinaryStream(BinaryInStream &in)
+{
+	ActorParams *actor = NULL;
+	switch (in.ReadI32())
+	{
+		case AT_Sphere:
+			actor = GCC_NEW SphereParams;
+			break;
+
+		case AT_Teapot:
+			actor = GCC_NEW TeapotParams;
+			break;
+
+		case AT_TestObject:
+			actor = GCC_NEW TestObjectParams;
+			break;
+
+		case AT_Grid:
+			actor = GCC_NEW GridParams;
+			break;
+
+		case AT_GenericMeshObject:
+			actor = GCC_NEW GenericMeshObjectParams;
+			break;
+
+		default:
+			in.SetFailed();
+			return NULL;
+	}
+
+	if (! actor->VInitBinary(in))
+	{
+		in.SetFailed();
+		SAFE_DELETE(actor);
+	}
+
+	return actor;
+}
+
 //
 // ActorParams::CreateFromLuaObj				- Chapter 19, page 688 
 //
@@ -185,3 +231,491 @@ ActorParams * ActorParams::CreateFromLuaObj( LuaObject srcData )
 
 	return pActorParams;
 }
+
+
+//
+// Lua tables in binary form
+//
+//   Every pair is a tagged key followed by a tagged value, and a
+//   kLuaTag_End closes the table. Booleans, numbers, strings and
+//   tables go through; functions, userdata and the like mean nothing
+//   in another process, so those pairs are left out.
+//
+namespace
+{
+	enum eLuaBinaryTag
+	{
+		kLuaTag_End = 0,
+		kLuaTag_Boolean,
+		kLuaTag_Number,
+		kLuaTag_String,
+		kLuaTag_Table
+	};
+
+	// deep enough for any actor def, shallow enough that a cycle
+	// ( t.self = t ) can't run away
+	const int kMaxLuaTableDepth = 16;
+
+	unsigned char GetLuaBinaryTag( LuaObject & obj, int depth )
+	{
+		if ( obj.IsBoolean() )
+			return kLuaTag_Boolean;
+		if ( obj.IsNumber() )
+			return kLuaTag_Number;
+		if ( obj.IsString() )
+			return kLuaTag_String;
+		if ( obj.IsTable() && depth + 1 < kMaxLuaTableDepth )
+			return kLuaTag_Table;
+		return kLuaTag_End;
+	}
+
+	void WriteLuaTable( BinaryOutStream & out, LuaObject & table, int depth );
+
+	void WriteLuaValue( BinaryOutStream & out, LuaObject & obj, unsigned char tag, int depth )
+	{
+		out.WriteU8( tag );
+		switch ( tag )
+		{
+			case kLuaTag_Boolean:
+				out.WriteBool( obj.GetBoolean() );
+				break;
+			case kLuaTag_Number:
+				out.WriteDouble( obj.GetNumber() );
+				break;
+			case kLuaTag_String:
+				out.WriteString( obj.GetString() );
+				break;
+			case kLuaTag_Table:
+				WriteLuaTable( out, obj, depth + 1 );
+				break;
+		}
+	}
+
+	void WriteLuaTable( BinaryOutStream & out, LuaObject & table, int depth )
+	{
+		for ( LuaTableIterator it( table ); it; it.Next() )
+		{
+			LuaObject key = it.GetKey();
+			LuaObject value = it.GetValue();
+
+			unsigned char const keyTag = GetLuaBinaryTag( key, depth );
+			unsigned char const valueTag = GetLuaBinaryTag( value, depth );
+			if ( ( keyTag != kLuaTag_Number && keyTag != kLuaTag_String ) || valueTag == kLuaTag_End )
+				continue;
+
+			WriteLuaValue( out, key, keyTag, depth );
+			WriteLuaValue( out, value, valueTag, depth );
+		}
+		out.WriteU8( kLuaTag_End );
+	}
+
+	void ReadLuaTable( BinaryInStream & in, LuaState * pState, LuaObject & table, int depth );
+
+	bool ReadLuaValue( BinaryInStream & in, LuaState * pState, unsigned char tag, LuaObject & obj, int depth )
+	{
+		switch ( tag )
+		{
+			case kLuaTag_Boolean:
+				obj.AssignBoolean( pState, in.ReadBool() );
+				return true;
+
+			case kLuaTag_Number:
+				obj.AssignNumber( pState, in.ReadDouble() );
+				return true;
+
+			case kLuaTag_String:
+			{
+				std::string str;
+				in.ReadString( str );
+				obj.AssignString( pState, str.c_str() );
+				return true;
+			}
+
+			case kLuaTag_Table:
+				if ( depth + 1 >= kMaxLuaTableDepth )
+					break;
+				obj.AssignNewTable( pState );
+				ReadLuaTable( in, pState, obj, depth + 1 );
+				return true;
+		}
+
+		in.SetFailed();
+		return false;
+	}
+
+	void ReadLuaTable( BinaryInStream & in, LuaState * pState, LuaObject & table, int depth )
+	{
+		// a failed stream reads zeros, which is kLuaTag_End
+		unsigned char keyTag;
+		while ( kLuaTag_End != ( keyTag = in.ReadU8() ) )
+		{
+			LuaObject key, value;
+			if ( !ReadLuaValue( in, pState, keyTag, key, depth )
+				|| !ReadLuaValue( in, pState, in.ReadU8(), value, depth ) )
+			{
+				return;
+			}
+			table.SetObject( key, value );
+		}
+	}
+}
+
+//
+// SerializeLuaTableBinary
+//
+void SerializeLuaTableBinary( BinaryOutStream & out, LuaObject table )
+{
+	out.WriteBool( table.IsTable() );
+	if ( table.IsTable() )
+	{
+		WriteLuaTable( out, table, 0 );
+	}
+}
+
+//
+// DeserializeLuaTableBinary
+//
+LuaObject DeserializeLuaTableBinary( BinaryInStream & in )
+{
+	LuaObject table;
+	if ( in.ReadBool() )
+	{
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
+		table.AssignNewTable( pState );
+		ReadLuaTable( in, pState, table, 0 );
+	}
+	return table;
+}
+
+
+//
+// testEventSerialization					- not in the book
+//
+//   Encode and decode rates for each event type, VSerialize() text
+//   against VSerializeBinary(). Decoding goes through the
+//   EventFactory, so it includes building the event, just as the
+//   network and the journal player would. Each type is also decoded
+//   once more from each form and checked field by field against the
+//   original. Results go to the debugger output.
+//
+namespace
+{
+	const int kSerializationIterations = 20000;
+
+	double EventsPerSecond( LARGE_INTEGER const & start, LARGE_INTEGER const & end, LARGE_INTEGER const & frequency )
+	{
+		LONGLONG const ticks = end.QuadPart - start.QuadPart;
+		return ticks > 0 ? double( kSerializationIterations ) * frequency.QuadPart / ticks : 0.0;
+	}
+
+	void BenchmarkEventSerialization( IEventData const & event )
+	{
+		unsigned long const eventType = event.VGetEventType().getHashValue();
+		LARGE_INTEGER frequency, start, end;
+		QueryPerformanceFrequency( &frequency );
+
+		double textEncode = 0.0, textDecode = 0.0;
+		unsigned int textSize = 0;
+		if ( EventFactory::CanCreate( eventType ) )
+		{
+			QueryPerformanceCounter( &start );
+			for ( int i = 0; i < kSerializationIterations; ++i )
+			{
+				std::ostrstream out;
+				event.VSerialize( out );
+				textSize = static_cast< unsigned int >( out.pcount() );
+			}
+			QueryPerformanceCounter( &end );
+			textEncode = EventsPerSecond( start, end, frequency );
+
+			std::ostrstream out;
+			event.VSerialize( out );
+			std::string const text( out.str(), out.pcount() );
+			out.freeze( false );
+
+			QueryPerformanceCounter( &start );
+			for ( int i = 0; i < kSerializationIterations; ++i )
+			{
+				std::istrstream in( text.c_str(), static_cast< std::streamsize >( text.length() ) );
+				IEventDataPtr copy = EventFactory::CreateFromStream( eventType, in );
+			}
+			QueryPerformanceCounter( &end );
+			textDecode = EventsPerSecond( start, end, frequency );
+		}
+
+		double binaryEncode = 0.0, binaryDecode = 0.0;
+		BinaryOutStream out;
+		QueryPerformanceCounter( &start );
+		for ( int i = 0; i < kSerializationIterations; ++i )
+		{
+			out.Clear();
+			event.VSerializeBinary( out );
+		}
+		QueryPerformanceCounter( &end );
+		binaryEncode = EventsPerSecond( start, end, frequency );
+
+		bool binaryOk = EventFactory::CanCreateFromBinary( eventType );
+		if ( binaryOk )
+		{
+			QueryPerformanceCounter( &start );
+			for ( int i = 0; i < kSerializationIterations && binaryOk; ++i )
+			{
+				BinaryInStream in( out.GetData(), out.GetSize() );
+				binaryOk = ( NULL != EventFactory::CreateFromBinary( eventType, in ) );
+			}
+			QueryPerformanceCounter( &end );
+			binaryDecode = EventsPerSecond( start, end, frequency );
+		}
+
+		char buffer[512];
+		_snprintf( buffer, sizeof(buffer)-1,
+			"  %-24s text %4u bytes enc %9.0f/s dec %9.0f/s   binary %4u bytes enc %9.0f/s dec %9.0f/s%s\n",
+			event.VGetEventType().getStr().c_str(),
+			textSize, textEncode, textDecode,
+			out.GetSize(), binaryEncode, binaryDecode,
+			binaryOk ? "" : "  ( DECODE FAILED )" );
+		buffer[sizeof(buffer)-1] = 0;
+		OutputDebugStringA( buffer );
+	}
+
+	// --- field by field, for CheckRoundTrip() ---
+
+	bool SameMat( Mat4x4 const & a, Mat4x4 const & b )
+	{
+		for ( int i = 0; i < 4; ++i )
+			for ( int j = 0; j < 4; ++j )
+				if ( a.m[i][j] != b.m[i][j] )
+					return false;
+		return true;
+	}
+
+	bool SameLuaTables( LuaObject a, LuaObject b );
+
+	bool SameLuaValues( LuaObject a, LuaObject b )
+	{
+		if ( a.IsTable() || b.IsTable() )
+			return a.IsTable() && b.IsTable() && SameLuaTables( a, b );
+		if ( a.IsNumber() || b.IsNumber() )
+			return a.IsNumber() && b.IsNumber() && a.GetNumber() == b.GetNumber();
+		if ( a.IsString() || b.IsString() )
+			return a.IsString() && b.IsString() && 0 == strcmp( a.GetString(), b.GetString() );
+		if ( a.IsBoolean() || b.IsBoolean() )
+			return a.IsBoolean() && b.IsBoolean() && a.GetBoolean() == b.GetBoolean();
+		return a.IsNil() && b.IsNil();
+	}
+
+	// Every key of one is in the other, with the same value.
+	bool SameLuaTables( LuaObject a, LuaObject b )
+	{
+		if ( !a.IsTable() || !b.IsTable() )
+			return a.IsTable() == b.IsTable();
+
+		int countA = 0, countB = 0;
+		for ( LuaTableIterator it( b ); it; it.Next() )
+			++countB;
+		for ( LuaTableIterator it( a ); it; it.Next() )
+		{
+			++countA;
+			LuaObject key = it.GetKey();
+			LuaObject other = key.IsString() ? b[ key.GetString() ] : b[ key.GetInteger() ];
+			if ( !SameLuaValues( it.GetValue(), other ) )
+				return false;
+		}
+		return countA == countB;
+	}
+
+	bool SameParams( ActorParams const * pA, ActorParams const * pB )
+	{
+		if ( !pA || !pB )
+			return pA == pB;
+
+		if ( pA->m_Size != pB->m_Size || pA->m_Type != pB->m_Type
+			|| pA->m_Id.valid() != pB->m_Id.valid() || ( pA->m_Id.valid() && *pA->m_Id != *pB->m_Id )
+			|| pA->m_Pos.x != pB->m_Pos.x || pA->m_Pos.y != pB->m_Pos.y || pA->m_Pos.z != pB->m_Pos.z
+			|| pA->m_Color.r != pB->m_Color.r || pA->m_Color.g != pB->m_Color.g
+			|| pA->m_Color.b != pB->m_Color.b || pA->m_Color.a != pB->m_Color.a
+			|| strcmp( pA->m_OnCreateLuaFunctionName, pB->m_OnCreateLuaFunctionName )
+			|| strcmp( pA->m_OnDestroyLuaFunctionName, pB->m_OnDestroyLuaFunctionName ) )
+			return false;
+
+		if ( pA->m_Type == AT_Teapot )
+		{
+			TeapotParams const * pTeapotA = static_cast< TeapotParams const * >( pA );
+			TeapotParams const * pTeapotB = static_cast< TeapotParams const * >( pB );
+			return pTeapotA->m_Length == pTeapotB->m_Length && pTeapotA->m_ViewId == pTeapotB->m_ViewId
+				&& SameMat( pTeapotA->m_Mat, pTeapotB->m_Mat );
+		}
+		return true;
+	}
+
+	bool SameFields( EmptyEventData const & a, EmptyEventData const & b )
+	{
+		return true;
+	}
+
+	bool SameFields( EvtData_New_Actor const & a, EvtData_New_Actor const & b )
+	{
+		return a.m_id == b.m_id && SameParams( a.m_pActorParams, b.m_pActorParams );
+	}
+
+	bool SameFields( EvtData_Destroy_Actor const & a, EvtData_Destroy_Actor const & b )
+	{
+		return a.m_id == b.m_id;
+	}
+
+	bool SameFields( EvtData_Move_Actor const & a, EvtData_Move_Actor const & b )
+	{
+		return a.m_Id == b.m_Id && SameMat( a.m_Mat, b.m_Mat );
+	}
+
+	bool SameFields( EvtData_Game_State const & a, EvtData_Game_State const & b )
+	{
+		return a.m_gameState == b.m_gameState;
+	}
+
+	bool SameFields( EvtData_Remote_Client const & a, EvtData_Remote_Client const & b )
+	{
+		return a.m_socketId == b.m_socketId && a.m_ipAddress == b.m_ipAddress;
+	}
+
+	bool SameFields( EvtData_Update_Tick const & a, EvtData_Update_Tick const & b )
+	{
+		return a.m_DeltaMilliseconds == b.m_DeltaMilliseconds;
+	}
+
+	bool SameFields( EvtData_Debug_String const & a, EvtData_Debug_String const & b )
+	{
+		return a.m_DebugMessage == b.m_DebugMessage && a.m_Type == b.m_Type;
+	}
+
+	bool SameFields( EvtData_Network_Player_Actor_Assignment const & a, EvtData_Network_Player_Actor_Assignment const & b )
+	{
+		return a.m_actorId == b.m_actorId && a.m_remotePlayerId == b.m_remotePlayerId;
+	}
+
+	bool SameFields( EvtData_Decompress_Request const & a, EvtData_Decompress_Request const & b )
+	{
+		return a.m_zipFileName == b.m_zipFileName && a.m_fileName == b.m_fileName;
+	}
+
+	// m_buffer isn't sent
+	bool SameFields( EvtData_Decompression_Progress const & a, EvtData_Decompression_Progress const & b )
+	{
+		return a.m_progress == b.m_progress && a.m_zipFileName == b.m_zipFileName && a.m_fileName == b.m_fileName;
+	}
+
+	// The params if it came from code, the table if it came from script.
+	bool SameFields( EvtData_Request_New_Actor const & a, EvtData_Request_New_Actor const & b )
+	{
+		if ( a.m_pActorParams || b.m_pActorParams )
+			return SameParams( a.m_pActorParams, b.m_pActorParams );
+		return SameLuaTables( a.VGetLuaEventData(), b.VGetLuaEventData() );
+	}
+
+	bool SameFields( EvtData_Fire_Weapon const & a, EvtData_Fire_Weapon const & b )
+	{
+		return a.m_id == b.m_id;
+	}
+
+	bool SameFields( EvtData_Thrust const & a, EvtData_Thrust const & b )
+	{
+		return a.m_id == b.m_id && a.m_throttle == b.m_throttle;
+	}
+
+	bool SameFields( EvtData_Steer const & a, EvtData_Steer const & b )
+	{
+		return a.m_id == b.m_id && a.m_dir == b.m_dir;
+	}
+
+	bool SameFields( EvtData_UpdateActorParams const & a, EvtData_UpdateActorParams const & b )
+	{
+		return a.m_ActorID == b.m_ActorID && SameLuaTables( a.VGetLuaEventData(), b.VGetLuaEventData() );
+	}
+
+	//
+	// Decodes the event from each form the EventFactory can build it
+	// from, and compares every field with the original's.
+	//
+	template < class T >
+	void CheckRoundTrip( T const & event )
+	{
+		unsigned long const eventType = event.VGetEventType().getHashValue();
+
+		char const * pText = "n/a";
+		if ( EventFactory::CanCreate( eventType ) )
+		{
+			std::ostrstream out;
+			event.VSerialize( out );
+			std::string const text( out.str(), out.pcount() );
+			out.freeze( false );
+
+			std::istrstream in( text.c_str(), static_cast< std::streamsize >( text.length() ) );
+			IEventDataPtr copy = EventFactory::CreateFromStream( eventType, in );
+			pText = ( copy && SameFields( event, static_cast< T const & >( *copy ) ) ) ? "ok" : "MISMATCH";
+		}
+
+		char const * pBinary = "n/a";
+		if ( EventFactory::CanCreateFromBinary( eventType ) )
+		{
+			BinaryOutStream out;
+			event.VSerializeBinary( out );
+
+			BinaryInStream in( out.GetData(), out.GetSize() );
+			IEventDataPtr copy = EventFactory::CreateFromBinary( eventType, in );
+			pBinary = ( copy && in.IsOk() && SameFields( event, static_cast< T const & >( *copy ) ) ) ? "ok" : "MISMATCH";
+		}
+
+		char buffer[512];
+		_snprintf( buffer, sizeof(buffer)-1, "  %-24s round trip text %s, binary %s\n",
+			event.VGetEventType().getStr().c_str(), pText, pBinary );
+		buffer[sizeof(buffer)-1] = 0;
+		OutputDebugStringA( buffer );
+	}
+
+	template < class T >
+	void CheckEventSerialization( T const & event )
+	{
+		BenchmarkEventSerialization( event );
+		CheckRoundTrip( event );
+	}
+}
+
+void testEventSerialization()
+{
+	OutputDebugStringA( "---- Event Serialization ----\n" );
+
+	Mat4x4 mat;
+	mat.BuildTranslation( Vec3( 1.0f, 2.0f, 3.0f ) );
+
+	TeapotParams teapotParams;
+	teapotParams.m_Id = 7;
+	teapotParams.m_Mat = mat;
+	// The text form can't carry an empty function name.
+	strcpy( teapotParams.m_OnCreateLuaFunctionName, "OnCreateTeapot" );
+	strcpy( teapotParams.m_OnDestroyLuaFunctionName, "OnDestroyTeapot" );
+
+	LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
+	LuaObject actorParams;
+	actorParams.AssignNewTable( pState );
+	actorParams.SetInteger( "ActorID", 7 );
+	actorParams.SetNumber( "Radius", 2.5 );
+	actorParams.SetString( "OnCreateFunc", "OnCreateSphere" );
+
+	CheckEventSerialization( EvtData_New_Actor( 7, &teapotParams ) );
+	CheckEventSerialization( EvtData_Destroy_Actor( 7 ) );
+	CheckEventSerialization( EvtData_Move_Actor( 7, mat ) );
+	CheckEventSerialization( EvtData_New_Game() );
+	CheckEventSerialization( EvtData_Request_Start_Game() );
+	CheckEventSerialization( EvtData_Game_State( BGS_Running ) );
+	CheckEventSerialization( EvtData_Remote_Client( 3, 0x7f000001 ) );
+	CheckEventSerialization( EvtData_Update_Tick( 16 ) );
+	CheckEventSerialization( EvtData_Debug_String( "Lorem ipsum dolor sit amet", EvtData_Debug_String::kDST_ScriptMsg ) );
+	CheckEventSerialization( EvtData_Network_Player_Actor_Assignment( 7, 2 ) );
+	CheckEventSerialization( EvtData_Decompress_Request( L"big.zip", "big.dat" ) );
+	CheckEventSerialization( EvtData_Decompression_Progress( 50, L"big.zip", "big.dat", NULL ) );
+	CheckEventSerialization( EvtData_Request_New_Actor( &teapotParams ) );
+	CheckEventSerialization( EvtData_Fire_Weapon( 7 ) );
+	CheckEventSerialization( EvtData_Thrust( 7, 0.5f ) );
+	CheckEventSerialization( EvtData_Steer( 7, -0.25f ) );
+	CheckEventSerialization( EvtData_UpdateActorParams( actorParams ) );
+}
@@ -56,6 +56,11 @@
 #include "../GameCode.h"
 #include "../Actors.h"
 
+// Script tables in binary form, for the events below that carry one.
+// Only booleans, numbers, strings and nested tables survive.
+void SerializeLuaTableBinary( BinaryOutStream & out, LuaObject table );
+LuaObject DeserializeLuaTableBinary( BinaryInStream & in );
+
 // Auxillary data decls ...
 //
 // data that is passed per-event in the userData parameter
@@ -89,6 +94,12 @@ struct EvtData_New_Actor : public BaseEventData
 		m_pActorParams = ActorParams::CreateFromStream( in );
 	}
 
+	explicit EvtData_New_Actor( BinaryInStream & in )
+	{
+		m_id = in.ReadU32();
+		m_pActorParams = ActorParams::CreateFromBinaryStream( in );
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr( GCC_NEW EvtData_New_Actor( m_id, m_pActorParams ) );
@@ -110,7 +121,7 @@ struct EvtData_New_Actor : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -132,6 +143,12 @@ struct EvtData_New_Actor : public BaseEventData
 		m_pActorParams->VSerialize(out);
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteU32( m_id );
+		m_pActorParams->VSerializeBinary( out );
+	}
+
 	ActorId m_id;	//ID of actor created
 	ActorParams *m_pActorParams;	//Parameters for actor
 
@@ -159,6 +176,11 @@ struct EvtData_Destroy_Actor : public BaseEventData
 		in >> m_id;
 	}
 
+	explicit EvtData_Destroy_Actor( BinaryInStream & in )
+		: m_id( in.ReadU32() )
+	{
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_Destroy_Actor ( m_id ) );
@@ -177,7 +199,7 @@ struct EvtData_Destroy_Actor : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -191,6 +213,11 @@ struct EvtData_Destroy_Actor : public BaseEventData
 		out << m_id;
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteU32( m_id );
+	}
+
 	ActorId m_id;
 
 private:
@@ -223,6 +250,12 @@ struct EvtData_Move_Actor : public BaseEventData
 		}
 	}
 
+	explicit EvtData_Move_Actor( BinaryInStream & in )
+	{
+		m_Id = in.ReadU32();
+		in.ReadFloats( &m_Mat.m[0][0], 16 );
+	}
+
 	virtual LuaObject VGetLuaEventData(void) const
 	{
 		assert( ( true == m_bHasLuaEventData ) && "Can't get lua event data because it hasn't been built yet!  Call BulidLuaEventData() first!" );
@@ -234,7 +267,7 @@ struct EvtData_Move_Actor : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Now assign the data.
@@ -262,11 +295,30 @@ struct EvtData_Move_Actor : public BaseEventData
 		}
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteU32( m_Id );
+		out.WriteFloats( &m_Mat.m[0][0], 16 );
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr(GCC_NEW EvtData_Move_Actor(m_Id, m_Mat));
 	}
 
+	// Only the newest move for an actor is worth processing.
+	virtual bool VGetCoalesceKey( unsigned int & key ) const
+	{
+		key = m_Id;
+		return true;
+	}
+
+	virtual bool VGetInterestActor( unsigned int & actorId ) const
+	{
+		actorId = m_Id;
+		return true;
+	}
+
 	ActorId m_Id;
 	Mat4x4 m_Mat;
 
@@ -296,6 +348,10 @@ public:
 	{
 	}
 
+	explicit EvtData_New_Game( BinaryInStream &in )
+	{
+	}
+
 	EvtData_New_Game( LuaObject srcData )
 	{
 	}
@@ -319,6 +375,10 @@ public:
 	{
 	}
 
+	explicit EvtData_Request_Start_Game( BinaryInStream &in )
+	{
+	}
+
 	EvtData_Request_Start_Game( LuaObject srcData )
 	{
 	}
@@ -349,6 +409,11 @@ struct EvtData_Game_State : public BaseEventData
 		m_gameState = static_cast<BaseGameState>( tempVal );
 	}
 
+	explicit EvtData_Game_State( BinaryInStream &in )
+		: m_gameState( static_cast<BaseGameState>( in.ReadI32() ) )
+	{
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr( GCC_NEW EvtData_Game_State( m_gameState ) );
@@ -367,7 +432,7 @@ struct EvtData_Game_State : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -400,6 +465,11 @@ struct EvtData_Game_State : public BaseEventData
 		out << tempVal;
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteI32( static_cast< int >( m_gameState ) );
+	}
+
 	BaseGameState m_gameState;
 
 private:
@@ -430,6 +500,12 @@ struct EvtData_Remote_Client : public BaseEventData
 		in >> m_ipAddress;
 	}
 
+	explicit EvtData_Remote_Client( BinaryInStream &in )
+	{
+		m_socketId = in.ReadI32();
+		m_ipAddress = in.ReadI32();
+	}
+
 	virtual ~EvtData_Remote_Client() {}
 
 	virtual LuaObject VGetLuaEventData(void) const
@@ -443,7 +519,7 @@ struct EvtData_Remote_Client : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -460,6 +536,12 @@ struct EvtData_Remote_Client : public BaseEventData
 		out << m_ipAddress;
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteI32( m_socketId );
+		out.WriteI32( m_ipAddress );
+	}
+
 	int m_socketId;
 	int m_ipAddress;
 
@@ -480,6 +562,11 @@ struct EvtData_Update_Tick : public BaseEventData
 	{
 	}
 
+	explicit EvtData_Update_Tick( BinaryInStream &in )
+		: m_DeltaMilliseconds( in.ReadI32() )
+	{
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr (GCC_NEW EvtData_Update_Tick ( m_DeltaMilliseconds ) );
@@ -496,7 +583,7 @@ struct EvtData_Update_Tick : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -511,6 +598,12 @@ struct EvtData_Update_Tick : public BaseEventData
 		assert( 0 && "You should not be serializing update ticks!" );
 	}
 
+	// Not for the network, but the event journal keeps them.
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteI32( m_DeltaMilliseconds );
+	}
+
 	int m_DeltaMilliseconds;
 private:
 	LuaObject m_LuaEventData;
@@ -537,6 +630,12 @@ struct EvtData_Debug_String : public BaseEventData
 	{
 	}
 
+	explicit EvtData_Debug_String( BinaryInStream &in )
+	{
+		in.ReadString( m_DebugMessage );
+		m_Type = static_cast< eDebugStringType >( in.ReadU8() );
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_Debug_String (m_DebugMessage, m_Type) );
@@ -553,7 +652,7 @@ struct EvtData_Debug_String : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -576,6 +675,12 @@ struct EvtData_Debug_String : public BaseEventData
 		assert( 0 && "You should not be serializing debug strings!" );
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteString( m_DebugMessage );
+		out.WriteU8( static_cast< unsigned char >( m_Type ) );
+	}
+
 	std::string m_DebugMessage;
 	eDebugStringType m_Type;
 private:
@@ -607,6 +712,12 @@ struct EvtData_Network_Player_Actor_Assignment : public BaseEventData
 		in >> m_remotePlayerId;
 	}
 
+	explicit EvtData_Network_Player_Actor_Assignment( BinaryInStream &in )
+	{
+		m_actorId = in.ReadI32();
+		m_remotePlayerId = in.ReadI32();
+	}
+
 
 	virtual ~EvtData_Network_Player_Actor_Assignment() {}
 
@@ -621,7 +732,7 @@ struct EvtData_Network_Player_Actor_Assignment : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -638,6 +749,12 @@ struct EvtData_Network_Player_Actor_Assignment : public BaseEventData
 		out << m_remotePlayerId;
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteI32( m_actorId );
+		out.WriteI32( m_remotePlayerId );
+	}
+
 	int m_actorId;
 	int m_remotePlayerId;
 
@@ -661,6 +778,12 @@ struct EvtData_Decompress_Request : public BaseEventData
 	{
 	}
 
+	explicit EvtData_Decompress_Request( BinaryInStream &in )
+	{
+		in.ReadWString( m_zipFileName );
+		in.ReadString( m_fileName );
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr (GCC_NEW EvtData_Decompress_Request ( m_zipFileName, m_fileName ) );
@@ -683,6 +806,12 @@ struct EvtData_Decompress_Request : public BaseEventData
 		assert( 0 && "You should not be serializing decompression requests!" );
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteWString( m_zipFileName );
+		out.WriteString( m_fileName );
+	}
+
 public:
 	std::wstring m_zipFileName;
 	std::string m_fileName;
@@ -708,6 +837,16 @@ struct EvtData_Decompression_Progress : public BaseEventData
 	{
 	}
 
+	// The buffer belongs to this process, so it isn't sent - it
+	// comes back NULL.
+	explicit EvtData_Decompression_Progress( BinaryInStream &in )
+		: m_buffer( NULL )
+	{
+		m_progress = in.ReadI32();
+		in.ReadWString( m_zipFileName );
+		in.ReadString( m_fileName );
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr (GCC_NEW EvtData_Decompression_Progress ( m_progress, m_zipFileName, m_fileName, m_buffer ) );
@@ -730,6 +869,13 @@ struct EvtData_Decompression_Progress : public BaseEventData
 		assert( 0 && "You should not be serializing decompression progress events!" );
 	}
 
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteI32( m_progress );
+		out.WriteWString( m_zipFileName );
+		out.WriteString( m_fileName );
+	}
+
 public:
 	int m_progress;
 	std::wstring m_zipFileName;
@@ -767,11 +913,39 @@ struct EvtData_Request_New_Actor : public BaseEventData
 		memcpy(m_pActorParams, pCreateParams, pCreateParams->m_Size);
 	}
 
+	explicit EvtData_Request_New_Actor( BinaryInStream &in )
+		: m_pActorParams( NULL )
+	{
+		m_bHasLuaEventData = in.ReadBool();
+		if ( m_bHasLuaEventData )
+		{
+			m_ActorDef = DeserializeLuaTableBinary( in );
+		}
+		else
+		{
+			m_pActorParams = ActorParams::CreateFromBinaryStream( in );
+		}
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_Request_New_Actor ( m_ActorDef ) );
 	}
 
+	// The table if it came from script, the params if it came from code.
+	virtual void VSerializeBinary(BinaryOutStream &out) const
+	{
+		out.WriteBool( NULL == m_pActorParams );
+		if ( NULL == m_pActorParams )
+		{
+			SerializeLuaTableBinary( out, m_ActorDef );
+		}
+		else
+		{
+			m_pActorParams->VSerializeBinary( out );
+		}
+	}
+
 	virtual ~EvtData_Request_New_Actor()
 	{
 		SAFE_DELETE( m_pActorParams );
@@ -817,6 +991,11 @@ public:
 		in >> m_id;
 	}
 
+	explicit EvtData_Fire_Weapon( BinaryInStream & in )
+		: m_id( in.ReadU32() )
+	{
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_Fire_Weapon (m_id) );
@@ -835,7 +1014,7 @@ public:
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Serialize the data necessary.
@@ -849,6 +1028,17 @@ public:
 		out << m_id << " ";
 	}
 
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		out.WriteU32( m_id );
+	}
+
+	virtual bool VGetInterestActor( unsigned int & actorId ) const
+	{
+		actorId = m_id;
+		return true;
+	}
+
 	ActorId m_id;
 
 private:
@@ -876,6 +1066,12 @@ struct EvtData_Thrust : public BaseEventData
 		in >> m_throttle;
 	}
 
+	explicit EvtData_Thrust( BinaryInStream & in )
+	{
+		m_id = in.ReadU32();
+		m_throttle = in.ReadFloat();
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_Thrust (m_id, m_throttle) );
@@ -899,7 +1095,7 @@ struct EvtData_Thrust : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Set the appropriate data.
@@ -915,6 +1111,12 @@ struct EvtData_Thrust : public BaseEventData
 		out << m_throttle << " ";
 	}
 
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		out.WriteU32( m_id );
+		out.WriteFloat( m_throttle );
+	}
+
 private:
 	LuaObject	m_LuaEventData;
 };
@@ -939,6 +1141,12 @@ struct EvtData_Steer : public BaseEventData
 		in >> m_dir;
 	}
 
+	explicit EvtData_Steer( BinaryInStream & in )
+	{
+		m_id = in.ReadU32();
+		m_dir = in.ReadFloat();
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_Steer (m_id, m_dir) );
@@ -959,7 +1167,7 @@ struct EvtData_Steer : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Set appropriate data.
@@ -975,6 +1183,12 @@ struct EvtData_Steer : public BaseEventData
 		out << m_dir << " ";
 	}
 
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		out.WriteU32( m_id );
+		out.WriteFloat( m_dir );
+	}
+
 	ActorId m_id;
 	float m_dir;		// -1.0 is all the way left, 0 is straight, 1.0 is right
 
@@ -1015,11 +1229,31 @@ public:
 		m_bHasLuaEventData = true;	//We're just using what was passed into us.
 	}
 
+	explicit EvtData_UpdateActorParams( BinaryInStream & in )
+		: m_LuaEventData( DeserializeLuaTableBinary( in ) )
+		, m_ActorID( 0 )
+	{
+		if ( m_LuaEventData.IsTable() )
+		{
+			LuaObject actorID = m_LuaEventData[ "ActorID" ];
+			if ( actorID.IsInteger() )
+			{
+				m_ActorID = actorID.GetInteger();
+			}
+		}
+		m_bHasLuaEventData = true;
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr (GCC_NEW EvtData_UpdateActorParams(m_LuaEventData) );
 	}
 
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		SerializeLuaTableBinary( out, m_LuaEventData );
+	}
+
 	virtual LuaObject VGetLuaEventData(void) const
 	{
 		assert( ( true == m_bHasLuaEventData ) && "Can't get lua event data because it hasn't been built yet!  Call BulidLuaEventData() first!" );
@@ -0,0 +1,466 @@
+//========================================================================
+// TimerWheel.cpp : Hierarchical timing wheel for delayed events
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class TimerWheel			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "TimerWheel.h"
+
+#include <algorithm>
+
+
+//
+// TimerWheel::TimerWheel
+//
+TimerWheel::TimerWheel( unsigned long now )
+	: m_FreeHead( kNil ),
+	  m_Pending( 0 ),
+	  m_Now( static_cast< unsigned int >( now ) )
+{
+	for ( unsigned int i = 0; i < kNumSlots; ++i )
+	{
+		m_Slots[i].m_Head = kNil;
+		m_Slots[i].m_Tail = kNil;
+	}
+}
+
+//
+// TimerWheel::Schedule
+//
+TimerWheel::TimerId TimerWheel::Schedule( IEventDataPtr const & event, unsigned long when,
+	unsigned long period )
+{
+	assert( event && "Can't schedule an empty event!" );
+	assert( period < 0x80000000 && "Timer period is too long!" );
+
+	unsigned int index;
+	if ( m_FreeHead != kNil )
+	{
+		index = m_FreeHead;
+		m_FreeHead = m_Timers[index].m_Next;
+	}
+	else
+	{
+		if ( m_Timers.size() >= kMaxTimers )
+		{
+			assert( 0 && "Too many timers pending!" );
+			return IEventManager::kInvalidTimer;
+		}
+
+		index = static_cast< unsigned int >( m_Timers.size() );
+
+		Timer timer;
+		timer.m_Expires = 0;
+		timer.m_Period = 0;
+		timer.m_Prev = kNil;
+		timer.m_Next = kNil;
+		timer.m_Slot = kNil;
+		timer.m_Generation = 0;
+		m_Timers.push_back( timer );
+	}
+
+	Timer & timer = m_Timers[index];
+	timer.m_Event = event;
+	timer.m_Expires = static_cast< unsigned int >( when );
+	timer.m_Period = static_cast< unsigned int >( period );
+
+	Link( index );
+	++m_Pending;
+
+	return MakeId( index );
+}
+
+//
+// TimerWheel::Cancel
+//
+bool TimerWheel::Cancel( TimerId timerId )
+{
+	// the invalid id comes out as a huge index, and fails the size check
+	unsigned int const index = ( timerId & kIndexMask ) - 1;
+	if ( index >= m_Timers.size() )
+		return false;
+
+	Timer const & timer = m_Timers[index];
+	if ( timer.m_Slot == kNil || ( timer.m_Generation & kGenerationMask ) != ( timerId >> kIndexBits ) )
+		return false;
+
+	Unlink( index );
+	Release( index );
+	return true;
+}
+
+//
+// TimerWheel::Advance
+//
+void TimerWheel::Advance( unsigned long now, std::vector< IEventDataPtr > & expired )
+{
+	unsigned int const target = static_cast< unsigned int >( now );
+
+	// anything scheduled for a time already stepped past goes first,
+	// even if the clock hasn't moved since
+	Expire( kOverdueSlot, expired );
+
+	// with nothing in any slot there's nothing to step through
+	if ( 0 == m_Pending )
+	{
+		if ( static_cast< int >( target - m_Now ) >= 0 )
+			m_Now = target + 1;
+		return;
+	}
+
+	while ( static_cast< int >( target - m_Now ) >= 0 )
+	{
+		unsigned int const index = m_Now & kSlotMask;
+
+		// the level 0 wheel came round - bring the next stretch of
+		// time down from the coarser wheels, going further up only
+		// when a wheel has come round too
+		if ( 0 == index )
+		{
+			for ( unsigned int level = 1; level < kLevels; ++level )
+			{
+				if ( Cascade( level ) != 0 )
+					break;
+			}
+		}
+
+		Expire( index, expired );
+		++m_Now;
+	}
+}
+
+//
+// TimerWheel::Clear
+//
+void TimerWheel::Clear( void )
+{
+	for ( unsigned int i = 0; i < m_Timers.size(); ++i )
+	{
+		if ( m_Timers[i].m_Slot != kNil )
+		{
+			m_Timers[i].m_Slot = kNil;
+			Release( i );
+		}
+	}
+
+	for ( unsigned int i = 0; i < kNumSlots; ++i )
+	{
+		m_Slots[i].m_Head = kNil;
+		m_Slots[i].m_Tail = kNil;
+	}
+}
+
+//
+// TimerWheel::MakeId
+//
+TimerWheel::TimerId TimerWheel::MakeId( unsigned int index ) const
+{
+	return ( ( m_Timers[index].m_Generation & kGenerationMask ) << kIndexBits ) | ( index + 1 );
+}
+
+//
+// TimerWheel::Link
+//
+void TimerWheel::Link( unsigned int index )
+{
+	Timer & timer = m_Timers[index];
+	unsigned int const delta = timer.m_Expires - m_Now;
+
+	unsigned int slotIndex;
+	if ( static_cast< int >( delta ) < 0 )
+	{
+		slotIndex = kOverdueSlot;
+	}
+	else
+	{
+		unsigned int level = 0;
+		while ( level < kLevels - 1 && delta >= ( 1u << ( kSlotBits * ( level + 1 ) ) ) )
+			++level;
+
+		slotIndex = level * kSlots + ( ( timer.m_Expires >> ( kSlotBits * level ) ) & kSlotMask );
+	}
+
+	Slot & slot = m_Slots[slotIndex];
+	timer.m_Slot = slotIndex;
+	timer.m_Prev = slot.m_Tail;
+	timer.m_Next = kNil;
+
+	if ( slot.m_Tail != kNil )
+		m_Timers[slot.m_Tail].m_Next = index;
+	else
+		slot.m_Head = index;
+	slot.m_Tail = index;
+}
+
+//
+// TimerWheel::Unlink
+//
+void TimerWheel::Unlink( unsigned int index )
+{
+	Timer & timer = m_Timers[index];
+	Slot & slot = m_Slots[timer.m_Slot];
+
+	if ( timer.m_Prev != kNil )
+		m_Timers[timer.m_Prev].m_Next = timer.m_Next;
+	else
+		slot.m_Head = timer.m_Next;
+
+	if ( timer.m_Next != kNil )
+		m_Timers[timer.m_Next].m_Prev = timer.m_Prev;
+	else
+		slot.m_Tail = timer.m_Prev;
+
+	timer.m_Slot = kNil;
+}
+
+//
+// TimerWheel::Release
+//
+void TimerWheel::Release( unsigned int index )
+{
+	Timer & timer = m_Timers[index];
+	timer.m_Event.reset();
+	++timer.m_Generation;
+	timer.m_Next = m_FreeHead;
+	m_FreeHead = index;
+	--m_Pending;
+}
+
+//
+// TimerWheel::Expire
+//
+void TimerWheel::Expire( unsigned int slotIndex, std::vector< IEventDataPtr > & expired )
+{
+	Slot & slot = m_Slots[slotIndex];
+	unsigned int timerIndex = slot.m_Head;
+	slot.m_Head = kNil;
+	slot.m_Tail = kNil;
+
+	while ( timerIndex != kNil )
+	{
+		Timer & timer = m_Timers[timerIndex];
+		unsigned int const next = timer.m_Next;
+		timer.m_Slot = kNil;
+
+		if ( timer.m_Period )
+		{
+			expired.push_back( timer.m_Event->VCopy() );
+			timer.m_Expires = m_Now + timer.m_Period;
+			Link( timerIndex );
+		}
+		else
+		{
+			expired.push_back( timer.m_Event );
+			Release( timerIndex );
+		}
+
+		timerIndex = next;
+	}
+}
+
+//
+// TimerWheel::Cascade
+//
+unsigned int TimerWheel::Cascade( unsigned int level )
+{
+	unsigned int const index = ( m_Now >> ( kSlotBits * level ) ) & kSlotMask;
+
+	Slot & slot = m_Slots[level * kSlots + index];
+	unsigned int timerIndex = slot.m_Head;
+	slot.m_Head = kNil;
+	slot.m_Tail = kNil;
+
+	// everything here is now due within one turn of the wheel below,
+	// so Link() puts it on a finer one
+	while ( timerIndex != kNil )
+	{
+		unsigned int const next = m_Timers[timerIndex].m_Next;
+		Link( timerIndex );
+		timerIndex = next;
+	}
+
+	return index;
+}
+
+
+//
+// testTimerWheel							- not in the book
+//
+//   100,000 pending timers spread over a minute: what it costs to
+//   schedule and cancel one, and what a 16 ms tick costs while
+//   they come due. Then the same number parked an hour out, to show
+//   a tick costs the same whether or not anything is waiting. The
+//   clock is simulated, so it doesn't take a minute to run. Results
+//   go to the debugger output. EventBench's timer_ benchmarks do the
+//   same without the game - see Headless/EventBench.cpp.
+//
+namespace
+{
+	const unsigned int kBenchmarkTimers = 100000;
+	const unsigned int kBenchmarkSpanMs = 60000;
+	const unsigned int kBenchmarkTickMs = 16;
+
+	class TimerTestEvent : public EvtData<unsigned int>
+	{
+	public:
+		TimerTestEvent() : EvtData<unsigned int>( 0 ) { }
+
+		static const EventType sk_EventType;
+		virtual const EventType & VGetEventType( void ) const
+		{
+			return sk_EventType;
+		}
+
+		virtual IEventDataPtr VCopy() const
+		{
+			return IEventDataPtr( GCC_NEW TimerTestEvent() );
+		}
+	};
+
+	const EventType TimerTestEvent::sk_EventType( "timer_test" );
+
+	double TicksToNs( LONGLONG ticks, LARGE_INTEGER const & frequency, unsigned int count )
+	{
+		return count ? double( ticks ) * 1.0e9 / double( frequency.QuadPart ) / count : 0.0;
+	}
+
+	void ReportTimerBenchmark( char const * pLabel, double nanoseconds )
+	{
+		char buffer[512];
+		_snprintf( buffer, sizeof(buffer)-1, "  %-40s %10.1f ns\n", pLabel, nanoseconds );
+		buffer[sizeof(buffer)-1] = 0;
+		OutputDebugStringA( buffer );
+	}
+}
+
+void testTimerWheel()
+{
+	OutputDebugStringA( "---- Timer Wheel ----\n" );
+
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency( &frequency );
+
+	IEventDataPtr event( GCC_NEW TimerTestEvent() );
+	std::vector< TimerWheel::TimerId > ids( kBenchmarkTimers );
+	std::vector< IEventDataPtr > expired;
+	expired.reserve( kBenchmarkTimers );
+
+	unsigned long now = 0;
+	TimerWheel wheel( now );
+
+	// --- timers coming due over the next minute ---
+
+	QueryPerformanceCounter( &start );
+	for ( unsigned int i = 0; i < kBenchmarkTimers; ++i )
+	{
+		unsigned long const delay = ( ( rand() << 15 ) | rand() ) % kBenchmarkSpanMs + 1;
+		ids[i] = wheel.Schedule( event, now + delay );
+	}
+	QueryPerformanceCounter( &end );
+	ReportTimerBenchmark( "schedule, per timer", TicksToNs( end.QuadPart - start.QuadPart, frequency, kBenchmarkTimers ) );
+
+	unsigned int cancelled = 0;
+	QueryPerformanceCounter( &start );
+	for ( unsigned int i = 0; i < kBenchmarkTimers; i += 10 )
+	{
+		if ( wheel.Cancel( ids[i] ) )
+			++cancelled;
+	}
+	QueryPerformanceCounter( &end );
+	ReportTimerBenchmark( "cancel, per timer", TicksToNs( end.QuadPart - start.QuadPart, frequency, cancelled ) );
+
+	unsigned int ticks = 0;
+	unsigned int fired = 0;
+	LONGLONG worstTick = 0;
+	QueryPerformanceCounter( &start );
+	while ( wheel.GetPendingCount() > 0 )
+	{
+		LARGE_INTEGER tickStart, tickEnd;
+		QueryPerformanceCounter( &tickStart );
+
+		now += kBenchmarkTickMs;
+		wheel.Advance( now, expired );
+		fired += static_cast< unsigned int >( expired.size() );
+		expired.clear();
+
+		QueryPerformanceCounter( &tickEnd );
+		worstTick = std::max( worstTick, tickEnd.QuadPart - tickStart.QuadPart );
+		++ticks;
+	}
+	QueryPerformanceCounter( &end );
+	ReportTimerBenchmark( "16 ms tick, average", TicksToNs( end.QuadPart - start.QuadPart, frequency, ticks ) );
+	ReportTimerBenchmark( "16 ms tick, worst", TicksToNs( worstTick, frequency, 1 ) );
+	ReportTimerBenchmark( "per expired timer", TicksToNs( end.QuadPart - start.QuadPart, frequency, fired ) );
+
+	// --- the same number waiting an hour out, nothing coming due ---
+
+	const unsigned int kIdleTicks = 1000;
+
+	wheel.Schedule( event, now + 3600000 );
+
+	QueryPerformanceCounter( &start );
+	for ( unsigned int i = 0; i < kIdleTicks; ++i )
+	{
+		now += kBenchmarkTickMs;
+		wheel.Advance( now, expired );
+	}
+	QueryPerformanceCounter( &end );
+	ReportTimerBenchmark( "idle tick, 1 pending", TicksToNs( end.QuadPart - start.QuadPart, frequency, kIdleTicks ) );
+
+	for ( unsigned int i = 0; i < kBenchmarkTimers; ++i )
+		wheel.Schedule( event, now + 3600000 + i + 1 );
+
+	QueryPerformanceCounter( &start );
+	for ( unsigned int i = 0; i < kIdleTicks; ++i )
+	{
+		now += kBenchmarkTickMs;
+		wheel.Advance( now, expired );
+	}
+	QueryPerformanceCounter( &end );
+	ReportTimerBenchmark( "idle tick, 100k pending", TicksToNs( end.QuadPart - start.QuadPart, frequency, kIdleTicks ) );
+
+	char buffer[512];
+	_snprintf( buffer, sizeof(buffer)-1, "  %u fired, %u cancelled, %u still pending\n",
+		fired, cancelled, wheel.GetPendingCount() );
+	buffer[sizeof(buffer)-1] = 0;
+	OutputDebugStringA( buffer );
+
+	wheel.Clear();
+}
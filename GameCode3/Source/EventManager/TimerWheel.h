@@ -0,0 +1,170 @@
+#pragma once
+//========================================================================
+// TimerWheel.h : Hierarchical timing wheel for delayed events
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class TimerWheel			- not in the book
+//========================================================================
+
+#include <vector>
+#include "EventManager.h"
+
+
+// TimerWheel Description
+//
+// Holds events until a given time, for IEventManager::VQueueEventAt()
+// and VQueueEventPeriodic(). It's a hierarchical timing wheel - four
+// wheels of 256 slots each, the first one slot per millisecond, each
+// one after that 256 times coarser:
+//
+//	level 0		due in the next 256 ms
+//	level 1		due in the next 65 seconds
+//	level 2		due in the next 4.6 hours
+//	level 3		everything else, up to 24 days out
+//
+// A timer goes into the slot for its expiry time on the finest wheel
+// that reaches that far, so scheduling is a shift and a list insert,
+// and since each timer knows its slot, cancelling is a list unlink.
+// When the level 0 wheel comes round, the next slot of the level 1
+// wheel is emptied down onto it, and so on up - each timer moves at
+// most three times in its life. Advance() only ever looks at the
+// slots it steps through, so the cost of a tick follows the number
+// of timers that come due, not the number waiting.
+//
+// Times are milliseconds on a 32-bit clock, GetTickCount() style,
+// and every comparison is done on the difference, so the clock
+// wrapping is harmless.
+//
+// Timers are kept in one array and linked by index, and dead ones
+// go on a free list, so once the array has grown to the most timers
+// ever pending at once nothing more is allocated.
+
+class TimerWheel : public boost::noncopyable
+{
+public:
+	typedef IEventManager::TimerId TimerId;
+
+	explicit TimerWheel( unsigned long now );
+
+	// Holds 'event' until 'when', then every 'period' milliseconds
+	// after that if a period is given. A 'when' that has already
+	// passed comes due on the next Advance(). Returns
+	// IEventManager::kInvalidTimer if there's no room left.
+	TimerId Schedule( IEventDataPtr const & event, unsigned long when,
+		unsigned long period = 0 );
+
+	// Returns false if the timer already fired ( and wasn't periodic )
+	// or was already cancelled - old ids are never mistaken for new
+	// timers reusing the same spot.
+	bool Cancel( TimerId timerId );
+
+	// Runs the clock up to and including 'now', adding the event of
+	// every timer that came due to 'expired', earliest first. A
+	// periodic timer hands out a VCopy() each time and is rescheduled
+	// one period after it fired - a long stall gives one late event,
+	// not a burst of them.
+	void Advance( unsigned long now, std::vector< IEventDataPtr > & expired );
+
+	void Clear( void );
+
+	unsigned int GetPendingCount( void ) const { return m_Pending; }
+
+	// The next millisecond Advance() will look at.
+	unsigned long GetTime( void ) const { return m_Now; }
+
+private:
+	enum eConstants
+	{
+		kLevels = 4,
+		kSlotBits = 8,
+		kSlots = 1 << kSlotBits,
+		kSlotMask = kSlots - 1,
+
+		// one more list for timers whose time had already passed
+		// when they were scheduled
+		kOverdueSlot = kLevels * kSlots,
+		kNumSlots = kOverdueSlot + 1,
+
+		// a TimerId is the timer's index + 1 in the low bits, and
+		// the generation of that spot in the array in the high bits
+		kIndexBits = 20,
+		kIndexMask = ( 1 << kIndexBits ) - 1,
+		kMaxTimers = kIndexMask - 1,
+		kGenerationMask = ( 1 << ( 32 - kIndexBits ) ) - 1
+	};
+
+	static const unsigned int kNil = 0xffffffff;
+
+	struct Timer
+	{
+		IEventDataPtr m_Event;
+		unsigned int  m_Expires;
+		unsigned int  m_Period;
+		unsigned int  m_Prev;			// links within the slot, or
+		unsigned int  m_Next;			// m_Next alone on the free list
+		unsigned int  m_Slot;			// kNil when not scheduled
+		unsigned int  m_Generation;
+	};
+
+	struct Slot
+	{
+		unsigned int m_Head;
+		unsigned int m_Tail;
+	};
+
+	TimerId MakeId( unsigned int index ) const;
+
+	// Puts the timer in the slot its expiry time belongs in, as seen
+	// from m_Now.
+	void Link( unsigned int index );
+	void Unlink( unsigned int index );
+	void Release( unsigned int index );
+
+	// Hands out the events of every timer in the slot.
+	void Expire( unsigned int slotIndex, std::vector< IEventDataPtr > & expired );
+
+	// Empties the current slot of a coarse wheel down onto the finer
+	// ones, and returns that slot's number.
+	unsigned int Cascade( unsigned int level );
+
+	std::vector< Timer > m_Timers;
+	unsigned int         m_FreeHead;
+	unsigned int         m_Pending;
+	unsigned int         m_Now;
+	Slot                 m_Slots[kNumSlots];
+};
@@ -60,6 +60,7 @@
 
 #include "GameCode.h"
 #include "MainLoop\Initialization.h"
+#include "MainLoop\GameInstance.h"
 #include "DumbStuff\GameCodeError.h"
 #include "DumbStuff\CMath.h"
 #include "DumbStuff\String.h"
@@ -69,6 +70,7 @@
 #include "Lang\Strings.h"
 #include "Audio\DirectSoundAudio.h"
 #include "EventManager\EventManagerImpl.h"
+#include "EventManager\EventFactory.h"
 #include "Network\Network.h"
 #include "Scripting\LuaStateManager.h"
 #include "ai/Pathing.h"
@@ -105,6 +107,8 @@ GameCodeApp::GameCodeApp()
 
 	m_pLuaStateManager = NULL;
 	m_pEventManager = NULL;
+	m_pEventJournal = NULL;
+	m_pGameInstances = NULL;
 	m_ResCache = NULL;
 
 	m_bQuitRequested = false;
@@ -118,6 +122,24 @@ HWND GameCodeApp::GetHwnd()
 	return DXUTGetHWND();
 }
 
+//
+// GameCodeApp::GetCurrentGame				- not in the book
+//
+BaseGameLogic *GameCodeApp::GetCurrentGame()
+{
+	GameInstance *pInstance = GameInstance::GetCurrent();
+	return pInstance ? pInstance->GetGame() : m_pGame;
+}
+
+//
+// GameCodeApp::GetCurrentLuaStateManager		- not in the book
+//
+LuaStateManager *GameCodeApp::GetCurrentLuaStateManager()
+{
+	GameInstance *pInstance = GameInstance::GetCurrent();
+	return pInstance ? pInstance->GetLuaStateManager() : m_pLuaStateManager;
+}
+
 
 //===================================================================
 // Win32 Specific Stuff
@@ -253,8 +275,19 @@ bool GameCodeApp::InitInstance(HINSTANCE hInstance, LPWSTR lpCmdLine, HWND hWnd,
 		return false;
 	}
 
+	m_pEventManager->RegisterScriptInterface();
+
 	RegisterBaseGameEvents();	//Register all base event types.
 
+	if (!m_pOptions->m_eventJournal.empty())
+	{
+		m_pEventJournal = GCC_NEW EventJournal();
+		if (m_pEventJournal->Open(m_pOptions->m_eventJournal.c_str()))
+			m_pEventManager->SetJournal(m_pEventJournal);
+		else
+			SAFE_DELETE(m_pEventJournal);
+	}
+
 	// Now that the event manager and the Lua State manager are init'd, let's run the initialization file.
 	const bool bLuaInitSuccess = m_pLuaStateManager->Init( "data\\Scripts\\init.lua" );
 	if ( false == bLuaInitSuccess )
@@ -782,6 +815,11 @@ LRESULT GameCodeApp::OnClose()
 {
 	// release all the game systems in reverse order from which they were created
 
+	// the network thread mustn't be handing anything to the game as it goes
+	if (m_pBaseSocketManager)
+		m_pBaseSocketManager->StopThread();
+
+	SAFE_DELETE(m_pGameInstances);
 	SAFE_DELETE(m_pGame);
 
 	SAFE_DELETE(m_pFontHandler);
@@ -792,6 +830,10 @@ LRESULT GameCodeApp::OnClose()
 
 	SAFE_DELETE(m_pBaseSocketManager);
 
+	if (m_pEventManager)
+		m_pEventManager->SetJournal(NULL);
+	SAFE_DELETE(m_pEventJournal);
+
 	SAFE_DELETE(m_pEventManager);
 
 	SAFE_DELETE(m_pLuaStateManager);
@@ -1167,7 +1209,19 @@ void CALLBACK GameCodeApp::OnUpdateGame( double fTime, float fElapsedTime, void*
 		if (g_pApp->m_pBaseSocketManager)
 			g_pApp->m_pBaseSocketManager->DoSelect(0);	// pause 0 microseconds
 
+		// the other games run while this one does
+		GameInstancePool *pInstances = g_pApp->m_pGameInstances;
+		if (pInstances)
+			pInstances->BeginUpdate(fTime, fElapsedTime);
+
 		g_pApp->m_pGame->VOnUpdate(fTime, fElapsedTime);
+
+		if (pInstances)
+			pInstances->EndUpdate();
+
+		// what the updates sent goes now, not next frame
+		if (g_pApp->m_pBaseSocketManager)
+			g_pApp->m_pBaseSocketManager->FlushOutput();
 	}
 }
 
@@ -1244,6 +1298,36 @@ void GameCodeApp::RegisterBaseGameEvents( void )
 	// Decompression process events...
 	m_pEventManager->RegisterCodeOnlyEvent( EvtData_Decompress_Request::sk_EventType );
 //	m_pEventManager->RegisterCodeOnlyEvent( EvtData_Decompression_Progress::sk_EventType );
+
+	// Events that can be rebuilt from their serialized form, e.g. by
+	// the event journal player. Those with no VSerialize() only have
+	// the binary form.
+	EventFactory::Register< EvtData_New_Actor >();
+	EventFactory::Register< EvtData_Destroy_Actor >();
+	EventFactory::Register< EvtData_Move_Actor >();
+	EventFactory::Register< EvtData_Game_State >();
+	EventFactory::Register< EvtData_Remote_Client >();
+	EventFactory::Register< EvtData_Network_Player_Actor_Assignment >();
+	EventFactory::Register< EvtData_AiSteer >();
+	EventFactory::RegisterBinaryCreator< EvtData_Update_Tick >();
+	EventFactory::RegisterBinaryCreator< EvtData_Debug_String >();
+	EventFactory::RegisterBinaryCreator< EvtData_Decompress_Request >();
+	EventFactory::RegisterBinaryCreator< EvtData_Decompression_Progress >();
+	EventFactory::RegisterBinaryCreator< EvtData_PhysTrigger_Enter >();
+	EventFactory::RegisterBinaryCreator< EvtData_PhysTrigger_Leave >();
+	EventFactory::RegisterBinaryCreator< EvtData_PhysCollision >();
+	EventFactory::RegisterBinaryCreator< EvtData_PhysSeparation >();
+
+	// Events that go over the network, and the wire ids they go as.
+	// Never renumber these - both ends have to agree on them.
+	EventWire::Register< EvtData_New_Actor >( 1 );
+	EventWire::Register< EvtData_Destroy_Actor >( 2 );
+	EventWire::Register< EvtData_Move_Actor >( 3, NetChannel_UnreliableSequenced );
+	EventWire::Register< EvtData_Game_State >( 4 );
+	EventWire::Register< EvtData_Remote_Client >( 5 );
+	EventWire::Register< EvtData_Network_Player_Actor_Assignment >( 6 );
+	EventWire::Register< EvtData_AiSteer >( 7 );
+	EventWire::Register< EvtData_Debug_String >( 8 );
 }
 
 
@@ -1263,7 +1347,7 @@ const float ACTOR_ANGULAR_VELOCITY = 3.0f;  // 3 radians per second
 void BaseActor::VRotateY(float angleRadians)
 {
 	angleRadians = WrapPi(angleRadians);
-	shared_ptr<IGamePhysics> pPhysics = g_pApp->m_pGame->VGetGamePhysics();
+	shared_ptr<IGamePhysics> pPhysics = g_pApp->GetCurrentGame()->VGetGamePhysics();
 	float diff = angleRadians - pPhysics->VGetOrientationY(m_id);
 	float timeMs = fabs(diff / ACTOR_ANGULAR_VELOCITY);
 
@@ -1297,6 +1381,20 @@ BaseGameLogic::BaseGameLogic(struct GameOptions const &options)
 	m_ExpectedAI = 0;
 	m_pPathingGraph.reset(CreatePathingGraph());
 
+	m_SnapshotIntervalMs = 0;
+	m_SnapshotTimer = 0;
+	if (options.m_snapshotRate > 0)
+	{
+		m_pSnapshots.reset(GCC_NEW SnapshotReplicator);
+		m_SnapshotIntervalMs = 1000 / options.m_snapshotRate;
+	}
+
+	if (options.m_interestRadius > 0)
+	{
+		float const radius = static_cast<float>(options.m_interestRadius);
+		m_pInterest.reset(GCC_NEW InterestManager(radius, radius + options.m_interestHysteresis));
+	}
+
 	m_pAiEventListener = EventListenerPtr (GCC_NEW AiEventListener ( ));
 	safeAddListener(m_pAiEventListener, EvtData_AiSteer::sk_EventType);
 }
@@ -1457,12 +1555,63 @@ void BaseGameLogic::VOnUpdate(float time, float elapsedTime)
 
 }
 
+//
+// BaseGameLogic::UpdateSnapshots			- not in the book
+//
+void BaseGameLogic::UpdateSnapshots(int deltaMilliseconds)
+{
+	if (m_bProxy || !m_pSnapshots || !m_pSnapshots->HasClients())
+		return;
+
+	m_SnapshotTimer += deltaMilliseconds;
+	if (m_SnapshotTimer < m_SnapshotIntervalMs)
+		return;
+
+	// a long frame doesn't mean a burst of snapshots to catch up
+	m_SnapshotTimer %= m_SnapshotIntervalMs;
+
+	m_pSnapshots->BeginSnapshot();
+	for (ActorMap::iterator i = m_ActorList.begin(); i != m_ActorList.end(); ++i)
+	{
+		ActorNetState state;
+		BuildActorNetState(i->first, i->second->VGetMat(), state);
+		m_pSnapshots->AddActor(state);
+	}
+	m_pSnapshots->SendSnapshot();
+}
+
+//
+// BaseGameLogic::UpdateInterest				- not in the book
+//
+void BaseGameLogic::UpdateInterest()
+{
+	if (m_bProxy || !m_pInterest)
+		return;
+
+	m_pInterest->BeginUpdate();
+	for (ActorMap::iterator i = m_ActorList.begin(); i != m_ActorList.end(); ++i)
+	{
+		Vec3 const pos = i->second->VGetMat().GetPosition();
+		float const where[3] = { pos.x, pos.y, pos.z };
+		m_pInterest->AddActor(i->first, where);
+	}
+	m_pInterest->EndUpdate();
+}
+
 //
 // BaseGameLogic::VChangeState				- Chapter 19, page 710
 //
 void BaseGameLogic::VChangeState(BaseGameState newState)
 {
-	if (newState==BGS_WaitingForPlayers)
+	if (newState==BGS_WaitingForPlayers && GameInstance::GetCurrent())
+	{
+		// One of a server's other games - there's no menu, and its
+		// players are all remote. The sockets are g_pApp's game's.
+		m_ExpectedPlayers = 0;
+		m_ExpectedRemotePlayers = g_pApp->m_pOptions->m_expectedPlayers;
+		m_ExpectedAI = g_pApp->m_pOptions->m_numAIs;
+	}
+	else if (newState==BGS_WaitingForPlayers)
 	{
 		// Get rid of the Main Menu...
 		m_gameViews.pop_front();
@@ -1485,6 +1634,8 @@ void BaseGameLogic::VChangeState(BaseGameState newState)
 				return;
 			}
 			g_pApp->m_pBaseSocketManager = pClient;
+			if (g_pApp->m_pOptions->m_networkThread)
+				pClient->StartThread();
 		}
 		else if (m_ExpectedRemotePlayers > 0)
 		{
@@ -1498,6 +1649,21 @@ void BaseGameLogic::VChangeState(BaseGameState newState)
 
 			pServer->AddSocket(new GameServerListenSocket(g_pApp->m_pOptions->m_listenPort));
 			g_pApp->m_pBaseSocketManager = pServer;
+
+			// the rest of the games this server runs, each on the next
+			// port - they need the sockets on a thread of their own
+			if (g_pApp->m_pOptions->m_gameInstances > 1)
+			{
+				g_pApp->m_pGameInstances = GCC_NEW GameInstancePool();
+				if (!g_pApp->m_pGameInstances->Create(g_pApp->m_pOptions->m_gameInstances - 1, g_pApp->m_pOptions->m_listenPort + 1))
+				{
+					OutputDebugStringA("ERROR Couldn't make the other game instances - running just the one\n");
+					SAFE_DELETE(g_pApp->m_pGameInstances);
+				}
+			}
+
+			if (g_pApp->m_pOptions->m_networkThread || g_pApp->m_pGameInstances)
+				pServer->StartThread();
 		}
 	}
 
@@ -1514,7 +1680,7 @@ void BaseGameLogic::VChangeState(BaseGameState newState)
 void BaseGameLogic::VBuildInitialScene()
 {
 	//Execute our startup script file first.
-	const bool bStartupScriptSuccess = g_pApp->m_pLuaStateManager->DoFile( "data\\Scripts\\startup.lua" );
+	const bool bStartupScriptSuccess = g_pApp->GetCurrentLuaStateManager()->DoFile( "data\\Scripts\\startup.lua" );
 	if ( false == bStartupScriptSuccess )
 	{
 		assert( 0 && "Unable to execute startup.lua!" );
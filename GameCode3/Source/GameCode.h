@@ -84,6 +84,8 @@ class EventManager;
 class LuaStateManager;
 class BaseSocketManager;
 class PathingGraph;
+class SnapshotReplicator;
+class InterestManager;
 class StateMachine;
 
 class GameCodeApp
@@ -162,6 +164,17 @@ public:
 	virtual BaseGameLogic *VCreateGameAndView()=0;
 	virtual bool VLoadGame()=0;
 
+	// Makes the game for each GameInstance, when the Game_Instances
+	// option asks for more than one - see GameInstancePool. A game
+	// that can't run more than one leaves it NULL.
+	virtual BaseGameLogic *VCreateGameInstance() { return NULL; }
+
+	// The game and Lua state the calling thread is running - its
+	// GameInstance's, if it has one, or else m_pGame and
+	// m_pLuaStateManager. Game code asks for these, not the members.
+	BaseGameLogic *GetCurrentGame();
+	LuaStateManager *GetCurrentLuaStateManager();
+
 	// File and Resource System
 	class ResCache *m_ResCache;
 	TCHAR m_saveGameDirectory[MAX_PATH];
@@ -176,10 +189,16 @@ public:
 	EventManager *m_pEventManager;
 	// Registers all base game events with the event manager.
 	void RegisterBaseGameEvents( void );
+	// Records every event, if the Event_Journal option is set.
+	class EventJournal *m_pEventJournal;
 
 	// Socket manager - could be server or client
 	BaseSocketManager *m_pBaseSocketManager;
 
+	// The server's other games, run beside m_pGame - NULL unless the
+	// Game_Instances option's more than 1.
+	class GameInstancePool *m_pGameInstances;
+
 	// Main loop processing
 	//bool MainLoop();
 	void AbortGame() { m_bQuitting = true; }
@@ -230,6 +249,20 @@ protected:
 	bool m_RenderDiagnostics;						// Are we rendering diagnostics?
 	shared_ptr<IGamePhysics> m_pPhysics;
 
+	shared_ptr<SnapshotReplicator> m_pSnapshots;	// sends actor movement to remote players, if Snapshot_Rate is set
+	int m_SnapshotIntervalMs;
+	int m_SnapshotTimer;
+
+	// Sends every actor's position to the remote players, when it's
+	// time to. Call it once a frame, after the physics has moved them.
+	void UpdateSnapshots(int deltaMilliseconds);
+
+	shared_ptr<InterestManager> m_pInterest;		// what each remote player can see, if Interest_Radius is set
+
+	// Tells the interest manager where every actor is. Call it once a
+	// frame, after the physics has moved them.
+	void UpdateInterest(void);
+
 public:
 
 	BaseGameLogic(struct GameOptions const &optionss);
@@ -238,6 +271,7 @@ public:
 	// Pausing
 	void TogglePause(bool active);
 	void SetProxy(bool isProxy) { m_bProxy = isProxy; }
+	bool IsProxy(void) const { return m_bProxy; }
 
 	ActorId GetNewActorID( void )
 	{
@@ -247,6 +281,8 @@ public:
 	ActorId GetRandomActor(optional<ActorId> ignoreMe);
 	
 	shared_ptr<PathingGraph> GetPathingGraph(void) { return m_pPathingGraph; }
+	SnapshotReplicator *GetSnapshotReplicator(void) { return m_pSnapshots.get(); }
+	shared_ptr<InterestManager> GetInterestManager(void) { return m_pInterest; }
 	CRandom& GetRNG(void) { return m_random; }
 
 	virtual void VBuildInitialScene();
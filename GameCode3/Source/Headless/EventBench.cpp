@@ -0,0 +1,767 @@
+//========================================================================
+// EventBench.cpp : Event system microbenchmarks
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  EventBench					- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "../EventManager/EventManagerImpl.h"
+#include "../EventManager/EventChannel.h"
+
+#include <boost/thread/thread.hpp>
+
+// EventBench Description
+//
+// Times the EventManager calls the game leans on every frame, with
+// nothing else running - no Lua, no window, no DirectX. Build it with
+// the Makefile in this directory and run it:
+//
+//	./EventBench				every benchmark
+//	./EventBench trigger		only the ones with "trigger" in their name
+//
+// Each result is one line of JSON on stdout, so a run can be saved
+// and compared against the last one by a script:
+//
+//	{"benchmark":"trigger_fanout","param":10,"iterations":100000,
+//	 "ns_per_op":152.3,"ops_per_sec":6565988}
+//
+// 'param' is whatever the benchmark varies - listeners, batch size,
+// queue depth or producer threads. Every benchmark is run kRuns times
+// and the fastest run is reported, which is the number that moves
+// least from one run to the next.
+
+namespace
+{
+	const unsigned int kRuns = 5;
+
+	// --- events and listeners ---
+
+	class BenchEvent : public EvtData<unsigned int>
+	{
+	public:
+		explicit BenchEvent( EventType const & eventType, unsigned int n = 0 )
+			: EvtData<unsigned int>( n )
+			, m_EventType( eventType )
+		{
+		}
+
+		virtual const EventType & VGetEventType( void ) const
+		{
+			return m_EventType;
+		}
+
+		virtual IEventDataPtr VCopy() const
+		{
+			return IEventDataPtr( GCC_NEW BenchEvent( m_EventType ) );
+		}
+
+	private:
+		EventType m_EventType;
+	};
+
+	const EventType kBenchEventA( "bench_a" );
+	const EventType kBenchEventB( "bench_b" );
+
+	// Counts what it's handed, and never consumes it, so a trigger
+	// always reaches every listener.
+	class CountingListener : public IEventListener
+	{
+	public:
+		CountingListener() : m_Count( 0 ) { }
+
+		virtual char const * GetName( void ) { return "CountingListener"; }
+
+		virtual bool HandleEvent( IEventData const & event )
+		{
+			++m_Count;
+			return false;
+		}
+
+		unsigned int m_Count;
+	};
+
+	typedef boost::shared_ptr< CountingListener > CountingListenerPtr;
+
+	// One of a numbered run, for checking the order they arrive in.
+	class SequenceEvent : public BenchEvent
+	{
+	public:
+		SequenceEvent( EventType const & eventType, unsigned int seq )
+			: BenchEvent( eventType ), m_Seq( seq )
+		{
+		}
+
+		unsigned int const m_Seq;
+	};
+
+	// Parallel-safe, and takes a little time over each event so
+	// there's still a job on the pool when the next VTrigger()
+	// comes. Counts the events that didn't come in order.
+	class SequenceListener : public IEventListener
+	{
+	public:
+		SequenceListener() : m_Next( 0 ), m_OutOfOrder( 0 ), m_Work( 0 ) { }
+
+		virtual char const * GetName( void ) { return "SequenceListener"; }
+		virtual bool IsParallelSafe( void ) const { return true; }
+
+		virtual bool HandleEvent( IEventData const & event )
+		{
+			unsigned int const seq = static_cast< SequenceEvent const & >( event ).m_Seq;
+			if ( seq != m_Next )
+				++m_OutOfOrder;
+			m_Next = seq + 1;
+
+			for ( unsigned int i = 0; i < 200; ++i )
+				m_Work += i;
+			return false;
+		}
+
+		unsigned int m_Next;
+		unsigned int m_OutOfOrder;
+		volatile unsigned int m_Work;
+	};
+
+	// Serial - triggers the next event in the run from inside
+	// VTick(), while the parallel-safe listener's batch is still
+	// being built.
+	class RetriggerListener : public IEventListener
+	{
+	public:
+		explicit RetriggerListener( EventManager * pManager ) : m_pManager( pManager ) { }
+
+		virtual char const * GetName( void ) { return "RetriggerListener"; }
+
+		virtual bool HandleEvent( IEventData const & event )
+		{
+			unsigned int const seq = static_cast< SequenceEvent const & >( event ).m_Seq;
+			m_pManager->VTrigger( SequenceEvent( kBenchEventA, seq ) );
+			return false;
+		}
+
+	private:
+		EventManager * m_pManager;
+	};
+
+	// A BenchEvent with the static type EventChannel needs.
+	class ChannelEvent : public BenchEvent
+	{
+	public:
+		static const EventType sk_EventType;
+
+		ChannelEvent() : BenchEvent( sk_EventType ) { }
+	};
+
+	const EventType ChannelEvent::sk_EventType( "bench_channel" );
+
+	// The same as CountingListener, for EventChannel<ChannelEvent>.
+	class TypedCountingListener : public ITypedEventListener< ChannelEvent >
+	{
+	public:
+		TypedCountingListener() : m_Count( 0 ) { }
+
+		virtual char const * GetName( void ) { return "TypedCountingListener"; }
+
+		virtual bool VHandleEvent( ChannelEvent const & event )
+		{
+			++m_Count;
+			return false;
+		}
+
+		unsigned int m_Count;
+	};
+
+
+	// --- timing and reporting ---
+
+	class Stopwatch
+	{
+	public:
+		Stopwatch()
+		{
+			QueryPerformanceFrequency( &m_Frequency );
+			QueryPerformanceCounter( &m_Start );
+		}
+
+		double ElapsedNs( void ) const
+		{
+			LARGE_INTEGER now;
+			QueryPerformanceCounter( &now );
+			return double( now.QuadPart - m_Start.QuadPart ) * 1.0e9 / double( m_Frequency.QuadPart );
+		}
+
+	private:
+		LARGE_INTEGER m_Frequency;
+		LARGE_INTEGER m_Start;
+	};
+
+	char const * g_pFilter = NULL;
+
+	bool IsSelected( char const * pBenchmark )
+	{
+		return !g_pFilter || strstr( pBenchmark, g_pFilter ) != NULL;
+	}
+
+	void Report( char const * pBenchmark, unsigned int param, unsigned int iterations, double bestNs )
+	{
+		double const nsPerOp = iterations ? bestNs / iterations : 0.0;
+		double const opsPerSec = nsPerOp > 0.0 ? 1.0e9 / nsPerOp : 0.0;
+
+		printf( "{\"benchmark\":\"%s\",\"param\":%u,\"iterations\":%u,\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f}\n",
+			pBenchmark, param, iterations, nsPerOp, opsPerSec );
+		fflush( stdout );
+	}
+
+	// The manager only takes events of types it has been told about.
+	void RegisterBenchEvents( EventManager & manager )
+	{
+		manager.RegisterCodeOnlyEvent( kBenchEventA );
+		manager.RegisterCodeOnlyEvent( kBenchEventB );
+		manager.RegisterCodeOnlyEvent( ChannelEvent::sk_EventType );
+	}
+
+	void AddListeners( EventManager & manager, std::vector< CountingListenerPtr > & listeners,
+		unsigned int count, EventType const & eventType )
+	{
+		for ( unsigned int i = 0; i < count; ++i )
+		{
+			CountingListenerPtr listener( GCC_NEW CountingListener() );
+			manager.VAddListener( listener, eventType );
+			listeners.push_back( listener );
+		}
+	}
+
+	// --- the benchmarks ---
+
+	//
+	// Adding and removing listeners, as actors come and go: 100
+	// listeners added to one type, then removed again in the order
+	// they were added. One op is one add or one del.
+	//
+	void BenchListenerChurn( void )
+	{
+		char const * const pName = "listener_churn";
+		if ( !IsSelected( pName ) )
+			return;
+
+		unsigned int const kListeners = 100;
+		unsigned int const kRounds = 200;
+
+		EventManager manager( "EventBench", false );
+		RegisterBenchEvents( manager );
+		std::vector< EventListenerPtr > listeners;
+		for ( unsigned int i = 0; i < kListeners; ++i )
+			listeners.push_back( EventListenerPtr( GCC_NEW CountingListener() ) );
+
+		double best = 0.0;
+		for ( unsigned int run = 0; run < kRuns; ++run )
+		{
+			Stopwatch timer;
+			for ( unsigned int round = 0; round < kRounds; ++round )
+			{
+				for ( unsigned int i = 0; i < kListeners; ++i )
+					manager.VAddListener( listeners[i], kBenchEventA );
+				for ( unsigned int i = 0; i < kListeners; ++i )
+					manager.VDelListener( listeners[i], kBenchEventA );
+			}
+			double const elapsed = timer.ElapsedNs();
+			if ( run == 0 || elapsed < best )
+				best = elapsed;
+		}
+
+		Report( pName, kListeners, kRounds * kListeners * 2, best );
+	}
+
+	//
+	// VTrigger() of one event to 1, 10 and 100 listeners. One op is
+	// one trigger, however many listeners it reaches.
+	//
+	void BenchTriggerFanout( void )
+	{
+		char const * const pName = "trigger_fanout";
+		if ( !IsSelected( pName ) )
+			return;
+
+		unsigned int const fanouts[] = { 1, 10, 100 };
+		unsigned int const kTotalCalls = 2000000;
+
+		for ( unsigned int f = 0; f < sizeof( fanouts ) / sizeof( fanouts[0] ); ++f )
+		{
+			EventManager manager( "EventBench", false );
+			RegisterBenchEvents( manager );
+			std::vector< CountingListenerPtr > listeners;
+			AddListeners( manager, listeners, fanouts[f], kBenchEventA );
+
+			BenchEvent const event( kBenchEventA );
+			unsigned int const triggers = kTotalCalls / fanouts[f];
+
+			double best = 0.0;
+			for ( unsigned int run = 0; run < kRuns; ++run )
+			{
+				Stopwatch timer;
+				for ( unsigned int i = 0; i < triggers; ++i )
+					manager.VTrigger( event );
+				double const elapsed = timer.ElapsedNs();
+				if ( run == 0 || elapsed < best )
+					best = elapsed;
+			}
+
+			assert( listeners[0]->m_Count == kRuns * triggers );
+			Report( pName, fanouts[f], triggers, best );
+		}
+	}
+
+	//
+	// EventChannel<T>::Trigger() to 1 and 10 typed listeners, against
+	// calling the same listeners straight from a list held by the
+	// caller - what a channel that kept the list it was subscribed to
+	// would do instead of going through the manager's registry. One
+	// op is one trigger.
+	//
+	void BenchChannelTrigger( void )
+	{
+		char const * const pName = "channel_trigger";
+		char const * const pDirectName = "channel_direct";
+		if ( !IsSelected( pName ) && !IsSelected( pDirectName ) )
+			return;
+
+		unsigned int const fanouts[] = { 1, 10 };
+		unsigned int const kTotalCalls = 2000000;
+
+		for ( unsigned int f = 0; f < sizeof( fanouts ) / sizeof( fanouts[0] ); ++f )
+		{
+			EventManager manager( "EventBench", true );
+			RegisterBenchEvents( manager );
+			std::vector< EventChannel< ChannelEvent >::ListenerPtr > listeners;
+			for ( unsigned int i = 0; i < fanouts[f]; ++i )
+			{
+				listeners.push_back( EventChannel< ChannelEvent >::ListenerPtr( GCC_NEW TypedCountingListener() ) );
+				EventChannel< ChannelEvent >::Subscribe( listeners.back() );
+			}
+
+			ChannelEvent const event;
+			unsigned int const triggers = kTotalCalls / fanouts[f];
+
+			if ( IsSelected( pName ) )
+			{
+				double best = 0.0;
+				for ( unsigned int run = 0; run < kRuns; ++run )
+				{
+					Stopwatch timer;
+					for ( unsigned int i = 0; i < triggers; ++i )
+						EventChannel< ChannelEvent >::Trigger( event );
+					double const elapsed = timer.ElapsedNs();
+					if ( run == 0 || elapsed < best )
+						best = elapsed;
+				}
+				Report( pName, fanouts[f], triggers, best );
+			}
+
+			if ( IsSelected( pDirectName ) )
+			{
+				double best = 0.0;
+				for ( unsigned int run = 0; run < kRuns; ++run )
+				{
+					Stopwatch timer;
+					for ( unsigned int i = 0; i < triggers; ++i )
+						for ( unsigned int l = 0; l < listeners.size(); ++l )
+							listeners[l]->VHandleEvent( event );
+					double const elapsed = timer.ElapsedNs();
+					if ( run == 0 || elapsed < best )
+						best = elapsed;
+				}
+				Report( pDirectName, fanouts[f], triggers, best );
+			}
+		}
+	}
+
+	//
+	// VQueueEvent() a batch of events, then VTick() them out to one
+	// listener - the whole life of a queued event. The batch size is
+	// the number queued per tick. One op is one event.
+	//
+	void BenchQueueTick( void )
+	{
+		char const * const pName = "queue_tick";
+		if ( !IsSelected( pName ) )
+			return;
+
+		unsigned int const batches[] = { 1, 16, 256, 4096 };
+		unsigned int const kTotalEvents = 500000;
+
+		for ( unsigned int b = 0; b < sizeof( batches ) / sizeof( batches[0] ); ++b )
+		{
+			EventManager manager( "EventBench", false );
+			RegisterBenchEvents( manager );
+			std::vector< CountingListenerPtr > listeners;
+			AddListeners( manager, listeners, 1, kBenchEventA );
+
+			unsigned int const ticks = kTotalEvents / batches[b];
+
+			// the events are made up front, so what's timed is the
+			// event system and not the allocator
+			std::vector< IEventDataPtr > events;
+			for ( unsigned int i = 0; i < batches[b]; ++i )
+				events.push_back( IEventDataPtr( GCC_NEW BenchEvent( kBenchEventA, i ) ) );
+
+			double best = 0.0;
+			for ( unsigned int run = 0; run < kRuns; ++run )
+			{
+				Stopwatch timer;
+				for ( unsigned int tick = 0; tick < ticks; ++tick )
+				{
+					for ( unsigned int i = 0; i < batches[b]; ++i )
+						manager.VQueueEvent( events[i] );
+					manager.VTick( IEventManager::kINFINITE );
+				}
+				double const elapsed = timer.ElapsedNs();
+				if ( run == 0 || elapsed < best )
+					best = elapsed;
+			}
+
+			assert( listeners[0]->m_Count == kRuns * ticks * batches[b] );
+			Report( pName, batches[b], ticks * batches[b], best );
+		}
+	}
+
+	//
+	// A parallel-safe listener handed a numbered run of events every
+	// way there is - queued and dispatched on the pool, triggered
+	// while its last job is still running, and triggered by a serial
+	// listener while its next job is still being built. Each tick
+	// queues 'batch' events, one more that's triggered from inside
+	// VTick(), and 'batch' more, then triggers one after VTick().
+	// Anything out of order is an error. One op is one event.
+	//
+	void BenchParallelOrder( void )
+	{
+		char const * const pName = "parallel_order";
+		if ( !IsSelected( pName ) )
+			return;
+
+		unsigned int const batches[] = { 1, 16, 256 };
+		unsigned int const kTotalEvents = 200000;
+
+		for ( unsigned int b = 0; b < sizeof( batches ) / sizeof( batches[0] ); ++b )
+		{
+			unsigned int const perTick = batches[b] * 2 + 2;
+			unsigned int const ticks = kTotalEvents / perTick;
+
+			double best = 0.0;
+			unsigned int outOfOrder = 0;
+			for ( unsigned int run = 0; run < kRuns; ++run )
+			{
+				EventManager manager( "EventBench", false );
+				RegisterBenchEvents( manager );
+				boost::shared_ptr< SequenceListener > listener( GCC_NEW SequenceListener() );
+				manager.VAddListener( listener, kBenchEventA );
+				manager.VAddListener( EventListenerPtr( GCC_NEW RetriggerListener( &manager ) ), kBenchEventB );
+
+				unsigned int seq = 0;
+				Stopwatch timer;
+				for ( unsigned int tick = 0; tick < ticks; ++tick )
+				{
+					for ( unsigned int i = 0; i < batches[b]; ++i )
+						manager.VQueueEvent( IEventDataPtr( GCC_NEW SequenceEvent( kBenchEventA, seq++ ) ) );
+					manager.VQueueEvent( IEventDataPtr( GCC_NEW SequenceEvent( kBenchEventB, seq++ ) ) );
+					for ( unsigned int i = 0; i < batches[b]; ++i )
+						manager.VQueueEvent( IEventDataPtr( GCC_NEW SequenceEvent( kBenchEventA, seq++ ) ) );
+					manager.VTick( IEventManager::kINFINITE );
+					manager.VTrigger( SequenceEvent( kBenchEventA, seq++ ) );
+				}
+				manager.WaitForParallelDispatch();
+				double const elapsed = timer.ElapsedNs();
+				if ( run == 0 || elapsed < best )
+					best = elapsed;
+
+				outOfOrder += listener->m_OutOfOrder;
+				if ( listener->m_Next != seq )
+					fprintf( stderr, "parallel_order: the listener saw %u events of %u\n", listener->m_Next, seq );
+			}
+
+			if ( outOfOrder )
+				fprintf( stderr, "parallel_order: %u events out of order\n", outOfOrder );
+			Report( pName, batches[b], ticks * perTick, best );
+		}
+	}
+
+	//
+	// VAbortEvent() of the first event of a type that sits behind
+	// 'depth' events of another type, which is the worst case - it
+	// has to look at the whole queue to find it. One op is one abort.
+	//
+	void BenchAbortEvent( void )
+	{
+		char const * const pName = "abort_event";
+		if ( !IsSelected( pName ) )
+			return;
+
+		unsigned int const depths[] = { 10, 100, 1000, 10000 };
+		unsigned int const kAborts = 1000;
+
+		for ( unsigned int d = 0; d < sizeof( depths ) / sizeof( depths[0] ); ++d )
+		{
+			EventManager manager( "EventBench", false );
+			RegisterBenchEvents( manager );
+			std::vector< CountingListenerPtr > listeners;
+			AddListeners( manager, listeners, 1, kBenchEventA );
+			AddListeners( manager, listeners, 1, kBenchEventB );
+
+			IEventDataPtr const eventA( GCC_NEW BenchEvent( kBenchEventA ) );
+			IEventDataPtr const eventB( GCC_NEW BenchEvent( kBenchEventB ) );
+
+			double best = 0.0;
+			for ( unsigned int run = 0; run < kRuns; ++run )
+			{
+				for ( unsigned int i = 0; i < depths[d]; ++i )
+					manager.VQueueEvent( eventA );
+				for ( unsigned int i = 0; i < kAborts; ++i )
+					manager.VQueueEvent( eventB );
+
+				Stopwatch timer;
+				for ( unsigned int i = 0; i < kAborts; ++i )
+					manager.VAbortEvent( kBenchEventB, false );
+				double const elapsed = timer.ElapsedNs();
+				if ( run == 0 || elapsed < best )
+					best = elapsed;
+
+				manager.VAbortEvent( kBenchEventA, true );
+			}
+
+			assert( listeners[1]->m_Count == 0 );
+			Report( pName, depths[d], kAborts, best );
+		}
+	}
+
+	//
+	// The TimerWheel behind VQueueEventAt() with 100,000 timers due
+	// at random over the next minute, on a simulated clock:
+	//
+	//	timer_schedule		one op is one Schedule()
+	//	timer_cancel		one op is one Cancel(), of every tenth timer
+	//	timer_advance		one op is one 16 ms Advance() while the
+	//					rest come due, until none are left
+	//	timer_idle_tick		one op is one 16 ms Advance() with 'param'
+	//					timers parked an hour out and none due
+	//
+	// 'param' is the number of timers pending.
+	//
+	void BenchTimerWheel( void )
+	{
+		if ( !IsSelected( "timer_schedule" ) && !IsSelected( "timer_cancel" )
+			&& !IsSelected( "timer_advance" ) && !IsSelected( "timer_idle_tick" ) )
+			return;
+
+		unsigned int const kTimers = 100000;
+		unsigned int const kSpanMs = 60000;
+		unsigned int const kTickMs = 16;
+		unsigned int const kIdleTicks = 10000;
+
+		IEventDataPtr const event( GCC_NEW BenchEvent( kBenchEventA ) );
+		std::vector< IEventManager::TimerId > ids( kTimers );
+		std::vector< IEventDataPtr > expired;
+		expired.reserve( kTimers );
+
+		// the same spread of times every run
+		std::vector< unsigned long > delays( kTimers );
+		srand( 1 );
+		for ( unsigned int i = 0; i < kTimers; ++i )
+			delays[i] = ( ( rand() << 15 ) | rand() ) % kSpanMs + 1;
+
+		double bestSchedule = 0.0, bestCancel = 0.0, bestAdvance = 0.0;
+		unsigned int cancelled = 0, ticks = 0;
+		for ( unsigned int run = 0; run < kRuns; ++run )
+		{
+			unsigned long now = 0;
+			TimerWheel wheel( now );
+
+			Stopwatch scheduleTimer;
+			for ( unsigned int i = 0; i < kTimers; ++i )
+				ids[i] = wheel.Schedule( event, now + delays[i] );
+			double const scheduleNs = scheduleTimer.ElapsedNs();
+
+			cancelled = 0;
+			Stopwatch cancelTimer;
+			for ( unsigned int i = 0; i < kTimers; i += 10 )
+			{
+				if ( wheel.Cancel( ids[i] ) )
+					++cancelled;
+			}
+			double const cancelNs = cancelTimer.ElapsedNs();
+
+			unsigned int fired = 0;
+			ticks = 0;
+			Stopwatch advanceTimer;
+			while ( wheel.GetPendingCount() > 0 )
+			{
+				now += kTickMs;
+				wheel.Advance( now, expired );
+				fired += static_cast< unsigned int >( expired.size() );
+				expired.clear();
+				++ticks;
+			}
+			double const advanceNs = advanceTimer.ElapsedNs();
+
+			if ( fired + cancelled != kTimers )
+				fprintf( stderr, "timer_advance: %u fired and %u cancelled of %u\n", fired, cancelled, kTimers );
+
+			if ( run == 0 || scheduleNs < bestSchedule )
+				bestSchedule = scheduleNs;
+			if ( run == 0 || cancelNs < bestCancel )
+				bestCancel = cancelNs;
+			if ( run == 0 || advanceNs < bestAdvance )
+				bestAdvance = advanceNs;
+		}
+
+		if ( IsSelected( "timer_schedule" ) )
+			Report( "timer_schedule", kTimers, kTimers, bestSchedule );
+		if ( IsSelected( "timer_cancel" ) )
+			Report( "timer_cancel", kTimers, cancelled, bestCancel );
+		if ( IsSelected( "timer_advance" ) )
+			Report( "timer_advance", kTimers, ticks, bestAdvance );
+
+		if ( !IsSelected( "timer_idle_tick" ) )
+			return;
+
+		unsigned int const pendings[] = { 1, kTimers };
+
+		for ( unsigned int p = 0; p < sizeof( pendings ) / sizeof( pendings[0] ); ++p )
+		{
+			unsigned long now = 0;
+			TimerWheel wheel( now );
+			for ( unsigned int i = 0; i < pendings[p]; ++i )
+				wheel.Schedule( event, now + 3600000 + i );
+
+			double best = 0.0;
+			for ( unsigned int run = 0; run < kRuns; ++run )
+			{
+				Stopwatch timer;
+				for ( unsigned int i = 0; i < kIdleTicks; ++i )
+				{
+					now += kTickMs;
+					wheel.Advance( now, expired );
+				}
+				double const elapsed = timer.ElapsedNs();
+				if ( run == 0 || elapsed < best )
+					best = elapsed;
+			}
+
+			if ( !expired.empty() || wheel.GetPendingCount() != pendings[p] )
+				fprintf( stderr, "timer_idle_tick: %u came due early\n", static_cast< unsigned int >( expired.size() ) );
+			Report( "timer_idle_tick", pendings[p], kIdleTicks, best );
+		}
+	}
+
+	//
+	// VThreadSafeQueueEvent() from 1, 2 and 4 producer threads while
+	// the main thread ticks, as the game loop does while realtime
+	// processes feed it. One op is one event, from the first push to
+	// the last one handled.
+	//
+	void Produce( EventManager * pManager, IEventDataPtr event, unsigned int count )
+	{
+		for ( unsigned int i = 0; i < count; ++i )
+			pManager->VThreadSafeQueueEvent( event );
+	}
+
+	void BenchThreadSafeQueue( void )
+	{
+		char const * const pName = "threadsafe_queue";
+		if ( !IsSelected( pName ) )
+			return;
+
+		unsigned int const producers[] = { 1, 2, 4 };
+		unsigned int const kTotalEvents = 400000;
+
+		for ( unsigned int p = 0; p < sizeof( producers ) / sizeof( producers[0] ); ++p )
+		{
+			EventManager manager( "EventBench", false );
+			RegisterBenchEvents( manager );
+			std::vector< CountingListenerPtr > listeners;
+			AddListeners( manager, listeners, 1, kBenchEventA );
+
+			IEventDataPtr const event( GCC_NEW BenchEvent( kBenchEventA ) );
+			unsigned int const perProducer = kTotalEvents / producers[p];
+			unsigned int const total = perProducer * producers[p];
+
+			double best = 0.0;
+			for ( unsigned int run = 0; run < kRuns; ++run )
+			{
+				listeners[0]->m_Count = 0;
+
+				Stopwatch timer;
+				std::vector< boost::thread * > threads;
+				for ( unsigned int i = 0; i < producers[p]; ++i )
+					threads.push_back( GCC_NEW boost::thread( &Produce, &manager, event, perProducer ) );
+
+				while ( listeners[0]->m_Count < total )
+					manager.VTick( IEventManager::kINFINITE );
+				double const elapsed = timer.ElapsedNs();
+
+				for ( unsigned int i = 0; i < threads.size(); ++i )
+				{
+					threads[i]->join();
+					SAFE_DELETE( threads[i] );
+				}
+
+				if ( run == 0 || elapsed < best )
+					best = elapsed;
+			}
+
+			Report( pName, producers[p], total, best );
+		}
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	if ( argc > 1 )
+		g_pFilter = argv[1];
+
+	BenchListenerChurn();
+	BenchTriggerFanout();
+	BenchChannelTrigger();
+	BenchQueueTick();
+	BenchParallelOrder();
+	BenchAbortEvent();
+	BenchThreadSafeQueue();
+	BenchTimerWheel();
+
+	return 0;
+}
@@ -0,0 +1,364 @@
+#pragma once
+//========================================================================
+// GameCodeStd.h : Stand-in for the precompiled header in headless builds
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  Not in the book
+//========================================================================
+
+// Headless builds - the benchmarks and tools in this directory, built
+// by its Makefile - put this directory ahead of Source on the include
+// path, so the "GameCodeStd.h" every .cpp starts with comes from here
+// instead of the real one. It has the standard library and boost
+// parts of the real one and none of DirectX or DXUT.
+//
+// Off Windows it also covers the handful of Win32 calls the event
+// system makes - clocks, thread ids, debugger output, and the thread
+// and auto-reset event the journal writer runs on - with POSIX ones.
+// Like the game, it's a UNICODE build, so TCHAR is a wide character.
+// Anything else that's Win32-only shouldn't be in a headless build in
+// the first place.
+
+#ifdef WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <tchar.h>
+
+#else
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+
+typedef int				BOOL;
+typedef unsigned char	BYTE;
+typedef unsigned short	WORD;
+typedef unsigned int	DWORD;
+typedef int				LONG;
+typedef long long		LONGLONG;
+typedef unsigned int	UINT;
+typedef int				INT;
+typedef long			HRESULT;
+typedef char			CHAR;
+typedef wchar_t			TCHAR;
+typedef wchar_t			WCHAR;
+typedef void *			LPVOID;
+typedef void *			HWND;
+
+#define __int64 long long
+
+#define TRUE		1
+#define FALSE		0
+#define INFINITE	0xffffffff
+#define MAX_PATH	260
+#define S_OK		0
+#define E_FAIL		0x80004005L
+#define WINAPI
+#define WAIT_OBJECT_0	0
+#define WAIT_TIMEOUT	258
+
+#define _T(x)		L ## x
+
+#define _snprintf	snprintf
+#define stricmp		strcasecmp
+#define _stricmp	strcasecmp
+
+struct LARGE_INTEGER
+{
+	LONGLONG QuadPart;
+};
+
+inline BOOL QueryPerformanceFrequency( LARGE_INTEGER * pFrequency )
+{
+	pFrequency->QuadPart = 1000000000LL;
+	return TRUE;
+}
+
+inline BOOL QueryPerformanceCounter( LARGE_INTEGER * pCount )
+{
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	pCount->QuadPart = static_cast< LONGLONG >( now.tv_sec ) * 1000000000LL + now.tv_nsec;
+	return TRUE;
+}
+
+// Like the real thing, milliseconds that wrap after 49.7 days.
+inline DWORD GetTickCount( void )
+{
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return static_cast< DWORD >( static_cast< unsigned long long >( now.tv_sec ) * 1000 + now.tv_nsec / 1000000 );
+}
+
+inline DWORD timeGetTime( void )
+{
+	return GetTickCount();
+}
+
+inline DWORD GetCurrentThreadId( void )
+{
+	return static_cast< DWORD >( syscall( SYS_gettid ) );
+}
+
+inline void Sleep( DWORD milliseconds )
+{
+	usleep( milliseconds * 1000 );
+}
+
+// There's no debugger window to write to, so it goes to stderr, which
+// leaves stdout for benchmark results.
+inline void OutputDebugStringA( char const * pString )
+{
+	fputs( pString, stderr );
+}
+
+inline DWORD GetModuleFileNameA( void *, char * pFileName, DWORD size )
+{
+	ssize_t const length = readlink( "/proc/self/exe", pFileName, size - 1 );
+	pFileName[ length > 0 ? length : 0 ] = 0;
+	return length > 0 ? static_cast< DWORD >( length ) : 0;
+}
+
+inline LONG InterlockedExchange( LONG volatile * pTarget, LONG value )
+{
+	__sync_synchronize();
+	return __sync_lock_test_and_set( pTarget, value );
+}
+
+inline LONG InterlockedCompareExchange( LONG volatile * pTarget, LONG exchange, LONG comparand )
+{
+	return __sync_val_compare_and_swap( pTarget, comparand, exchange );
+}
+
+// A HANDLE is either an auto-reset event or a thread - the only two
+// kinds of kernel object the event system waits on.
+class HeadlessHandle
+{
+public:
+	virtual ~HeadlessHandle() { }
+	virtual DWORD Wait( DWORD milliseconds ) = 0;
+};
+
+typedef HeadlessHandle * HANDLE;
+typedef DWORD ( WINAPI * LPTHREAD_START_ROUTINE )( LPVOID );
+
+class HeadlessEvent : public HeadlessHandle
+{
+public:
+	HeadlessEvent() : m_bSignaled( false )
+	{
+		pthread_mutex_init( &m_Mutex, NULL );
+		pthread_cond_init( &m_Cond, NULL );
+	}
+
+	virtual ~HeadlessEvent()
+	{
+		pthread_cond_destroy( &m_Cond );
+		pthread_mutex_destroy( &m_Mutex );
+	}
+
+	void Set( void )
+	{
+		pthread_mutex_lock( &m_Mutex );
+		m_bSignaled = true;
+		pthread_cond_signal( &m_Cond );
+		pthread_mutex_unlock( &m_Mutex );
+	}
+
+	virtual DWORD Wait( DWORD milliseconds )
+	{
+		timespec deadline;
+		clock_gettime( CLOCK_REALTIME, &deadline );
+		deadline.tv_sec += milliseconds / 1000;
+		deadline.tv_nsec += ( milliseconds % 1000 ) * 1000000;
+		if ( deadline.tv_nsec >= 1000000000 )
+		{
+			++deadline.tv_sec;
+			deadline.tv_nsec -= 1000000000;
+		}
+
+		pthread_mutex_lock( &m_Mutex );
+		int rc = 0;
+		while ( !m_bSignaled && rc == 0 )
+		{
+			rc = milliseconds == INFINITE
+				? pthread_cond_wait( &m_Cond, &m_Mutex )
+				: pthread_cond_timedwait( &m_Cond, &m_Mutex, &deadline );
+		}
+		bool const bSignaled = m_bSignaled;
+		m_bSignaled = false;				// auto-reset
+		pthread_mutex_unlock( &m_Mutex );
+
+		return bSignaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+	}
+
+private:
+	pthread_mutex_t m_Mutex;
+	pthread_cond_t  m_Cond;
+	bool            m_bSignaled;
+};
+
+class HeadlessThread : public HeadlessHandle
+{
+public:
+	HeadlessThread( LPTHREAD_START_ROUTINE pStart, LPVOID pParam )
+		: m_pStart( pStart ), m_pParam( pParam ), m_bJoined( false )
+	{
+		m_bStarted = pthread_create( &m_Thread, NULL, &HeadlessThread::Run, this ) == 0;
+	}
+
+	virtual ~HeadlessThread()
+	{
+		if ( m_bStarted && !m_bJoined )
+			pthread_detach( m_Thread );
+	}
+
+	bool IsStarted( void ) const { return m_bStarted; }
+
+	// Only waiting for the thread to finish is supported.
+	virtual DWORD Wait( DWORD milliseconds )
+	{
+		assert( milliseconds == INFINITE );
+		if ( m_bStarted && !m_bJoined )
+		{
+			pthread_join( m_Thread, NULL );
+			m_bJoined = true;
+		}
+		return WAIT_OBJECT_0;
+	}
+
+private:
+	static void * Run( void * pThis )
+	{
+		HeadlessThread * pThread = static_cast< HeadlessThread * >( pThis );
+		pThread->m_pStart( pThread->m_pParam );
+		return NULL;
+	}
+
+	LPTHREAD_START_ROUTINE m_pStart;
+	LPVOID                 m_pParam;
+	pthread_t              m_Thread;
+	bool                   m_bStarted;
+	bool                   m_bJoined;
+};
+
+// Always auto-reset and unsignaled to start - the only kind used.
+inline HANDLE CreateEvent( void *, BOOL bManualReset, BOOL bInitialState, void * )
+{
+	assert( !bManualReset && !bInitialState );
+	return new HeadlessEvent();
+}
+
+inline BOOL SetEvent( HANDLE hEvent )
+{
+	static_cast< HeadlessEvent * >( hEvent )->Set();
+	return TRUE;
+}
+
+inline HANDLE CreateThread( void *, size_t, LPTHREAD_START_ROUTINE pStart, LPVOID pParam, DWORD, DWORD * )
+{
+	HeadlessThread * pThread = new HeadlessThread( pStart, pParam );
+	if ( !pThread->IsStarted() )
+	{
+		delete pThread;
+		return NULL;
+	}
+	return pThread;
+}
+
+inline DWORD WaitForSingleObject( HANDLE handle, DWORD milliseconds )
+{
+	return handle->Wait( milliseconds );
+}
+
+inline BOOL CloseHandle( HANDLE handle )
+{
+	delete handle;
+	return TRUE;
+}
+
+#endif
+
+
+// C RunTime Header Files
+#include <stdlib.h>
+#include <assert.h>
+
+#include <algorithm>
+#include <string>
+#include <list>
+#include <vector>
+#include <queue>
+#include <map>
+
+
+#if defined(_DEBUG) && defined(WIN32)
+#	include <crtdbg.h>
+#	define GCC_NEW new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#else
+#	define GCC_NEW new
+#endif
+
+
+#include <boost/config.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+using boost::shared_ptr;
+
+
+#if !defined(SAFE_DELETE)
+	#define SAFE_DELETE(x) if(x) delete x; x=NULL;
+#endif
+
+#if !defined(SAFE_DELETE_ARRAY)
+	#define SAFE_DELETE_ARRAY(x) if (x) delete [] x; x=NULL;
+#endif
+
+
+// interfaces.h is all DirectX, so of it only the actor id the event
+// system needs is repeated here.
+typedef unsigned int ActorId;
@@ -0,0 +1,1082 @@
+//========================================================================
+// LoadGen.cpp : Headless multi-client load generator
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  LoadGen						- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "../Network/SocketManager.h"
+#include "../Network/NetworkEvents.h"
+#include "../EventManager/EventManagerImpl.h"
+
+#include <deque>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// LoadGen Description
+//
+// A load test for the game server that needs nothing but this box -
+// no DirectX clients, no second machine. It opens a lot of
+// connections over loopback that talk the way a RemoteEventSocket
+// does, logs each one in, and has them all send Thrust, Steer and
+// Fire_Weapon events at a steady rate, as many players would.
+//
+//	./LoadGen						64 clients for 10 seconds
+//	./LoadGen -c 500 -s 30 -t 20	500 clients, 20 thrusts a second each
+//	./LoadGen -p 20000				a server already listening on 20000
+//
+//	-c clients		how many connections ( 64 )
+//	-s seconds		how long they send for ( 10 )
+//	-t rate			Thrust events a second, per client ( 10 )
+//	-r rate			Steer events a second, per client ( 10 )
+//	-f rate			Fire_Weapon events a second, per client ( 2 )
+//	-p port			send to a server that's already running, instead
+//					of the stand-in one
+//	-m ms			the stand-in server's frame ( 16 )
+//	-T				the stand-in server's sockets on a network thread
+//					- see BaseSocketManager::StartThread()
+//	-v				each of its connections' NetSocketStats at the end
+//
+// Without -p this process is the server and a child process is all
+// of the clients. The stand-in server is what GameServerListenSocket
+// and the game do with a connection, without the game: it makes a
+// RemoteEventSocket-like socket for each one, and on the game thread
+// gives it an actor and sends it NetMsg_PlayerLoginOk, as
+// NetworkGameView::VOnAttach() does. The events it reads go through
+// an EventManager to a game logic listener, which counts them and
+// sends each back to the client it came from - as a NetworkEventForwarder
+// would - once it's been handled.
+//
+// A client sends its events in order, and gets them back in order, so
+// the time from sending each to getting it back is the whole round
+// trip: both socket layers, and however long the event waited for the
+// server's next frame. A server that doesn't send them back - a real
+// one, with -p - only gets pinged for round trip times.
+//
+// The events here are stand-ins for the game's EvtData_Thrust,
+// EvtData_Steer and EvtData_Fire_Weapon, which need the rest of the
+// game to build; they have the same names, wire ids and binary form,
+// so the server can't tell the difference.
+//
+// Results are JSON lines on stdout, like the benchmarks': one for the
+// clients - what they sent, how much came back and how long it took,
+// in percentiles - and one for the stand-in server, with the events a
+// second its game logic handled and what its frames cost.
+
+namespace
+{
+	const unsigned int kDefaultClients = 64;
+	const unsigned int kDefaultSeconds = 10;
+	const float kDefaultThrustRate = 10.0f;
+	const float kDefaultSteerRate = 10.0f;
+	const float kDefaultFireRate = 2.0f;
+	const unsigned int kDefaultFrameMs = 16;
+
+	const unsigned int kConnectTimeoutMs = 30000;
+	const unsigned int kDrainMs = 2000;
+	const unsigned int kPingIntervalMs = 1000;		// as RemoteEventSocket's
+	const unsigned int kRecvChunk = 64 * 1024;
+
+	struct Options
+	{
+		Options()
+			: m_Clients(kDefaultClients), m_Seconds(kDefaultSeconds), m_Port(0),
+			  m_FrameMs(kDefaultFrameMs), m_bThreaded(false), m_bVerbose(false)
+		{
+			m_Rates[0] = kDefaultThrustRate;
+			m_Rates[1] = kDefaultSteerRate;
+			m_Rates[2] = kDefaultFireRate;
+		}
+
+		unsigned int m_Clients;
+		unsigned int m_Seconds;
+		float m_Rates[3];				// by eCommand
+		unsigned short m_Port;
+		unsigned int m_FrameMs;
+		bool m_bThreaded;
+		bool m_bVerbose;
+	};
+
+	// --- the events ---
+
+	enum eCommand
+	{
+		kThrust,
+		kSteer,
+		kFireWeapon,
+		kCommands
+	};
+
+	char const * const g_CommandNames[kCommands] = { "thrust", "steer", "fire_weapon" };
+
+	// What EvtData_Thrust, EvtData_Steer and EvtData_Fire_Weapon all
+	// are - an actor, and for all but firing, how hard.
+	class LoadCommandEvent : public BaseEventData
+	{
+	public:
+		LoadCommandEvent( eCommand command, ActorId id, float value )
+			: m_Command( command ), m_Id( id ), m_Value( value )
+		{
+		}
+
+		LoadCommandEvent( eCommand command, BinaryInStream & in )
+			: m_Command( command )
+		{
+			m_Id = in.ReadU32();
+			m_Value = command == kFireWeapon ? 0.0f : in.ReadFloat();
+		}
+
+		virtual void VSerialize( std::ostrstream & out ) const
+		{
+			out << m_Id << " ";
+			if ( m_Command != kFireWeapon )
+				out << m_Value << " ";
+		}
+
+		virtual void VSerializeBinary( BinaryOutStream & out ) const
+		{
+			out.WriteU32( m_Id );
+			if ( m_Command != kFireWeapon )
+				out.WriteFloat( m_Value );
+		}
+
+		virtual LuaObject VGetLuaEventData( void ) const
+		{
+			return m_LuaEventData;
+		}
+
+		virtual void VBuildLuaEventData( void )
+		{
+			m_bHasLuaEventData = true;
+		}
+
+		eCommand m_Command;
+		ActorId m_Id;
+		float m_Value;
+
+	private:
+		LuaObject m_LuaEventData;
+	};
+
+	template < int Command >
+	class LoadCommand : public LoadCommandEvent
+	{
+	public:
+		static const EventType sk_EventType;
+		virtual const EventType & VGetEventType( void ) const
+		{
+			return sk_EventType;
+		}
+
+		LoadCommand( ActorId id, float value )
+			: LoadCommandEvent( static_cast< eCommand >( Command ), id, value )
+		{
+		}
+
+		explicit LoadCommand( BinaryInStream & in )
+			: LoadCommandEvent( static_cast< eCommand >( Command ), in )
+		{
+		}
+
+		virtual IEventDataPtr VCopy() const
+		{
+			return IEventDataPtr( GCC_NEW LoadCommand( *this ) );
+		}
+	};
+
+	template <> const EventType LoadCommand< kThrust >::sk_EventType( g_CommandNames[kThrust] );
+	template <> const EventType LoadCommand< kSteer >::sk_EventType( g_CommandNames[kSteer] );
+	template <> const EventType LoadCommand< kFireWeapon >::sk_EventType( g_CommandNames[kFireWeapon] );
+
+	// What the stand-in server's listen socket hands its game, as
+	// GameServerListenSocket does EvtData_Remote_Client. It never goes
+	// over the network.
+	class LoadRemoteClientEvent : public BaseEventData
+	{
+	public:
+		static const EventType sk_EventType;
+		virtual const EventType & VGetEventType( void ) const
+		{
+			return sk_EventType;
+		}
+
+		explicit LoadRemoteClientEvent( int sockId )
+			: m_SockId( sockId )
+		{
+		}
+
+		virtual void VSerialize( std::ostrstream & out ) const
+		{
+			out << m_SockId << " ";
+		}
+
+		virtual void VSerializeBinary( BinaryOutStream & out ) const
+		{
+			out.WriteI32( m_SockId );
+		}
+
+		virtual IEventDataPtr VCopy() const
+		{
+			return IEventDataPtr( GCC_NEW LoadRemoteClientEvent( m_SockId ) );
+		}
+
+		virtual LuaObject VGetLuaEventData( void ) const
+		{
+			return m_LuaEventData;
+		}
+
+		virtual void VBuildLuaEventData( void )
+		{
+			m_bHasLuaEventData = true;
+		}
+
+		int m_SockId;
+
+	private:
+		LuaObject m_LuaEventData;
+	};
+
+	const EventType LoadRemoteClientEvent::sk_EventType( "loadgen_remote_client" );
+
+	// --- timing and reporting ---
+
+	double NowNs()
+	{
+		LARGE_INTEGER frequency, now;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&now);
+		return double(now.QuadPart) * 1.0e9 / double(frequency.QuadPart);
+	}
+
+	double CpuNs()
+	{
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1.0e9 +
+			(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0e3;
+	}
+
+	// 'samples' is sorted
+	double Percentile(std::vector<double> const &samples, unsigned int percent)
+	{
+		if (samples.empty())
+			return 0.0;
+		size_t index = samples.size() * percent / 100;
+		return samples[index < samples.size() ? index : samples.size() - 1];
+	}
+
+	// {"p50":..,"p90":..,"p99":..,"max":..} in milliseconds, from
+	// samples in nanoseconds
+	std::string PercentilesMs(std::vector<double> &samples)
+	{
+		std::sort(samples.begin(), samples.end());
+
+		char buffer[128];
+		_snprintf(buffer, sizeof(buffer)-1, "{\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}",
+			Percentile(samples, 50) / 1.0e6, Percentile(samples, 90) / 1.0e6,
+			Percentile(samples, 99) / 1.0e6, samples.empty() ? 0.0 : samples.back() / 1.0e6);
+		buffer[sizeof(buffer)-1] = 0;
+		return buffer;
+	}
+
+	// --- the stand-in server ---
+
+	// What RemoteEventSocket does with what it reads, less what only a
+	// client gets.
+	class LoadServerSocket : public NetSocket
+	{
+	public:
+		LoadServerSocket(SOCKET new_sock, unsigned int hostIP) : NetSocket(new_sock, hostIP) { }
+
+	protected:
+		virtual void HandlePacket(IPacket const &packet)
+		{
+			char const *pData = packet.VGetData() + sizeof(u_long);
+			unsigned int const size = packet.VGetSize() - sizeof(u_long);
+			if (!EventWire::IsBinaryMessage(pData, size))
+				return;
+
+			BinaryInStream in(pData, size);
+			switch (in.ReadU8())
+			{
+				case EventWire::kMsgEvent:
+				{
+					IEventDataPtr event = EventWire::ReadEvent(in);
+					if (event)
+						g_pSocketManager->QueueEvent(event);
+					break;
+				}
+
+				case EventWire::kMsgPing:
+				{
+					unsigned int stamp = in.ReadU32();
+					if (in.IsOk())
+					{
+						BinaryOutStream out;
+						EventWire::WritePing(EventWire::kMsgPong, stamp, out);
+						Send(shared_ptr<IPacket>(GCC_NEW BinaryPacket(out.GetData(), out.GetSize())), false);
+					}
+					break;
+				}
+			}
+		}
+	};
+
+	class LoadListenSocket : public NetListenSocket
+	{
+	public:
+		LoadListenSocket() : m_Accepted(0)
+		{
+			// port 0 - whatever's free
+			Init(0);
+
+			struct sockaddr_in sa;
+			socklen_t size = sizeof(sa);
+			getsockname(m_sock, (struct sockaddr *)&sa, &size);
+			port = ntohs(sa.sin_port);
+		}
+
+		// GameServerListenSocket::HandleInput()
+		virtual void HandleInput()
+		{
+			unsigned int ipaddr;
+			SOCKET new_sock = AcceptConnection(&ipaddr);
+			if (new_sock != INVALID_SOCKET)
+			{
+				int sockId = g_pSocketManager->AddSocket(GCC_NEW LoadServerSocket(new_sock, ipaddr));
+				g_pSocketManager->QueueEvent(IEventDataPtr(GCC_NEW LoadRemoteClientEvent(sockId)));
+				++m_Accepted;
+			}
+		}
+
+		unsigned int m_Accepted;
+	};
+
+	// The game, as far as the network can tell: it gives each new
+	// client an actor and logs it in, and sends every command back to
+	// whoever sent it.
+	class LoadGameLogic : public IEventListener
+	{
+	public:
+		LoadGameLogic() : m_NextActorId(1), m_Handled(0), m_FirstNs(0.0), m_LastNs(0.0)
+		{
+			memset(m_Commands, 0, sizeof(m_Commands));
+		}
+
+		virtual char const *GetName(void) { return "LoadGameLogic"; }
+
+		virtual bool HandleEvent(IEventData const &event)
+		{
+			if (event.VGetEventType() == LoadRemoteClientEvent::sk_EventType)
+			{
+				// NetworkGameView::VOnAttach()
+				int const sockId = static_cast<LoadRemoteClientEvent const &>(event).m_SockId;
+				ActorId const actorId = m_NextActorId++;
+				m_Players[actorId] = sockId;
+
+				m_Out.Clear();
+				EventWire::WritePlayerLoginOk(sockId, actorId, m_Out);
+				g_pSocketManager->Send(sockId, shared_ptr<IPacket>(GCC_NEW BinaryPacket(m_Out.GetData(), m_Out.GetSize())));
+				return false;
+			}
+
+			LoadCommandEvent const &command = static_cast<LoadCommandEvent const &>(event);
+
+			double const now = NowNs();
+			if (!m_Handled)
+				m_FirstNs = now;
+			m_LastNs = now;
+			++m_Handled;
+			++m_Commands[command.m_Command];
+
+			std::map<ActorId, int>::const_iterator it = m_Players.find(command.m_Id);
+			if (it != m_Players.end())
+			{
+				shared_ptr<IPacket> packet = EventWire::CreatePacket(event, m_Out);
+				if (packet)
+					g_pSocketManager->Send(it->second, packet);
+			}
+			return false;
+		}
+
+		ActorId m_NextActorId;
+		std::map<ActorId, int> m_Players;			// actor to socket id
+		BinaryOutStream m_Out;
+
+		unsigned int m_Handled;
+		unsigned int m_Commands[kCommands];
+		double m_FirstNs;
+		double m_LastNs;
+	};
+
+	// --- the clients ---
+
+	struct LoadClient
+	{
+		LoadClient() : m_Sock(INVALID_SOCKET), m_bLoggedIn(false), m_ActorId(0), m_InBegin(0), m_OutBegin(0) { }
+
+		SOCKET m_Sock;
+		bool m_bLoggedIn;
+		ActorId m_ActorId;
+
+		std::vector<char> m_In;						// not yet parsed, from m_InBegin
+		size_t m_InBegin;
+		std::vector<char> m_Out;					// not yet sent, from m_OutBegin
+		size_t m_OutBegin;
+
+		double m_NextCommand[kCommands];			// when each is next due
+		double m_NextPing;
+		std::deque<double> m_InFlight;				// when each command not yet back was sent
+	};
+
+	class LoadClients
+	{
+	public:
+		LoadClients(Options const &options)
+			: m_Options(options), m_Sent(0), m_Echoed(0), m_Other(0), m_MaxBacklog(0), m_bFailed(false)
+		{
+			memset(m_SentCommands, 0, sizeof(m_SentCommands));
+		}
+
+		bool Connect(unsigned short port);
+		bool LogIn();
+		void Run();
+		void Report();
+
+	private:
+		void Schedule(LoadClient &client, double now);
+		void SendCommand(LoadClient &client, eCommand command);
+		void SendMessage(LoadClient &client, BinaryOutStream const &message);
+		void Flush(LoadClient &client);
+		void Read(LoadClient &client);
+		void HandleMessage(LoadClient &client, char const *pData, unsigned int size);
+		bool Poll(int timeoutMs);
+		unsigned int CountLoggedIn() const;
+
+		Options const &m_Options;
+		std::vector<LoadClient> m_Clients;
+		std::vector<struct pollfd> m_PollFds;
+		BinaryOutStream m_Message;
+
+		unsigned int m_Sent;
+		unsigned int m_SentCommands[kCommands];
+		unsigned int m_Echoed;
+		unsigned int m_Other;						// events that weren't ours coming back
+		size_t m_MaxBacklog;
+		bool m_bFailed;
+
+		double m_StartNs;
+		double m_SentNs;							// how long the sending took
+		double m_CpuNs;
+
+		std::vector<double> m_ConnectNs;
+		std::vector<double> m_LoginNs;
+		std::vector<double> m_Latency;
+		std::vector<double> m_RoundTrip;
+	};
+
+	//
+	// LoadClients::Connect
+	//
+	bool LoadClients::Connect(unsigned short port)
+	{
+		m_Clients.resize(m_Options.m_Clients);
+		m_PollFds.resize(m_Options.m_Clients);
+
+		m_StartNs = NowNs();
+		for (unsigned int i = 0; i < m_Clients.size(); ++i)
+		{
+			double const begin = NowNs();
+
+			SOCKET sock = socket(PF_INET, SOCK_STREAM, 0);
+			if (sock == INVALID_SOCKET)
+				return false;
+
+			struct sockaddr_in sa;
+			memset(&sa, 0, sizeof(sa));
+			sa.sin_family = AF_INET;
+			sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			sa.sin_port = htons(port);
+
+			if (connect(sock, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+			{
+				fprintf(stderr, "LoadGen: connection %u of %u failed: %s\n", i + 1, m_Options.m_Clients, strerror(errno));
+				closesocket(sock);
+				return false;
+			}
+
+			// as NetSocket::Connect() does
+			int x = 1;
+			setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&x, sizeof(x));
+			fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+			// close with a reset, so thousands of them don't sit in TIME_WAIT
+			struct linger lingerOff = { 1, 0 };
+			setsockopt(sock, SOL_SOCKET, SO_LINGER, (char *)&lingerOff, sizeof(lingerOff));
+
+			m_Clients[i].m_Sock = sock;
+			m_PollFds[i].fd = sock;
+			m_ConnectNs.push_back(NowNs() - begin);
+		}
+		return true;
+	}
+
+	//
+	// LoadClients::LogIn
+	//
+	//   Waits for NetMsg_PlayerLoginOk on every connection.
+	//
+	bool LoadClients::LogIn()
+	{
+		unsigned int const start = timeGetTime();
+		while (CountLoggedIn() < m_Clients.size() && timeGetTime() - start < kConnectTimeoutMs && !m_bFailed)
+			Poll(100);
+
+		if (CountLoggedIn() < m_Clients.size())
+		{
+			fprintf(stderr, "LoadGen: only %u of %u clients logged in\n", CountLoggedIn(), static_cast<unsigned int>(m_Clients.size()));
+			return false;
+		}
+		return true;
+	}
+
+	//
+	// LoadClients::Run
+	//
+	//   Each client's commands are spread evenly over the second, and
+	//   the clients are spread over each other, so they don't all send
+	//   at once.
+	//
+	void LoadClients::Run()
+	{
+		double const start = NowNs();
+		double const cpuStart = CpuNs();
+		double const end = start + m_Options.m_Seconds * 1.0e9;
+
+		for (unsigned int i = 0; i < m_Clients.size(); ++i)
+		{
+			double const phase = double(i) / m_Clients.size();
+			for (int c = 0; c < kCommands; ++c)
+				m_Clients[i].m_NextCommand[c] = m_Options.m_Rates[c] > 0.0f ? start + phase * 1.0e9 / m_Options.m_Rates[c] : end;
+			m_Clients[i].m_NextPing = start + phase * kPingIntervalMs * 1.0e6;
+		}
+
+		double now;
+		while ((now = NowNs()) < end && !m_bFailed)
+		{
+			double next = end;
+			for (unsigned int i = 0; i < m_Clients.size(); ++i)
+			{
+				LoadClient &client = m_Clients[i];
+				Schedule(client, now);
+				Flush(client);
+
+				for (int c = 0; c < kCommands; ++c)
+					next = std::min(next, client.m_NextCommand[c]);
+				next = std::min(next, client.m_NextPing);
+			}
+
+			Poll(static_cast<int>(ceil((next - NowNs()) / 1.0e6)));
+		}
+		m_SentNs = NowNs() - start;
+
+		// what's still on its way back
+		unsigned int const drainStart = timeGetTime();
+		for (;;)
+		{
+			bool bWaiting = false;
+			for (unsigned int i = 0; i < m_Clients.size(); ++i)
+			{
+				Flush(m_Clients[i]);
+				bWaiting |= !m_Clients[i].m_InFlight.empty();
+			}
+			if (!bWaiting || m_bFailed || timeGetTime() - drainStart > kDrainMs)
+				break;
+			Poll(10);
+		}
+
+		m_CpuNs = CpuNs() - cpuStart;
+	}
+
+	//
+	// LoadClients::Schedule
+	//
+	void LoadClients::Schedule(LoadClient &client, double now)
+	{
+		for (int c = 0; c < kCommands; ++c)
+		{
+			double const interval = 1.0e9 / m_Options.m_Rates[c];
+			while (client.m_NextCommand[c] <= now)
+			{
+				SendCommand(client, static_cast<eCommand>(c));
+				client.m_NextCommand[c] += interval;
+			}
+		}
+
+		if (client.m_NextPing <= now)
+		{
+			// microseconds, so loopback's round trips show - only this
+			// end reads it
+			m_Message.Clear();
+			EventWire::WritePing(EventWire::kMsgPing, static_cast<unsigned int>(now / 1.0e3), m_Message);
+			SendMessage(client, m_Message);
+			client.m_NextPing += kPingIntervalMs * 1.0e6;
+		}
+	}
+
+	//
+	// LoadClients::SendCommand
+	//
+	void LoadClients::SendCommand(LoadClient &client, eCommand command)
+	{
+		// steering back and forth, and the throttle up and down
+		float const value = static_cast<float>(sin(m_Sent * 0.1));
+
+		m_Message.Clear();
+		switch (command)
+		{
+			case kThrust:		EventWire::WriteEvent(LoadCommand<kThrust>(client.m_ActorId, value), m_Message); break;
+			case kSteer:		EventWire::WriteEvent(LoadCommand<kSteer>(client.m_ActorId, value), m_Message); break;
+			case kFireWeapon:	EventWire::WriteEvent(LoadCommand<kFireWeapon>(client.m_ActorId, 0.0f), m_Message); break;
+			default:			return;
+		}
+
+		SendMessage(client, m_Message);
+		client.m_InFlight.push_back(NowNs());
+		++m_Sent;
+		++m_SentCommands[command];
+	}
+
+	//
+	// LoadClients::SendMessage
+	//
+	//   Frames it as a BinaryPacket does, and queues it.
+	//
+	void LoadClients::SendMessage(LoadClient &client, BinaryOutStream const &message)
+	{
+		u_long const header = htonl(message.GetSize() + sizeof(u_long));
+		char const *pHeader = reinterpret_cast<char const *>(&header);
+
+		client.m_Out.insert(client.m_Out.end(), pHeader, pHeader + sizeof(header));
+		client.m_Out.insert(client.m_Out.end(), message.GetData(), message.GetData() + message.GetSize());
+	}
+
+	//
+	// LoadClients::Flush
+	//
+	//   As much as the socket takes. A server that can't keep up
+	//   leaves it queued here, rather than holding up the others.
+	//
+	void LoadClients::Flush(LoadClient &client)
+	{
+		size_t const backlog = client.m_Out.size() - client.m_OutBegin;
+		m_MaxBacklog = std::max(m_MaxBacklog, backlog);
+		if (!backlog)
+			return;
+
+		int const sent = send(client.m_Sock, &client.m_Out[client.m_OutBegin], backlog, MSG_NOSIGNAL);
+		if (sent > 0)
+		{
+			client.m_OutBegin += sent;
+			if (client.m_OutBegin == client.m_Out.size())
+			{
+				client.m_Out.clear();
+				client.m_OutBegin = 0;
+			}
+		}
+		else if (sent < 0 && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			fprintf(stderr, "LoadGen: send failed: %s\n", strerror(errno));
+			m_bFailed = true;
+		}
+	}
+
+	//
+	// LoadClients::Poll
+	//
+	//   Reads whatever arrives in the next 'timeoutMs'.
+	//
+	bool LoadClients::Poll(int timeoutMs)
+	{
+		for (unsigned int i = 0; i < m_Clients.size(); ++i)
+		{
+			m_PollFds[i].events = POLLIN;
+			if (m_Clients[i].m_Out.size() > m_Clients[i].m_OutBegin)
+				m_PollFds[i].events |= POLLOUT;
+			m_PollFds[i].revents = 0;
+		}
+
+		int const ready = poll(&m_PollFds[0], m_PollFds.size(), timeoutMs > 0 ? timeoutMs : 0);
+		if (ready <= 0)
+			return false;
+
+		for (unsigned int i = 0; i < m_Clients.size(); ++i)
+		{
+			if (m_PollFds[i].revents & (POLLIN | POLLERR | POLLHUP))
+				Read(m_Clients[i]);
+			if (m_PollFds[i].revents & POLLOUT)
+				Flush(m_Clients[i]);
+		}
+		return true;
+	}
+
+	//
+	// LoadClients::Read
+	//
+	void LoadClients::Read(LoadClient &client)
+	{
+		size_t const had = client.m_In.size();
+		client.m_In.resize(had + kRecvChunk);
+
+		int const got = recv(client.m_Sock, &client.m_In[had], kRecvChunk, 0);
+		if (got <= 0)
+		{
+			client.m_In.resize(had);
+			if (got == 0 || (errno != EWOULDBLOCK && errno != EINTR))
+			{
+				fprintf(stderr, "LoadGen: the server closed a connection\n");
+				m_bFailed = true;
+			}
+			return;
+		}
+		client.m_In.resize(had + got);
+
+		// each whole packet - the same framing NetSocket::HandleInput() reads
+		while (client.m_In.size() - client.m_InBegin >= sizeof(u_long))
+		{
+			u_long size;
+			memcpy(&size, &client.m_In[client.m_InBegin], sizeof(size));
+			size = ntohl(size);
+
+			if (size < sizeof(u_long) || size > MAX_PACKET_SIZE)
+			{
+				fprintf(stderr, "LoadGen: a packet of %lu bytes\n", static_cast<unsigned long>(size));
+				m_bFailed = true;
+				return;
+			}
+			if (client.m_In.size() - client.m_InBegin < size)
+				break;
+
+			HandleMessage(client, &client.m_In[client.m_InBegin + sizeof(u_long)], size - sizeof(u_long));
+			client.m_InBegin += size;
+		}
+
+		if (client.m_InBegin == client.m_In.size())
+		{
+			client.m_In.clear();
+			client.m_InBegin = 0;
+		}
+		else if (client.m_InBegin > kRecvChunk)
+		{
+			client.m_In.erase(client.m_In.begin(), client.m_In.begin() + client.m_InBegin);
+			client.m_InBegin = 0;
+		}
+	}
+
+	//
+	// LoadClients::HandleMessage
+	//
+	//   RemoteEventSocket::HandleBinaryMessage(), for a client that
+	//   only wants its own commands back.
+	//
+	void LoadClients::HandleMessage(LoadClient &client, char const *pData, unsigned int size)
+	{
+		if (!EventWire::IsBinaryMessage(pData, size))
+			return;
+
+		BinaryInStream in(pData, size);
+		switch (in.ReadU8())
+		{
+			case EventWire::kMsgPlayerLoginOk:
+			{
+				in.ReadI32();						// the server's socket id
+				int actorId = in.ReadI32();
+				if (in.IsOk() && !client.m_bLoggedIn)
+				{
+					client.m_bLoggedIn = true;
+					client.m_ActorId = actorId;
+					m_LoginNs.push_back(NowNs() - m_StartNs);
+				}
+				break;
+			}
+
+			case EventWire::kMsgEvent:
+			{
+				IEventDataPtr event = EventWire::ReadEvent(in);
+				bool const bCommand = event &&
+					(event->VGetEventType() == LoadCommand<kThrust>::sk_EventType ||
+					 event->VGetEventType() == LoadCommand<kSteer>::sk_EventType ||
+					 event->VGetEventType() == LoadCommand<kFireWeapon>::sk_EventType);
+
+				if (bCommand && static_cast<LoadCommandEvent const &>(*event).m_Id == client.m_ActorId && !client.m_InFlight.empty())
+				{
+					m_Latency.push_back(NowNs() - client.m_InFlight.front());
+					client.m_InFlight.pop_front();
+					++m_Echoed;
+				}
+				else
+				{
+					++m_Other;
+				}
+				break;
+			}
+
+			case EventWire::kMsgPing:
+			{
+				unsigned int stamp = in.ReadU32();
+				if (in.IsOk())
+				{
+					m_Message.Clear();
+					EventWire::WritePing(EventWire::kMsgPong, stamp, m_Message);
+					SendMessage(client, m_Message);
+				}
+				break;
+			}
+
+			case EventWire::kMsgPong:
+			{
+				unsigned int stamp = in.ReadU32();
+				if (in.IsOk())
+					m_RoundTrip.push_back((static_cast<unsigned int>(NowNs() / 1.0e3) - stamp) * 1.0e3);
+				break;
+			}
+		}
+	}
+
+	//
+	// LoadClients::CountLoggedIn
+	//
+	unsigned int LoadClients::CountLoggedIn() const
+	{
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < m_Clients.size(); ++i)
+			count += m_Clients[i].m_bLoggedIn;
+		return count;
+	}
+
+	//
+	// LoadClients::Report
+	//
+	void LoadClients::Report()
+	{
+		double const seconds = m_SentNs / 1.0e9;
+
+		printf("{\"loadgen\":\"clients\",\"clients\":%u,\"logged_in\":%u,\"seconds\":%.2f,"
+			"\"thrust_rate\":%.1f,\"steer_rate\":%.1f,\"fire_rate\":%.1f,"
+			"\"sent\":%u,\"thrust\":%u,\"steer\":%u,\"fire_weapon\":%u,\"sent_per_sec\":%.0f,"
+			"\"echoed\":%u,\"other_events\":%u,\"max_backlog_bytes\":%lu,\"cpu_percent\":%.1f,"
+			"\"connect_ms\":%s,\"login_ms\":%s,\"latency_ms\":%s,\"rtt_ms\":%s}\n",
+			m_Options.m_Clients, CountLoggedIn(), seconds,
+			m_Options.m_Rates[kThrust], m_Options.m_Rates[kSteer], m_Options.m_Rates[kFireWeapon],
+			m_Sent, m_SentCommands[kThrust], m_SentCommands[kSteer], m_SentCommands[kFireWeapon],
+			seconds > 0.0 ? m_Sent / seconds : 0.0,
+			m_Echoed, m_Other, static_cast<unsigned long>(m_MaxBacklog), m_SentNs > 0.0 ? m_CpuNs * 100.0 / m_SentNs : 0.0,
+			PercentilesMs(m_ConnectNs).c_str(), PercentilesMs(m_LoginNs).c_str(),
+			PercentilesMs(m_Latency).c_str(), PercentilesMs(m_RoundTrip).c_str());
+		fflush(stdout);
+	}
+
+	//
+	// RunClients
+	//
+	int RunClients(Options const &options, unsigned short port)
+	{
+		LoadClients clients(options);
+		if (!clients.Connect(port) || !clients.LogIn())
+			return 1;
+
+		clients.Run();
+		clients.Report();
+		return 0;
+	}
+
+	//
+	// RunServer
+	//
+	//   A game loop for the stand-in server, until the clients are done.
+	//
+	int RunServer(Options const &options)
+	{
+		EventManager eventManager("LoadGen", true);
+		eventManager.RegisterCodeOnlyEvent(LoadRemoteClientEvent::sk_EventType);
+		eventManager.RegisterCodeOnlyEvent(LoadCommand<kThrust>::sk_EventType);
+		eventManager.RegisterCodeOnlyEvent(LoadCommand<kSteer>::sk_EventType);
+		eventManager.RegisterCodeOnlyEvent(LoadCommand<kFireWeapon>::sk_EventType);
+
+		shared_ptr<LoadGameLogic> game(GCC_NEW LoadGameLogic);
+		eventManager.VAddListener(game, LoadRemoteClientEvent::sk_EventType);
+		eventManager.VAddListener(game, LoadCommand<kThrust>::sk_EventType);
+		eventManager.VAddListener(game, LoadCommand<kSteer>::sk_EventType);
+		eventManager.VAddListener(game, LoadCommand<kFireWeapon>::sk_EventType);
+
+		BaseSocketManager manager;
+		manager.Init();
+
+		LoadListenSocket *pListen = GCC_NEW LoadListenSocket;
+		manager.AddSocket(pListen);
+
+		// before there's a network thread, which the child wouldn't have
+		fflush(stdout);
+		pid_t child = fork();
+		if (child == 0)
+			_exit(RunClients(options, pListen->port));
+		if (child < 0)
+			return 1;
+
+		if (options.m_bThreaded && !manager.StartThread())
+		{
+			fprintf(stderr, "LoadGen: no network thread\n");
+			kill(child, SIGTERM);
+			waitpid(child, NULL, 0);
+			return 1;
+		}
+
+		std::vector<double> frames;
+		double const cpuStart = CpuNs();
+		double const start = NowNs();
+		int status = 0;
+
+		for (;;)
+		{
+			double const begin = NowNs();
+			manager.DoSelect(0);
+			eventManager.VTick(IEventManager::kINFINITE);
+			manager.FlushOutput();
+			double const took = NowNs() - begin;
+
+			// only the frames with the game busy
+			if (game->m_Handled)
+				frames.push_back(took);
+
+			if (waitpid(child, &status, WNOHANG) == child)
+				break;
+
+			unsigned int const tookMs = static_cast<unsigned int>(took / 1.0e6);
+			if (tookMs < options.m_FrameMs)
+				Sleep(options.m_FrameMs - tookMs);
+		}
+
+		double const cpuNs = CpuNs() - cpuStart;
+		double const elapsedNs = NowNs() - start;
+		unsigned int const stalls = manager.GetEventStalls();
+		unsigned int const accepted = pListen->m_Accepted;
+
+		std::string stats;
+		if (options.m_bVerbose)
+			manager.DumpStats(stats);
+
+		manager.StopThread();
+		manager.Shutdown();
+
+		double const handlingNs = game->m_LastNs - game->m_FirstNs;
+		std::sort(frames.begin(), frames.end());
+
+		printf("{\"loadgen\":\"server\",\"mode\":\"%s\",\"frame_ms\":%u,\"clients\":%u,"
+			"\"events\":%u,\"thrust\":%u,\"steer\":%u,\"fire_weapon\":%u,\"events_per_sec\":%.0f,"
+			"\"frames\":%u,\"frame_p50_us\":%.1f,\"frame_p99_us\":%.1f,\"frame_max_us\":%.1f,"
+			"\"event_stalls\":%u,\"cpu_percent\":%.1f}\n",
+			options.m_bThreaded ? "threaded" : "inline", options.m_FrameMs, accepted,
+			game->m_Handled, game->m_Commands[kThrust], game->m_Commands[kSteer], game->m_Commands[kFireWeapon],
+			handlingNs > 0.0 ? game->m_Handled * 1.0e9 / handlingNs : 0.0,
+			static_cast<unsigned int>(frames.size()), Percentile(frames, 50) / 1.0e3, Percentile(frames, 99) / 1.0e3,
+			frames.empty() ? 0.0 : frames.back() / 1.0e3, stalls, elapsedNs > 0.0 ? cpuNs * 100.0 / elapsedNs : 0.0);
+
+		// one connection a line, as a dashboard would take them
+		for (size_t line = 0, end; (end = stats.find('\n', line)) != std::string::npos; line = end + 1)
+			printf("{\"loadgen\":\"connection\",\"socket\":%s}\n", stats.substr(line, end - line).c_str());
+		fflush(stdout);
+
+		return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+	}
+
+	void Usage()
+	{
+		fprintf(stderr, "usage: LoadGen [-c clients] [-s seconds] [-t thrust/s] [-r steer/s] [-f fire/s] [-p port] [-m frame ms] [-T] [-v]\n");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "c:s:t:r:f:p:m:Tv")) != -1)
+	{
+		switch (opt)
+		{
+			case 'c': options.m_Clients = atoi(optarg); break;
+			case 's': options.m_Seconds = atoi(optarg); break;
+			case 't': options.m_Rates[kThrust] = static_cast<float>(atof(optarg)); break;
+			case 'r': options.m_Rates[kSteer] = static_cast<float>(atof(optarg)); break;
+			case 'f': options.m_Rates[kFireWeapon] = static_cast<float>(atof(optarg)); break;
+			case 'p': options.m_Port = static_cast<unsigned short>(atoi(optarg)); break;
+			case 'm': options.m_FrameMs = atoi(optarg); break;
+			case 'T': options.m_bThreaded = true; break;
+			case 'v': options.m_bVerbose = true; break;
+			default: Usage(); return 2;
+		}
+	}
+
+	if (!options.m_Clients)
+	{
+		Usage();
+		return 2;
+	}
+
+	// a descriptor per connection, at both ends
+	struct rlimit limit;
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	// the game's wire ids for them - see
+	// TeapotWarsGameApp::RegisterGameSpecificEvents()
+	EventWire::Register< LoadCommand< kFireWeapon > >( EventWire::kFirstGameWireId + 0 );
+	EventWire::Register< LoadCommand< kThrust > >( EventWire::kFirstGameWireId + 1 );
+	EventWire::Register< LoadCommand< kSteer > >( EventWire::kFirstGameWireId + 2 );
+
+	if (options.m_Port)
+		return RunClients(options, options.m_Port);
+
+	return RunServer(options);
+}
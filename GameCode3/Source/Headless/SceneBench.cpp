@@ -0,0 +1,518 @@
+//========================================================================
+// SceneBench.cpp : Scene graph benchmarks
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  SceneBench					- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "../SceneGraph/TransformHierarchy.h"
+#include "../SceneGraph/BoundingVolumeTree.h"
+
+#include <math.h>
+
+// SceneBench Description
+//
+// Times the scene graph's per-frame bookkeeping with nothing drawn -
+// the parts of it that don't need DirectX. Build it with the
+// Makefile in this directory and run it:
+//
+//	./SceneBench				every benchmark
+//	./SceneBench transform		only the ones with "transform" in their name
+//
+// transform_stack is what the scene did every frame before it had a
+// TransformHierarchy: walk the whole tree, multiplying each node's
+// transform onto the matrix stack's top, moving or not. 'param' is
+// how many nodes.
+//
+// transform_update is TransformHierarchy::Update() on a tree of
+// kNodes nodes, after 'param' percent of them, picked at random, have
+// been given a new transform. updated_per_frame is how many world
+// transforms it worked out - the moved nodes and everything under
+// them. max_error is how far any of them are from what the matrix
+// stack makes of the same tree, which should be next to nothing.
+//
+// cull_linear is what SceneNode::VIsVisible() did for each node before
+// the scene had a BoundingVolumeTree - the camera's transform fetched,
+// the node's position taken into camera space and its sphere tested
+// against the frustum's six planes. cull_tree is Scene::Cull()'s work
+// instead: kCullMovingPercent of the spheres moved a little and the
+// tree refitted for them ( refit_us ), then the whole lot culled at
+// once ( cull_us ). 'param' for both is how many spheres, scattered
+// through a cube kCullWorldSize across with the camera in the middle.
+// tests is how many planes a box or sphere was tested against, and
+// mismatches how many spheres the tree and the linear test disagree
+// about - it should be 0.
+//
+// Each result is a JSON line on stdout; every benchmark is run kRuns
+// times and the fastest run is reported, as EventBench does.
+
+namespace
+{
+	const unsigned int kRuns = 5;
+	const unsigned int kFrames = 100;
+	const unsigned int kNodes = 50000;
+
+	// Each actor's a little tree of its own - a body, its parts and
+	// their parts - under the root.
+	const unsigned int kNodesPerActor = 50;
+
+	const unsigned int kCullMovingPercent = 5;
+	const float kCullWorldSize = 1000.0f;
+	const float kCullStep = 0.25f;		// how far a moving sphere goes in a frame - 15 a second
+
+	typedef TransformHierarchy::Matrix Matrix;
+	typedef BoundingVolumeTree::Plane Plane;
+
+	// --- timing and reporting ---
+
+	double NowNs()
+	{
+		LARGE_INTEGER frequency, now;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&now);
+		return double(now.QuadPart) * 1.0e9 / double(frequency.QuadPart);
+	}
+
+	char const *g_pFilter = NULL;
+
+	bool IsSelected(char const *pBenchmark)
+	{
+		return !g_pFilter || strstr(pBenchmark, g_pFilter) != NULL;
+	}
+
+	// the same numbers every run
+	unsigned int g_Seed = 1;
+
+	unsigned int Random()
+	{
+		g_Seed ^= g_Seed << 13;
+		g_Seed ^= g_Seed >> 17;
+		g_Seed ^= g_Seed << 5;
+		return g_Seed;
+	}
+
+	float RandomFloat(float range)
+	{
+		return (Random() % 20001) * range / 10000.0f - range;
+	}
+
+	// A turn about y and a move, as an actor's or a part's would be.
+	Matrix RandomTransform()
+	{
+		float const yaw = RandomFloat(3.14159f);
+		Matrix mat;
+		memset(&mat, 0, sizeof(mat));
+		mat.m[0][0] = cosf(yaw);
+		mat.m[0][2] = -sinf(yaw);
+		mat.m[1][1] = 1.0f;
+		mat.m[2][0] = sinf(yaw);
+		mat.m[2][2] = cosf(yaw);
+		mat.m[3][0] = RandomFloat(10.0f);
+		mat.m[3][1] = RandomFloat(10.0f);
+		mat.m[3][2] = RandomFloat(10.0f);
+		mat.m[3][3] = 1.0f;
+		return mat;
+	}
+
+	// --- the scene ---
+
+	//
+	// A root, and under it actors of kNodesPerActor nodes each, where
+	// every part hangs off one made before it in the same actor. Kept
+	// as a TransformHierarchy, and as the child lists the scene graph
+	// itself has.
+	//
+	struct BenchScene
+	{
+		explicit BenchScene(unsigned int nodes)
+		{
+			g_Seed = 1;
+
+			Matrix identity;
+			memset(&identity, 0, sizeof(identity));
+			for (int i = 0; i < 4; ++i)
+				identity.m[i][i] = 1.0f;
+
+			Add(-1, identity);
+			while (m_Local.size() < nodes)
+			{
+				int const actor = Add(0, RandomTransform());
+				for (unsigned int part = 1; part < kNodesPerActor && m_Local.size() < nodes; ++part)
+					Add(actor + Random() % part, RandomTransform());
+			}
+		}
+
+		int Add(int parent, Matrix const &local)
+		{
+			int const node = static_cast<int>(m_Local.size());
+			m_Handles.push_back(m_Transforms.Add(parent < 0 ? TransformHierarchy::kNoParent : m_Handles[parent], local));
+			m_Local.push_back(local);
+			m_Children.push_back(std::vector<int>());
+			if (parent >= 0)
+				m_Children[parent].push_back(node);
+			return node;
+		}
+
+		void Move(int node, Matrix const &local)
+		{
+			m_Local[node] = local;
+			m_Transforms.SetLocal(m_Handles[node], local);
+		}
+
+		// What VPreRender() and VRenderChildren() did with the matrix
+		// stack - every node's transform times the top, into 'world'.
+		void WalkStack(int node, Matrix const &top, std::vector<Matrix> &world) const
+		{
+			TransformHierarchy::Multiply(world[node], m_Local[node], top);
+			std::vector<int> const &kids = m_Children[node];
+			for (unsigned int i = 0; i < kids.size(); ++i)
+				WalkStack(kids[i], world[node], world);
+		}
+
+		TransformHierarchy m_Transforms;
+		std::vector<int> m_Handles;
+		std::vector<Matrix> m_Local;
+		std::vector<std::vector<int> > m_Children;
+	};
+
+	// --- the benchmarks ---
+
+	//
+	// Every node multiplied down the stack, every frame.
+	//
+	void BenchTransformStack(unsigned int nodes)
+	{
+		char const * const pName = "transform_stack";
+		if (!IsSelected(pName))
+			return;
+
+		BenchScene scene(nodes);
+		std::vector<Matrix> world(nodes);
+		Matrix const &identity = scene.m_Local[0];
+
+		double best = 0.0;
+		for (unsigned int run = 0; run < kRuns; ++run)
+		{
+			double const begin = NowNs();
+			for (unsigned int frame = 0; frame < kFrames; ++frame)
+				scene.WalkStack(0, identity, world);
+			double const took = NowNs() - begin;
+			if (!run || took < best)
+				best = took;
+		}
+
+		printf("{\"benchmark\":\"%s\",\"param\":%u,\"iterations\":%u,\"us_per_frame\":%.1f,\"updated_per_frame\":%u}\n",
+			pName, nodes, kFrames, best / kFrames / 1.0e3, nodes);
+		fflush(stdout);
+	}
+
+	//
+	// Some of them moved, then only what's changed worked out again.
+	// The moves are picked before the clock starts; setting them is
+	// timed, since the scene does that too.
+	//
+	void BenchTransformUpdate(unsigned int movingPercent)
+	{
+		char const * const pName = "transform_update";
+		if (!IsSelected(pName))
+			return;
+
+		BenchScene scene(kNodes);
+		scene.m_Transforms.Update();
+
+		unsigned int const moving = kNodes * movingPercent / 100;
+		std::vector<int> moved(moving * kFrames);
+		std::vector<Matrix> moves(moving * kFrames);
+		for (unsigned int i = 0; i < moved.size(); ++i)
+		{
+			moved[i] = 1 + Random() % (kNodes - 1);
+			moves[i] = RandomTransform();
+		}
+
+		double best = 0.0;
+		unsigned int updated = 0;
+		for (unsigned int run = 0; run < kRuns; ++run)
+		{
+			updated = 0;
+			double const begin = NowNs();
+			for (unsigned int frame = 0; frame < kFrames; ++frame)
+			{
+				for (unsigned int i = frame * moving; i < (frame + 1) * moving; ++i)
+					scene.Move(moved[i], moves[i]);
+				updated += scene.m_Transforms.Update();
+			}
+			double const took = NowNs() - begin;
+			if (!run || took < best)
+				best = took;
+		}
+
+		// the same tree, the old way
+		std::vector<Matrix> world(kNodes);
+		scene.WalkStack(0, scene.m_Local[0], world);
+		float maxError = 0.0f;
+		for (unsigned int node = 0; node < kNodes; ++node)
+		{
+			Matrix const &cached = scene.m_Transforms.GetWorld(scene.m_Handles[node]);
+			for (int i = 0; i < 16; ++i)
+				maxError = std::max(maxError, fabsf(cached.m[i / 4][i % 4] - world[node].m[i / 4][i % 4]));
+		}
+
+		printf("{\"benchmark\":\"%s\",\"param\":%u,\"iterations\":%u,\"nodes\":%u,\"us_per_frame\":%.1f,\"updated_per_frame\":%u,\"max_error\":%g}\n",
+			pName, movingPercent, kFrames, kNodes, best / kFrames / 1.0e3, updated / kFrames, maxError);
+		fflush(stdout);
+	}
+
+	// --- culling ---
+
+	//
+	// Bounding spheres scattered through a cube, and a camera in the
+	// middle of it turned a little, with Frustum's defaults - 45
+	// degrees, 1 to 1000 - and a 4:3 screen.
+	//
+	struct BenchField
+	{
+		explicit BenchField(unsigned int spheres)
+		{
+			g_Seed = 1;
+			for (unsigned int i = 0; i < spheres; ++i)
+			{
+				Center c;
+				for (int axis = 0; axis < 3; ++axis)
+					c.m[axis] = RandomFloat(kCullWorldSize / 2.0f);
+				m_Centers.push_back(c);
+				m_Radii.push_back(0.5f + (Random() % 100) / 40.0f);
+			}
+
+			// the camera's FromWorld() - turned 30 degrees about y, and
+			// moved
+			float const yaw = 0.5236f;
+			memset(&m_FromWorld, 0, sizeof(m_FromWorld));
+			m_FromWorld.m[0][0] = cosf(yaw);
+			m_FromWorld.m[0][2] = sinf(yaw);
+			m_FromWorld.m[1][1] = 1.0f;
+			m_FromWorld.m[2][0] = -sinf(yaw);
+			m_FromWorld.m[2][2] = cosf(yaw);
+			m_FromWorld.m[3][0] = -10.0f;
+			m_FromWorld.m[3][2] = 20.0f;
+			m_FromWorld.m[3][3] = 1.0f;
+			m_ToWorld = m_FromWorld;		// never read - only copied, as VIsVisible() did
+
+			// Frustum::Init()'s planes, in camera space, facing in
+			float const tanY = tanf(3.14159f / 8.0f);
+			float const tanX = tanY * 4.0f / 3.0f;
+			SetPlane(m_CameraPlanes[0], 0.0f, 0.0f, 1.0f, -1.0f);
+			SetPlane(m_CameraPlanes[1], 0.0f, 0.0f, -1.0f, 1000.0f);
+			SetPlane(m_CameraPlanes[2], 0.0f, -1.0f, tanY, 0.0f);
+			SetPlane(m_CameraPlanes[3], -1.0f, 0.0f, tanX, 0.0f);
+			SetPlane(m_CameraPlanes[4], 0.0f, 1.0f, tanY, 0.0f);
+			SetPlane(m_CameraPlanes[5], 1.0f, 0.0f, tanX, 0.0f);
+
+			// what Scene::Cull() does with D3DXPlaneTransform() and the
+			// transpose of FromWorld()
+			for (int p = 0; p < 6; ++p)
+			{
+				float const in[4] = { m_CameraPlanes[p].a, m_CameraPlanes[p].b, m_CameraPlanes[p].c, m_CameraPlanes[p].d };
+				float out[4];
+				for (int j = 0; j < 4; ++j)
+					out[j] = in[0] * m_FromWorld.m[j][0] + in[1] * m_FromWorld.m[j][1] + in[2] * m_FromWorld.m[j][2] + in[3] * m_FromWorld.m[j][3];
+				m_WorldPlanes[p].a = out[0];
+				m_WorldPlanes[p].b = out[1];
+				m_WorldPlanes[p].c = out[2];
+				m_WorldPlanes[p].d = out[3];
+			}
+		}
+
+		static void SetPlane(Plane &plane, float a, float b, float c, float d)
+		{
+			float const length = sqrtf(a * a + b * b + c * c);
+			plane.a = a / length;
+			plane.b = b / length;
+			plane.c = c / length;
+			plane.d = d / length;
+		}
+
+		// SceneNode::VIsVisible(), as it was
+		bool IsVisible(unsigned int i) const
+		{
+			Matrix toWorld = m_ToWorld, fromWorld = m_FromWorld;
+			(void)toWorld;
+
+			float const *pos = m_Centers[i].m;
+			float camera[3];
+			for (int j = 0; j < 3; ++j)
+				camera[j] = pos[0] * fromWorld.m[0][j] + pos[1] * fromWorld.m[1][j] + pos[2] * fromWorld.m[2][j] + fromWorld.m[3][j];
+
+			for (int p = 0; p < 6; ++p)
+			{
+				Plane const &plane = m_CameraPlanes[p];
+				if (plane.a * camera[0] + plane.b * camera[1] + plane.c * camera[2] + plane.d < -m_Radii[i])
+					return false;
+			}
+			return true;
+		}
+
+		struct Center { float m[3]; };
+
+		std::vector<Center> m_Centers;
+		std::vector<float> m_Radii;
+		Matrix m_ToWorld, m_FromWorld;
+		Plane m_CameraPlanes[6];
+		Plane m_WorldPlanes[6];
+	};
+
+	//
+	// Every sphere tested on its own, every frame.
+	//
+	void BenchCullLinear(unsigned int spheres)
+	{
+		char const * const pName = "cull_linear";
+		if (!IsSelected(pName))
+			return;
+
+		BenchField field(spheres);
+
+		double best = 0.0;
+		unsigned int visible = 0;
+		for (unsigned int run = 0; run < kRuns; ++run)
+		{
+			double const begin = NowNs();
+			for (unsigned int frame = 0; frame < kFrames; ++frame)
+			{
+				visible = 0;
+				for (unsigned int i = 0; i < spheres; ++i)
+					visible += field.IsVisible(i) ? 1 : 0;
+			}
+			double const took = NowNs() - begin;
+			if (!run || took < best)
+				best = took;
+		}
+
+		printf("{\"benchmark\":\"%s\",\"param\":%u,\"iterations\":%u,\"cull_us\":%.1f,\"visible\":%u,\"tests\":%u}\n",
+			pName, spheres, kFrames, best / kFrames / 1.0e3, visible, spheres * 6);
+		fflush(stdout);
+	}
+
+	//
+	// Some of them moved and refitted, then all of them culled at once.
+	// Each run starts from where the last left off, which doesn't
+	// matter - they're only wandering about.
+	//
+	void BenchCullTree(unsigned int spheres)
+	{
+		char const * const pName = "cull_tree";
+		if (!IsSelected(pName))
+			return;
+
+		BenchField field(spheres);
+		BoundingVolumeTree tree;
+		for (unsigned int i = 0; i < spheres; ++i)
+			tree.Insert(i, field.m_Centers[i].m, field.m_Radii[i]);
+
+		unsigned int const moving = spheres * kCullMovingPercent / 100;
+		std::vector<int> moved(moving * kFrames);
+		std::vector<BenchField::Center> steps(moving * kFrames);
+		for (unsigned int i = 0; i < moved.size(); ++i)
+		{
+			moved[i] = Random() % spheres;
+			for (int axis = 0; axis < 3; ++axis)
+				steps[i].m[axis] = RandomFloat(kCullStep);
+		}
+
+		double bestRefit = 0.0, bestCull = 0.0;
+		unsigned int visible = 0, tests = 0;
+		for (unsigned int run = 0; run < kRuns; ++run)
+		{
+			double refit = 0.0, cull = 0.0;
+			for (unsigned int frame = 0; frame < kFrames; ++frame)
+			{
+				double const begin = NowNs();
+				for (unsigned int i = frame * moving; i < (frame + 1) * moving; ++i)
+				{
+					float *pos = field.m_Centers[moved[i]].m;
+					for (int axis = 0; axis < 3; ++axis)
+						pos[axis] += steps[i].m[axis];
+					tree.Move(moved[i], pos);
+				}
+				double const refitted = NowNs();
+				visible = tree.Cull(field.m_WorldPlanes, 6);
+				tests = tree.GetLastCullTests();
+				double const culled = NowNs();
+
+				refit += refitted - begin;
+				cull += culled - refitted;
+			}
+			if (!run || refit < bestRefit)
+				bestRefit = refit;
+			if (!run || cull < bestCull)
+				bestCull = cull;
+		}
+
+		unsigned int mismatches = 0;
+		for (unsigned int i = 0; i < spheres; ++i)
+			mismatches += tree.IsVisible(i) != field.IsVisible(i) ? 1 : 0;
+
+		printf("{\"benchmark\":\"%s\",\"param\":%u,\"iterations\":%u,\"refit_us\":%.1f,\"cull_us\":%.1f,\"visible\":%u,\"tests\":%u,\"height\":%d,\"mismatches\":%u}\n",
+			pName, spheres, kFrames, bestRefit / kFrames / 1.0e3, bestCull / kFrames / 1.0e3, visible, tests, tree.GetHeight(), mismatches);
+		fflush(stdout);
+	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1)
+		g_pFilter = argv[1];
+
+	unsigned int const sizes[] = { 5000, 50000 };
+	for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+		BenchTransformStack(sizes[i]);
+
+	unsigned int const moving[] = { 0, 1, 5, 25, 100 };
+	for (unsigned int i = 0; i < sizeof(moving) / sizeof(moving[0]); ++i)
+		BenchTransformUpdate(moving[i]);
+
+	unsigned int const spheres[] = { 1000, 10000, 50000, 100000 };
+	for (unsigned int i = 0; i < sizeof(spheres) / sizeof(spheres[0]); ++i)
+	{
+		BenchCullLinear(spheres[i]);
+		BenchCullTree(spheres[i]);
+	}
+
+	return 0;
+}
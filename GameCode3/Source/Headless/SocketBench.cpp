@@ -0,0 +1,2298 @@
+//========================================================================
+// SocketBench.cpp : Socket manager frame-cost benchmark
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  SocketBench					- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "../Network/SocketManager.h"
+#include "../Network/NetworkEvents.h"
+#include "../Network/Snapshot.h"
+#include "../Network/InterestManager.h"
+#include "../Network/UdpSocket.h"
+#include "../Network/NetCompressor.h"
+#include "../Network/Interpolation.h"
+#include "../EventManager/EventManagerImpl.h"
+#include "../EventManager/EventFactory.h"
+#include "../Multicore/ThreadPool.h"
+
+#include <deque>
+#include <map>
+#include <math.h>
+#include <new>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// SocketBench Description
+//
+// What a frame of BaseSocketManager::DoSelect() costs a server with
+// a lot of connections that are mostly quiet, for each ISocketPoller.
+// Everything is over loopback: a child process opens the idle
+// connections and sits on them, and a handful of hot ones in this
+// process send a packet every frame and get one back.
+//
+//	./SocketBench				every benchmark
+//	./SocketBench epoll			only the epoll poller
+//
+// Results are JSON lines on stdout like EventBench's, with the poller
+// named and 'param' the number of idle connections. One op is one
+// DoSelect(0) - idle_frame with the hot connections quiet, hot_frame
+// with them busy.
+//
+// send_burst queues 'param' small packets a frame for one client and
+// times BaseSocketManager::FlushOutput() sending them; one op is one
+// packet.
+//
+// recv_throughput has one connection stream packets of 'param' bytes
+// as fast as it can, and reports MB/s of wall time and MB/s of this
+// process' CPU time - one core's worth, since it's all one thread.
+//
+// forward has kForwardClients connections and triggers
+// kForwardEvents move events a frame then flushes - 'wire' says
+// whether EventWire was sending binary or text, and 'listener'
+// whether each client had a NetworkEventForwarder of its own or one
+// NetworkEventBroadcaster sent to them all. One op is one event sent
+// to every client, so ops_per_sec is the events a second the server
+// can forward, and allocs_per_op the heap allocations each cost.
+// parallel_forwarder is the forwarders made parallel-safe, with the
+// socket manager threaded: all but the last event are queued and
+// written out on the event manager's pool, and the last one is
+// triggered, so it has to wait for the forwarders to finish.
+// After the broadcaster's run, half the connections are closed, and
+// the next event has to drop those players from it, the
+// InterestManager and the SnapshotReplicator.
+//
+// decode is the other end: one op is reading one move event back
+// out of a message with EventWire::ReadEvent().
+//
+// udp has a UdpSocket server and client over loopback, each end's
+// NetSimulator losing 'param' percent of what it sends and holding
+// the rest back 30-40ms. The server sends a reliable packet and four
+// unreliable ones a 10ms frame; the client checks the reliable ones
+// all arrive in order and the unreliable ones never go backwards.
+//
+// snapshot is what one client costs a second, in bytes, with
+// kSnapshotActors actors of which 'param' are moving. The events
+// modes send a Move_Actor for each every physics tick, as the game
+// does by default; the snapshot mode has a SnapshotReplicator send
+// kSnapshotRate snapshots a second, with acks coming back a couple
+// of snapshots late, and some of them lost. max_error is how far
+// the client's idea of a position is from the server's.
+//
+// interest has kInterestActors actors wandering a map, each with a
+// Move_Actor every physics tick, and kInterestClients players each
+// seeing from one of them with an InterestManager of radius 'param'.
+// sends_per_event is how many players each event goes to, against
+// all of them without it; flips_per_sec is how often an actor comes
+// into or goes out of someone's view, with and without hysteresis.
+//
+// thread is what a 16ms game frame costs the game thread - DoSelect(),
+// ticking the events it handed over, a packet to every client and
+// FlushOutput() - with kThreadClients connections each sending a
+// burst of kThreadBurst move events every kThreadBurstMs, and
+// kThreadSlowClients of them never reading what they're sent. 'mode'
+// is inline, with the sockets on the game thread as before, or
+// threaded, after BaseSocketManager::StartThread(). Frame times are
+// in microseconds; the io_ ones are only the socket manager's share,
+// without ticking the events.
+//
+// stats runs kStatsClients connections for kStatsSeconds, sending
+// each of them kStatsPackets packets of kStatsPacketSize bytes a 10ms
+// frame - enough to fill loopback's buffers - and getting move
+// event bursts back, with one of them never reading. Then it prints
+// BaseSocketManager::DumpStats() - one line per socket, the slow one
+// standing out with a deep queue and a long time blocked.
+//
+// compress sends kCompressActors New_Actor messages, like a level
+// join's, through a NetCompressor pair kCompressPasses times and
+// checks they all come back the same. 'mode' is none, message with
+// a new pair for each message, stream with one pair for all of them,
+// or dictionary, a stream primed with the strings actors have; ratio
+// is the bytes sent over what they'd have been, and the _ns are per
+// compressed message.
+//
+// interpolate has kInterpActors actors going round in circles, each
+// sent 'param' times a second over a connection with jitter and a
+// little loss, and drawn every kInterpFrameMs. 'mode' is none, each
+// update drawn as it comes in, or buffer, through an
+// InterpolationBuffer kInterpDelayMs behind. jerk is how much each
+// frame's step differs from the last one's, as a fraction of a step,
+// and stalled_pct the frames an actor didn't move at all.
+//
+// instances runs 'param' games side by side in the one process, as
+// GameInstancePool does, sharing one threaded socket manager. Each
+// has an event manager of its own, kInstanceClients connections
+// bursting move events at it, kInstanceWorkUs of work a frame and a
+// packet a frame for each of its clients. 'mode' is serial, every
+// game's frame on the main thread in turn, or pool, each on a
+// ThreadPool thread. misrouted counts events that got to the wrong
+// game's event manager, or to the global one - it should be 0.
+//
+// select() can't wait on a descriptor past FD_SETSIZE, so it's only
+// run as far as that allows.
+
+// Every allocation is counted, so a benchmark can say how many an op
+// costs. The network and pool threads allocate too, so the count is
+// only ever touched atomically - read it with GetAllocations().
+static unsigned long volatile g_Allocations = 0;
+
+static unsigned long GetAllocations()
+{
+	return __sync_fetch_and_add(&g_Allocations, 0);
+}
+
+// These are all kept out of line - inlined, the compiler sees malloc()
+// and free() where new and delete were, and warns that they don't
+// match. C++14 also deletes with the size, and those have to be
+// replaced along with the others or they'd go to the library's.
+#define BENCH_OUT_OF_LINE __attribute__((noinline))
+
+BENCH_OUT_OF_LINE void *operator new(size_t size)
+{
+	__sync_add_and_fetch(&g_Allocations, 1);
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+BENCH_OUT_OF_LINE void *operator new[](size_t size) { return operator new(size); }
+BENCH_OUT_OF_LINE void operator delete(void *p) throw() { free(p); }
+BENCH_OUT_OF_LINE void operator delete[](void *p) throw() { free(p); }
+#if __cplusplus >= 201402L
+BENCH_OUT_OF_LINE void operator delete(void *p, size_t) throw() { free(p); }
+BENCH_OUT_OF_LINE void operator delete[](void *p, size_t) throw() { free(p); }
+#endif
+
+namespace
+{
+	const unsigned int kHotSockets = 4;
+	const unsigned int kFrames = 2000;
+	const unsigned int kPayloadSize = 60;
+	const unsigned int kConnectTimeoutMs = 30000;
+	const unsigned int kStreamBytes = 256 * 1024 * 1024;
+
+	const unsigned int kForwardClients = 64;
+	const unsigned int kForwardEvents = 16;
+	const unsigned int kForwardFrames = 500;
+	const unsigned int kWarmupFrames = 10;
+	const unsigned int kDecodes = 200000;
+
+	const unsigned int kUdpFrames = 300;
+	const unsigned int kUdpFrameMs = 10;
+	const unsigned int kUdpReliablePerFrame = 1;
+	const unsigned int kUdpUnreliablePerFrame = 4;
+	const unsigned int kUdpLatencyMs = 30;
+	const unsigned int kUdpJitterMs = 10;
+
+	const unsigned int kSnapshotActors = 64;
+	const unsigned int kSnapshotSeconds = 10;
+	const unsigned int kSnapshotRate = 20;
+	const unsigned int kSnapshotAckDelay = 2;
+	const unsigned int kPhysicsRate = 60;
+
+	const unsigned int kInterestActors = 2000;
+	const unsigned int kInterestClients = 64;
+	const unsigned int kInterestSeconds = 5;
+	const float kInterestMapSize = 2000.0f;
+
+	const unsigned int kThreadClients = 32;
+	const unsigned int kThreadSlowClients = 8;
+	const unsigned int kThreadBurst = 200;
+	const unsigned int kThreadBurstMs = 100;
+	const unsigned int kThreadFrames = 300;
+	const unsigned int kThreadFrameMs = 16;
+
+	const unsigned int kStatsClients = 4;
+	const unsigned int kStatsPackets = 64;
+	const unsigned int kStatsPacketSize = 1000;
+	const unsigned int kStatsSeconds = 3;
+	const unsigned int kStatsFrameMs = 10;
+
+	const unsigned int kCompressActors = 200;
+	const unsigned int kCompressPasses = 50;
+
+	const unsigned int kInterpActors = 16;
+	const unsigned int kInterpSeconds = 20;
+	const unsigned int kInterpWarmupMs = 1000;
+	const unsigned int kInterpFrameMs = 16;
+	const unsigned int kInterpLatencyMs = 40;
+	const unsigned int kInterpJitterMs = 30;
+	const unsigned int kInterpLoss = 2;
+	const unsigned int kInterpDelayMs = 100;
+	const float kInterpSpeed = 10.0f;
+	const float kInterpRadius = 20.0f;
+
+	const unsigned int kInstanceClients = 8;
+	const unsigned int kInstanceFrames = 200;
+	const unsigned int kInstanceWorkUs = 2000;
+
+	unsigned int g_PacketsIn = 0;
+	unsigned int g_BytesIn = 0;
+
+	// --- the events ---
+
+	// The same as EvtData_Move_Actor, which needs the game's Mat4x4.
+	class BenchMoveEvent : public BaseEventData
+	{
+	public:
+		static const EventType sk_EventType;
+		virtual const EventType & VGetEventType( void ) const
+		{
+			return sk_EventType;
+		}
+
+		explicit BenchMoveEvent( unsigned int id )
+			: m_Id( id )
+		{
+			for ( int i = 0; i < 16; ++i )
+				m_Mat[i] = static_cast< float >( id + i ) * 0.25f;
+		}
+
+		explicit BenchMoveEvent( std::istrstream & in )
+		{
+			in >> m_Id;
+			for ( int i = 0; i < 16; ++i )
+				in >> m_Mat[i];
+		}
+
+		explicit BenchMoveEvent( BinaryInStream & in )
+		{
+			m_Id = in.ReadU32();
+			in.ReadFloats( m_Mat, 16 );
+		}
+
+		virtual void VSerialize( std::ostrstream & out ) const
+		{
+			out << m_Id << " ";
+			for ( int i = 0; i < 16; ++i )
+				out << m_Mat[i] << " ";
+		}
+
+		virtual void VSerializeBinary( BinaryOutStream & out ) const
+		{
+			out.WriteU32( m_Id );
+			out.WriteFloats( m_Mat, 16 );
+		}
+
+		virtual IEventDataPtr VCopy() const
+		{
+			return IEventDataPtr( GCC_NEW BenchMoveEvent( *this ) );
+		}
+
+		virtual LuaObject VGetLuaEventData( void ) const
+		{
+			return m_LuaEventData;
+		}
+
+		virtual void VBuildLuaEventData( void )
+		{
+			m_bHasLuaEventData = true;
+		}
+
+		unsigned int m_Id;
+		float m_Mat[16];
+
+	private:
+		LuaObject m_LuaEventData;
+	};
+
+	const EventType BenchMoveEvent::sk_EventType( "bench_move" );
+
+	// --- the server side ---
+
+	// Counts what it reads, and keeps none of it.
+	class BenchSocket : public NetSocket
+	{
+	public:
+		BenchSocket(SOCKET new_sock) : NetSocket(new_sock, 0) { }
+
+	protected:
+		virtual void HandlePacket(IPacket const &packet)
+		{
+			++g_PacketsIn;
+			g_BytesIn += packet.VGetSize();
+		}
+	};
+
+	// Decodes each event it reads and hands it over - or the message
+	// itself, for a type the game has to build - as RemoteEventSocket
+	// does.
+	class BenchEventSocket : public NetSocket
+	{
+	public:
+		BenchEventSocket(SOCKET new_sock, IEventManager *pTo) : NetSocket(new_sock, 0), m_pTo(pTo) { }
+
+	protected:
+		virtual void HandlePacket(IPacket const &packet)
+		{
+			char const *pData = packet.VGetData() + sizeof(u_long);
+			unsigned int const size = packet.VGetSize() - sizeof(u_long);
+			if (EventWire::DecodesOnGameThread(pData, size))
+			{
+				g_pSocketManager->QueueMessage(pData, size, m_pTo);
+				return;
+			}
+
+			IEventDataPtr event = EventWire::ReadEvent(pData, size);
+			if (event)
+				g_pSocketManager->QueueEvent(event, m_pTo);
+		}
+
+		IEventManager *m_pTo;
+	};
+
+	class BenchListenSocket : public NetListenSocket
+	{
+	public:
+		BenchListenSocket() : m_Accepted(0), m_bDecode(false), m_pTo(NULL)
+		{
+			// port 0 - whatever's free
+			Init(0);
+
+			struct sockaddr_in sa;
+			socklen_t size = sizeof(sa);
+			getsockname(m_sock, (struct sockaddr *)&sa, &size);
+			port = ntohs(sa.sin_port);
+		}
+
+		virtual void HandleInput()
+		{
+			unsigned int ipaddr;
+			SOCKET new_sock = AcceptConnection(&ipaddr);
+			if (new_sock != INVALID_SOCKET)
+			{
+				NetSocket *pSocket = m_bDecode ? static_cast<NetSocket *>(GCC_NEW BenchEventSocket(new_sock, m_pTo)) : GCC_NEW BenchSocket(new_sock);
+				m_SockIds.push_back(g_pSocketManager->AddSocket(pSocket));
+				m_Sockets.push_back(pSocket);
+				++m_Accepted;
+			}
+		}
+
+		unsigned int m_Accepted;
+		bool m_bDecode;
+		IEventManager *m_pTo;			// the decoded events' event manager - NULL for the global one
+		std::vector<int> m_SockIds;
+		std::vector<NetSocket *> m_Sockets;
+	};
+
+	// --- the client side ---
+
+	SOCKET ConnectLoopback(unsigned short port)
+	{
+		SOCKET sock = socket(PF_INET, SOCK_STREAM, 0);
+		if (sock == INVALID_SOCKET)
+			return INVALID_SOCKET;
+
+		struct sockaddr_in sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sin_family = AF_INET;
+		sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sa.sin_port = htons(port);
+
+		if (connect(sock, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+		{
+			closesocket(sock);
+			return INVALID_SOCKET;
+		}
+
+		// close with a reset, so thousands of them don't sit in TIME_WAIT
+		struct linger lingerOff = { 1, 0 };
+		setsockopt(sock, SOL_SOCKET, SO_LINGER, (char *)&lingerOff, sizeof(lingerOff));
+		return sock;
+	}
+
+	// The child opens the idle connections, then waits for the
+	// parent to close the pipe.
+	pid_t SpawnIdleClients(unsigned short port, unsigned int count, int & releaseFd)
+	{
+		int fds[2];
+		if (pipe(fds) != 0)
+			return -1;
+
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			close(fds[1]);
+			std::vector<SOCKET> socks;
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				SOCKET sock = ConnectLoopback(port);
+				if (sock == INVALID_SOCKET)
+					_exit(1);
+				socks.push_back(sock);
+			}
+
+			char c;
+			while (read(fds[0], &c, 1) > 0)
+				;
+			_exit(0);
+		}
+
+		close(fds[0]);
+		releaseFd = fds[1];
+		return pid;
+	}
+
+	// The child streams kStreamBytes of packetSize byte packets, then
+	// waits for the parent to close the pipe.
+	pid_t SpawnStreamingClient(unsigned short port, unsigned int packetSize, int & releaseFd)
+	{
+		int fds[2];
+		if (pipe(fds) != 0)
+			return -1;
+
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			close(fds[1]);
+
+			SOCKET sock = ConnectLoopback(port);
+			if (sock == INVALID_SOCKET)
+				_exit(1);
+
+			// plain close, so nothing unread is thrown away
+			struct linger lingerOn = { 0, 0 };
+			setsockopt(sock, SOL_SOCKET, SO_LINGER, (char *)&lingerOn, sizeof(lingerOn));
+
+			std::vector<char> payload(packetSize - sizeof(u_long), 'x');
+			BinaryPacket packet(&payload[0], static_cast<u_long>(payload.size()));
+
+			std::vector<char> chunk;
+			while (chunk.size() + packetSize <= 64 * 1024)
+				chunk.insert(chunk.end(), packet.VGetData(), packet.VGetData() + packetSize);
+
+			for (unsigned int sent = 0; sent < kStreamBytes; sent += static_cast<unsigned int>(chunk.size()))
+			{
+				if (send(sock, &chunk[0], chunk.size(), MSG_NOSIGNAL) != (int)chunk.size())
+					_exit(1);
+			}
+
+			char c;
+			while (read(fds[0], &c, 1) > 0)
+				;
+			_exit(0);
+		}
+
+		close(fds[0]);
+		releaseFd = fds[1];
+		return pid;
+	}
+
+	void DrainClient(SOCKET sock)
+	{
+		char buffer[4096];
+		while (recv(sock, buffer, sizeof(buffer), MSG_DONTWAIT) > 0)
+			;
+	}
+
+	// The child opens 'count' connections and sends a burst of
+	// kThreadBurst move events down each every kThreadBurstMs, until
+	// the parent closes the pipe. The first 'slow' never read.
+	pid_t SpawnBurstingClients(unsigned short port, unsigned int count, unsigned int slow, int & releaseFd)
+	{
+		int fds[2];
+		if (pipe(fds) != 0)
+			return -1;
+
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			close(fds[1]);
+
+			std::vector<SOCKET> socks;
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				SOCKET sock = ConnectLoopback(port);
+				if (sock == INVALID_SOCKET)
+					_exit(1);
+				socks.push_back(sock);
+			}
+
+			std::vector<char> burst;
+			for (unsigned int i = 0; i < kThreadBurst; ++i)
+			{
+				BinaryOutStream message;
+				EventWire::WriteEvent(BenchMoveEvent(i), message);
+				BinaryPacket packet(message.GetData(), static_cast<u_long>(message.GetSize()));
+				burst.insert(burst.end(), packet.VGetData(), packet.VGetData() + packet.VGetSize());
+			}
+
+			struct pollfd release;
+			release.fd = fds[0];
+			release.events = POLLIN;
+			for (;;)
+			{
+				for (unsigned int i = 0; i < count; ++i)
+				{
+					if (send(socks[i], &burst[0], burst.size(), MSG_NOSIGNAL) != (int)burst.size())
+						_exit(1);
+					if (i >= slow)
+						DrainClient(socks[i]);
+				}
+
+				if (poll(&release, 1, kThreadBurstMs) != 0)
+					break;
+			}
+			_exit(0);
+		}
+
+		close(fds[0]);
+		releaseFd = fds[1];
+		return pid;
+	}
+
+	// The child opens 'count' connections and reads whatever comes in
+	// on them until the parent writes how many bytes it sent in all.
+	// Once that many have arrived the child writes back how many did.
+	pid_t SpawnReadingClients(unsigned short port, unsigned int count, int & controlFd, int & resultFd)
+	{
+		int control[2], result[2];
+		if (pipe(control) != 0 || pipe(result) != 0)
+			return -1;
+
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			close(control[1]);
+			close(result[0]);
+
+			std::vector<struct pollfd> fds(count + 1);
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				fds[i].fd = ConnectLoopback(port);
+				if (fds[i].fd == INVALID_SOCKET)
+					_exit(1);
+				fds[i].events = POLLIN;
+			}
+			fds[count].fd = control[0];
+			fds[count].events = POLLIN;
+
+			unsigned long long received = 0;
+			unsigned long long expected = ~0ULL;
+			while (received < expected)
+			{
+				if (poll(&fds[0], fds.size(), kConnectTimeoutMs) <= 0)
+					break;
+
+				for (unsigned int i = 0; i < count; ++i)
+				{
+					if (!fds[i].revents)
+						continue;
+
+					char buffer[64 * 1024];
+					int rc;
+					while ((rc = recv(fds[i].fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+						received += rc;
+				}
+
+				if (fds[count].revents)
+				{
+					if (read(control[0], &expected, sizeof(expected)) != sizeof(expected))
+						break;
+					fds[count].fd = -1;
+				}
+			}
+
+			write(result[1], &received, sizeof(received));
+			_exit(0);
+		}
+
+		close(control[0]);
+		close(result[1]);
+		controlFd = control[1];
+		resultFd = result[0];
+		return pid;
+	}
+
+	// --- timing and reporting ---
+
+	double CpuNs()
+	{
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1.0e9 +
+			(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0e3;
+	}
+
+	double NowNs()
+	{
+		LARGE_INTEGER frequency, now;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&now);
+		return double(now.QuadPart) * 1.0e9 / double(frequency.QuadPart);
+	}
+
+	void Report(char const *pBenchmark, char const *pPoller, unsigned int param, unsigned int iterations, double totalNs)
+	{
+		double const nsPerOp = iterations ? totalNs / iterations : 0.0;
+		double const opsPerSec = nsPerOp > 0.0 ? 1.0e9 / nsPerOp : 0.0;
+
+		printf("{\"benchmark\":\"%s\",\"poller\":\"%s\",\"param\":%u,\"iterations\":%u,\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f}\n",
+			pBenchmark, pPoller, param, iterations, nsPerOp, opsPerSec);
+		fflush(stdout);
+	}
+
+	//
+	// 'burst' packets queued for one client each frame, then flushed.
+	//
+	void BenchSendBurst(unsigned int burst)
+	{
+		BaseSocketManager manager;
+		manager.Init();
+
+		BenchListenSocket *pListen = GCC_NEW BenchListenSocket;
+		manager.AddSocket(pListen);
+
+		SOCKET client = ConnectLoopback(pListen->port);
+
+		unsigned int const start = timeGetTime();
+		while (pListen->m_Accepted < 1 && timeGetTime() - start < kConnectTimeoutMs)
+			manager.DoSelect(1000);
+
+		if (pListen->m_Accepted < 1)
+		{
+			fprintf(stderr, "send_burst: no connection\n");
+		}
+		else
+		{
+			for (unsigned int i = 0; i < 10; ++i)
+				manager.DoSelect(0);
+
+			char payload[kPayloadSize];
+			memset(payload, 'x', sizeof(payload));
+			shared_ptr<IPacket> packet(GCC_NEW BinaryPacket(payload, sizeof(payload)));
+
+			int const sockId = pListen->m_SockIds[0];
+			double total = 0.0;
+			for (unsigned int frame = 0; frame < kFrames; ++frame)
+			{
+				for (unsigned int i = 0; i < burst; ++i)
+					manager.Send(sockId, packet);
+
+				double const begin = NowNs();
+				manager.FlushOutput();
+				total += NowNs() - begin;
+
+				DrainClient(client);
+			}
+			Report("send_burst", manager.GetPoller()->VGetName(), burst, kFrames * burst, total);
+		}
+
+		closesocket(client);
+		manager.Shutdown();
+	}
+
+	//
+	// Closes half a broadcaster's connections, and checks the next
+	// event drops their players from it and from an InterestManager
+	// and SnapshotReplicator that had them all.
+	//
+	void CheckClientsClosed(BaseSocketManager &manager, EventManager &eventManager, NetworkEventBroadcaster &broadcaster,
+		BenchListenSocket &listen, BenchMoveEvent const &event)
+	{
+		shared_ptr<InterestManager> interest(GCC_NEW InterestManager(100.0f, 100.0f));
+		SnapshotReplicator snapshots;
+		for (unsigned int i = 0; i < listen.m_SockIds.size(); ++i)
+		{
+			interest->AddClient(listen.m_SockIds[i]);
+			snapshots.AddClient(listen.m_SockIds[i]);
+		}
+		broadcaster.SetInterest(interest);
+		broadcaster.SetSnapshots(&snapshots);
+
+		unsigned int const clients = static_cast<unsigned int>(listen.m_Sockets.size());
+		unsigned int const closed = clients / 2;
+		for (unsigned int i = 0; i < closed; ++i)
+			manager.RemoveSocket(listen.m_Sockets[i]);
+		listen.m_Sockets.erase(listen.m_Sockets.begin(), listen.m_Sockets.begin() + closed);
+
+		eventManager.VTrigger(event);
+
+		unsigned int const left = clients - closed;
+		if (broadcaster.GetSocketCount() != left || interest->GetClientCount() != left || snapshots.GetClientCount() != left)
+		{
+			fprintf(stderr, "forward: %u of %u connections left, but the broadcaster has %u, the InterestManager %u and the SnapshotReplicator %u\n",
+				left, clients, broadcaster.GetSocketCount(), interest->GetClientCount(), snapshots.GetClientCount());
+		}
+
+		broadcaster.SetInterest(shared_ptr<InterestManager>());
+		broadcaster.SetSnapshots(NULL);
+	}
+
+	//
+	// kForwardClients connections with a NetworkEventForwarder each,
+	// or one NetworkEventBroadcaster for all of them, and
+	// kForwardEvents move events triggered for them every frame.
+	// bParallel makes the forwarders parallel-safe, on a threaded
+	// socket manager, and queues the events instead.
+	//
+	void BenchForward(bool bText, bool bBroadcast, bool bParallel = false)
+	{
+		char const * const pWire = bText ? "text" : "binary";
+		char const * const pListener = bBroadcast ? "broadcaster" : bParallel ? "parallel_forwarder" : "forwarder";
+		EventWire::SetTextMode(bText);
+
+		EventManager eventManager("SocketBench", false);
+		eventManager.RegisterCodeOnlyEvent(BenchMoveEvent::sk_EventType);
+
+		BaseSocketManager manager;
+		manager.Init();
+
+		BenchListenSocket *pListen = GCC_NEW BenchListenSocket;
+		manager.AddSocket(pListen);
+
+		int controlFd = -1, resultFd = -1;
+		pid_t child = SpawnReadingClients(pListen->port, kForwardClients, controlFd, resultFd);
+
+		unsigned int const start = timeGetTime();
+		while (pListen->m_Accepted < kForwardClients && timeGetTime() - start < kConnectTimeoutMs)
+			manager.DoSelect(1000);
+
+		if (pListen->m_Accepted < kForwardClients)
+		{
+			fprintf(stderr, "forward: only %u of %u connections made\n", pListen->m_Accepted, kForwardClients);
+		}
+		else if (bParallel && !manager.StartThread())
+		{
+			fprintf(stderr, "forward: no network thread\n");
+		}
+		else
+		{
+			shared_ptr<NetworkEventBroadcaster> broadcaster;
+			if (bBroadcast)
+			{
+				broadcaster.reset(GCC_NEW NetworkEventBroadcaster);
+				for (unsigned int i = 0; i < kForwardClients; ++i)
+					broadcaster->AddSocket(pListen->m_SockIds[i]);
+				eventManager.VAddListener(broadcaster, BenchMoveEvent::sk_EventType);
+			}
+			else
+			{
+				for (unsigned int i = 0; i < kForwardClients; ++i)
+				{
+					EventListenerPtr listener(GCC_NEW NetworkEventForwarder(pListen->m_SockIds[i], bParallel));
+					eventManager.VAddListener(listener, BenchMoveEvent::sk_EventType);
+				}
+			}
+
+			std::vector<BenchMoveEvent> events;
+			std::vector<IEventDataPtr> queued;
+			for (unsigned int i = 0; i < kForwardEvents; ++i)
+			{
+				events.push_back(BenchMoveEvent(i));
+				queued.push_back(IEventDataPtr(GCC_NEW BenchMoveEvent(i)));
+			}
+
+			// what a frame's events cost on the wire, packet headers and
+			// all - the text ones aren't all the same size
+			unsigned int bytesPerFrame = 0;
+			for (unsigned int i = 0; i < kForwardEvents; ++i)
+			{
+				BinaryOutStream message;
+				EventWire::WriteEvent(events[i], message);
+				bytesPerFrame += message.GetSize() + sizeof(u_long);
+			}
+
+			// the first few frames grow the queues, and aren't counted
+			double total = 0.0;
+			unsigned long allocations = 0;
+			for (unsigned int frame = 0; frame < kWarmupFrames + kForwardFrames; ++frame)
+			{
+				unsigned long const allocationsBefore = GetAllocations();
+				double const begin = NowNs();
+				if (bParallel)
+				{
+					// the forwarders write them out on the event manager's
+					// pool and the network thread sends them - the last one's
+					// triggered while the forwarders may still be busy
+					for (unsigned int i = 0; i + 1 < kForwardEvents; ++i)
+						eventManager.VQueueEvent(queued[i]);
+					eventManager.VTick(IEventManager::kINFINITE);
+					eventManager.VTrigger(events[kForwardEvents - 1]);
+				}
+				else
+				{
+					for (unsigned int i = 0; i < kForwardEvents; ++i)
+						eventManager.VTrigger(events[i]);
+					manager.FlushOutput();
+				}
+				if (frame >= kWarmupFrames)
+				{
+					total += NowNs() - begin;
+					allocations += GetAllocations() - allocationsBefore;
+				}
+
+				// what didn't fit in the socket buffers goes out here
+				manager.DoSelect(0);
+			}
+
+			// anything still queued - with a thread, that's its job
+			while (!bParallel && timeGetTime() - start < kConnectTimeoutMs * 2)
+			{
+				bool bQueued = false;
+				for (unsigned int i = 0; i < kForwardClients; ++i)
+					bQueued = bQueued || pListen->m_Sockets[i]->HasOutput();
+				if (!bQueued)
+					break;
+				manager.DoSelect(1000);
+			}
+			unsigned long long sent = (unsigned long long)bytesPerFrame * (kWarmupFrames + kForwardFrames) * kForwardClients;
+
+			write(controlFd, &sent, sizeof(sent));
+			unsigned long long received = 0;
+			if (read(resultFd, &received, sizeof(received)) != sizeof(received) || received != sent)
+				fprintf(stderr, "forward: the clients got %llu of %llu bytes\n", received, sent);
+
+			if (broadcaster)
+				CheckClientsClosed(manager, eventManager, *broadcaster, *pListen, events[0]);
+
+			unsigned int const forwarded = kForwardFrames * kForwardEvents;
+			printf("{\"benchmark\":\"forward\",\"wire\":\"%s\",\"listener\":\"%s\",\"param\":%u,\"iterations\":%u,\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f,\"bytes_per_event\":%u,\"allocs_per_op\":%.2f}\n",
+				pWire, pListener, kForwardClients, forwarded, total / forwarded, forwarded * 1.0e9 / total, bytesPerFrame / kForwardEvents,
+				double(allocations) / forwarded);
+			fflush(stdout);
+		}
+
+		manager.Shutdown();
+
+		if (child > 0)
+		{
+			close(controlFd);
+			close(resultFd);
+			waitpid(child, NULL, 0);
+		}
+
+		EventWire::SetTextMode(false);
+	}
+
+	//
+	// EventWire::ReadEvent() on one move event's message.
+	//
+	void BenchDecode(bool bText)
+	{
+		char const * const pWire = bText ? "text" : "binary";
+		EventWire::SetTextMode(bText);
+
+		BinaryOutStream message;
+		EventWire::WriteEvent(BenchMoveEvent(7), message);
+
+		unsigned int decoded = 0;
+		double const begin = NowNs();
+		for (unsigned int i = 0; i < kDecodes; ++i)
+		{
+			IEventDataPtr event;
+			if (bText)
+			{
+				std::istrstream in(message.GetData(), message.GetSize());
+				int type;
+				in >> type;
+				event = EventWire::ReadEvent(in);
+			}
+			else
+			{
+				BinaryInStream in(message.GetData(), message.GetSize());
+				in.ReadU8();
+				event = EventWire::ReadEvent(in);
+			}
+			if (event)
+				++decoded;
+		}
+		double const total = NowNs() - begin;
+
+		if (decoded != kDecodes)
+			fprintf(stderr, "decode: %u of %u events came back\n", decoded, kDecodes);
+
+		printf("{\"benchmark\":\"decode\",\"wire\":\"%s\",\"param\":%u,\"iterations\":%u,\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f}\n",
+			pWire, message.GetSize(), kDecodes, total / kDecodes, kDecodes * 1.0e9 / total);
+		fflush(stdout);
+
+		EventWire::SetTextMode(false);
+	}
+
+	//
+	// One connection streaming packetSize byte packets, through the
+	// platform's best poller.
+	//
+	void BenchThroughput(unsigned int packetSize)
+	{
+		BaseSocketManager manager;
+		manager.Init();
+
+		BenchListenSocket *pListen = GCC_NEW BenchListenSocket;
+		manager.AddSocket(pListen);
+
+		// the stream's whole packets, as the child will send them
+		unsigned int const perChunk = (64 * 1024) / packetSize;
+		unsigned int const chunks = (kStreamBytes + perChunk * packetSize - 1) / (perChunk * packetSize);
+		unsigned int const packets = chunks * perChunk;
+		unsigned int const bytes = packets * packetSize;
+
+		g_PacketsIn = 0;
+		g_BytesIn = 0;
+
+		int releaseFd = -1;
+		pid_t child = SpawnStreamingClient(pListen->port, packetSize, releaseFd);
+
+		double const wallBegin = NowNs();
+		double const cpuBegin = CpuNs();
+
+		// a millisecond's wait when there's nothing to read, so the time
+		// spent waiting for the child isn't counted as work
+		unsigned int const start = timeGetTime();
+		while (g_BytesIn < bytes && timeGetTime() - start < kConnectTimeoutMs)
+			manager.DoSelect(1000);
+
+		double const cpuNs = CpuNs() - cpuBegin;
+		double const wallNs = NowNs() - wallBegin;
+
+		if (g_BytesIn < bytes)
+		{
+			fprintf(stderr, "recv_throughput: only %u of %u bytes arrived\n", g_BytesIn, bytes);
+		}
+		else
+		{
+			printf("{\"benchmark\":\"recv_throughput\",\"poller\":\"%s\",\"param\":%u,\"iterations\":%u,\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f,\"mb_per_sec\":%.1f,\"mb_per_cpu_sec\":%.1f}\n",
+				manager.GetPoller()->VGetName(), packetSize, packets, cpuNs / packets, packets * 1.0e9 / cpuNs,
+				bytes * 1.0e3 / wallNs, bytes * 1.0e3 / cpuNs);
+			fflush(stdout);
+		}
+
+		manager.Shutdown();
+
+		if (child > 0)
+		{
+			close(releaseFd);
+			waitpid(child, NULL, 0);
+		}
+	}
+
+	//
+	// One server with 'idle' quiet connections and kHotSockets busy
+	// ones, polled by pPoller.
+	//
+	void BenchPoller(ISocketPoller *pPoller, unsigned int idle)
+	{
+		BaseSocketManager manager;
+		manager.SetPoller(pPoller);
+		manager.Init();
+
+		char const * const pName = pPoller->VGetName();
+
+		BenchListenSocket *pListen = GCC_NEW BenchListenSocket;
+		manager.AddSocket(pListen);
+
+		// the hot ones first, so they're the first ids
+		std::vector<SOCKET> hotClients;
+		for (unsigned int i = 0; i < kHotSockets; ++i)
+			hotClients.push_back(ConnectLoopback(pListen->port));
+
+		int releaseFd = -1;
+		pid_t child = SpawnIdleClients(pListen->port, idle, releaseFd);
+
+		unsigned int const start = timeGetTime();
+		while (pListen->m_Accepted < kHotSockets + idle)
+		{
+			manager.DoSelect(1000);
+			if (timeGetTime() - start > kConnectTimeoutMs)
+				break;
+		}
+
+		if (pListen->m_Accepted < kHotSockets + idle)
+		{
+			fprintf(stderr, "%s: only %u of %u connections made\n", pName, pListen->m_Accepted, kHotSockets + idle);
+		}
+		else
+		{
+			// let the accepts and the first writable edges settle
+			for (unsigned int i = 0; i < 10; ++i)
+				manager.DoSelect(0);
+
+			// --- nobody says anything ---
+
+			double begin = NowNs();
+			for (unsigned int frame = 0; frame < kFrames; ++frame)
+				manager.DoSelect(0);
+			Report("idle_frame", pName, idle, kFrames, NowNs() - begin);
+
+			// --- the hot connections send a packet and get one back ---
+
+			char payload[kPayloadSize];
+			memset(payload, 'x', sizeof(payload));
+			BinaryPacket packet(payload, sizeof(payload));
+			shared_ptr<IPacket> reply(GCC_NEW BinaryPacket(payload, sizeof(payload)));
+
+			g_PacketsIn = 0;
+			double total = 0.0;
+			for (unsigned int frame = 0; frame < kFrames; ++frame)
+			{
+				for (unsigned int i = 0; i < kHotSockets; ++i)
+				{
+					send(hotClients[i], packet.VGetData(), packet.VGetSize(), MSG_NOSIGNAL);
+					manager.Send(pListen->m_SockIds[i], reply);
+				}
+
+				begin = NowNs();
+				manager.DoSelect(0);
+				total += NowNs() - begin;
+
+				for (unsigned int i = 0; i < kHotSockets; ++i)
+					DrainClient(hotClients[i]);
+			}
+			Report("hot_frame", pName, idle, kFrames, total);
+
+			if (g_PacketsIn != kFrames * kHotSockets)
+				fprintf(stderr, "%s: %u of %u packets arrived\n", pName, g_PacketsIn, kFrames * kHotSockets);
+		}
+
+		for (unsigned int i = 0; i < hotClients.size(); ++i)
+			closesocket(hotClients[i]);
+
+		manager.Shutdown();
+
+		if (child > 0)
+		{
+			close(releaseFd);
+			waitpid(child, NULL, 0);
+		}
+	}
+
+	// --- udp ---
+
+	// A counter in every packet, and which channel it was sent on.
+	void WriteCounter(char *payload, NetChannel channel, unsigned int counter)
+	{
+		payload[0] = static_cast<char>(channel);
+		counter = htonl(counter);
+		memcpy(payload + 1, &counter, sizeof(counter));
+	}
+
+	// Both ends lose and hold back what they send the same way, but
+	// not the same datagrams.
+	shared_ptr<NetSimulator> CreateSimulator(float lossPercent, unsigned int seed)
+	{
+		shared_ptr<NetSimulator> pSimulator(GCC_NEW NetSimulator(seed));
+		pSimulator->SetLoss(lossPercent);
+		pSimulator->SetLatency(kUdpLatencyMs, kUdpJitterMs);
+		return pSimulator;
+	}
+
+	// The client end, checking what arrives against what was sent.
+	class BenchUdpClient : public UdpSocket
+	{
+	public:
+		BenchUdpClient()
+			: m_ReliableIn(0), m_UnreliableIn(0), m_LastUnreliable(0), m_bInOrder(true) { }
+
+		unsigned int m_ReliableIn;
+		unsigned int m_UnreliableIn;
+		unsigned int m_LastUnreliable;
+		bool m_bInOrder;
+
+	protected:
+		virtual void HandlePacket(IPacket const &packet)
+		{
+			char const *pPayload = packet.VGetData() + sizeof(u_long);
+			unsigned int counter;
+			memcpy(&counter, pPayload + 1, sizeof(counter));
+			counter = ntohl(counter);
+
+			if (pPayload[0] == NetChannel_ReliableOrdered)
+			{
+				// every one, in order
+				if (counter != m_ReliableIn)
+					m_bInOrder = false;
+				++m_ReliableIn;
+			}
+			else
+			{
+				// some, but never one older than what's been seen
+				if (m_UnreliableIn && counter <= m_LastUnreliable)
+					m_bInOrder = false;
+				m_LastUnreliable = counter;
+				++m_UnreliableIn;
+			}
+		}
+	};
+
+	class BenchUdpListenSocket : public UdpListenSocket
+	{
+	public:
+		BenchUdpListenSocket(float lossPercent) : m_pServer(NULL), m_LossPercent(lossPercent)
+		{
+			Init(0);
+		}
+
+		UdpSocket *m_pServer;
+
+	protected:
+		virtual UdpSocket *VCreateSocket()
+		{
+			m_pServer = GCC_NEW UdpSocket;
+			m_pServer->SetSimulator(CreateSimulator(m_LossPercent, 2));
+			return m_pServer;
+		}
+
+		float m_LossPercent;
+	};
+
+	//
+	// A server and a client over loopback, both losing lossPercent of
+	// what they send, sending kUdpReliablePerFrame reliable and
+	// kUdpUnreliablePerFrame unreliable packets a frame to the client.
+	//
+	void BenchUdp(float lossPercent)
+	{
+		BaseSocketManager manager;
+		manager.Init();
+
+		BenchUdpListenSocket *pListen = GCC_NEW BenchUdpListenSocket(lossPercent);
+		manager.AddSocket(pListen);
+
+		BenchUdpClient *pClient = GCC_NEW BenchUdpClient;
+		pClient->SetSimulator(CreateSimulator(lossPercent, 1));
+		pClient->Connect(INADDR_LOOPBACK, pListen->port);
+		manager.AddSocket(pClient);
+
+		unsigned int start = timeGetTime();
+		while (!pClient->IsConnected() || !pListen->m_pServer || !pListen->m_pServer->IsConnected())
+		{
+			manager.DoSelect(1000);
+			if (timeGetTime() - start > kConnectTimeoutMs)
+			{
+				fprintf(stderr, "udp: no connection at %.0f%% loss\n", lossPercent);
+				manager.Shutdown();
+				return;
+			}
+		}
+
+		UdpSocket *pServer = pListen->m_pServer;
+
+		char payload[5];
+		unsigned int reliableOut = 0;
+		unsigned int unreliableOut = 0;
+
+		start = timeGetTime();
+		for (unsigned int frame = 0; frame < kUdpFrames; ++frame)
+		{
+			for (unsigned int i = 0; i < kUdpReliablePerFrame; ++i)
+			{
+				WriteCounter(payload, NetChannel_ReliableOrdered, reliableOut++);
+				pServer->SendOnChannel(shared_ptr<IPacket>(GCC_NEW BinaryPacket(payload, sizeof(payload))), NetChannel_ReliableOrdered);
+			}
+
+			for (unsigned int i = 0; i < kUdpUnreliablePerFrame; ++i)
+			{
+				WriteCounter(payload, NetChannel_UnreliableSequenced, unreliableOut++);
+				pServer->SendOnChannel(shared_ptr<IPacket>(GCC_NEW BinaryPacket(payload, sizeof(payload))), NetChannel_UnreliableSequenced);
+			}
+
+			manager.FlushOutput();
+
+			// a game's frame, not as fast as it'll go
+			unsigned int const frameEnd = start + (frame + 1) * kUdpFrameMs;
+			while (static_cast<int>(frameEnd - timeGetTime()) > 0)
+				manager.DoSelect(1000);
+		}
+
+		// everything reliable still has to get there
+		while (pClient->m_ReliableIn < reliableOut && timeGetTime() - start < kConnectTimeoutMs)
+			manager.DoSelect(1000);
+
+		unsigned int const elapsedMs = timeGetTime() - start;
+
+		printf("{\"benchmark\":\"udp\",\"poller\":\"%s\",\"param\":%.0f,\"iterations\":%u,\"reliable_sent\":%u,\"reliable_delivered\":%u,\"unreliable_sent\":%u,\"unreliable_delivered\":%u,\"in_order\":%s,\"datagrams\":%u,\"resends\":%u,\"rtt_ms\":%u,\"elapsed_ms\":%u}\n",
+			manager.GetPoller()->VGetName(), lossPercent, kUdpFrames, reliableOut, pClient->m_ReliableIn, unreliableOut, pClient->m_UnreliableIn,
+			pClient->m_bInOrder ? "true" : "false", pServer->GetDatagramsSent(), pServer->GetResends(), pServer->GetRoundTripMs(), elapsedMs);
+		fflush(stdout);
+
+		manager.Shutdown();
+	}
+
+	// --- snapshot ---
+
+	// Where actor 'id' is at 'tick' - 'moving' of them going round in
+	// circles and turning as they go, the rest standing still.
+	void SimulateActor(unsigned int id, unsigned int moving, unsigned int tick, ActorNetState &state)
+	{
+		float const t = (id < moving) ? tick / static_cast<float>(kPhysicsRate) : 0.0f;
+		float const radius = 5.0f + id % 7;
+		float const angle = t * (5.0f / radius) + id;			// 5 units a second
+
+		state.m_ActorId = id + 1;
+		state.m_Pos[0] = (id % 8) * 12.0f + radius * cosf(angle);
+		state.m_Pos[1] = 1.0f;
+		state.m_Pos[2] = (id / 8) * 12.0f + radius * sinf(angle);
+
+		// turning about y, to face the way it's going
+		state.m_Rot[0] = 0.0f;
+		state.m_Rot[1] = sinf(angle * 0.5f);
+		state.m_Rot[2] = 0.0f;
+		state.m_Rot[3] = cosf(angle * 0.5f);
+	}
+
+	// Hands its packets straight to a client's SnapshotReceiver,
+	// losing some, and acks them kSnapshotAckDelay snapshots later -
+	// about a round trip.
+	class BenchReplicator : public SnapshotReplicator
+	{
+	public:
+		BenchReplicator(unsigned int lossPercent)
+			: m_LossPercent(lossPercent), m_Seed(1), m_Packets(0), m_Lost(0) { }
+
+		void DeliverAcks(bool bAll)
+		{
+			while (!m_Acks.empty() && (bAll || m_Acks.front().first + kSnapshotAckDelay <= GetTick()))
+			{
+				OnAck(1, m_Acks.front().second);
+				m_Acks.erase(m_Acks.begin());
+			}
+		}
+
+		unsigned int m_LossPercent;
+		unsigned int m_Seed;
+		unsigned int m_Packets;
+		unsigned int m_Lost;
+
+		SnapshotReceiver m_Receiver;
+		std::vector<ActorNetState> m_Moved;
+		std::map<unsigned int, ActorNetState> m_ClientActors;
+		std::vector< std::pair<unsigned int, unsigned int> > m_Acks;		// sent at, tick
+
+	protected:
+		virtual bool VSend(int sockId, shared_ptr<IPacket> packet)
+		{
+			++m_Packets;
+
+			m_Seed = m_Seed * 1103515245 + 12345;
+			if ((m_Seed >> 16) % 100 < m_LossPercent)
+			{
+				++m_Lost;
+				return true;
+			}
+
+			BinaryInStream in(packet->VGetData() + sizeof(u_long), packet->VGetSize() - sizeof(u_long));
+			in.ReadU8();
+
+			unsigned int ackTick;
+			if (m_Receiver.Read(in, m_Moved, ackTick))
+			{
+				for (unsigned int i = 0; i < m_Moved.size(); ++i)
+					m_ClientActors[m_Moved[i].m_ActorId] = m_Moved[i];
+				if (ackTick)
+					m_Acks.push_back(std::make_pair(GetTick(), ackTick));
+			}
+			return true;
+		}
+	};
+
+	//
+	// What kSnapshotActors actors, 'moving' of them moving, cost a
+	// client a second: as a Move_Actor event for every actor that
+	// moves each physics tick, the way the physics sends them, and as
+	// snapshots kSnapshotRate times a second.
+	//
+	void BenchSnapshot(unsigned int moving)
+	{
+		unsigned int const physicsTicks = kPhysicsRate * kSnapshotSeconds;
+
+		// --- events, binary and text ---
+
+		for (int text = 0; text < 2; ++text)
+		{
+			EventWire::SetTextMode(text != 0);
+
+			BinaryOutStream scratch;
+			unsigned long bytes = 0;
+			unsigned int packets = 0;
+
+			for (unsigned int tick = 1; tick <= physicsTicks; ++tick)
+			{
+				for (unsigned int id = 0; id < moving; ++id)
+				{
+					ActorNetState state;
+					SimulateActor(id, moving, tick, state);
+
+					// a matrix like the one the physics would have
+					BenchMoveEvent event(state.m_ActorId);
+					float const y = 2.0f * atan2f(state.m_Rot[1], state.m_Rot[3]);
+					float const mat[16] = {
+						cosf(y), 0.0f, -sinf(y), 0.0f,
+						0.0f, 1.0f, 0.0f, 0.0f,
+						sinf(y), 0.0f, cosf(y), 0.0f,
+						state.m_Pos[0], state.m_Pos[1], state.m_Pos[2], 1.0f };
+					memcpy(event.m_Mat, mat, sizeof(mat));
+
+					shared_ptr<IPacket> packet = EventWire::CreatePacket(event, scratch);
+					bytes += packet->VGetSize();
+					++packets;
+				}
+			}
+
+			printf("{\"benchmark\":\"snapshot\",\"mode\":\"%s\",\"param\":%u,\"actors\":%u,\"bytes_per_client_per_sec\":%lu,\"packets_per_sec\":%u}\n",
+				text ? "events_text" : "events_binary", moving, kSnapshotActors, bytes / kSnapshotSeconds, packets / kSnapshotSeconds);
+		}
+		EventWire::SetTextMode(false);
+
+		// --- snapshots ---
+
+		unsigned int const losses[] = { 0, 5 };
+		for (unsigned int l = 0; l < sizeof(losses) / sizeof(losses[0]); ++l)
+		{
+			BenchReplicator replicator(losses[l]);
+			replicator.AddClient(1);
+
+			double encodeNs = 0.0;
+			unsigned int snapshots = 0;
+
+			for (unsigned int tick = 1; tick <= physicsTicks; ++tick)
+			{
+				if (tick % (kPhysicsRate / kSnapshotRate))
+					continue;
+
+				replicator.DeliverAcks(false);
+
+				// the last one gets there, so the client can be checked
+				if (tick + kPhysicsRate / kSnapshotRate > physicsTicks)
+					replicator.m_LossPercent = 0;
+
+				double const begin = NowNs();
+				replicator.BeginSnapshot();
+				for (unsigned int id = 0; id < kSnapshotActors; ++id)
+				{
+					ActorNetState state;
+					SimulateActor(id, moving, tick, state);
+					replicator.AddActor(state);
+				}
+				replicator.SendSnapshot();
+				encodeNs += NowNs() - begin;
+				++snapshots;
+
+				if (tick + kPhysicsRate / kSnapshotRate > physicsTicks)
+				{
+					// how far the client is from where they really are
+					float maxError = 0.0f;
+					for (unsigned int id = 0; id < kSnapshotActors; ++id)
+					{
+						ActorNetState state;
+						SimulateActor(id, moving, tick, state);
+
+						ActorNetState const &client = replicator.m_ClientActors[id + 1];
+						for (int i = 0; i < 3; ++i)
+							maxError = std::max(maxError, fabsf(client.m_Pos[i] - state.m_Pos[i]));
+						for (int i = 0; i < 4; ++i)
+							maxError = std::max(maxError, std::min(fabsf(client.m_Rot[i] - state.m_Rot[i]), fabsf(client.m_Rot[i] + state.m_Rot[i])));
+					}
+
+					printf("{\"benchmark\":\"snapshot\",\"mode\":\"snapshot\",\"param\":%u,\"actors\":%u,\"loss_percent\":%u,\"bytes_per_client_per_sec\":%lu,\"packets_per_sec\":%u,\"lost\":%u,\"ns_per_snapshot\":%.1f,\"max_error\":%.4f}\n",
+						moving, kSnapshotActors, losses[l], replicator.GetBytesSent() / kSnapshotSeconds, replicator.m_Packets / kSnapshotSeconds,
+						replicator.m_Lost, encodeNs / snapshots, maxError);
+				}
+			}
+		}
+		fflush(stdout);
+	}
+
+	//
+	// kInterestActors actors each sending a Move_Actor every physics
+	// tick, and how many of kInterestClients players an InterestManager
+	// lets each one go to. Every actor heads off its own way and
+	// wobbles a little, the way the physics does.
+	//
+	void BenchInterest(unsigned int radius, unsigned int hysteresis)
+	{
+		std::vector<float> pos(kInterestActors * 3);
+		std::vector<float> heading(kInterestActors);
+		unsigned int seed = 12345;
+
+		for (unsigned int id = 0; id < kInterestActors; ++id)
+		{
+			seed = seed * 1103515245 + 12345;
+			pos[id*3 + 0] = (seed >> 8) % static_cast<unsigned int>(kInterestMapSize);
+			pos[id*3 + 1] = 1.0f;
+			seed = seed * 1103515245 + 12345;
+			pos[id*3 + 2] = (seed >> 8) % static_cast<unsigned int>(kInterestMapSize);
+			heading[id] = static_cast<float>(id);
+		}
+
+		InterestManager interest(static_cast<float>(radius), static_cast<float>(radius + hysteresis));
+		for (unsigned int c = 0; c < kInterestClients; ++c)
+			interest.AddClient(c + 1);
+
+		// who could see what last tick, to count the flips
+		std::vector<char> seen(kInterestClients * kInterestActors, 0);
+
+		double updateNs = 0.0;
+		double filterNs = 0.0;
+		unsigned long long sends = 0;
+		unsigned long long events = 0;
+		unsigned long flips = 0;
+
+		unsigned int const ticks = kPhysicsRate * kInterestSeconds;
+		for (unsigned int tick = 0; tick < ticks; ++tick)
+		{
+			float const step = 5.0f / kPhysicsRate;				// 5 units a second
+			for (unsigned int id = 0; id < kInterestActors; ++id)
+			{
+				seed = seed * 1103515245 + 12345;
+				float const wobble = (static_cast<int>((seed >> 8) % 201) - 100) * 0.005f;
+
+				heading[id] += 0.01f;
+				pos[id*3 + 0] = fmodf(pos[id*3 + 0] + step * cosf(heading[id]) + wobble + kInterestMapSize, kInterestMapSize);
+				pos[id*3 + 2] = fmodf(pos[id*3 + 2] + step * sinf(heading[id]) - wobble + kInterestMapSize, kInterestMapSize);
+			}
+
+			double begin = NowNs();
+			interest.BeginUpdate();
+			for (unsigned int id = 0; id < kInterestActors; ++id)
+				interest.AddActor(id + 1, &pos[id*3]);
+			interest.EndUpdate();
+			updateNs += NowNs() - begin;
+
+			if (tick == 0)
+			{
+				for (unsigned int c = 0; c < kInterestClients; ++c)
+					interest.SetViewer(c + 1, c + 1);
+			}
+
+			// what a NetworkEventBroadcaster asks for each move
+			begin = NowNs();
+			unsigned int tickSends = 0;
+			for (unsigned int id = 0; id < kInterestActors; ++id)
+			{
+				for (unsigned int c = 0; c < kInterestClients; ++c)
+				{
+					if (interest.IsRelevant(c + 1, id + 1))
+						++tickSends;
+				}
+			}
+			filterNs += NowNs() - begin;
+			sends += tickSends;
+			events += kInterestActors;
+
+			for (unsigned int c = 0; c < kInterestClients; ++c)
+			{
+				for (unsigned int id = 0; id < kInterestActors; ++id)
+				{
+					char const now = interest.IsRelevant(c + 1, id + 1) ? 1 : 0;
+					char &was = seen[c * kInterestActors + id];
+					if (tick > 1 && now != was)
+						++flips;
+					was = now;
+				}
+			}
+		}
+
+		printf("{\"benchmark\":\"interest\",\"param\":%u,\"hysteresis\":%u,\"actors\":%u,\"clients\":%u,\"sends_per_event\":%.2f,\"sends_per_event_without\":%u,\"flips_per_sec\":%.1f,\"ns_per_update\":%.1f,\"ns_per_event\":%.1f}\n",
+			radius, hysteresis, kInterestActors, kInterestClients, sends / static_cast<double>(events), kInterestClients,
+			flips / static_cast<double>(kInterestSeconds), updateNs / ticks, filterNs / events);
+		fflush(stdout);
+	}
+
+	// --- the network thread ---
+
+	class BenchCountListener : public IEventListener
+	{
+	public:
+		BenchCountListener() : m_Count(0) { }
+
+		virtual char const *GetName(void) { return "BenchCountListener"; }
+		virtual bool HandleEvent(IEventData const &event) { ++m_Count; return false; }
+
+		unsigned int m_Count;
+	};
+
+	//
+	// What the game thread spends on a frame, with the sockets on it or
+	// on a thread of their own.
+	//
+	void BenchThread(bool bThreaded)
+	{
+		char const * const pMode = bThreaded ? "threaded" : "inline";
+
+		EventManager eventManager("SocketBench", true);
+		eventManager.RegisterCodeOnlyEvent(BenchMoveEvent::sk_EventType);
+		shared_ptr<BenchCountListener> listener(GCC_NEW BenchCountListener);
+		eventManager.VAddListener(listener, BenchMoveEvent::sk_EventType);
+
+		BaseSocketManager manager;
+		manager.Init();
+
+		BenchListenSocket *pListen = GCC_NEW BenchListenSocket;
+		pListen->m_bDecode = true;
+		manager.AddSocket(pListen);
+
+		int releaseFd = -1;
+		pid_t child = SpawnBurstingClients(pListen->port, kThreadClients, kThreadSlowClients, releaseFd);
+
+		unsigned int const start = timeGetTime();
+		while (pListen->m_Accepted < kThreadClients && timeGetTime() - start < kConnectTimeoutMs)
+			manager.DoSelect(1000);
+
+		if (pListen->m_Accepted < kThreadClients)
+		{
+			fprintf(stderr, "thread: only %u of %u connections made\n", pListen->m_Accepted, kThreadClients);
+		}
+		else if (bThreaded && !manager.StartThread())
+		{
+			fprintf(stderr, "thread: no network thread\n");
+		}
+		else
+		{
+			char payload[kPayloadSize];
+			memset(payload, 'x', sizeof(payload));
+			shared_ptr<IPacket> packet(GCC_NEW BinaryPacket(payload, sizeof(payload)));
+
+			std::vector<double> frames, io;
+			for (unsigned int frame = 0; frame < kWarmupFrames + kThreadFrames; ++frame)
+			{
+				double const begin = NowNs();
+				manager.DoSelect(0);
+				double const selected = NowNs();
+				eventManager.VTick(IEventManager::kINFINITE);
+				double const ticked = NowNs();
+				for (unsigned int i = 0; i < kThreadClients; ++i)
+					manager.Send(pListen->m_SockIds[i], packet);
+				manager.FlushOutput();
+				double const took = NowNs() - begin;
+
+				if (frame >= kWarmupFrames)
+				{
+					frames.push_back(took);
+					io.push_back(took - (ticked - selected));
+				}
+
+				unsigned int const tookMs = static_cast<unsigned int>(took / 1.0e6);
+				if (tookMs < kThreadFrameMs)
+					Sleep(kThreadFrameMs - tookMs);
+			}
+
+			unsigned int const stalls = manager.GetEventStalls();
+			manager.StopThread();
+
+			std::sort(frames.begin(), frames.end());
+			std::sort(io.begin(), io.end());
+			double total = 0.0;
+			for (unsigned int i = 0; i < frames.size(); ++i)
+				total += frames[i];
+
+			printf("{\"benchmark\":\"thread\",\"mode\":\"%s\",\"param\":%u,\"iterations\":%u,\"mean_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f,\"io_p50_us\":%.1f,\"io_p99_us\":%.1f,\"events\":%u,\"event_stalls\":%u}\n",
+				pMode, kThreadClients, kThreadFrames, total / frames.size() / 1.0e3, frames[frames.size() / 2] / 1.0e3,
+				frames[frames.size() * 99 / 100] / 1.0e3, frames.back() / 1.0e3, io[io.size() / 2] / 1.0e3,
+				io[io.size() * 99 / 100] / 1.0e3, listener->m_Count, stalls);
+			fflush(stdout);
+		}
+
+		manager.Shutdown();
+
+		if (child > 0)
+		{
+			close(releaseFd);
+			waitpid(child, NULL, 0);
+		}
+	}
+}
+
+namespace
+{
+	//
+	// Each socket's stats, after kStatsSeconds of traffic.
+	//
+	void BenchStats()
+	{
+		BaseSocketManager manager;
+		manager.Init();
+
+		BenchListenSocket *pListen = GCC_NEW BenchListenSocket;
+		manager.AddSocket(pListen);
+
+		int releaseFd = -1;
+		pid_t child = SpawnBurstingClients(pListen->port, kStatsClients, 1, releaseFd);
+
+		unsigned int const start = timeGetTime();
+		while (pListen->m_Accepted < kStatsClients && timeGetTime() - start < kConnectTimeoutMs)
+			manager.DoSelect(1000);
+
+		if (pListen->m_Accepted < kStatsClients)
+		{
+			fprintf(stderr, "stats: only %u of %u connections made\n", pListen->m_Accepted, kStatsClients);
+		}
+		else
+		{
+			char payload[kStatsPacketSize];
+			memset(payload, 'x', sizeof(payload));
+			shared_ptr<IPacket> packet(GCC_NEW BinaryPacket(payload, sizeof(payload)));
+
+			unsigned int const begin = timeGetTime();
+			while (timeGetTime() - begin < kStatsSeconds * 1000)
+			{
+				manager.DoSelect(0);
+				for (unsigned int i = 0; i < kStatsClients; ++i)
+				{
+					for (unsigned int p = 0; p < kStatsPackets; ++p)
+						manager.Send(pListen->m_SockIds[i], packet);
+				}
+				manager.FlushOutput();
+				Sleep(kStatsFrameMs);
+			}
+
+			std::string dump;
+			manager.DumpStats(dump);
+
+			// one socket a line, as a dashboard would take them
+			for (size_t line = 0, end; (end = dump.find('\n', line)) != std::string::npos; line = end + 1)
+				printf("{\"benchmark\":\"stats\",\"socket\":%s}\n", dump.substr(line, end - line).c_str());
+			fflush(stdout);
+		}
+
+		manager.Shutdown();
+
+		if (child > 0)
+		{
+			close(releaseFd);
+			waitpid(child, NULL, 0);
+		}
+	}
+}
+
+namespace
+{
+	//
+	// A level join's worth of New_Actor messages, much as
+	// EvtData_New_Actor::VSerializeBinary() writes them for the
+	// teapots, grids, spheres and meshes in a level.
+	//
+	void MakeJoinBurst(std::vector<std::string> &messages)
+	{
+		char const * const lua[] = { "", "GlowingGridOnCreate", "TeapotOnCreate", "SphereOnCreate" };
+
+		srand(46);
+		for (unsigned int i = 0; i < kCompressActors; ++i)
+		{
+			int const type = i % 4;
+			BinaryOutStream out;
+			out.WriteU8(EventWire::kMsgEvent);
+			out.WriteU16(EventWire::kFirstGameWireId + 2);
+			out.WriteU32(i + 1);
+
+			// ActorParams
+			out.WriteI32(type + 1);
+			out.WriteBool(true);
+			out.WriteU32(i + 1);
+			for (int f = 0; f < 3; ++f)
+				out.WriteFloat(float(rand() % 2000) / 10.0f);
+			float const color[] = { 1.0f, 0.5f, 0.5f, 1.0f };
+			out.WriteFloats(color, 4);
+			out.WriteString(lua[type]);
+			out.WriteString(type == 1 ? "GlowingGridOnDestroy" : "");
+
+			switch (type)
+			{
+				case 0:		// a mesh
+					out.WriteString("Meshes\\Tiny.x");
+					out.WriteString("Effects\\GameCode3.fx");
+					break;
+				case 1:		// a grid
+					out.WriteString("grid.dds");
+					out.WriteU32(100);
+					break;
+				case 2:		// a teapot
+					out.WriteFloat(1.0f);
+					out.WriteU32(i % 8);
+					break;
+				case 3:		// a sphere
+					out.WriteFloat(1.0f);
+					out.WriteI32(40);
+					break;
+			}
+
+			// a yaw and a translation
+			float const yaw = float(rand() % 360) * 3.14159f / 180.0f;
+			float const mat[16] =
+			{
+				cosf(yaw), 0.0f, -sinf(yaw), 0.0f,
+				0.0f, 1.0f, 0.0f, 0.0f,
+				sinf(yaw), 0.0f, cosf(yaw), 0.0f,
+				float(rand() % 2000) / 10.0f, 0.0f, float(rand() % 2000) / 10.0f, 1.0f
+			};
+			out.WriteFloats(mat, 16);
+
+			messages.push_back(std::string(out.GetData(), out.GetSize()));
+		}
+	}
+
+	//
+	// A join burst through a pair of NetCompressors, as a
+	// RemoteEventSocket would send it. 'mode' is none, message with a
+	// new pair for every message - what compressing each on its own
+	// would cost - stream with the one pair for them all, or
+	// dictionary, the same primed with the strings actors have.
+	//
+	void BenchCompress(char const *pMode)
+	{
+		std::vector<std::string> messages;
+		MakeJoinBurst(messages);
+
+		static char const s_Dictionary[] =
+			"Meshes\\Tiny.xEffects\\GameCode3.fxgrid.ddsGlowingGridOnDestroy"
+			"SphereOnCreateTeapotOnCreateGlowingGridOnCreate";
+
+		bool const bNone = !strcmp(pMode, "none");
+		bool const bFresh = !strcmp(pMode, "message");
+		if (!strcmp(pMode, "dictionary"))
+			NetCompressor::SetDictionary(s_Dictionary, sizeof(s_Dictionary) - 1);
+
+		NetSocketStats sending, receiving;
+		NetCompressor *pSender = NULL;
+		NetCompressor *pReceiver = NULL;
+
+		unsigned long rawBytes = 0, bytes = 0;
+		unsigned int bad = 0;
+		BinaryOutStream out;
+		std::vector<char> back;
+
+		for (unsigned int pass = 0; pass < kCompressPasses; ++pass)
+		{
+			for (size_t i = 0; i < messages.size(); ++i)
+			{
+				std::string const &message = messages[i];
+
+				if (!pSender || bFresh)
+				{
+					SAFE_DELETE(pSender);
+					SAFE_DELETE(pReceiver);
+					pSender = GCC_NEW NetCompressor(sending);
+					pReceiver = GCC_NEW NetCompressor(receiving);
+				}
+
+				rawBytes += message.size();
+				if (bNone || !pSender->Compress(message.data(), static_cast<unsigned int>(message.size()), out))
+				{
+					bytes += message.size();
+					continue;
+				}
+
+				bytes += out.GetSize();
+				if (!pReceiver->Decompress(out.GetData(), out.GetSize(), back) ||
+					back.size() != message.size() || memcmp(&back[0], message.data(), message.size()))
+				{
+					++bad;
+				}
+			}
+		}
+
+		SAFE_DELETE(pSender);
+		SAFE_DELETE(pReceiver);
+		NetCompressor::SetDictionary(NULL, 0);
+
+		if (bad)
+			fprintf(stderr, "compress: %u messages didn't come back the same\n", bad);
+
+		unsigned int const count = static_cast<unsigned int>(messages.size()) * kCompressPasses;
+		printf("{\"benchmark\":\"compress\",\"mode\":\"%s\",\"param\":%u,\"messages\":%u,\"compressed\":%lu,"
+			"\"raw_bytes\":%lu,\"bytes\":%lu,\"ratio\":%.3f,\"compress_ns\":%.0f,\"decompress_ns\":%.0f}\n",
+			pMode, NetCompressor::GetThreshold(), count, sending.m_CompressedOut, rawBytes, bytes, double(bytes) / rawBytes,
+			sending.m_CompressedOut ? sending.m_CompressNs / sending.m_CompressedOut : 0.0,
+			receiving.m_CompressedIn ? receiving.m_DecompressNs / receiving.m_CompressedIn : 0.0);
+		fflush(stdout);
+	}
+}
+
+namespace
+{
+	//
+	// Where actor 'a' of the interpolate benchmark is at 'ms', going
+	// round a circle of its own.
+	//
+	void InterpolateTruth(unsigned int a, unsigned int ms, ActorNetState &state)
+	{
+		float const angle = float(a) + ms * kInterpSpeed / (1000.0f * kInterpRadius);
+		float const heading = angle + 1.5708f;
+
+		state.m_ActorId = a + 1;
+		state.m_Pos[0] = kInterpRadius * cosf(angle) + a * 50.0f;
+		state.m_Pos[1] = 0.0f;
+		state.m_Pos[2] = kInterpRadius * sinf(angle);
+		state.m_Rot[0] = 0.0f;
+		state.m_Rot[1] = sinf(heading / 2.0f);
+		state.m_Rot[2] = 0.0f;
+		state.m_Rot[3] = cosf(heading / 2.0f);
+	}
+
+	//
+	// kInterpActors actors each sent 'rate' times a second, over a
+	// connection with kInterpLatencyMs and up to kInterpJitterMs more,
+	// losing kInterpLoss percent. The client draws a frame every
+	// kInterpFrameMs - the newest update as it is ('none'), or
+	// through an InterpolationBuffer ('buffer').
+	//
+	void BenchInterpolate(unsigned int rate, bool bBuffer)
+	{
+		InterpolationBuffer buffer;
+		buffer.SetDelay(kInterpDelayMs);
+
+		std::vector< std::deque< std::pair<unsigned int, ActorNetState> > > inFlight(kInterpActors);
+		std::vector<ActorNetState> shown(kInterpActors);
+		std::vector<ActorNetState> drawn[3];
+		std::vector<ActorNetState> sampled;
+		for (unsigned int a = 0; a < kInterpActors; ++a)
+			InterpolateTruth(a, 0, shown[a]);
+
+		srand(47);
+
+		unsigned int const interval = 1000 / rate;
+		unsigned int const endMs = kInterpSeconds * 1000;
+		double jerk = 0.0;
+		unsigned int frames = 0, stalls = 0, sent = 0;
+
+		for (unsigned int ms = 0; ms < endMs; ++ms)
+		{
+			// TCP - everything arrives, in order, a lost packet holding
+			// up the rest until it's resent a round trip later
+			if (ms % interval == 0)
+			{
+				for (unsigned int a = 0; a < kInterpActors; ++a)
+				{
+					std::pair<unsigned int, ActorNetState> update;
+					InterpolateTruth(a, ms, update.second);
+					update.first = ms + kInterpLatencyMs + rand() % (kInterpJitterMs + 1);
+					if (unsigned(rand() % 100) < kInterpLoss)
+						update.first += kInterpLatencyMs * 2;
+					if (!inFlight[a].empty() && update.first < inFlight[a].back().first)
+						update.first = inFlight[a].back().first;
+					inFlight[a].push_back(update);
+					++sent;
+				}
+			}
+
+			for (unsigned int a = 0; a < kInterpActors; ++a)
+			{
+				while (!inFlight[a].empty() && inFlight[a].front().first <= ms)
+				{
+					if (bBuffer)
+						buffer.Add(inFlight[a].front().second, ms);
+					else
+						shown[a] = inFlight[a].front().second;
+					inFlight[a].pop_front();
+				}
+			}
+
+			if (ms % kInterpFrameMs)
+				continue;
+
+			if (bBuffer)
+			{
+				buffer.Sample(ms, sampled);
+				for (unsigned int i = 0; i < sampled.size(); ++i)
+					shown[sampled[i].m_ActorId - 1] = sampled[i];
+			}
+
+			// how far each frame's step is from the last one's - it's
+			// going round steadily, so it ought to be next to nothing
+			drawn[0].swap(drawn[1]);
+			drawn[1].swap(drawn[2]);
+			drawn[2] = shown;
+			if (ms < kInterpWarmupMs)
+				continue;
+
+			for (unsigned int a = 0; a < kInterpActors; ++a)
+			{
+				float change = 0.0f, step = 0.0f;
+				for (int i = 0; i < 3; ++i)
+				{
+					float const d = (drawn[2][a].m_Pos[i] - drawn[1][a].m_Pos[i]) - (drawn[1][a].m_Pos[i] - drawn[0][a].m_Pos[i]);
+					change += d * d;
+					step += (drawn[2][a].m_Pos[i] - drawn[1][a].m_Pos[i]) * (drawn[2][a].m_Pos[i] - drawn[1][a].m_Pos[i]);
+				}
+				jerk += sqrtf(change);
+				if (step == 0.0f)
+					++stalls;
+				++frames;
+			}
+		}
+
+		// as a fraction of how far one goes in a frame
+		float const frameStep = kInterpSpeed * kInterpFrameMs / 1000.0f;
+		InterpolationBuffer::Stats const &stats = buffer.GetStats();
+		unsigned long const drawnTotal = stats.m_Interpolated + stats.m_Extrapolated + stats.m_Stopped;
+
+		printf("{\"benchmark\":\"interpolate\",\"mode\":\"%s\",\"param\":%u,\"updates\":%u,\"frames\":%u,"
+			"\"jerk\":%.3f,\"stalled_pct\":%.1f,\"extrapolated_pct\":%.1f,\"delay_ms\":%u}\n",
+			bBuffer ? "buffer" : "none", rate, sent, frames,
+			jerk / frames / frameStep, stalls * 100.0 / frames,
+			drawnTotal ? (stats.m_Extrapolated + stats.m_Stopped) * 100.0 / drawnTotal : 0.0,
+			bBuffer ? kInterpDelayMs : 0);
+		fflush(stdout);
+	}
+}
+
+namespace
+{
+	// Counts the move events one game of the instances benchmark is
+	// handed. Its clients' ids are all below kThreadBurst; the one each
+	// game triggers itself every frame is kThreadBurst plus its id.
+	class BenchInstanceListener : public IEventListener
+	{
+	public:
+		explicit BenchInstanceListener(unsigned int id) : m_Id(id), m_Events(0), m_Frames(0), m_Misrouted(0) { }
+
+		virtual char const *GetName(void) { return "BenchInstanceListener"; }
+		virtual bool HandleEvent(IEventData const &event)
+		{
+			unsigned int const id = static_cast<BenchMoveEvent const &>(event).m_Id;
+			if (id < kThreadBurst)
+				++m_Events;
+			else if (id == kThreadBurst + m_Id)
+				++m_Frames;
+			else
+				++m_Misrouted;
+			return false;
+		}
+
+		unsigned int m_Id;
+		unsigned int m_Events;
+		unsigned int m_Frames;
+		unsigned int m_Misrouted;
+	};
+
+	// What a GameInstance has, less the game - its event manager, the
+	// socket its clients connect to, and a frame's worth of work.
+	class BenchInstance
+	{
+	public:
+		BenchInstance(unsigned int id, EventManager const &types)
+			: m_EventManager("SocketBench instance", false), m_Sink(0.0)
+		{
+			m_EventManager.CopyCodeEventTypes(types);
+			m_pListener.reset(GCC_NEW BenchInstanceListener(id));
+			m_EventManager.VAddListener(m_pListener, BenchMoveEvent::sk_EventType);
+
+			m_pListen = GCC_NEW BenchListenSocket;
+			m_pListen->m_bDecode = true;
+			m_pListen->m_pTo = &m_EventManager;
+		}
+
+		// GameInstance::Update(), and a packet for each client
+		void Frame(shared_ptr<IPacket> const &packet)
+		{
+			IEventManager * const pWas = IEventManager::SetThreadCurrent(&m_EventManager);
+
+			g_pSocketManager->HandOverTo(&m_EventManager);
+			m_EventManager.VTick(IEventManager::kINFINITE);
+			safeTriggerEvent(BenchMoveEvent(kThreadBurst + m_pListener->m_Id));
+
+			double const until = NowNs() + kInstanceWorkUs * 1.0e3;
+			while (NowNs() < until)
+				m_Sink += sqrt(m_Sink + 1.0);
+
+			for (unsigned int i = 0; i < m_pListen->m_SockIds.size(); ++i)
+				g_pSocketManager->Send(m_pListen->m_SockIds[i], packet);
+
+			IEventManager::SetThreadCurrent(pWas);
+		}
+
+		EventManager m_EventManager;
+		shared_ptr<BenchInstanceListener> m_pListener;
+		BenchListenSocket *m_pListen;		// the socket manager's
+		double m_Sink;
+	};
+
+	class BenchInstanceJob : public IThreadPoolJob
+	{
+	public:
+		BenchInstanceJob(BenchInstance *pInstance, shared_ptr<IPacket> const &packet) : m_pInstance(pInstance), m_Packet(packet) { }
+		virtual void VRun() { m_pInstance->Frame(m_Packet); }
+
+	private:
+		BenchInstance *m_pInstance;
+		shared_ptr<IPacket> m_Packet;
+	};
+
+	//
+	// 'count' games sharing the one socket manager, their frames run
+	// one after another or on a thread each.
+	//
+	void BenchInstances(unsigned int count, bool bPool)
+	{
+		char const * const pMode = bPool ? "pool" : "serial";
+
+		EventManager eventManager("SocketBench", true);
+		eventManager.RegisterCodeOnlyEvent(BenchMoveEvent::sk_EventType);
+		shared_ptr<BenchCountListener> strays(GCC_NEW BenchCountListener);
+		eventManager.VAddListener(strays, BenchMoveEvent::sk_EventType);
+
+		BaseSocketManager manager;
+		manager.Init();
+
+		std::vector<BenchInstance *> instances;
+		std::vector<pid_t> children;
+		std::vector<int> releaseFds;
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			BenchInstance *pInstance = GCC_NEW BenchInstance(i + 1, eventManager);
+			manager.AddSocket(pInstance->m_pListen);
+			instances.push_back(pInstance);
+
+			int releaseFd = -1;
+			children.push_back(SpawnBurstingClients(pInstance->m_pListen->port, kInstanceClients, 0, releaseFd));
+			releaseFds.push_back(releaseFd);
+		}
+
+		unsigned int accepted = 0;
+		unsigned int const start = timeGetTime();
+		while (accepted < count * kInstanceClients && timeGetTime() - start < kConnectTimeoutMs)
+		{
+			manager.DoSelect(1000);
+			accepted = 0;
+			for (unsigned int i = 0; i < count; ++i)
+				accepted += instances[i]->m_pListen->m_Accepted;
+		}
+
+		if (accepted < count * kInstanceClients)
+		{
+			fprintf(stderr, "instances: only %u of %u connections made\n", accepted, count * kInstanceClients);
+		}
+		else if (!manager.StartThread())
+		{
+			fprintf(stderr, "instances: no network thread\n");
+		}
+		else
+		{
+			ThreadPool *pThreads = bPool ? GCC_NEW ThreadPool(count) : NULL;
+
+			char payload[kPayloadSize];
+			memset(payload, 'x', sizeof(payload));
+			shared_ptr<IPacket> packet(GCC_NEW BinaryPacket(payload, sizeof(payload)));
+
+			std::vector<double> frames;
+			for (unsigned int frame = 0; frame < kWarmupFrames + kInstanceFrames; ++frame)
+			{
+				double const begin = NowNs();
+				manager.DoSelect(0);
+				for (unsigned int i = 0; i < count; ++i)
+				{
+					if (pThreads)
+						pThreads->Submit(ThreadPoolJobPtr(GCC_NEW BenchInstanceJob(instances[i], packet)));
+					else
+						instances[i]->Frame(packet);
+				}
+				if (pThreads)
+					pThreads->WaitForAll();
+				manager.FlushOutput();
+				double const took = NowNs() - begin;
+
+				if (frame >= kWarmupFrames)
+					frames.push_back(took);
+
+				unsigned int const tookMs = static_cast<unsigned int>(took / 1.0e6);
+				if (tookMs < kThreadFrameMs)
+					Sleep(kThreadFrameMs - tookMs);
+			}
+
+			unsigned int const stalls = manager.GetEventStalls();
+			manager.StopThread();
+			SAFE_DELETE(pThreads);
+
+			unsigned int events = 0, fewest = 0xffffffff, misrouted = strays->m_Count, frameEvents = 0;
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				BenchInstanceListener const &listener = *instances[i]->m_pListener;
+				events += listener.m_Events;
+				fewest = std::min(fewest, listener.m_Events);
+				misrouted += listener.m_Misrouted;
+				frameEvents += listener.m_Frames;
+			}
+
+			std::sort(frames.begin(), frames.end());
+			double total = 0.0;
+			for (unsigned int i = 0; i < frames.size(); ++i)
+				total += frames[i];
+
+			printf("{\"benchmark\":\"instances\",\"mode\":\"%s\",\"param\":%u,\"iterations\":%u,\"mean_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f,"
+				"\"events\":%u,\"fewest_events\":%u,\"frame_events\":%u,\"misrouted\":%u,\"event_stalls\":%u}\n",
+				pMode, count, kInstanceFrames, total / frames.size() / 1.0e3, frames[frames.size() / 2] / 1.0e3,
+				frames[frames.size() * 99 / 100] / 1.0e3, frames.back() / 1.0e3,
+				events, fewest, frameEvents, misrouted, stalls);
+			fflush(stdout);
+		}
+
+		manager.Shutdown();
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			if (children[i] > 0)
+			{
+				close(releaseFds[i]);
+				waitpid(children[i], NULL, 0);
+			}
+			delete instances[i];
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	char const *pFilter = argc > 1 ? argv[1] : NULL;
+
+	// one descriptor per connection here, and as many in the child
+	struct rlimit limit;
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	EventFactory::Register<BenchMoveEvent>();
+	EventWire::Register<BenchMoveEvent>(1);
+
+	unsigned int const idleCounts[] = { 100, 1000, 2500, 5000, 10000 };
+
+	for (unsigned int i = 0; i < sizeof(idleCounts) / sizeof(idleCounts[0]); ++i)
+	{
+		unsigned int const idle = idleCounts[i];
+
+		// stdin, stdout, stderr, the listener, the pipe, and the hot
+		// connections at both ends
+		unsigned int const selectDescriptors = idle + 6 + kHotSockets * 2;
+
+		if ((!pFilter || strstr("select", pFilter)) && selectDescriptors < FD_SETSIZE)
+			BenchPoller(GCC_NEW SelectSocketPoller, idle);
+
+		if (!pFilter || strstr("epoll", pFilter))
+			BenchPoller(GCC_NEW EpollSocketPoller, idle);
+
+		if (idle + 64 > limit.rlim_cur)
+			break;
+	}
+
+	unsigned int const bursts[] = { 1, 4, 16, 64, 256 };
+
+	for (unsigned int i = 0; i < sizeof(bursts) / sizeof(bursts[0]); ++i)
+	{
+		if (!pFilter || strstr("send_burst", pFilter))
+			BenchSendBurst(bursts[i]);
+	}
+
+	unsigned int const packetSizes[] = { 32, 128, MAX_PACKET_SIZE };
+
+	for (unsigned int i = 0; i < sizeof(packetSizes) / sizeof(packetSizes[0]); ++i)
+	{
+		if (!pFilter || strstr("recv_throughput", pFilter))
+			BenchThroughput(packetSizes[i]);
+	}
+
+	for (int text = 0; text < 2; ++text)
+	{
+		if (!pFilter || strstr("forward", pFilter))
+		{
+			BenchForward(text != 0, false);
+			BenchForward(text != 0, false, true);
+			BenchForward(text != 0, true);
+		}
+
+		if (!pFilter || strstr("decode", pFilter))
+			BenchDecode(text != 0);
+	}
+
+	float const losses[] = { 0.0f, 5.0f, 20.0f };
+
+	for (unsigned int i = 0; i < sizeof(losses) / sizeof(losses[0]); ++i)
+	{
+		if (!pFilter || strstr("udp", pFilter))
+			BenchUdp(losses[i]);
+	}
+
+	unsigned int const movingCounts[] = { 8, 32, 64 };
+
+	for (unsigned int i = 0; i < sizeof(movingCounts) / sizeof(movingCounts[0]); ++i)
+	{
+		if (!pFilter || strstr("snapshot", pFilter))
+			BenchSnapshot(movingCounts[i]);
+	}
+
+	unsigned int const radii[] = { 50, 100, 200 };
+
+	for (unsigned int i = 0; i < sizeof(radii) / sizeof(radii[0]); ++i)
+	{
+		if (!pFilter || strstr("interest", pFilter))
+		{
+			BenchInterest(radii[i], 0);
+			BenchInterest(radii[i], 10);
+		}
+	}
+
+	if (!pFilter || strstr("thread", pFilter))
+	{
+		BenchThread(false);
+		BenchThread(true);
+	}
+
+	if (!pFilter || strstr("stats", pFilter))
+		BenchStats();
+
+	char const * const compressModes[] = { "none", "message", "stream", "dictionary" };
+
+	for (unsigned int i = 0; i < sizeof(compressModes) / sizeof(compressModes[0]); ++i)
+	{
+		if (!pFilter || strstr("compress", pFilter))
+			BenchCompress(compressModes[i]);
+	}
+
+	unsigned int const interpRates[] = { 60, 20, 10 };
+
+	for (unsigned int i = 0; i < sizeof(interpRates) / sizeof(interpRates[0]); ++i)
+	{
+		if (!pFilter || strstr("interpolate", pFilter))
+		{
+			BenchInterpolate(interpRates[i], false);
+			BenchInterpolate(interpRates[i], true);
+		}
+	}
+
+	for (unsigned int count = 1; count <= 8; count *= 2)
+	{
+		if (!pFilter || strstr("instances", pFilter))
+		{
+			BenchInstances(count, false);
+			BenchInstances(count, true);
+		}
+	}
+
+	return 0;
+}
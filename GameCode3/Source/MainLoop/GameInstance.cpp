@@ -0,0 +1,264 @@
+//========================================================================
+// GameInstance.cpp : Running several games in one process
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete - 3rd Edition
+//
+//  class GameInstance			- not in the book
+//  class GameInstancePool		- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include "..\GameCode.h"
+#include "..\EventManager\EventManagerImpl.h"
+#include "..\Multicore\ThreadPool.h"
+#include "..\Network\Network.h"
+#include "..\Scripting\LuaStateManager.h"
+#include "GameInstance.h"
+
+
+// GameInstance::GetCurrent()'s, for each thread
+#ifdef WIN32
+static __declspec(thread) GameInstance * t_pCurrentInstance = NULL;
+#else
+static __thread GameInstance * t_pCurrentInstance = NULL;
+#endif
+
+
+//========================================================================
+//
+// GameInstance implementation
+//
+//========================================================================
+
+//
+// GameInstance::GameInstance				- not in the book
+//
+GameInstance::GameInstance(int id)
+{
+	m_Id = id;
+	m_pEventManager = NULL;
+	m_pLuaStateManager = NULL;
+	m_pGame = NULL;
+}
+
+//
+// GameInstance::~GameInstance				- not in the book
+//
+//   In the reverse of the order they were made, as GameCodeApp::OnClose()
+//   does - the game's listeners go before the event manager, and so do
+//   any events the socket manager still has set aside for it.
+//
+GameInstance::~GameInstance()
+{
+	Scope current(this);
+
+	SAFE_DELETE(m_pGame);
+	if (g_pSocketManager)
+		g_pSocketManager->DropHandedOver(m_pEventManager);
+	SAFE_DELETE(m_pEventManager);
+	SAFE_DELETE(m_pLuaStateManager);
+}
+
+//
+// GameInstance::GetCurrent					- not in the book
+//
+GameInstance *GameInstance::GetCurrent()
+{
+	return t_pCurrentInstance;
+}
+
+//
+// GameInstance::Init						- not in the book
+//
+//   The same steps as GameCodeApp::InitInstance(), less the window. The
+//   event types were all registered with g_pApp's event manager, and
+//   the factories and wire ids are global, so this one just takes a
+//   copy of them; Lua registers its own when init.lua runs.
+//
+bool GameInstance::Init()
+{
+	m_pLuaStateManager = GCC_NEW LuaStateManager();
+	m_pEventManager = GCC_NEW EventManager("GameInstance Event Mgr", false);
+	m_pEventManager->CopyCodeEventTypes(*g_pApp->m_pEventManager);
+
+	Scope current(this);
+
+	m_pEventManager->RegisterScriptInterface();
+	if (!m_pLuaStateManager->Init("data\\Scripts\\init.lua"))
+		return false;
+
+	m_pGame = g_pApp->VCreateGameInstance();
+	if (!m_pGame)
+		return false;
+
+	// no menu to start it from - it's waiting for its players as soon
+	// as it's made
+	m_pGame->VChangeState(BGS_WaitingForPlayers);
+	return true;
+}
+
+//
+// GameInstance::Update						- not in the book
+//
+//   What GameCodeApp::OnUpdateGame() does for g_pApp's game, less the
+//   sockets - those are the main thread's. What they've read for it
+//   is made into events here, in its scope, so any Lua they need is
+//   its own.
+//
+void GameInstance::Update(double fTime, float fElapsedTime)
+{
+	Scope current(this);
+
+	g_pSocketManager->HandOverTo(m_pEventManager);
+	m_pEventManager->VTick(20);
+	m_pGame->VOnUpdate(static_cast<float>(fTime), fElapsedTime);
+}
+
+
+//
+// GameInstance::Scope::Scope				- not in the book
+//
+GameInstance::Scope::Scope(GameInstance *pInstance)
+{
+	m_pWas = t_pCurrentInstance;
+	m_pWasEventManager = IEventManager::SetThreadCurrent(pInstance ? pInstance->m_pEventManager : NULL);
+	t_pCurrentInstance = pInstance;
+}
+
+//
+// GameInstance::Scope::~Scope				- not in the book
+//
+GameInstance::Scope::~Scope()
+{
+	t_pCurrentInstance = m_pWas;
+	IEventManager::SetThreadCurrent(m_pWasEventManager);
+}
+
+
+//========================================================================
+//
+// GameInstancePool implementation
+//
+//========================================================================
+
+namespace
+{
+	// one instance's frame
+	class GameInstanceJob : public IThreadPoolJob
+	{
+	public:
+		GameInstanceJob(GameInstance *pInstance, double fTime, float fElapsedTime)
+			: m_pInstance(pInstance), m_fTime(fTime), m_fElapsedTime(fElapsedTime) { }
+
+		virtual void VRun() { m_pInstance->Update(m_fTime, m_fElapsedTime); }
+
+	private:
+		GameInstance *m_pInstance;
+		double m_fTime;
+		float m_fElapsedTime;
+	};
+}
+
+//
+// GameInstancePool::GameInstancePool		- not in the book
+//
+GameInstancePool::GameInstancePool(int numThreads)
+{
+	m_pThreads = GCC_NEW ThreadPool(numThreads);
+}
+
+//
+// GameInstancePool::~GameInstancePool		- not in the book
+//
+//   The socket manager's thread has to have been stopped first. It
+//   only sets the instances' events aside now, but their sockets still
+//   point at them - a GameServerListenSocket asks its instance for its
+//   event manager when a player connects, and each RemoteEventSocket
+//   files what it reads under that event manager. Left running, it
+//   could do either with an instance that's been deleted.
+//
+GameInstancePool::~GameInstancePool()
+{
+	m_pThreads->WaitForAll();
+	SAFE_DELETE(m_pThreads);
+
+	for (std::vector<GameInstance *>::iterator i = m_Instances.begin(); i != m_Instances.end(); ++i)
+		delete *i;
+	m_Instances.clear();
+}
+
+//
+// GameInstancePool::Create					- not in the book
+//
+//   Ids start at 1; g_pApp's game is the 0th. No socket's listening for
+//   any of them until they've all been made, so a pool that fails can
+//   be thrown away.
+//
+bool GameInstancePool::Create(int count, int firstPort)
+{
+	assert(g_pSocketManager && !g_pSocketManager->IsThreaded() && "GameInstancePool::Create() needs the socket manager, and before its thread starts");
+
+	for (int i = 0; i < count; ++i)
+	{
+		GameInstance *pInstance = GCC_NEW GameInstance(GetCount() + 1);
+		m_Instances.push_back(pInstance);
+		if (!pInstance->Init())
+			return false;
+	}
+
+	for (int i = 0; i < count; ++i)
+		g_pSocketManager->AddSocket(GCC_NEW GameServerListenSocket(firstPort + i, m_Instances[i]));
+	return true;
+}
+
+//
+// GameInstancePool::BeginUpdate				- not in the book
+//
+void GameInstancePool::BeginUpdate(double fTime, float fElapsedTime)
+{
+	for (std::vector<GameInstance *>::iterator i = m_Instances.begin(); i != m_Instances.end(); ++i)
+		m_pThreads->Submit(ThreadPoolJobPtr(GCC_NEW GameInstanceJob(*i, fTime, fElapsedTime)));
+}
+
+//
+// GameInstancePool::EndUpdate				- not in the book
+//
+void GameInstancePool::EndUpdate()
+{
+	m_pThreads->WaitForAll();
+}
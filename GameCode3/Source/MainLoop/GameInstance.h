@@ -0,0 +1,164 @@
+#pragma once
+//========================================================================
+// GameInstance.h : Running several games in one process
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete - 3rd Edition
+//
+//  class GameInstance			- not in the book
+//  class GameInstancePool		- not in the book
+//========================================================================
+
+#include <vector>
+
+class BaseGameLogic;
+class EventManager;
+class IEventManager;
+class LuaStateManager;
+class ThreadPool;
+
+
+//////////////////////////////////////////////////////////////////////
+// GameInstance Description
+//
+// One of several games a server process runs side by side, each with
+// its own event manager, Lua state and game logic - and so its own
+// process manager, physics world and actors. What they share is what
+// doesn't change once it's loaded - g_pApp's options and ResCache, and
+// the event types - and the one socket manager.
+//
+// Code that used to ask g_pApp for "the" game or Lua state now asks
+// for the current one - GameCodeApp::GetCurrentGame() - which is the
+// GameInstance's when there's one running on the calling thread. The
+// safe* event functions go to its event manager the same way.
+//
+// g_pApp's own game isn't one of these; it's the one with the views,
+// and it goes on running on the main thread as it always has.
+//
+//////////////////////////////////////////////////////////////////////
+
+class GameInstance : public boost::noncopyable
+{
+public:
+	explicit GameInstance(int id);
+	~GameInstance();
+
+	// Makes its event manager and Lua state, runs init.lua, and has
+	// g_pApp make the game and start it waiting for players. On the
+	// main thread, before the socket manager's thread starts.
+	bool Init();
+
+	// A frame - its events, then the game's update. On any thread, but
+	// never on two at once.
+	void Update(double fTime, float fElapsedTime);
+
+	int GetId() const { return m_Id; }
+	EventManager *GetEventManager() { return m_pEventManager; }
+	LuaStateManager *GetLuaStateManager() { return m_pLuaStateManager; }
+	BaseGameLogic *GetGame() { return m_pGame; }
+
+	// The one being run on the calling thread - NULL on the main one.
+	static GameInstance *GetCurrent();
+
+	// Makes an instance the calling thread's current one, with its
+	// event manager, until it goes out of scope.
+	class Scope : public boost::noncopyable
+	{
+	public:
+		explicit Scope(GameInstance *pInstance);
+		~Scope();
+
+	private:
+		GameInstance *m_pWas;
+		IEventManager *m_pWasEventManager;
+	};
+
+private:
+	int m_Id;
+	EventManager *m_pEventManager;
+	LuaStateManager *m_pLuaStateManager;
+	BaseGameLogic *m_pGame;
+};
+
+
+//////////////////////////////////////////////////////////////////////
+// GameInstancePool Description
+//
+// The GameInstances a server runs beside g_pApp's own game, and the
+// threads that run them. Each listens on a port of its own, so a
+// client picks its game by the port it connects to.
+//
+// Each frame the main thread hands every instance's Update() to the
+// pool and, while they run, does its own game's; then it waits for
+// them, so a frame's packets all go out together in FlushOutput().
+// The socket manager has to have a thread of its own - its DoSelect()
+// only hands over what's been read.
+//
+//		// once the server socket manager's made
+//		pPool->Create(count, firstPort);
+//		pServer->StartThread();
+//
+//		// each frame, on the main thread
+//		pServer->DoSelect(0);
+//		pPool->BeginUpdate(fTime, fElapsedTime);
+//		g_pApp->m_pGame->VOnUpdate(fTime, fElapsedTime);
+//		pPool->EndUpdate();
+//		pServer->FlushOutput();
+//
+//////////////////////////////////////////////////////////////////////
+
+class GameInstancePool : public boost::noncopyable
+{
+public:
+	// numThreads == 0 is one per core, less the main thread's
+	explicit GameInstancePool(int numThreads = 0);
+	~GameInstancePool();
+
+	// Makes 'count' instances, the first listening on firstPort and
+	// each after it on the next. Before the socket manager's thread
+	// starts - false if any of them couldn't be made.
+	bool Create(int count, int firstPort);
+
+	void BeginUpdate(double fTime, float fElapsedTime);
+	void EndUpdate();
+
+	int GetCount() const { return static_cast<int>(m_Instances.size()); }
+	GameInstance *GetInstance(int i) { return m_Instances[i]; }
+
+private:
+	ThreadPool *m_pThreads;
+	std::vector<GameInstance *> m_Instances;
+};
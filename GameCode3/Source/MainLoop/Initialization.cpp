@@ -187,6 +187,28 @@ GameOptions::GameOptions(const char* path)
 
 	m_maxPlayers = ::GetPrivateProfileIntA( 
 		"MULTIPLAYER", "Max_Players", 4, path );	
+
+	m_snapshotRate = ::GetPrivateProfileIntA( 
+		"MULTIPLAYER", "Snapshot_Rate", 0, path );
+
+	m_interestRadius = ::GetPrivateProfileIntA( 
+		"MULTIPLAYER", "Interest_Radius", 0, path );
+
+	m_interestHysteresis = ::GetPrivateProfileIntA( 
+		"MULTIPLAYER", "Interest_Hysteresis", 10, path );
+
+	m_networkThread = ::GetPrivateProfileIntA( 
+		"MULTIPLAYER", "Network_Thread", 0, path ) != 0;
+
+	m_interpolationDelay = ::GetPrivateProfileIntA( 
+		"MULTIPLAYER", "Interpolation_Delay", 100, path );
+
+	m_gameInstances = ::GetPrivateProfileIntA( 
+		"MULTIPLAYER", "Game_Instances", 1, path );
+
+	::GetPrivateProfileStringA( 
+		"DEBUG", "Event_Journal", "", buffer, 256, path );
+	m_eventJournal = buffer;
 }
 
 
@@ -67,6 +67,13 @@ struct GameOptions
 	int m_numAIs;
 	int m_maxAIs;
 	int m_maxPlayers;
+	int m_snapshotRate;					// actor movement snapshots a second to remote players - 0 sends Move_Actor events
+	int m_interestRadius;				// how far remote players can see actors move - 0 sees everything
+	int m_interestHysteresis;			// how much further an actor goes before it's out of sight again
+	bool m_networkThread;				// run the sockets on a thread of their own
+	int m_interpolationDelay;			// ms a remote player sees actors in the past - 0 moves them as updates come in
+	int m_gameInstances;				// games a server runs at once, on Listen_Port and the ports after it
+	std::string m_eventJournal;			// record events here, if set
 
 	GameOptions(const char* path);
 };
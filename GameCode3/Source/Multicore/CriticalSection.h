@@ -36,10 +36,16 @@
 //
 //========================================================================
  
+#ifdef WIN32
 #include <windows.h>
+#else
+#include <boost/thread/recursive_mutex.hpp>
+#endif
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
  
+#ifdef WIN32
+
 class CriticalSection : public boost::noncopyable
 {
 public:
@@ -68,6 +74,30 @@ protected:
        // the critical section itself
     mutable CRITICAL_SECTION m_cs;
 };
+
+#else
+
+// Off Windows a recursive mutex does the same job - like a
+// CRITICAL_SECTION, the thread holding it can lock it again.
+
+class CriticalSection : public boost::noncopyable
+{
+public:
+	void Lock()
+	{
+		m_cs.lock();
+	}
+
+	void Unlock()
+	{
+		m_cs.unlock();
+	}
+
+protected:
+	mutable boost::recursive_mutex m_cs;
+};
+
+#endif
  
  
 /*
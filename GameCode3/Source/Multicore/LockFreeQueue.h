@@ -0,0 +1,143 @@
+#pragma once
+//========================================================================
+// LockFreeQueue.h : A queue from one thread to another, without locks
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class LockFreeQueue				- not in the book
+//========================================================================
+
+#include <vector>
+
+
+////////////////////////////////////////////////////
+//
+// LockFreeQueue Description
+//
+//   A fixed-size ring for handing things from one thread to one
+//   other - exactly one thread pushes and exactly one pops. Neither
+//   ever waits on a lock: the pusher only writes m_WritePos and the
+//   popper only writes m_ReadPos, each published with an interlocked
+//   exchange after the item it covers is in place, the same way the
+//   EventJournal's ring works.
+//
+//   It doesn't grow. TryPush() is false when it's full, and it's up
+//   to the pusher what to do about it - wait, or keep the item back
+//   and try again later.
+//
+//		LockFreeQueue<IEventDataPtr> queue(4096);
+//
+//		// the one thread
+//		queue.TryPush(event);
+//
+//		// the other
+//		IEventDataPtr event;
+//		while (queue.TryPop(event))
+//			...
+//
+////////////////////////////////////////////////////
+
+template <class T>
+class LockFreeQueue : public boost::noncopyable
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit LockFreeQueue(unsigned int capacity)
+	{
+		unsigned int size = 1;
+		while (size < capacity)
+			size <<= 1;
+
+		m_Items.resize(size);
+		m_Mask = size - 1;
+		m_WritePos = 0;
+		m_ReadPos = 0;
+	}
+
+	// the pushing thread only
+	bool TryPush(T const &item)
+	{
+		unsigned int const writePos = static_cast<unsigned int>(m_WritePos);
+		unsigned int const readPos = static_cast<unsigned int>(InterlockedCompareExchange(&m_ReadPos, 0, 0));
+		if (writePos - readPos > m_Mask)
+			return false;
+
+		m_Items[writePos & m_Mask] = item;
+
+		// publish it only once it's there
+		InterlockedExchange(&m_WritePos, static_cast<LONG>(writePos + 1));
+		return true;
+	}
+
+	// the popping thread only
+	bool TryPop(T &item)
+	{
+		unsigned int const readPos = static_cast<unsigned int>(m_ReadPos);
+		unsigned int const writePos = static_cast<unsigned int>(InterlockedCompareExchange(&m_WritePos, 0, 0));
+		if (readPos == writePos)
+			return false;
+
+		// let go of it here, not when the slot's next written - a
+		// shared_ptr is freed on this thread, not the other
+		T &slot = m_Items[readPos & m_Mask];
+		item = slot;
+		slot = T();
+
+		InterlockedExchange(&m_ReadPos, static_cast<LONG>(readPos + 1));
+		return true;
+	}
+
+	// Only a guess from any thread but the popper's.
+	bool IsEmpty() const
+	{
+		return m_ReadPos == m_WritePos;
+	}
+
+	unsigned int GetCapacity() const { return m_Mask + 1; }
+
+private:
+	std::vector<T> m_Items;
+	unsigned int m_Mask;
+
+	// each on a cache line of its own, so the two threads don't fight
+	// over one
+	char m_Pad0[64];
+	volatile LONG m_WritePos;		// items ever pushed - the pusher only
+	char m_Pad1[64];
+	volatile LONG m_ReadPos;		// items ever popped - the popper only
+	char m_Pad2[64];
+};
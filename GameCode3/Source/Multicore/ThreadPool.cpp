@@ -0,0 +1,271 @@
+//========================================================================
+// ThreadPool.cpp : A simple pool of worker threads
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete - 3rd Edition
+//
+//  class ThreadPool			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "ThreadPool.h"
+
+
+#ifdef WIN32
+
+//
+// ThreadPool::ThreadPool
+//
+ThreadPool::ThreadPool( int numThreads )
+	: m_PendingJobs(0)
+{
+	if (numThreads <= 0)
+	{
+		SYSTEM_INFO sysInfo;
+		GetSystemInfo(&sysInfo);
+		numThreads = static_cast<int>(sysInfo.dwNumberOfProcessors) - 1;
+		if (numThreads < 1)
+			numThreads = 1;
+	}
+
+	m_hJobsDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	for (int i=0; i<numThreads; ++i)
+	{
+		HANDLE hThread = CreateThread(
+					 NULL,         // default security attributes
+					 0,            // default stack size
+					 (LPTHREAD_START_ROUTINE) ThreadProc,
+					 this,         // thread parameter is a pointer to the pool
+					 0,            // default creation flags
+					 NULL);        // receive thread identifier
+
+		if (hThread == NULL)
+		{
+			assert(0 && "Could not create thread pool worker!");
+			break;
+		}
+
+		m_Threads.push_back(hThread);
+	}
+}
+
+
+//
+// ThreadPool::~ThreadPool
+//
+ThreadPool::~ThreadPool()
+{
+	WaitForAll();
+
+	// an empty job tells a worker to quit
+	for (size_t i=0; i<m_Threads.size(); ++i)
+	{
+		m_Jobs.push(ThreadPoolJobPtr());
+	}
+
+	for (size_t i=0; i<m_Threads.size(); ++i)
+	{
+		WaitForSingleObject(m_Threads[i], INFINITE);
+		CloseHandle(m_Threads[i]);
+	}
+	m_Threads.clear();
+
+	CloseHandle(m_hJobsDone);
+}
+
+
+//
+// ThreadPool::Submit
+//
+void ThreadPool::Submit( ThreadPoolJobPtr const & job )
+{
+	assert(job && "Can't submit an empty job - that's the quit signal!");
+
+	if (m_Threads.empty())
+	{
+		// no workers could be created - run it here rather than lose it
+		job->VRun();
+		return;
+	}
+
+	InterlockedIncrement(&m_PendingJobs);
+	m_Jobs.push(job);
+}
+
+
+//
+// ThreadPool::WaitForAll
+//
+void ThreadPool::WaitForAll()
+{
+	// The event can be left signaled by a previous batch, so it's
+	// only a hint - the counter is the truth.
+	while (InterlockedCompareExchange(&m_PendingJobs, 0, 0) != 0)
+	{
+		WaitForSingleObject(m_hJobsDone, INFINITE);
+	}
+}
+
+
+//
+// ThreadPool::ThreadProc
+//
+DWORD WINAPI ThreadPool::ThreadProc( LPVOID lpParam )
+{
+	ThreadPool *pool = static_cast<ThreadPool *>(lpParam);
+
+	while (true)
+	{
+		ThreadPoolJobPtr job;
+		pool->m_Jobs.wait_and_pop(job);
+		if (!job)
+			break;
+
+		job->VRun();
+
+		// release the job (and anything it holds) before reporting in
+		job.reset();
+
+		if (InterlockedDecrement(&pool->m_PendingJobs) == 0)
+		{
+			SetEvent(pool->m_hJobsDone);
+		}
+	}
+
+	return TRUE;
+}
+
+#else
+
+// The same pool on boost::thread, for builds outside Windows.
+
+//
+// ThreadPool::ThreadPool
+//
+ThreadPool::ThreadPool( int numThreads )
+	: m_PendingJobs(0)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = static_cast<int>(boost::thread::hardware_concurrency()) - 1;
+		if (numThreads < 1)
+			numThreads = 1;
+	}
+
+	for (int i=0; i<numThreads; ++i)
+	{
+		m_Threads.push_back(GCC_NEW boost::thread(&ThreadPool::ThreadProc, this));
+	}
+}
+
+
+//
+// ThreadPool::~ThreadPool
+//
+ThreadPool::~ThreadPool()
+{
+	WaitForAll();
+
+	// an empty job tells a worker to quit
+	for (size_t i=0; i<m_Threads.size(); ++i)
+	{
+		m_Jobs.push(ThreadPoolJobPtr());
+	}
+
+	for (size_t i=0; i<m_Threads.size(); ++i)
+	{
+		m_Threads[i]->join();
+		SAFE_DELETE(m_Threads[i]);
+	}
+	m_Threads.clear();
+}
+
+
+//
+// ThreadPool::Submit
+//
+void ThreadPool::Submit( ThreadPoolJobPtr const & job )
+{
+	assert(job && "Can't submit an empty job - that's the quit signal!");
+
+	{
+		boost::mutex::scoped_lock lock(m_PendingMutex);
+		++m_PendingJobs;
+	}
+	m_Jobs.push(job);
+}
+
+
+//
+// ThreadPool::WaitForAll
+//
+void ThreadPool::WaitForAll()
+{
+	boost::mutex::scoped_lock lock(m_PendingMutex);
+	while (m_PendingJobs != 0)
+	{
+		m_JobsDone.wait(lock);
+	}
+}
+
+
+//
+// ThreadPool::ThreadProc
+//
+void ThreadPool::ThreadProc( ThreadPool * pool )
+{
+	while (true)
+	{
+		ThreadPoolJobPtr job;
+		pool->m_Jobs.wait_and_pop(job);
+		if (!job)
+			break;
+
+		job->VRun();
+
+		// release the job (and anything it holds) before reporting in
+		job.reset();
+
+		boost::mutex::scoped_lock lock(pool->m_PendingMutex);
+		if (--pool->m_PendingJobs == 0)
+		{
+			pool->m_JobsDone.notify_all();
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+//========================================================================
+// ThreadPool.h : A simple pool of worker threads
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete - 3rd Edition
+//
+//  class ThreadPool			- not in the book
+//========================================================================
+
+#include <vector>
+#include "CriticalSection.h"
+
+#ifndef WIN32
+#include <boost/thread/thread.hpp>
+#endif
+
+//////////////////////////////////////////////////////////////////////
+// IThreadPoolJob Description
+//
+// A unit of work handed to a ThreadPool. VRun() is called exactly
+// once, on one of the pool's worker threads.
+//
+//////////////////////////////////////////////////////////////////////
+
+class IThreadPoolJob
+{
+public:
+	virtual ~IThreadPoolJob() { }
+	virtual void VRun() = 0;
+};
+
+typedef shared_ptr<IThreadPoolJob> ThreadPoolJobPtr;
+
+
+//////////////////////////////////////////////////////////////////////
+// ThreadPool Description
+//
+// A fixed set of worker threads pulling jobs from a concurrent_queue.
+// Jobs may run in any order and on any worker, so anything that needs
+// ordering must be done inside a single job.
+//
+// Submit() and WaitForAll() are meant to be called from one thread -
+// normally the main loop.
+//
+//////////////////////////////////////////////////////////////////////
+
+class ThreadPool : public boost::noncopyable
+{
+public:
+	// numThreads == 0 creates one worker per core, leaving one core
+	// for the main thread.
+	explicit ThreadPool( int numThreads = 0 );
+	~ThreadPool();
+
+	void Submit( ThreadPoolJobPtr const & job );
+
+	// Blocks until every job submitted so far has finished.
+	void WaitForAll();
+
+	bool IsIdle() const { return m_PendingJobs == 0; }
+	int GetNumThreads() const { return static_cast<int>(m_Threads.size()); }
+
+private:
+#ifdef WIN32
+	static DWORD WINAPI ThreadProc( LPVOID lpParam );
+
+	std::vector<HANDLE> m_Threads;
+	concurrent_queue<ThreadPoolJobPtr> m_Jobs;
+
+	volatile LONG m_PendingJobs;	// submitted but not yet finished
+	HANDLE m_hJobsDone;				// auto-reset, set when m_PendingJobs hits zero
+#else
+	static void ThreadProc( ThreadPool * pool );
+
+	std::vector<boost::thread *> m_Threads;
+	concurrent_queue<ThreadPoolJobPtr> m_Jobs;
+
+	volatile long m_PendingJobs;	// submitted but not yet finished,
+	boost::mutex m_PendingMutex;	// guarded by m_PendingMutex
+	boost::condition_variable m_JobsDone;	// signalled when m_PendingJobs hits zero
+#endif
+};
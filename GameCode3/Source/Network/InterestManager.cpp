@@ -0,0 +1,300 @@
+//========================================================================
+// InterestManager.cpp : Which actors each remote player can see
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class InterestManager			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include <algorithm>
+#include <math.h>
+
+#include "InterestManager.h"
+
+
+namespace
+{
+	int CellOf( float pos, float cellSize )
+	{
+		return static_cast< int >( floorf( pos / cellSize ) );
+	}
+
+	// orders the grid by cell alone, so a run of cells can be found
+	struct CellLess
+	{
+		bool operator()( int const a[3], int const b[3] ) const
+		{
+			if ( a[0] != b[0] )
+				return a[0] < b[0];
+			if ( a[1] != b[1] )
+				return a[1] < b[1];
+			return a[2] < b[2];
+		}
+
+		template < class A, class B >
+		bool operator()( A const & a, B const & b ) const { return ( *this )( a.m_Cell, b.m_Cell ); }
+	};
+}
+
+
+//
+// InterestManager::InterestManager
+//
+InterestManager::InterestManager( float enterRadius, float leaveRadius )
+{
+	SetRadii( enterRadius, leaveRadius );
+}
+
+//
+// InterestManager::SetRadii
+//
+//   Takes effect at the next EndUpdate().
+//
+void InterestManager::SetRadii( float enterRadius, float leaveRadius )
+{
+	m_EnterRadius = enterRadius > 0.0f ? enterRadius : 1.0f;
+	m_LeaveRadius = std::max( leaveRadius, m_EnterRadius );
+}
+
+//
+// InterestManager::AddClient
+//
+void InterestManager::AddClient( int sockId )
+{
+	Client client;
+	client.m_SockId = sockId;
+
+	std::vector< Client >::iterator it = std::lower_bound( m_Clients.begin(), m_Clients.end(), client );
+	if ( it != m_Clients.end() && it->m_SockId == sockId )
+		return;
+
+	client.m_bHasViewer = false;
+	client.m_ViewerId = 0;
+	client.m_bSeesAll = true;
+	m_Clients.insert( it, client );
+}
+
+//
+// InterestManager::RemoveClient
+//
+void InterestManager::RemoveClient( int sockId )
+{
+	Client client;
+	client.m_SockId = sockId;
+
+	std::vector< Client >::iterator it = std::lower_bound( m_Clients.begin(), m_Clients.end(), client );
+	if ( it != m_Clients.end() && it->m_SockId == sockId )
+		m_Clients.erase( it );
+}
+
+//
+// InterestManager::SetViewer
+//
+void InterestManager::SetViewer( int sockId, unsigned int actorId )
+{
+	AddClient( sockId );
+
+	Client * pClient = FindClient( sockId );
+	pClient->m_bHasViewer = true;
+	pClient->m_ViewerId = actorId;
+	UpdateClient( *pClient );
+}
+
+//
+// InterestManager::BeginUpdate
+//
+void InterestManager::BeginUpdate( void )
+{
+	m_Actors.clear();
+}
+
+//
+// InterestManager::AddActor
+//
+void InterestManager::AddActor( unsigned int actorId, float const pos[3] )
+{
+	Actor actor;
+	actor.m_ActorId = actorId;
+	for ( int i = 0; i < 3; ++i )
+	{
+		actor.m_Pos[i] = pos[i];
+		actor.m_Cell[i] = CellOf( pos[i], m_LeaveRadius );
+	}
+	m_Actors.push_back( actor );
+}
+
+//
+// InterestManager::EndUpdate
+//
+void InterestManager::EndUpdate( void )
+{
+	std::sort( m_Actors.begin(), m_Actors.end() );
+
+	m_Cells.resize( m_Actors.size() );
+	for ( unsigned int i = 0; i < m_Cells.size(); ++i )
+	{
+		for ( int p = 0; p < 3; ++p )
+			m_Cells[i].m_Cell[p] = m_Actors[i].m_Cell[p];
+		m_Cells[i].m_Index = i;
+	}
+	std::sort( m_Cells.begin(), m_Cells.end(), CellLess() );
+
+	for ( unsigned int i = 0; i < m_Clients.size(); ++i )
+		UpdateClient( m_Clients[i] );
+}
+
+//
+// InterestManager::UpdateClient
+//
+void InterestManager::UpdateClient( Client & client )
+{
+	Actor const * pViewer = client.m_bHasViewer ? FindActor( client.m_ViewerId ) : NULL;
+	client.m_bSeesAll = ( pViewer == NULL );
+	if ( client.m_bSeesAll )
+	{
+		client.m_Relevant.clear();
+		return;
+	}
+
+	// the last view, for the hysteresis
+	m_Scratch.swap( client.m_Relevant );
+	client.m_Relevant.clear();
+
+	float const enter2 = m_EnterRadius * m_EnterRadius;
+	float const leave2 = m_LeaveRadius * m_LeaveRadius;
+
+	// the cells are as big as the leave radius, so anything within it
+	// is in this cell or one next to it - each run of z is together
+	Cell first, last;
+	for ( int x = pViewer->m_Cell[0] - 1; x <= pViewer->m_Cell[0] + 1; ++x )
+	{
+		for ( int y = pViewer->m_Cell[1] - 1; y <= pViewer->m_Cell[1] + 1; ++y )
+		{
+			first.m_Cell[0] = last.m_Cell[0] = x;
+			first.m_Cell[1] = last.m_Cell[1] = y;
+			first.m_Cell[2] = pViewer->m_Cell[2] - 1;
+			last.m_Cell[2] = pViewer->m_Cell[2] + 1;
+
+			std::vector< Cell >::iterator it = std::lower_bound( m_Cells.begin(), m_Cells.end(), first, CellLess() );
+			std::vector< Cell >::iterator end = std::upper_bound( it, m_Cells.end(), last, CellLess() );
+			for ( ; it != end; ++it )
+			{
+				Actor const & actor = m_Actors[it->m_Index];
+				float const dx = actor.m_Pos[0] - pViewer->m_Pos[0];
+				float const dy = actor.m_Pos[1] - pViewer->m_Pos[1];
+				float const dz = actor.m_Pos[2] - pViewer->m_Pos[2];
+				float const dist2 = dx*dx + dy*dy + dz*dz;
+
+				if ( dist2 <= enter2 ||
+					( dist2 <= leave2 && std::binary_search( m_Scratch.begin(), m_Scratch.end(), actor.m_ActorId ) ) )
+				{
+					client.m_Relevant.push_back( actor.m_ActorId );
+				}
+			}
+		}
+	}
+
+	std::sort( client.m_Relevant.begin(), client.m_Relevant.end() );
+}
+
+//
+// InterestManager::IsRelevant
+//
+bool InterestManager::IsRelevant( int sockId, unsigned int actorId ) const
+{
+	Client const * pClient = FindClient( sockId );
+	if ( !pClient || pClient->m_bSeesAll )
+		return true;
+
+	if ( std::binary_search( pClient->m_Relevant.begin(), pClient->m_Relevant.end(), actorId ) )
+		return true;
+
+	// nothing's known about where it is
+	return FindActor( actorId ) == NULL;
+}
+
+//
+// InterestManager::GetRelevantCount
+//
+unsigned int InterestManager::GetRelevantCount( int sockId ) const
+{
+	Client const * pClient = FindClient( sockId );
+	if ( !pClient || pClient->m_bSeesAll )
+		return static_cast< unsigned int >( m_Actors.size() );
+
+	return static_cast< unsigned int >( pClient->m_Relevant.size() );
+}
+
+//
+// InterestManager::FindActor
+//
+InterestManager::Actor const * InterestManager::FindActor( unsigned int actorId ) const
+{
+	Actor actor;
+	actor.m_ActorId = actorId;
+
+	std::vector< Actor >::const_iterator it = std::lower_bound( m_Actors.begin(), m_Actors.end(), actor );
+	if ( it == m_Actors.end() || it->m_ActorId != actorId )
+		return NULL;
+
+	return &*it;
+}
+
+//
+// InterestManager::FindClient
+//
+InterestManager::Client const * InterestManager::FindClient( int sockId ) const
+{
+	return const_cast< InterestManager * >( this )->FindClient( sockId );
+}
+
+//
+// InterestManager::FindClient
+//
+InterestManager::Client * InterestManager::FindClient( int sockId )
+{
+	Client client;
+	client.m_SockId = sockId;
+
+	std::vector< Client >::iterator it = std::lower_bound( m_Clients.begin(), m_Clients.end(), client );
+	if ( it == m_Clients.end() || it->m_SockId != sockId )
+		return NULL;
+
+	return &*it;
+}
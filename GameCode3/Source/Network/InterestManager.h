@@ -0,0 +1,146 @@
+#pragma once
+//========================================================================
+// InterestManager.h : Which actors each remote player can see
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class InterestManager			- not in the book
+//========================================================================
+
+// Which actors each remote player is near enough to care about, so
+// the events about the rest needn't be sent to them. Like Snapshot.h,
+// nothing here knows about the game - it's handed ids and positions.
+
+#include <vector>
+
+
+////////////////////////////////////////////////////
+//
+// InterestManager Description
+//
+//   Each client sees the world from one actor - its player's. An
+//   actor comes into a client's view once it's within the enter
+//   radius of that actor, and only goes out of it again once it's
+//   further away than the leave radius. The gap between the two is
+//   the hysteresis: something wandering back and forth across one
+//   line would otherwise be sent, then not, then sent again.
+//
+//   Once a tick the game hands it where every actor is:
+//
+//		interest.BeginUpdate();
+//		for each actor:
+//			interest.AddActor(id, pos);
+//		interest.EndUpdate();
+//
+//   which sorts the actors into a grid of cells as big as the leave
+//   radius, so finding what's near a client looks in at most 27 cells
+//   rather than at every actor. Each client's view is then a sorted
+//   list of actor ids, and IsRelevant() is a binary search of it.
+//
+//   When in doubt, an actor is relevant: to a client that hasn't got
+//   an actor yet, and if the actor wasn't in the last update - it's
+//   only just been made, say.
+//
+////////////////////////////////////////////////////
+
+class InterestManager
+{
+public:
+	InterestManager( float enterRadius, float leaveRadius );
+
+	// leaveRadius is never less than enterRadius
+	void SetRadii( float enterRadius, float leaveRadius );
+	float GetEnterRadius( void ) const { return m_EnterRadius; }
+	float GetLeaveRadius( void ) const { return m_LeaveRadius; }
+
+	void AddClient( int sockId );
+	void RemoveClient( int sockId );
+	unsigned int GetClientCount( void ) const { return static_cast< unsigned int >( m_Clients.size() ); }
+
+	// The actor whose position is the client's view.
+	void SetViewer( int sockId, unsigned int actorId );
+
+	void BeginUpdate( void );
+	void AddActor( unsigned int actorId, float const pos[3] );
+	void EndUpdate( void );
+
+	bool IsRelevant( int sockId, unsigned int actorId ) const;
+
+	// How many actors are in the client's view - all of them if it
+	// sees everything.
+	unsigned int GetRelevantCount( int sockId ) const;
+
+protected:
+	struct Actor
+	{
+		unsigned int m_ActorId;
+		float m_Pos[3];
+		int m_Cell[3];
+
+		bool operator<( Actor const & other ) const { return m_ActorId < other.m_ActorId; }
+	};
+
+	struct Client
+	{
+		int m_SockId;
+		bool m_bHasViewer;
+		unsigned int m_ViewerId;
+		bool m_bSeesAll;						// no viewer, or it's not in the world
+		std::vector< unsigned int > m_Relevant;	// sorted
+
+		bool operator<( Client const & other ) const { return m_SockId < other.m_SockId; }
+	};
+
+	struct Cell
+	{
+		int m_Cell[3];
+		unsigned int m_Index;					// in m_Actors
+	};
+
+	void UpdateClient( Client & client );
+	Actor const * FindActor( unsigned int actorId ) const;
+	Client const * FindClient( int sockId ) const;
+	Client * FindClient( int sockId );
+
+	float m_EnterRadius;
+	float m_LeaveRadius;
+
+	std::vector< Actor > m_Actors;			// sorted by id after EndUpdate()
+	std::vector< Cell > m_Cells;			// the grid - sorted by cell
+	std::vector< Client > m_Clients;		// sorted by socket id
+	std::vector< unsigned int > m_Scratch;
+};
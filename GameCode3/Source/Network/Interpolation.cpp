@@ -0,0 +1,305 @@
+//========================================================================
+// Interpolation.cpp : Drawing remote actors a little in the past
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class InterpolationBuffer		- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include <math.h>
+
+#include "Interpolation.h"
+
+
+const float InterpolationBuffer::kSnapDistance = 20.0f;
+
+namespace
+{
+	//
+	// Blend - 'a' to 'b', 't' of the way; past 1 is further on the
+	// same way.
+	//
+	void Blend( ActorNetState const & a, ActorNetState const & b, float t, ActorNetState & out )
+	{
+		out.m_ActorId = b.m_ActorId;
+
+		for ( int i = 0; i < 3; ++i )
+			out.m_Pos[i] = a.m_Pos[i] + ( b.m_Pos[i] - a.m_Pos[i] ) * t;
+
+		// q and -q are the same rotation - go the short way round
+		float dot = 0.0f;
+		for ( int i = 0; i < 4; ++i )
+			dot += a.m_Rot[i] * b.m_Rot[i];
+		float const sign = dot < 0.0f ? -1.0f : 1.0f;
+
+		float length = 0.0f;
+		for ( int i = 0; i < 4; ++i )
+		{
+			out.m_Rot[i] = a.m_Rot[i] + ( b.m_Rot[i] * sign - a.m_Rot[i] ) * t;
+			length += out.m_Rot[i] * out.m_Rot[i];
+		}
+
+		if ( length > 0.0f )
+		{
+			float const scale = 1.0f / sqrtf( length );
+			for ( int i = 0; i < 4; ++i )
+				out.m_Rot[i] *= scale;
+		}
+		else
+		{
+			memcpy( out.m_Rot, b.m_Rot, sizeof( out.m_Rot ) );
+		}
+	}
+
+	float DistanceSq( ActorNetState const & a, ActorNetState const & b )
+	{
+		float sum = 0.0f;
+		for ( int i = 0; i < 3; ++i )
+			sum += ( b.m_Pos[i] - a.m_Pos[i] ) * ( b.m_Pos[i] - a.m_Pos[i] );
+		return sum;
+	}
+
+	// 'a' is at or after 'b', allowing for timeGetTime() wrapping
+	bool NotBefore( unsigned int a, unsigned int b )
+	{
+		return static_cast< int >( a - b ) >= 0;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// InterpolationBuffer::Track Implementation
+
+//
+// InterpolationBuffer::Track::Track
+//
+InterpolationBuffer::Track::Track()
+	: m_First( 0 ), m_Count( 0 ), m_bHasPrevious( false ),
+	  m_LastArrival( 0 ), m_SpacingMs( kDefaultSpacingMs ), m_bStill( false )
+{
+}
+
+//
+// InterpolationBuffer::Track::Push
+//
+void InterpolationBuffer::Track::Push( Entry const & entry )
+{
+	if ( m_Count == kMaxSamples )
+		Pop();
+	m_Entries[( m_First + m_Count ) % kMaxSamples] = entry;
+	++m_Count;
+}
+
+//
+// InterpolationBuffer::Track::Pop
+//
+void InterpolationBuffer::Track::Pop( void )
+{
+	m_Previous = m_Entries[m_First];
+	m_bHasPrevious = true;
+	m_First = ( m_First + 1 ) % kMaxSamples;
+	--m_Count;
+}
+
+
+//-------------------------------------------------------------------
+// InterpolationBuffer Implementation
+
+//
+// InterpolationBuffer::InterpolationBuffer
+//
+InterpolationBuffer::InterpolationBuffer()
+	: m_DelayMs( kDefaultDelayMs ), m_MaxExtrapolationMs( kDefaultMaxExtrapolationMs )
+{
+	memset( &m_Stats, 0, sizeof( m_Stats ) );
+}
+
+//
+// InterpolationBuffer::Add
+//
+void InterpolationBuffer::Add( ActorNetState const & state, unsigned int now )
+{
+	Track & track = m_Tracks[state.m_ActorId];
+
+	Entry entry;
+	entry.m_Time = now;
+	entry.m_State = state;
+	entry.m_bSnap = false;
+
+	if ( !track.m_Count )
+	{
+		track.m_LastArrival = now;
+		track.Push( entry );
+		track.m_bStill = false;
+		return;
+	}
+
+	Entry & last = track.Get( track.m_Count - 1 );
+	unsigned int const gap = now - track.m_LastArrival;
+	track.m_LastArrival = now;
+
+	if ( track.m_bStill && gap > track.m_SpacingMs * kQuietGaps )
+	{
+		// It's been drawn standing still since the last one - have it
+		// set off a gap before this one, not crawl all the way there.
+		Entry rest = last;
+		rest.m_Time = now - track.m_SpacingMs;
+		rest.m_bSnap = false;
+		if ( !NotBefore( last.m_Time, rest.m_Time ) )
+			track.Push( rest );
+	}
+	else
+	{
+		// a running average of the gaps, which are mostly the rate
+		// it's sent at give or take the jitter
+		unsigned int const spacing = ( track.m_SpacingMs * 7 + gap ) / 8;
+		track.m_SpacingMs = spacing < kMinSpacingMs ? kMinSpacingMs : ( spacing > kMaxSpacingMs ? kMaxSpacingMs : spacing );
+
+		// Keep to that rate, more or less, however they arrive - but
+		// never so far from when they did that the delay's used up.
+		int const spacingMs = static_cast< int >( track.m_SpacingMs );
+		int const lastMs = static_cast< int >( track.Get( track.m_Count - 1 ).m_Time - now );
+		int offset = 0;
+		if ( offset < lastMs + spacingMs / 2 )
+			offset = lastMs + spacingMs / 2;
+		if ( offset > lastMs + spacingMs * 3 / 2 )
+			offset = lastMs + spacingMs * 3 / 2;
+		if ( offset < -static_cast< int >( m_DelayMs / 2 ) )
+			offset = -static_cast< int >( m_DelayMs / 2 );
+		if ( offset > spacingMs )
+			offset = spacingMs;
+		entry.m_Time = now + offset;
+	}
+
+	Entry const & before = track.Get( track.m_Count - 1 );
+	entry.m_bSnap = DistanceSq( before.m_State, state ) > kSnapDistance * kSnapDistance;
+	if ( entry.m_bSnap )
+		++m_Stats.m_Snapped;
+
+	track.Push( entry );
+	track.m_bStill = false;
+}
+
+//
+// InterpolationBuffer::Remove
+//
+void InterpolationBuffer::Remove( unsigned int actorId )
+{
+	m_Tracks.erase( actorId );
+}
+
+//
+// InterpolationBuffer::Sample
+//
+void InterpolationBuffer::Sample( unsigned int now, std::vector< ActorNetState > & states )
+{
+	states.clear();
+
+	unsigned int const time = now - m_DelayMs;
+	for ( TrackMap::iterator i = m_Tracks.begin(); i != m_Tracks.end(); ++i )
+	{
+		ActorNetState state;
+		if ( SampleTrack( i->second, time, state ) )
+			states.push_back( state );
+	}
+}
+
+//
+// InterpolationBuffer::SampleTrack
+//
+bool InterpolationBuffer::SampleTrack( Track & track, unsigned int time, ActorNetState & state )
+{
+	if ( track.m_bStill || !track.m_Count )
+		return false;
+
+	// the first one that's still to come is second
+	while ( track.m_Count > 1 && NotBefore( time, track.Get( 1 ).m_Time ) )
+		track.Pop();
+
+	Entry & from = track.Get( 0 );
+	if ( !NotBefore( time, from.m_Time ) )
+	{
+		// nothing to show yet - only happens before the first one's due
+		return false;
+	}
+
+	if ( track.m_Count > 1 )
+	{
+		Entry const & to = track.Get( 1 );
+		if ( to.m_bSnap )
+		{
+			// stays put until it teleports
+			state = from.m_State;
+		}
+		else
+		{
+			float const t = float( time - from.m_Time ) / float( to.m_Time - from.m_Time );
+			Blend( from.m_State, to.m_State, t, state );
+		}
+
+		++m_Stats.m_Interpolated;
+		return true;
+	}
+
+	// Past the last one there is. Carry on from the one before it, if
+	// it was going anywhere.
+	unsigned int ahead = time - from.m_Time;
+	if ( !track.m_bHasPrevious || from.m_bSnap || from.m_Time == track.m_Previous.m_Time ||
+		DistanceSq( track.m_Previous.m_State, from.m_State ) == 0.0f || !m_MaxExtrapolationMs )
+	{
+		state = from.m_State;
+		track.m_bStill = true;
+		return true;
+	}
+
+	if ( ahead >= m_MaxExtrapolationMs )
+	{
+		ahead = m_MaxExtrapolationMs;
+		track.m_bStill = true;
+		++m_Stats.m_Stopped;
+	}
+	else
+	{
+		++m_Stats.m_Extrapolated;
+	}
+
+	float const t = 1.0f + float( ahead ) / float( from.m_Time - track.m_Previous.m_Time );
+	Blend( track.m_Previous.m_State, from.m_State, t, state );
+	return true;
+}
@@ -0,0 +1,178 @@
+#pragma once
+//========================================================================
+// Interpolation.h : Drawing remote actors a little in the past
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class InterpolationBuffer		- not in the book
+//========================================================================
+
+// Where a remote client draws each actor, from the positions the
+// server sends it - a Move_Actor event or a snapshot at a time, and
+// never as evenly as they were sent. Like Snapshot.h it only knows
+// ActorNetState; BuildActorNetState() and BuildActorMat() in
+// Network.h go to and from a Mat4x4.
+
+#include <map>
+#include <vector>
+
+#include "Snapshot.h"
+
+
+////////////////////////////////////////////////////
+//
+// InterpolationBuffer Description
+//
+//   Draws every actor a fixed delay in the past - GetDelay() ms -
+//   rather than wherever the last update put it. Each update is
+//   stamped with about when it came in, and each frame the actor
+//   goes where it was between the two updates either side of now
+//   minus the delay, position lerped and rotation nlerped. As long as
+//   the next update is in before the delay's up, late or bunched up
+//   packets don't show, and the server can send a lot less often
+//   than the client draws.
+//
+//   When the next one isn't in yet - it was lost, or just very late
+//   - the actor carries on the way it was going for up to
+//   GetMaxExtrapolation() ms, then stops there until it is.
+//
+//   Packets that arrive together would have the actor cover the
+//   second stretch in no time, and one that's late would have it
+//   crawl, so an update isn't stamped when it arrived but from half
+//   to one and a half of the usual gap after the one before - as
+//   long as that's no more than a gap after it arrived, or half the
+//   delay before.
+//
+//   An update after the actor's been drawn standing still is it
+//   setting off again, and it sets off a gap before the update
+//   rather than creeping all the way from the last one. An update that's moved the actor
+//   further than kSnapDistance is a teleport: it goes straight there
+//   once its time comes, rather than sliding across the map.
+//
+//   An actor comes out of Sample() only while it's moving, and not
+//   at all until its first update's time comes round - until then
+//   it stays where it was made.
+//
+//		// as each update comes in
+//		buffer.Add(state, timeGetTime());
+//
+//		// each frame
+//		buffer.Sample(timeGetTime(), states);
+//		for each of states:
+//			move the actor there
+//
+////////////////////////////////////////////////////
+
+class InterpolationBuffer
+{
+public:
+	enum
+	{
+		kDefaultDelayMs = 100,
+		kDefaultMaxExtrapolationMs = 100,
+		kDefaultSpacingMs = 50,				// until there's been a gap to go by
+		kMinSpacingMs = 5,
+		kMaxSpacingMs = 500,
+		kQuietGaps = 4,						// gaps without an update that's an actor stopping
+		kMaxSamples = 32,
+	};
+
+	static const float kSnapDistance;
+
+	struct Stats
+	{
+		unsigned long m_Interpolated;		// actors drawn by Sample(), by how
+		unsigned long m_Extrapolated;
+		unsigned long m_Stopped;			// extrapolated as far as it goes
+		unsigned long m_Snapped;			// teleports, as they're added
+	};
+
+	InterpolationBuffer();
+
+	void SetDelay( unsigned int ms ) { m_DelayMs = ms; }
+	unsigned int GetDelay( void ) const { return m_DelayMs; }
+	void SetMaxExtrapolation( unsigned int ms ) { m_MaxExtrapolationMs = ms; }
+	unsigned int GetMaxExtrapolation( void ) const { return m_MaxExtrapolationMs; }
+
+	void Add( ActorNetState const & state, unsigned int now );
+	void Remove( unsigned int actorId );
+	void Clear( void ) { m_Tracks.clear(); }
+
+	// Where each actor that's moving should be drawn now. 'states' is
+	// cleared first.
+	void Sample( unsigned int now, std::vector< ActorNetState > & states );
+
+	Stats const & GetStats( void ) const { return m_Stats; }
+
+protected:
+	struct Entry
+	{
+		unsigned int m_Time;
+		ActorNetState m_State;
+		bool m_bSnap;						// got here by teleporting
+	};
+
+	struct Track
+	{
+		Track();
+
+		Entry & Get( unsigned int i ) { return m_Entries[( m_First + i ) % kMaxSamples]; }
+		void Push( Entry const & entry );
+		void Pop( void );
+
+		Entry m_Entries[kMaxSamples];		// oldest first, from m_First
+		unsigned int m_First;
+		unsigned int m_Count;
+
+		Entry m_Previous;					// the last one popped, for extrapolating
+		bool m_bHasPrevious;
+
+		unsigned int m_LastArrival;
+		unsigned int m_SpacingMs;			// the usual gap between updates
+		bool m_bStill;						// has come out of Sample() where it'll stay
+	};
+
+	// Where a track's actor was at 'time'. False if it's not moving.
+	bool SampleTrack( Track & track, unsigned int time, ActorNetState & state );
+
+	typedef std::map< unsigned int, Track > TrackMap;
+	TrackMap m_Tracks;
+
+	unsigned int m_DelayMs;
+	unsigned int m_MaxExtrapolationMs;
+	Stats m_Stats;
+};
@@ -0,0 +1,237 @@
+//========================================================================
+// NetCompressor.cpp : Compressing a connection's big messages
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class NetCompressor				- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include "../ResourceCache/zlib/zlib.h"
+
+#include "NetCompressor.h"
+#include "NetworkEvents.h"
+
+
+unsigned int NetCompressor::s_Threshold = NetCompressor::kDefaultThreshold;
+char const *NetCompressor::s_pDictionary = NULL;
+unsigned int NetCompressor::s_DictionarySize = 0;
+
+namespace
+{
+	// what every Z_SYNC_FLUSH ends with - an empty stored block
+	const unsigned char g_FlushTail[] = { 0x00, 0x00, 0xff, 0xff };
+	const unsigned int kHeaderSize = 3;				// kind, size
+
+	double NowNs()
+	{
+		LARGE_INTEGER frequency, now;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&now);
+		return double(now.QuadPart) * 1.0e9 / double(frequency.QuadPart);
+	}
+}
+
+
+//
+// NetCompressor::NetCompressor
+//
+NetCompressor::NetCompressor(NetSocketStats &stats)
+	: m_Stats(stats), m_pDeflate(NULL), m_pInflate(NULL), m_bBroken(false)
+{
+}
+
+//
+// NetCompressor::~NetCompressor
+//
+NetCompressor::~NetCompressor()
+{
+	if (m_pDeflate)
+		deflateEnd(m_pDeflate);
+	if (m_pInflate)
+		inflateEnd(m_pInflate);
+	SAFE_DELETE(m_pDeflate);
+	SAFE_DELETE(m_pInflate);
+}
+
+//
+// NetCompressor::SetDictionary
+//
+void NetCompressor::SetDictionary(char const *pData, unsigned int size)
+{
+	s_pDictionary = size ? pData : NULL;
+	s_DictionarySize = size;
+}
+
+//
+// NetCompressor::StartDeflate
+//
+//   The zlib header's only sent once, at the start of the stream - it
+//   says whether there's a dictionary, which the reading end needs to
+//   know.
+//
+bool NetCompressor::StartDeflate()
+{
+	m_pDeflate = GCC_NEW z_stream;
+	memset(m_pDeflate, 0, sizeof(*m_pDeflate));
+
+	if (deflateInit2(m_pDeflate, Z_BEST_SPEED, Z_DEFLATED, kWindowBits, kMemLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		SAFE_DELETE(m_pDeflate);
+		return false;
+	}
+
+	if (s_pDictionary)
+		deflateSetDictionary(m_pDeflate, reinterpret_cast<Bytef const *>(s_pDictionary), s_DictionarySize);
+	return true;
+}
+
+//
+// NetCompressor::StartInflate
+//
+bool NetCompressor::StartInflate()
+{
+	m_pInflate = GCC_NEW z_stream;
+	memset(m_pInflate, 0, sizeof(*m_pInflate));
+
+	if (inflateInit2(m_pInflate, kWindowBits) != Z_OK)
+	{
+		SAFE_DELETE(m_pInflate);
+		return false;
+	}
+	return true;
+}
+
+//
+// NetCompressor::Compress
+//
+bool NetCompressor::Compress(char const *pMessage, unsigned int size, BinaryOutStream &out)
+{
+	if (!s_Threshold || size < s_Threshold || size > kMaxMessageSize || m_bBroken)
+		return false;
+
+	// room for it not to come out any smaller
+	if (size + kMaxOverhead + sizeof(u_long) > MAX_PACKET_SIZE)
+		return false;
+
+	double const begin = NowNs();
+
+	if (!m_pDeflate && !StartDeflate())
+	{
+		m_bBroken = true;
+		return false;
+	}
+
+	if (m_Scratch.size() < size + kMaxOverhead * 2)
+		m_Scratch.resize(size + kMaxOverhead * 2);
+
+	m_pDeflate->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(pMessage));
+	m_pDeflate->avail_in = size;
+	m_pDeflate->next_out = reinterpret_cast<Bytef *>(&m_Scratch[0]);
+	m_pDeflate->avail_out = static_cast<uInt>(m_Scratch.size());
+
+	// With room left over, it's all been flushed. Once the stream has
+	// taken the message, it has to go compressed or the next one won't
+	// make sense at the other end - so if that's not how it ends, this
+	// stream is never used again.
+	int const result = deflate(m_pDeflate, Z_SYNC_FLUSH);
+	unsigned int const written = static_cast<unsigned int>(m_Scratch.size() - m_pDeflate->avail_out);
+	if (result != Z_OK || m_pDeflate->avail_in || !m_pDeflate->avail_out ||
+		written < sizeof(g_FlushTail) || memcmp(&m_Scratch[written - sizeof(g_FlushTail)], g_FlushTail, sizeof(g_FlushTail)))
+	{
+		m_bBroken = true;
+		return false;
+	}
+
+	unsigned int const deflated = written - sizeof(g_FlushTail);
+
+	out.Clear();
+	out.WriteU8(EventWire::kMsgCompressed);
+	out.WriteU16(static_cast<unsigned short>(size));
+	out.WriteBytes(&m_Scratch[0], deflated);
+
+	m_Stats.Compressed(size, kHeaderSize + deflated, NowNs() - begin);
+	return true;
+}
+
+//
+// NetCompressor::Decompress
+//
+bool NetCompressor::Decompress(char const *pMessage, unsigned int size, std::vector<char> &message)
+{
+	double const begin = NowNs();
+
+	BinaryInStream in(pMessage, size);
+	unsigned char const kind = in.ReadU8();
+	unsigned int const rawSize = in.ReadU16();
+	if (!in.IsOk() || kind != EventWire::kMsgCompressed || !rawSize || rawSize > kMaxMessageSize)
+		return false;
+
+	if (!m_pInflate && !StartInflate())
+		return false;
+
+	unsigned int const deflated = size - kHeaderSize;
+	if (m_Scratch.size() < deflated + sizeof(g_FlushTail))
+		m_Scratch.resize(deflated + sizeof(g_FlushTail));
+	memcpy(&m_Scratch[0], pMessage + kHeaderSize, deflated);
+	memcpy(&m_Scratch[deflated], g_FlushTail, sizeof(g_FlushTail));
+
+	// a byte to spare, so it goes on through the empty block at the end
+	// rather than stopping once it's filled the message
+	message.resize(rawSize + 1);
+
+	m_pInflate->next_in = reinterpret_cast<Bytef *>(&m_Scratch[0]);
+	m_pInflate->avail_in = deflated + sizeof(g_FlushTail);
+	m_pInflate->next_out = reinterpret_cast<Bytef *>(&message[0]);
+	m_pInflate->avail_out = rawSize + 1;
+
+	int result = inflate(m_pInflate, Z_SYNC_FLUSH);
+	if (result == Z_NEED_DICT && s_pDictionary)
+	{
+		if (inflateSetDictionary(m_pInflate, reinterpret_cast<Bytef const *>(s_pDictionary), s_DictionarySize) != Z_OK)
+			return false;
+		result = inflate(m_pInflate, Z_SYNC_FLUSH);
+	}
+
+	if (result != Z_OK || m_pInflate->avail_in || m_pInflate->avail_out != 1)
+		return false;
+
+	message.resize(rawSize);
+	m_Stats.Decompressed(rawSize, size, NowNs() - begin);
+	return true;
+}
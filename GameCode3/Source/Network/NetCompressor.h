@@ -0,0 +1,150 @@
+#pragma once
+//========================================================================
+// NetCompressor.h : Compressing a connection's big messages
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class NetCompressor				- not in the book
+//========================================================================
+
+// Compressing the big messages a connection sends - a level join's
+// burst of New_Actor events, say, each with the same Lua function
+// names and much the same numbers in it. Like the rest of the socket
+// layer, nothing here knows about the game.
+
+#include <vector>
+
+struct NetSocketStats;
+class BinaryOutStream;
+
+typedef struct z_stream_s z_stream;
+
+
+////////////////////////////////////////////////////
+//
+// NetCompressor Description
+//
+//   One connection's zlib streams, one each way. A message as big as
+//   the threshold or bigger goes as
+//
+//		u8		EventWire::kMsgCompressed
+//		u16		how big the message was
+//		...		it, deflated
+//
+//   and everything else goes as it is. The stream isn't started over
+//   for each message - each is flushed to a byte boundary and the next
+//   carries on from it - so a string that was in any of the last
+//   4KB of messages sent costs a few bits the next time, not its
+//   length. That only works because the other end reads every one in
+//   order, so it's only for a reliable, ordered connection; never an
+//   unreliable UdpSocket channel.
+//
+//   A dictionary set before the first connection is made primes both
+//   ends' streams, so even the first message finds things in it. It
+//   has to be the same at both ends, like the wire ids.
+//
+//   The flush ends every message with the same four bytes; they aren't
+//   sent, and the reading end puts them back.
+//
+//   Each takes about 36KB once it's compressed or decompressed
+//   something, and nothing until then.
+//
+//		// the sending end, on the socket's thread
+//		NetCompressor compressor(m_Stats);
+//		if (compressor.Compress(pMessage, size, out))
+//			... send 'out' instead
+//
+//		// the reading end
+//		case EventWire::kMsgCompressed:
+//			if (!compressor.Decompress(pMessage, size, message))
+//				... the stream's broken - drop the connection
+//
+////////////////////////////////////////////////////
+
+class NetCompressor : public boost::noncopyable
+{
+public:
+	enum
+	{
+		kDefaultThreshold = 128,
+		kWindowBits = 12,			// 4KB of history
+		kMemLevel = 5,
+		kMaxMessageSize = 16 * 1024,
+
+		// Worst case, what compressing adds to a message that won't -
+		// one that big in the last of a packet goes as it is.
+		kMaxOverhead = 32,
+	};
+
+	explicit NetCompressor(NetSocketStats &stats);
+	~NetCompressor();
+
+	// Writes a kMsgCompressed for the message to 'out', which is
+	// cleared first, if it's big enough. False if it isn't, or if
+	// compressing has already failed once - send it as it was.
+	bool Compress(char const *pMessage, unsigned int size, BinaryOutStream &out);
+
+	// The message a whole kMsgCompressed one holds. False if it's not
+	// one that could have come from Compress(), after which nothing
+	// more from the same stream can be read.
+	bool Decompress(char const *pMessage, unsigned int size, std::vector<char> &message);
+
+	// The smallest message worth compressing - 0 never compresses
+	// anything. Only the sending end cares.
+	static void SetThreshold(unsigned int bytes) { s_Threshold = bytes; }
+	static unsigned int GetThreshold() { return s_Threshold; }
+
+	// Not copied - keep it around. Before the first NetCompressor
+	// starts, at both ends.
+	static void SetDictionary(char const *pData, unsigned int size);
+
+private:
+	bool StartDeflate();
+	bool StartInflate();
+
+	NetSocketStats &m_Stats;
+
+	z_stream *m_pDeflate;
+	z_stream *m_pInflate;
+	bool m_bBroken;						// the sending stream - never compress again
+
+	std::vector<char> m_Scratch;
+
+	static unsigned int s_Threshold;
+	static char const *s_pDictionary;
+	static unsigned int s_DictionarySize;
+};
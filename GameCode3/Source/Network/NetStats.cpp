@@ -0,0 +1,338 @@
+//========================================================================
+// NetStats.cpp : What each connection has been doing
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class NetHistogram				- not in the book
+//  struct NetSocketStats			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "NetStats.h"
+
+
+//-------------------------------------------------------------------
+// NetHistogram Implementation
+
+//
+// NetHistogram::NetHistogram
+//
+NetHistogram::NetHistogram()
+{
+	memset(m_Counts, 0, sizeof(m_Counts));
+	m_Max[0] = m_Max[1] = 0;
+	m_Sum[0] = m_Sum[1] = 0.0;
+	m_Current = 0;
+}
+
+//
+// NetHistogram::BucketOf
+//
+int NetHistogram::BucketOf(unsigned int value)
+{
+	int bucket = 0;
+	while (value && bucket < kBuckets - 1)
+	{
+		value >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+//
+// NetHistogram::GetBucketLimit
+//
+unsigned int NetHistogram::GetBucketLimit(int bucket)
+{
+	if (bucket <= 0)
+		return 0;
+	if (bucket >= kBuckets - 1)
+		return 0xffffffff;
+	return (1u << bucket) - 1;
+}
+
+//
+// NetHistogram::Add
+//
+void NetHistogram::Add(unsigned int value)
+{
+	++m_Counts[m_Current][BucketOf(value)];
+	m_Sum[m_Current] += value;
+	if (value > m_Max[m_Current])
+		m_Max[m_Current] = value;
+}
+
+//
+// NetHistogram::Roll
+//
+void NetHistogram::Roll()
+{
+	m_Current ^= 1;
+	memset(m_Counts[m_Current], 0, sizeof(m_Counts[m_Current]));
+	m_Max[m_Current] = 0;
+	m_Sum[m_Current] = 0.0;
+}
+
+//
+// NetHistogram::GetCount
+//
+unsigned int NetHistogram::GetCount() const
+{
+	unsigned int count = 0;
+	for (int b = 0; b < kBuckets; ++b)
+		count += GetBucketCount(b);
+	return count;
+}
+
+//
+// NetHistogram::GetMax
+//
+unsigned int NetHistogram::GetMax() const
+{
+	return m_Max[0] > m_Max[1] ? m_Max[0] : m_Max[1];
+}
+
+//
+// NetHistogram::GetMean
+//
+unsigned int NetHistogram::GetMean() const
+{
+	unsigned int const count = GetCount();
+	return count ? static_cast<unsigned int>((m_Sum[0] + m_Sum[1]) / count) : 0;
+}
+
+//
+// NetHistogram::GetPercentile
+//
+//   The top of a bucket can be more than anything in it - the max is
+//   the better answer then.
+//
+unsigned int NetHistogram::GetPercentile(float percent) const
+{
+	unsigned int const count = GetCount();
+	if (!count)
+		return 0;
+
+	unsigned int const wanted = static_cast<unsigned int>(count * percent / 100.0f + 0.5f);
+	unsigned int seen = 0;
+	for (int b = 0; b < kBuckets; ++b)
+	{
+		seen += GetBucketCount(b);
+		if (seen >= wanted && seen > 0)
+		{
+			unsigned int const limit = GetBucketLimit(b);
+			return limit < GetMax() ? limit : GetMax();
+		}
+	}
+	return GetMax();
+}
+
+//
+// NetHistogram::WriteJson
+//
+void NetHistogram::WriteJson(std::string &out) const
+{
+	char buffer[128];
+	_snprintf(buffer, sizeof(buffer)-1, "{\"count\":%u,\"mean\":%u,\"p50\":%u,\"p99\":%u,\"max\":%u}",
+		GetCount(), GetMean(), GetPercentile(50.0f), GetPercentile(99.0f), GetMax());
+	buffer[sizeof(buffer)-1] = 0;
+	out += buffer;
+}
+
+
+//-------------------------------------------------------------------
+// NetSocketStats Implementation
+
+//
+// NetSocketStats::NetSocketStats
+//
+NetSocketStats::NetSocketStats()
+{
+	m_SockId = -1;
+	m_BytesIn = m_BytesOut = 0;
+	m_PacketsIn = m_PacketsOut = 0;
+	m_QueuedBytes = 0;
+	m_bBlocked = false;
+	m_BlockedSince = 0;
+	m_BlockedMs = 0;
+	m_BlockedCounted = 0;
+	m_RoundTripMs = 0;
+	m_CompressedOut = m_CompressRawBytes = m_CompressBytes = 0;
+	m_CompressNs = 0.0;
+	m_CompressedIn = m_DecompressRawBytes = m_DecompressBytes = 0;
+	m_DecompressNs = 0.0;
+	m_BytesInPerSec = m_BytesOutPerSec = 0;
+
+	m_WindowStart = timeGetTime();
+	m_WindowBytesIn = m_WindowBytesOut = 0;
+}
+
+//
+// NetSocketStats::Sent
+//
+void NetSocketStats::Sent(unsigned int bytes, unsigned int now)
+{
+	m_BytesOut += bytes;
+
+	if (m_bBlocked)
+	{
+		m_BlockedMs += now - m_BlockedCounted;
+		m_Blocked.Add(now - m_BlockedSince);
+		m_bBlocked = false;
+	}
+}
+
+//
+// NetSocketStats::SendBlocked
+//
+void NetSocketStats::SendBlocked(unsigned int now)
+{
+	if (!m_bBlocked)
+	{
+		m_bBlocked = true;
+		m_BlockedSince = now;
+		m_BlockedCounted = now;
+	}
+}
+
+//
+// NetSocketStats::Queued
+//
+void NetSocketStats::Queued(unsigned int bytes)
+{
+	m_QueuedBytes += bytes;
+	m_QueueDepth.Add(m_QueuedBytes);
+}
+
+//
+// NetSocketStats::RoundTrip
+//
+void NetSocketStats::RoundTrip(unsigned int ms)
+{
+	m_RoundTripMs = ms;
+	m_RoundTrip.Add(ms);
+}
+
+//
+// NetSocketStats::Compressed
+//
+void NetSocketStats::Compressed(unsigned int rawBytes, unsigned int bytes, double ns)
+{
+	++m_CompressedOut;
+	m_CompressRawBytes += rawBytes;
+	m_CompressBytes += bytes;
+	m_CompressNs += ns;
+}
+
+//
+// NetSocketStats::Decompressed
+//
+void NetSocketStats::Decompressed(unsigned int rawBytes, unsigned int bytes, double ns)
+{
+	++m_CompressedIn;
+	m_DecompressRawBytes += rawBytes;
+	m_DecompressBytes += bytes;
+	m_DecompressNs += ns;
+}
+
+//
+// NetSocketStats::Roll
+//
+void NetSocketStats::Roll(unsigned int now)
+{
+	unsigned int const elapsed = now - m_WindowStart;
+	if (elapsed)
+	{
+		m_BytesInPerSec = static_cast<unsigned int>((m_BytesIn - m_WindowBytesIn) * 1000.0 / elapsed);
+		m_BytesOutPerSec = static_cast<unsigned int>((m_BytesOut - m_WindowBytesOut) * 1000.0 / elapsed);
+	}
+
+	// a socket that's been blocked all window long has to show it
+	if (m_bBlocked)
+	{
+		m_BlockedMs += now - m_BlockedCounted;
+		m_BlockedCounted = now;
+	}
+
+	m_WindowStart = now;
+	m_WindowBytesIn = m_BytesIn;
+	m_WindowBytesOut = m_BytesOut;
+
+	m_QueueDepth.Roll();
+	m_Blocked.Roll();
+	m_RoundTrip.Roll();
+}
+
+//
+// NetSocketStats::WriteJson
+//
+void NetSocketStats::WriteJson(std::string &out) const
+{
+	char buffer[512];
+	_snprintf(buffer, sizeof(buffer)-1,
+		"{\"sock\":%d,\"bytes_in\":%lu,\"bytes_out\":%lu,\"packets_in\":%lu,\"packets_out\":%lu,"
+		"\"bytes_in_per_sec\":%u,\"bytes_out_per_sec\":%u,\"queued_bytes\":%u,\"blocked\":%s,\"blocked_ms\":%u,\"rtt_ms\":%u",
+		m_SockId, m_BytesIn, m_BytesOut, m_PacketsIn, m_PacketsOut,
+		m_BytesInPerSec, m_BytesOutPerSec, m_QueuedBytes, m_bBlocked ? "true" : "false", m_BlockedMs, m_RoundTripMs);
+	buffer[sizeof(buffer)-1] = 0;
+	out += buffer;
+
+	out += ",\"queue_depth\":";
+	m_QueueDepth.WriteJson(out);
+	out += ",\"blocked_spells\":";
+	m_Blocked.WriteJson(out);
+	out += ",\"rtt\":";
+	m_RoundTrip.WriteJson(out);
+
+	// ratio is what's sent over what it would have been
+	_snprintf(buffer, sizeof(buffer)-1,
+		",\"compress\":{\"messages\":%lu,\"raw_bytes\":%lu,\"bytes\":%lu,\"ratio\":%.3f,\"ns_per_message\":%.0f}"
+		",\"decompress\":{\"messages\":%lu,\"raw_bytes\":%lu,\"bytes\":%lu,\"ratio\":%.3f,\"ns_per_message\":%.0f}",
+		m_CompressedOut, m_CompressRawBytes, m_CompressBytes,
+		m_CompressRawBytes ? double(m_CompressBytes) / m_CompressRawBytes : 1.0,
+		m_CompressedOut ? m_CompressNs / m_CompressedOut : 0.0,
+		m_CompressedIn, m_DecompressRawBytes, m_DecompressBytes,
+		m_DecompressRawBytes ? double(m_DecompressBytes) / m_DecompressRawBytes : 1.0,
+		m_CompressedIn ? m_DecompressNs / m_CompressedIn : 0.0);
+	buffer[sizeof(buffer)-1] = 0;
+	out += buffer;
+	out += "}";
+}
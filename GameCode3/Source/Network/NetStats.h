@@ -0,0 +1,182 @@
+#pragma once
+//========================================================================
+// NetStats.h : What each connection has been doing
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class NetHistogram				- not in the book
+//  struct NetSocketStats			- not in the book
+//========================================================================
+
+// What each connection has been doing, so the clients that are
+// dragging a server down can be picked out. The sockets count as they
+// go ( see NetSocket::GetStats() ) and the socket manager rolls the
+// windows over and publishes a copy for anyone to read - see
+// BaseSocketManager::GetSocketStats().
+
+#include <string>
+
+
+////////////////////////////////////////////////////
+//
+// NetHistogram Description
+//
+//   How often each size of value has turned up lately. The buckets
+//   go up in powers of two - bucket 0 is 0, bucket b is from
+//   2^(b-1) up to 2^b - so adding a value is a few instructions, and
+//   a percentile is only good to within a factor of two, which is
+//   plenty to tell a 5ms round trip from a 500ms one.
+//
+//   It's rolling: there are two windows, and Roll() throws the older
+//   one away and starts a new one. What's read is both, so it's
+//   always at least one whole window's worth.
+//
+////////////////////////////////////////////////////
+
+class NetHistogram
+{
+public:
+	enum { kBuckets = 25 };			// the last holds 2^23 and up
+
+	NetHistogram();
+
+	void Add(unsigned int value);
+	void Roll();
+
+	unsigned int GetCount() const;
+	unsigned int GetMax() const;
+	unsigned int GetMean() const;
+
+	// The top of the bucket the percentile falls in - 0 if there's
+	// nothing in it.
+	unsigned int GetPercentile(float percent) const;
+
+	unsigned int GetBucketCount(int bucket) const { return m_Counts[0][bucket] + m_Counts[1][bucket]; }
+	static unsigned int GetBucketLimit(int bucket);
+
+	// {"count":..,"mean":..,"p50":..,"p99":..,"max":..}
+	void WriteJson(std::string &out) const;
+
+private:
+	static int BucketOf(unsigned int value);
+
+	unsigned int m_Counts[2][kBuckets];
+	unsigned int m_Max[2];
+	double m_Sum[2];
+	int m_Current;
+};
+
+
+////////////////////////////////////////////////////
+//
+// NetSocketStats Description
+//
+//   One connection's counters. The totals are since it was made; the
+//   histograms and rates are over the last window or two - see
+//   BaseSocketManager::kStatsWindowMs.
+//
+//   m_QueuedBytes is what's waiting in a NetSocket's send queue. A
+//   socket is blocked from a send() that would have blocked until
+//   the next one that doesn't - a client that isn't reading, or
+//   can't keep up, spends a long time blocked with a deep queue.
+//
+//   m_RoundTrip only has anything in it for sockets that measure it
+//   - a RemoteEventSocket pings the other end, and a UdpSocket times
+//   its acks. Likewise the compression counts are only for sockets
+//   with a NetCompressor.
+//
+////////////////////////////////////////////////////
+
+struct NetSocketStats
+{
+	NetSocketStats();
+
+	// as it happens, on the socket's thread
+	void Sent(unsigned int bytes, unsigned int now);
+	void SendBlocked(unsigned int now);
+	void Received(unsigned int bytes) { m_BytesIn += bytes; }
+	void Queued(unsigned int bytes);
+	void Dequeued(unsigned int bytes) { m_QueuedBytes -= bytes; }
+	void RoundTrip(unsigned int ms);
+	void Compressed(unsigned int rawBytes, unsigned int bytes, double ns);
+	void Decompressed(unsigned int rawBytes, unsigned int bytes, double ns);
+
+	// The socket manager's, every window.
+	void Roll(unsigned int now);
+
+	// One JSON object, with no line end.
+	void WriteJson(std::string &out) const;
+
+	int m_SockId;
+
+	unsigned long m_BytesIn;
+	unsigned long m_BytesOut;
+	unsigned long m_PacketsIn;
+	unsigned long m_PacketsOut;
+
+	unsigned int m_QueuedBytes;
+	NetHistogram m_QueueDepth;			// bytes, each time a packet's queued
+
+	bool m_bBlocked;
+	unsigned int m_BlockedSince;		// when the spell it's in began
+	unsigned int m_BlockedMs;			// in all - a spell still going on, up to the last Roll()
+	NetHistogram m_Blocked;				// ms, each spell that's over
+
+	unsigned int m_RoundTripMs;			// the latest, 0 until there's been one
+	NetHistogram m_RoundTrip;			// ms
+
+	// kMsgCompressed messages each way - how big they'd have been,
+	// how big they were, and the time it took
+	unsigned long m_CompressedOut;
+	unsigned long m_CompressRawBytes;
+	unsigned long m_CompressBytes;
+	double m_CompressNs;
+	unsigned long m_CompressedIn;
+	unsigned long m_DecompressRawBytes;
+	unsigned long m_DecompressBytes;
+	double m_DecompressNs;
+
+	// bytes a second over the last whole window
+	unsigned int m_BytesInPerSec;
+	unsigned int m_BytesOutPerSec;
+
+private:
+	unsigned int m_BlockedCounted;		// when m_BlockedMs was last added to
+	unsigned int m_WindowStart;
+	unsigned long m_WindowBytesIn;
+	unsigned long m_WindowBytesOut;
+};
@@ -42,19 +42,9 @@
 #include <assert.h>
 #include "Network.h"
 #include "../EventManager/Events.h"
-#include "../TeapotWars/TeapotEvents.h"			// GAH - Game specific dependancy! Create a factory later...
-#include "../ai/AiEvents.h"
+#include "../MainLoop/GameInstance.h"
 #include "../DumbStuff/String.h"
 
-#pragma comment(lib, "Ws2_32")
-
-#define EXIT_ASSERT assert(0);
-
-const char *BinaryPacket::g_Type = "BinaryPacket";
-const char *TextPacket::g_Type = "TextPacket";
-
-
-BaseSocketManager *g_pSocketManager = NULL;
 
 /******************************************************
 
@@ -100,944 +90,327 @@ void testCode()
 ******************************************************/
 
 
-//
-// TextPacket::TextPacket			- Chapter 16, page 607
-//
-TextPacket::TextPacket(char const * const text)
- :BinaryPacket(static_cast<u_long>(strlen(text) + 2))
-{ 
-	MemCpy(text, strlen(text), 0);
-	MemCpy("\r\n", 2, 2);
-	*(u_long *)m_Data = 0;
-}
-
-
-//-------------------------------------------------------------------
-// NetSocket Implementation
-
-//
-// NetSocket::NetSocket				- Chapter 16, page 591
-//
-NetSocket::NetSocket() 
-{ 
-	m_sock = INVALID_SOCKET;
-	m_deleteFlag = 0;
-	m_sendOfs = 0;
-	m_timeOut = 0;
-
-	m_recvOfs = m_recvBegin = 0;
-	m_internal = 0;
-	m_bBinaryProtocol = 1;
-}
 
 
 //
-// NetSocket::NetSocket				- Chapter 16, page 591
+// ClientSocketManager::Connect					- Chapter 16, page 610
 //
-NetSocket::NetSocket(SOCKET new_sock, unsigned int hostIP)
+bool ClientSocketManager::Connect()
 {
-	m_sock = INVALID_SOCKET;
-	m_deleteFlag = 0;
-	m_sendOfs = 0;
-	m_timeOut = 0;
-
-	m_bBinaryProtocol = 1;
-
-	m_recvOfs = m_recvBegin = 0;
-	m_internal = 0;
-
-	m_timeCreated = timeGetTime();
-
-	m_sock = new_sock;
-	m_ipaddr = hostIP;
-
-	m_internal = g_pSocketManager->IsInternal(m_ipaddr);
-
-	setsockopt (m_sock, SOL_SOCKET, SO_DONTLINGER, NULL, 0);
+	if (!BaseSocketManager::Init())
+		return false;
 
-	if (m_ipaddr)
+	RemoteEventSocket *pSocket = GCC_NEW RemoteEventSocket;
+	
+	if (!pSocket->Connect(GetHostByName(m_HostName), m_Port) )
 	{
-		TCHAR buffer[128];
-		const char *ansiIpaddress = g_pSocketManager->GetHostByAddr(m_ipaddr);
-		if (ansiIpaddress)
-		{
-			TCHAR genIpaddress[64];
-			AnsiToGenericCch(genIpaddress, ansiIpaddress, static_cast<int>(strlen(ansiIpaddress)+1));
-			_tcssprintf(buffer, _T("User connected: %s %s"), genIpaddress, (m_internal) ? _T("(internal)") : _T(""));
-			OutputDebugString(buffer);
-		}
+		SAFE_DELETE(pSocket);
+		return false;
 	}
+	AddSocket(pSocket);
+	return true;
 }
 
 
+
 //
-// NetSocket::~NetSocket				- Chapter 16, page 593
+// GameServerListenSocket::HandleInput				- Chapter 16, page 629
 //
-NetSocket::~NetSocket() 
+void GameServerListenSocket::HandleInput() 
 {
-	if (m_sock != INVALID_SOCKET) 
-	{
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-	}
- }
-
+	SOCKET new_sock;
+	unsigned int theipaddr;
 
+	new_sock = AcceptConnection(&theipaddr);
 
-//
-// NetSocket::Connect				- Chapter 16, page 593
-//
-bool NetSocket::Connect(unsigned int ip, unsigned int port, int fCoalesce) 
-{
-	struct sockaddr_in sa;
+#ifdef SO_DONTLINGER
 	int x = 1;
+	setsockopt(new_sock, SOL_SOCKET, SO_DONTLINGER, (char *)&x, sizeof(x));
+#endif
 
-	if ((m_sock = socket(PF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET)
-		return false;
-
-	if (!fCoalesce)
+	if (new_sock != INVALID_SOCKET)
 	{
-		setsockopt(m_sock, IPPROTO_TCP, TCP_NODELAY, (char *)&x, sizeof(x));
+		RemoteEventSocket * sock = GCC_NEW RemoteEventSocket(new_sock, theipaddr);
+		sock->SetInstance(m_pInstance);
+		int sockId = g_pSocketManager->AddSocket(sock);
+		int ipAddress = g_pSocketManager->GetIpAddress(sockId);
+		g_pSocketManager->QueueEvent( IEventDataPtr( GCC_NEW EvtData_Remote_Client( sockId, ipAddress ) ),
+			m_pInstance ? m_pInstance->GetEventManager() : NULL );
 	}
+ }
 
-	//	setsockopt(m_sock, SOL_SOCKET, SO_KEEPALIVE, (char *)&x, sizeof(x));
 
-	sa.sin_family = AF_INET;
-	sa.sin_addr.s_addr = htonl(ip);
-	sa.sin_port = htons(port);
 
-	if (connect(m_sock, (struct sockaddr *)&sa, sizeof(sa))) 
-	{
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-		return false;
-	}
 
-	return true;
- }
 
-//
-// NetSocket::Send							- Chapter 16, page 594
-//
-void NetSocket::Send(shared_ptr<IPacket> pkt, bool clearTimeOut)
-{
-	if (clearTimeOut)
-		m_timeOut = 0;
 
-	m_OutList.push_back(pkt);
-}
 
 //
-// NetSocket::SetBlocking				- Chapter 16, page 594
-//
-void NetSocket::SetBlocking(int block) 
-{
-	#ifdef WIN32
-		unsigned long val = block ? 0 : 1;
-		ioctlsocket(m_sock, FIONBIO, &val);
-	#else
-		int val = fcntl(m_sock, F_GETFL, 0);
-		if (block)
-			val &= ~(O_NONBLOCK);
-		else
-			val |= O_NONBLOCK;
-
-		fcntl(m_sock, F_SETFL, val);
-	#endif
-}
-
-
+// RemoteEventSocket::HandlePacket				- Chapter 16, page 615
 //
-// NetSocket::HandleOutput				- Chapter 16, page 595
+//   This was HandleInput() in the book, which went through m_InList
+//   after NetSocket::HandleInput() had filled it. Now each packet is
+//   read straight out of the receive buffer.
 //
-void NetSocket::HandleOutput() 
+void RemoteEventSocket::HandlePacket(IPacket const &packet)
 {
-	int fSent = 0;
-	do 
+	if (!strcmp(packet.VGetType(), BinaryPacket::g_Type))
 	{
-		assert(!m_OutList.empty());
-		PacketList::iterator i = m_OutList.begin();
+		const char *buf = packet.VGetData()+sizeof(u_long);
+		unsigned int size = packet.VGetSize()-sizeof(u_long);
 
-		shared_ptr<IPacket> pkt = *i;
-		const char *buf = pkt->VGetData();
-		int len = static_cast<int>(pkt->VGetSize());
-
-		int rc = send(m_sock, buf+m_sendOfs, len-m_sendOfs, 0);
-		if (rc > 0) 
-		{
-			g_pSocketManager->m_Outbound += rc;
-			m_sendOfs += rc;
-			fSent = 1;
-		}
-		else if (WSAGetLastError() != WSAEWOULDBLOCK)
-		{
-			HandleException();
-			fSent = 0;
-		}
+		if (EventWire::IsBinaryMessage(buf, size))
+			HandleBinaryMessage(buf, size);
 		else
-		{
-			fSent = 0;
-		}
-
-		if (m_sendOfs == pkt->VGetSize()) 
-		{
-			m_OutList.pop_front();
-			m_sendOfs = 0;
-		}
-
-	} while ( fSent && !m_OutList.empty() );
+			HandleTextMessage(buf, size);
+	}
+	else if (!strcmp(packet.VGetType(), TextPacket::g_Type))
+	{
+		OutputDebugStringA(packet.VGetData()+sizeof(u_long));
+	}
 }
 
-
-
 //
-// NetSocket::HandleInput				- Chapter 16, page 596
+// RemoteEventSocket::HandleBinaryMessage		- not in the book
 //
-void NetSocket::HandleInput() 
+void RemoteEventSocket::HandleBinaryMessage(char const *pData, unsigned int size)
 {
-	bool bPktRecieved = false;
-	u_long packetSize = 0;
-	int rc = recv(m_sock, m_recvBuf+m_recvBegin+m_recvOfs, RECV_BUFFER_SIZE-m_recvOfs, 0);
-
-	char metrics[1024];
-	sprintf(metrics, "Incoming: %6d bytes. Begin %6d Offset %4d\n", rc, m_recvBegin, m_recvOfs);
-	OutputDebugStringA(metrics);
-
-	if (rc==0)
-	{
-		return;
-	}
-
-	if (rc < 0)
-	{
-		m_deleteFlag = 1;
-		return;
-	}
-
-	const int hdrSize = sizeof(u_long);
-	unsigned int newData = m_recvOfs + rc;
-	int processedData = 0;
+	BinaryInStream in(pData, size);
 
-	while (newData > hdrSize)
+	switch(in.ReadU8())
 	{
-		// There are two types of packets at the lowest level of our design:
-		// BinaryPacket - Sends the size as a positive 4 byte integer
-		// TextPacket - Sends 0 for the size, the parser will search for a CR
-
-		packetSize = *(reinterpret_cast<u_long*>(m_recvBuf+m_recvBegin));
-		packetSize = ntohl(packetSize);
+		case NetMsg_Event:
+			CreateEvent(pData, size);
+			break;
 
-		if (m_bBinaryProtocol)
+		case NetMsg_PlayerLoginOk:
 		{
-			// we don't have enough new data to grab the next packet
-			if (newData < packetSize)
-				break;
+			int serverSockId = in.ReadI32();
+			int actorId = in.ReadI32();
+			if (in.IsOk())
+				QueueEvent( IEventDataPtr( GCC_NEW EvtData_Network_Player_Actor_Assignment( actorId, serverSockId ) ) );
+			break;
+		}
 
-			if (packetSize > MAX_PACKET_SIZE)
-			{
-				// prevent nasty buffer overruns!
-				HandleException();
-				return;
-			}
+		case NetMsg_Snapshot:
+			HandleSnapshot(in);
+			break;
 
-			if (newData >= packetSize)
-			{
-				// we know how big the packet is...and we have the whole thing
-				char test[1024];
-				memcpy(test, &m_recvBuf[m_recvBegin+hdrSize], packetSize);
-				test[packetSize+1]='\r';
-				test[packetSize+2]='\n';
-				test[packetSize+3]=0;
-				OutputDebugStringA(test);
-				shared_ptr<BinaryPacket> pkt(GCC_NEW BinaryPacket(&m_recvBuf[m_recvBegin+hdrSize], packetSize-hdrSize));
-				m_InList.push_back(pkt);
-				bPktRecieved = true;
-				processedData += packetSize;
-				newData -= packetSize;
-				m_recvBegin += packetSize;
-			}
+		case NetMsg_SnapshotAck:
+		{
+			unsigned int tick = in.ReadU32();
+			BaseGameLogic *pGame = m_pInstance ? m_pInstance->GetGame() : g_pApp->m_pGame;
+			SnapshotReplicator *pSnapshots = pGame ? pGame->GetSnapshotReplicator() : NULL;
+			if (in.IsOk() && pSnapshots)
+				pSnapshots->OnAck(m_id, tick);
+			break;
 		}
-		else
+
+		case NetMsg_Ping:
 		{
-			// the text protocol waits for a carraige return and creates a string
-			char *cr = static_cast<char *>(memchr(&m_recvBuf[m_recvBegin], 0x0a, rc));
-			if (cr)
+			unsigned int stamp = in.ReadU32();
+			if (in.IsOk())
 			{
-				*(cr+1) = 0;
-				shared_ptr<TextPacket> pkt(GCC_NEW TextPacket(&m_recvBuf[m_recvBegin]));
-				m_InList.push_back(pkt);
-				packetSize = cr - &m_recvBuf[m_recvBegin];
-				bPktRecieved = true;
-
-				processedData += packetSize;
-				newData -= packetSize;
-				m_recvBegin += packetSize;
+				BinaryOutStream out;
+				EventWire::WritePing(EventWire::kMsgPong, stamp, out);
+				Send(shared_ptr<IPacket>(GCC_NEW BinaryPacket(out.GetData(), out.GetSize())), false);
 			}
+			break;
 		}
-	}
-
-	g_pSocketManager->m_Inbound += rc;
-	m_recvOfs = newData;
 
-	if (bPktRecieved)
-	{
-		if (m_recvOfs == 0)
+		case NetMsg_Pong:
 		{
-			m_recvOfs = 0;
-			m_recvBegin = 0;
+			unsigned int stamp = in.ReadU32();
+			if (in.IsOk())
+				m_Stats.RoundTrip(timeGetTime() - stamp);
+			break;
 		}
-		else if (m_recvBegin + m_recvOfs + MAX_PACKET_SIZE > RECV_BUFFER_SIZE)
+
+		case NetMsg_Compressed:
 		{
-			// we don't want to overrun the buffer - so we copy the leftover bits 
-			// to the beginning of the recieve buffer and start over
-			int leftover = m_recvOfs;
-			memcpy(m_recvBuf, &m_recvBuf[m_recvBegin], m_recvOfs);
-			m_recvBegin = 0;
+			// a broken stream can't be read past - and nothing's
+			// compressed twice
+			if (!m_Compressor.Decompress(pData, size, m_Decompressed) ||
+				static_cast<unsigned char>(m_Decompressed[0]) == NetMsg_Compressed)
+			{
+				OutputDebugStringA("ERROR Bad compressed message from remote\n");
+				HandleException();
+				break;
+			}
+			HandleBinaryMessage(&m_Decompressed[0], static_cast<unsigned int>(m_Decompressed.size()));
+			break;
 		}
-	}	
-}
-
-
-//-------------------------------------------------------------------
-// NetListenSocket Implementation
-
-
-
-NetListenSocket::NetListenSocket(int portnum) 
-{
-	port = 0;
-	Init(portnum);
-}
-
-
-//
-// NetListenSocket::Init				- Chapter 16, page 599
-//
-void NetListenSocket::Init(int portnum)
-{
-	struct sockaddr_in sa;
-	int x = 1;
-
-	if ((m_sock = socket(PF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET)
-	{
-		perror("NetListenSocket::Init: socket");
-		EXIT_ASSERT
-		exit(1);
-	}
-
-	if (setsockopt(m_sock, SOL_SOCKET, SO_REUSEADDR, (char *)&x, sizeof(x))== SOCKET_ERROR) 
-	{
-		perror("NetListenSocket::Init: setsockopt");
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-		EXIT_ASSERT
-		exit(1);
-	}
-	
-	memset(&sa, 0, sizeof(sa));
-	sa.sin_family = AF_INET;
-	sa.sin_addr.s_addr = ADDR_ANY;
-	sa.sin_port = htons(portnum);
 
-	// bind to port
-	if (bind(m_sock, (struct sockaddr *)&sa, sizeof(sa)) == SOCKET_ERROR) 
-	{
-		perror("NetListenSocket::Init: bind");
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-		EXIT_ASSERT
-		exit(1);
-	}
-
-	// set nonblocking - accept() blocks under some odd circumstances otherwise
-	SetBlocking(0);
-
-	// start listening
-	if (listen(m_sock, 256) == SOCKET_ERROR) 
-	{
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-		EXIT_ASSERT
-		exit(1);
+		default:
+			assert(0 && _T("Unknown message type."));
 	}
-
-	port = portnum;
 }
 
 //
-// NetListenSocket::InitScan			- added post press
-//   Opens multiple ports to listen for connections.
+// RemoteEventSocket::SendOnChannel				- not in the book
 //
-void NetListenSocket::InitScan(int portnum_min, int portnum_max) 
-{
-	struct sockaddr_in sa;
-	int portnum, x = 1;
-
-	if ((m_sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET)
-	{
-		EXIT_ASSERT
-		exit(1);
-	}
-
-	if (setsockopt(m_sock, SOL_SOCKET, SO_REUSEADDR, (char *)&x, sizeof(x)) == SOCKET_ERROR) 
-	{
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-		EXIT_ASSERT
-		exit(1);
-	}
-
-	memset(&sa, 0, sizeof(sa));
-	sa.sin_family = AF_INET;
-	for (portnum = portnum_min; portnum < portnum_max; portnum++) 
-	{
-		sa.sin_port = htons(portnum);
-		// bind to port
-		if (bind(m_sock, (struct sockaddr *)&sa, sizeof(sa)) != SOCKET_ERROR)
-			break;
-	}
-
-	if (portnum == portnum_max) 
-	{
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-		EXIT_ASSERT
-		exit(1);
-	}
-
-	// set nonblocking - accept() blocks under some odd circumstances otherwise
-	SetBlocking(0);
-
-	// start listening
-	if (listen(m_sock, 8) == SOCKET_ERROR) 
-	{
-		closesocket(m_sock);
-		m_sock = INVALID_SOCKET;
-		EXIT_ASSERT
-		exit(1);
-	}
-
-	port = portnum;
- }
-
+//   Big binary messages go compressed - see NetCompressor. The time
+//   out is the ping timer, so nothing sent puts it off.
 //
-// NetListenSocket::AcceptConnection				- Chapter 16, page 600
-//
-SOCKET NetListenSocket::AcceptConnection(unsigned int *pAddr)
+void RemoteEventSocket::SendOnChannel(shared_ptr<IPacket> pkt, NetChannel channel)
 {
-	SOCKET new_sock;
-	struct sockaddr_in sock;
-	int size;
-
-	size = sizeof(sock);
+	char const *pData = pkt->VGetData() + sizeof(u_long);
+	unsigned int const size = pkt->VGetSize() - sizeof(u_long);
 
-	if ((new_sock = accept(m_sock, (struct sockaddr *)&sock, &size))== INVALID_SOCKET)
-		return INVALID_SOCKET;
-
-	if (getpeername(new_sock, (struct sockaddr *)&sock, &size) == SOCKET_ERROR)
+	if (size >= NetCompressor::GetThreshold() && !strcmp(pkt->VGetType(), BinaryPacket::g_Type) &&
+		EventWire::IsBinaryMessage(pData, size) && m_Compressor.Compress(pData, size, m_Compressed))
 	{
-		closesocket(new_sock);
-		return INVALID_SOCKET;
+		pkt.reset(GCC_NEW BinaryPacket(m_Compressed.GetData(), m_Compressed.GetSize()));
 	}
-	*pAddr = ntohl(sock.sin_addr.s_addr);
-	return new_sock;
- }
-
 
-
-
-//
-// BaseSocketManager::BaseSocketManager				- Chapter 16, page 603
-//
-BaseSocketManager::BaseSocketManager() 
-{ 
-	m_Inbound = 0;
-	m_Outbound = 0;
-	m_MaxOpenSockets = 0;
-	m_SubnetMask = 0;
-	m_Subnet = 0xffffffff;
-	m_NextSocketId = 0;
-
-	g_pSocketManager = this; 
-	ZeroMemory(&m_WsaData, sizeof(WSADATA)); 
+	Send(pkt, false);
 }
 
-
-//
-// BaseSocketManager::Init						- Chapter 16, page 603
 //
-bool BaseSocketManager::Init()
-{
-	int errorCode = WSAStartup(0x0202, &m_WsaData);
-	if (errorCode==0)
-		return true;
-	else
-	{
-		assert(0 && "WSAStartup failure!");
-		return false;
-	}
-}
-
-
+// RemoteEventSocket::TimeOut					- not in the book
 //
-// BaseSocketManager::Shutdown					- Chapter 16, page 604
+//   Pings the other end, which pongs the time straight back - see
+//   HandleBinaryMessage().
 //
-void BaseSocketManager::Shutdown()
+void RemoteEventSocket::TimeOut()
 {
-	// Get rid of all those pesky kids...
-	while (!m_SockList.empty())
-	{
-		delete *m_SockList.begin();
-		m_SockList.pop_front();
-	}
-
-	WSACleanup();
-}
-
-//
-// BaseSocketManager::AddSocket					- Chapter 16, page 604
-//
-int BaseSocketManager::AddSocket(NetSocket *socket) 
-{ 
-	socket->m_id = m_NextSocketId;
-	m_SockList.push_front(socket); 
-	
-	int openSockets = static_cast<int>(m_SockList.size());
-	
-	if (openSockets > m_MaxOpenSockets)
-		++m_MaxOpenSockets;
+	BinaryOutStream out;
+	EventWire::WritePing(EventWire::kMsgPing, timeGetTime(), out);
+	Send(shared_ptr<IPacket>(GCC_NEW BinaryPacket(out.GetData(), out.GetSize())), false);
 
-	m_SockMap[m_NextSocketId] = socket;
-	++m_NextSocketId; 
-
-	return socket->m_id; 
+	SetTimeOut(kPingIntervalMs);
 }
 
 //
-// BaseSocketManager::RemoveSocket					- Chapter 16, page 604
-//
-void BaseSocketManager::RemoveSocket(NetSocket *socket) 
-{ 
-	m_SockList.remove(socket); 
-	m_SockMap.erase(socket->m_id);
-	SAFE_DELETE(socket);
-}
-
+// RemoteEventSocket::HandleTextMessage			- Chapter 16, page 615
 //
-// BaseSocketManager::FindSocket					- Chapter 16, page 605
+//   The book's protocol, for when EventWire is in text mode.
 //
-NetSocket *BaseSocketManager::FindSocket(int sockId)
+void RemoteEventSocket::HandleTextMessage(char const *pData, unsigned int size)
 {
-	SocketIdMap::iterator i = m_SockMap.find(sockId);
-	if (i==m_SockMap.end())
+	std::istrstream in(pData, size);
+	
+	int type;
+	in >> type;
+	switch(type)
 	{
-		return NULL;
-	}
-
-	return (*i).second;
-}
-
+		case NetMsg_Event:
+			CreateEvent(pData, size);
+			break;
 
+		case NetMsg_PlayerLoginOk:
+		{
+			int serverSockId, actorId;
+			in >> serverSockId;
+			in >> actorId;
+			QueueEvent( IEventDataPtr( GCC_NEW EvtData_Network_Player_Actor_Assignment( actorId, serverSockId ) ) );
+			break;
+		}
 
-int BaseSocketManager::GetIpAddress(int sockId)
-{
-	NetSocket *socket = FindSocket(sockId);
-	if (socket)
-	{
-		return socket->GetIpAddress();
-	}
-	else
-	{
-		return 0;
+		default:
+			assert(0 && _T("Unknown message type."));
 	}
 }
 
 
-
-//
-// BaseSocketManager::Send							- Chapter 16, page 605
 //
-bool BaseSocketManager::Send(int sockId, shared_ptr<IPacket> packet)
-{
-	NetSocket *sock = FindSocket(sockId);
-	if (!sock)
-		return false;
-	sock->Send(packet);
-	return true;
-}
-
+// RemoteEventSocket::HandleSnapshot			- not in the book
 //
-// BaseSocketManager::DoSelect					- Chapter 16, page 605
+//   The client's side of SnapshotReplicator. Each actor that's moved
+//   becomes a Move_Actor event, as if the server had sent one.
 //
-void BaseSocketManager::DoSelect(int pauseMicroSecs, int handleInput) 
+void RemoteEventSocket::HandleSnapshot(BinaryInStream &in)
 {
-	timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = pauseMicroSecs;    // 100 microseconds is 0.1 milliseconds or .0001 seconds
-
-	fd_set inp_set, out_set, exc_set;
-	int maxdesc;
-	NetSocket *pSock;
-
-	FD_ZERO(&inp_set);
-	FD_ZERO(&out_set);
-	FD_ZERO(&exc_set);
-
-	maxdesc = 0;
-
-  // set everything up for the select
-	for (SocketList::iterator i = m_SockList.begin(); i != m_SockList.end(); ++i)
-	{
-		pSock = *i;
-		if ((pSock->m_deleteFlag&1) || pSock->m_sock == INVALID_SOCKET)
-			continue;
-
-		if (handleInput)
-			FD_SET(pSock->m_sock, &inp_set);
-
-		FD_SET(pSock->m_sock, &exc_set);
-
-		if (pSock->HasOutput())
-			FD_SET(pSock->m_sock, &out_set);
-
-		if ((int)pSock->m_sock > maxdesc)
-			maxdesc = (int)pSock->m_sock;
-
-	 }
-  
-	int selRet = 0;
-
-	// do the select (duration passed in as tv, NULL to block until event)
-	selRet = select(maxdesc+1, &inp_set, &out_set, &exc_set, &tv) ;
-	if (selRet == SOCKET_ERROR)
-	{
-		PrintError();
+	unsigned int ackTick;
+	if (!m_Snapshots.Read(in, m_Moved, ackTick))
 		return;
-	}
-
-	// handle input, output, and exceptions
 
-	if (selRet)
+	for (unsigned int i = 0; i < m_Moved.size(); ++i)
 	{
-		for (SocketList::iterator i = m_SockList.begin(); i != m_SockList.end(); ++i)
-		{
-			pSock = *i;
-
-			if ((pSock->m_deleteFlag&1) || pSock->m_sock == INVALID_SOCKET)
-				continue;
-
-			if (FD_ISSET(pSock->m_sock, &exc_set))
-			{
-				pSock->HandleException();
-			}
-
-			if (!(pSock->m_deleteFlag&1) && FD_ISSET(pSock->m_sock, &out_set))
-			{
-				pSock->HandleOutput();
-			}
-
-			if (   handleInput
-				&& !(pSock->m_deleteFlag&1) && FD_ISSET(pSock->m_sock, &inp_set))
-			{
-				pSock->HandleInput();
-			}
-		 }	
+		Mat4x4 mat;
+		BuildActorMat(m_Moved[i], mat);
+		QueueEvent( IEventDataPtr( GCC_NEW EvtData_Move_Actor( m_Moved[i].m_ActorId, mat ) ) );
 	}
 
-	unsigned int timeNow = timeGetTime();
-
-	// handle deleting any sockets
-	for (SocketList::iterator i = m_SockList.begin(); i != m_SockList.end(); ++i)
+	if (ackTick)
 	{
-		pSock = *i;
-		if (pSock->m_timeOut) 
-		{
-			if (pSock->m_timeOut < timeNow)
-			{
-				pSock->TimeOut();
-			}
-		}
-
-		if (pSock->m_deleteFlag&1) 
-		{
-			switch (pSock->m_deleteFlag) 
-			{
-			  case 1:
-//					--i;
-					g_pSocketManager->RemoveSocket(pSock);
-					break;
-				case 3:
-					pSock->m_deleteFlag = 2;
-					if (pSock->m_sock != INVALID_SOCKET) 
-					{
-						closesocket(pSock->m_sock);
-						pSock->m_sock = INVALID_SOCKET;
-					}
-					break;
-			}
-		}
-
-	 }
- }
-
-
-//
-// BaseSocketManager::IsInternal					- Chapter 16, page 609
-//
-bool BaseSocketManager::IsInternal(unsigned int ipaddr)
-{
-	bool internal = false;
-	if (m_SubnetMask)
-	{
-	    unsigned int hostSubnet = ipaddr & m_SubnetMask;
-		if (hostSubnet == m_Subnet)
-		{
-			internal = 1;
-		}
+		BinaryOutStream out;
+		SnapshotReceiver::WriteAck(ackTick, out);
+		SendOnChannel(shared_ptr<IPacket>(GCC_NEW BinaryPacket(out.GetData(), out.GetSize())), NetChannel_UnreliableSequenced);
 	}
-	return internal;
 }
 
 
 //
-// BaseSocketManager::GetHostByName					- Chapter 16, page 609
-//
-unsigned int BaseSocketManager::GetHostByName(const std::string &hostName)
-{
-	struct hostent *pHostEnt; 
-    struct sockaddr_in tmpSockAddr; //placeholder for the ip address
-
-    //This will retrieve the ip details and put it into pHostEnt structure
-	pHostEnt = gethostbyname(hostName.c_str());
-
-    if(pHostEnt == NULL)
-    {
-        assert(0 && _T("Error occured"));
-        return 0;
-    }
-
-    memcpy(&tmpSockAddr.sin_addr,pHostEnt->h_addr,pHostEnt->h_length);
-	return ntohl(tmpSockAddr.sin_addr.s_addr);
-}
-
+// RemoteEventSocket::CreateEvent				- Chapter 16, page 616
 //
-// BaseSocketManager::GetHostByAddr					- Chapter 16, page 609
+//   The book built the event here, comparing the name against every
+//   type it knew. Now EventWire does that from the type's wire id,
+//   here on whichever thread has the sockets - except for the types
+//   that make Lua tables, in the Lua state of the game they're for.
+//   Those aren't built until the message has been handed over to that
+//   game's thread - see BaseSocketManager::QueueMessage().
 //
-const char *BaseSocketManager::GetHostByAddr(unsigned int ip)
+void RemoteEventSocket::CreateEvent(char const *pData, unsigned int size)
 {
-	static char host[32];
-
-	int netip = htonl(ip);
-	LPHOSTENT lpHostEnt = gethostbyaddr((const char *)&netip, 4, PF_INET);
-
-	if (lpHostEnt)
+	if (EventWire::DecodesOnGameThread(pData, size))
 	{
-		strcpy(host, lpHostEnt->h_name);
-		return host;
+		g_pSocketManager->QueueMessage(pData, size, m_pInstance ? m_pInstance->GetEventManager() : NULL);
+		return;
 	}
 
-	return NULL;
-}
-
-//
-// BaseSocketManager::PrintError					- not in the book
-//
-void BaseSocketManager::PrintError()
-{
-	int realError = WSAGetLastError();
-	TCHAR *reason;
-
-	switch(realError)
+	IEventDataPtr event = EventWire::ReadEvent(pData, size);
+	if (!event)
 	{
-		case WSANOTINITIALISED: reason = _T("A successful WSAStartup must occur before using this API."); break;
-		case WSAEFAULT: reason = _T("The Windows Sockets implementation was unable to allocated needed resources for its internal operations, or the readfds, writefds, exceptfds, or timeval parameters are not part of the user address space."); break;
-		case WSAENETDOWN: reason = _T("The network subsystem has failed."); break;
-		case WSAEINVAL: reason = _T("The timeout value is not valid, or all three descriptor parameters were NULL."); break;
-		case WSAEINTR: reason = _T("The (blocking) call was canceled via WSACancelBlockingCall."); break;
-		case WSAEINPROGRESS: reason = _T("A blocking Windows Sockets 1.1 call is in progress, or the service provider is still processing a callback function."); break;
-		case WSAENOTSOCK: reason = _T("One of the descriptor sets contains an entry which is not a socket."); break;
-		default: reason = _T("Unknown."); 
+		OutputDebugStringA("ERROR Unknown event type from remote\n");
+		return;
 	}
 
-	TCHAR buffer[256];
-	_tcssprintf(buffer, _T("SOCKET error: %s\n"), reason);
-	OutputDebugString(buffer);
+	QueueEvent(event);
 }
 
-
-//
-// ClientSocketManager::Connect					- Chapter 16, page 610
-//
-bool ClientSocketManager::Connect()
-{
-	if (!BaseSocketManager::Init())
-		return false;
-
-	RemoteEventSocket *pSocket = GCC_NEW RemoteEventSocket;
-	
-	if (!pSocket->Connect(GetHostByName(m_HostName), m_Port) )
-	{
-		SAFE_DELETE(pSocket);
-		return false;
-	}
-	AddSocket(pSocket);
-	return true;
-}
-
-
-
-//
-// GameServerListenSocket::HandleInput				- Chapter 16, page 629
-//
-void GameServerListenSocket::HandleInput() 
-{
-	SOCKET new_sock;
-	unsigned int theipaddr;
-
-	new_sock = AcceptConnection(&theipaddr);
-
-	int x = 1;
-	setsockopt(new_sock, SOL_SOCKET, SO_DONTLINGER, (char *)&x, sizeof(x));
-
-	if (new_sock != INVALID_SOCKET)
-	{
-		RemoteEventSocket * sock = GCC_NEW RemoteEventSocket(new_sock, theipaddr);
-		int sockId = g_pSocketManager->AddSocket(sock);
-		int ipAddress = g_pSocketManager->GetIpAddress(sockId);
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Remote_Client( sockId, ipAddress ) ) );
-	}
- }
-
-
-
-
-
-
-
 //
-// RemoteEventSocket::HandleInput				- Chapter 16, page 615
+// RemoteEventSocket::QueueEvent				- not in the book
 //
-void RemoteEventSocket::HandleInput()
+void RemoteEventSocket::QueueEvent(IEventDataPtr const &event)
 {
-	NetSocket::HandleInput();
-
-	// traverse the list of m_InList packets and do something useful with them
-	while (!m_InList.empty())
-	{
-		shared_ptr<IPacket> packet = *m_InList.begin();
-		m_InList.pop_front();
-		if (!strcmp(packet->VGetType(), BinaryPacket::g_Type))
-		{
-			const char *buf = packet->VGetData();
-			int size = static_cast<int>(packet->VGetSize());
-
-			std::istrstream in(buf+sizeof(u_long), (size-sizeof(u_long)));
-			
-			int type;
-			in >> type;
-			switch(type)
-			{
-				case NetMsg_Event:
-					CreateEvent(in);
-					break;
-
-				case NetMsg_PlayerLoginOk:
-				{
-					int serverSockId, actorId;
-					in >> serverSockId;
-					in >> actorId;
-					safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Network_Player_Actor_Assignment( actorId, serverSockId ) ) );
-					break;
-				}
-
-				default:
-					assert(0 && _T("Unknown message type."));
-			}
-		}
-		else if (!strcmp(packet->VGetType(), TextPacket::g_Type))
-		{
-			OutputDebugStringA(packet->VGetData()+sizeof(u_long));
-		}
-	}
+	g_pSocketManager->QueueEvent(event, m_pInstance ? m_pInstance->GetEventManager() : NULL);
 }
 
 
 //
-// RemoteEventSocket::CreateEvent				- Chapter 16, page 616
+// BuildActorNetState							- not in the book
 //
-void RemoteEventSocket::CreateEvent(std::istrstream &in)
+void BuildActorNetState(ActorId id, Mat4x4 const &mat, ActorNetState &state)
 {
-	// Note:  We can improve the efficiency of this by comparing the hash values instead of strings.
-	// But strings are easier to debug!
-	char eventType[256];
-	in >> eventType;
-
-	// This really needs to get rewritten with real streaming code.
-	// Once that is done all the game specific events can be moved from Events.h & .cpp
-	// back into TeapotEvents.h & .cpp.
-
-	if ( EvtData_New_Game::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_New_Game( in ) ) );
-	}
-	else if ( EvtData_Game_State::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Game_State( in ) ) );
-	}
-	else if ( EvtData_New_Actor::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_New_Actor( in ) ) );
-	}
-	else if ( EvtData_Move_Actor::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Move_Actor( in ) ) );
-	}
-	else if ( EvtData_Destroy_Actor::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Destroy_Actor( in ) ) );
-	}
-	else if ( EvtData_Fire_Weapon::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Fire_Weapon( in ) ) );
-	}
-	else if ( EvtData_Thrust::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Thrust( in ) ) );
-	}
-	else if ( EvtData_Steer::sk_EventType.getStr() == eventType )
-	{
-		safeQueEvent( IEventDataPtr( GCC_NEW EvtData_Steer( in ) ) );
-	}
-	else if (EvtData_AiSteer::sk_EventType.getStr() == eventType)
-	{
-		safeQueEvent(IEventDataPtr(GCC_NEW EvtData_AiSteer(in)));
-	}
-	else
-	{
-		char debugMessage[256];
-		sprintf(debugMessage, "ERROR Unknown event type from remote: %s\n", eventType);
-		OutputDebugStringA(debugMessage);
-	}
+	state.m_ActorId = id;
+
+	Vec3 const pos = mat.GetPosition();
+	state.m_Pos[0] = pos.x;
+	state.m_Pos[1] = pos.y;
+	state.m_Pos[2] = pos.z;
+
+	Quaternion rot;
+	rot.Build(mat);
+	state.m_Rot[0] = rot.x;
+	state.m_Rot[1] = rot.y;
+	state.m_Rot[2] = rot.z;
+	state.m_Rot[3] = rot.w;
 }
 
-
-
 //
-// NetworkEventForwarder::HandleEvent			- Chapter 16, page 617
+// BuildActorMat								- not in the book
 //
-bool NetworkEventForwarder::HandleEvent( IEventData const & event )
+void BuildActorMat(ActorNetState const &state, Mat4x4 &mat)
 {
-	std::ostrstream out;
-
-	out << static_cast<int>(RemoteEventSocket::NetMsg_Event) << " ";
-	out << event.VGetEventType().getStr() << " ";
-	event.VSerialize(out);
-	out << "\r\n";
-
-	shared_ptr<BinaryPacket> eventMsg(GCC_NEW BinaryPacket(out.rdbuf()->str(), out.pcount()));
-
-	g_pSocketManager->Send(m_sockId, eventMsg);
-	return true;
+	Quaternion rot;
+	rot.x = state.m_Rot[0];
+	rot.y = state.m_Rot[1];
+	rot.z = state.m_Rot[2];
+	rot.w = state.m_Rot[3];
+
+	mat.BuildRotationQuat(rot);
+	mat.SetPosition(Vec3(state.m_Pos[0], state.m_Pos[1], state.m_Pos[2]));
 }
 
 
@@ -1055,14 +428,10 @@ void NetworkGameView::VOnAttach(GameViewId viewId, optional<ActorId> aid)
 	// which is how each client can be uniquely identified from other
 	// clients attached to the server.
 
-	std::ostrstream out;
-
-	out << static_cast<int>(RemoteEventSocket::NetMsg_PlayerLoginOk) << " ";
-	out << m_SockId << " ";
-	out << *m_PlayerActorId << " ";
-	out << "\r\n";
+	BinaryOutStream out;
+	EventWire::WritePlayerLoginOk(m_SockId, *m_PlayerActorId, out);
 
-	shared_ptr<BinaryPacket> gvidMsg(GCC_NEW BinaryPacket(out.rdbuf()->str(), out.pcount()));
+	shared_ptr<BinaryPacket> gvidMsg(GCC_NEW BinaryPacket(out.GetData(), out.GetSize()));
 	g_pSocketManager->Send(m_SockId, gvidMsg);
 }
 
@@ -35,233 +35,29 @@
 //========================================================================
 //  Content References in Game Coding Complete 3rd Edition
 // 
-//  class IPacket					- Chapter 16, page 587
-//  class BinaryPacket				- Chapter 16, page 588
-//  class TextPacket				- Chapter 16, page 589
-//  class NetSocket					- Chapter 16, page 590
-//  class NetListenSocket			- Chapter 16, page 599
-//  class BaseSocketManager			- Chapter 16, page 601
 //  class ClientSocketManager		- Chapter 16, page 610
 //  class GameServerListenSocket	- Chapter 16, page 612
 //  class RemoteEventSocket			- Chapter 16, page 614
-//  class NetworkEventForwarder		- Chapter 16, page 617
 //  class NetworkGameView			- Chapter 16, page 618
 
 
-#include <sys/types.h>
-#include <Winsock2.h>
-#include "..\EventManager\EventManager.h"
+// The packets, sockets and the socket manager are in SocketManager.h,
+// and how events are sent in NetworkEvents.h; what's here ties them to
+// the game.
 
+#include "SocketManager.h"
+#include "NetworkEvents.h"
+#include "Snapshot.h"
+#include "InterestManager.h"
+#include "NetCompressor.h"
 
-#define MAX_PACKET_SIZE (256)
-#define RECV_BUFFER_SIZE (MAX_PACKET_SIZE * 512)
-#define MAX_QUEUE_PER_PLAYER (10000)
-
-#define MAGIC_NUMBER		(0x1f2e3d4c)
-#define IPMANGLE(a,b,c,d) (((a)<<24)|((b)<<16)|((c)<<8)|((d)))
-
-class NetSocket;
-
-typedef std::list<NetSocket *> SocketList;
-typedef std::map<int, NetSocket *> SocketIdMap;
-
-
-////////////////////////////////////////////////////
-//
-// IPacket Description
-//
-//    The interface class that defines a public API for 
-//    packet objects - data that is either about to be
-//    sent to or just been recieved from the network
-//
-////////////////////////////////////////////////////
-
-class IPacket
-{
-public:
-	virtual char const * const VGetType() const=0;
-	virtual char const * const VGetData() const=0;
-	virtual u_long VGetSize() const =0;
-	virtual ~IPacket() { }
-};
-
-typedef std::list< shared_ptr <IPacket> > PacketList;
-
-
-////////////////////////////////////////////////////
-//
-// BinaryPacket Description
-//
-//   A packet object that can be constructed all at once,
-//   or with repeated calls to MemCpy
-////////////////////////////////////////////////////
-
-class BinaryPacket : public IPacket
-{
-protected:
-	char *m_Data;
-
-public:
-	inline BinaryPacket(char const * const data, u_long size);
-	inline BinaryPacket(u_long size);
-	virtual ~BinaryPacket() { SAFE_DELETE(m_Data); }
-	virtual char const * const VGetType() const { return g_Type; }
-	virtual char const * const VGetData() const { return m_Data; }
-	virtual u_long VGetSize() const { return ntohl(*(u_long *)m_Data); }
-	inline void MemCpy(char const *const data, size_t size, int destOffset);
-
-	static const char *g_Type;
-};
-
-
-inline BinaryPacket::BinaryPacket(char const * const data, u_long size)
-{
-	// BinaryPacket::BinaryPacket		- Chapter 16, page 606
-	m_Data = GCC_NEW char[size + sizeof(u_long)];
-	assert(m_Data);
-	*(u_long *)m_Data = htonl(size+sizeof(u_long));
-	memcpy(m_Data+sizeof(u_long), data, size);
-}
-
-inline BinaryPacket::BinaryPacket(u_long size)
-{
-	// BinaryPacket::BinaryPacket		- Chapter 16, page 607
-	m_Data = GCC_NEW char[size + sizeof(u_long)];
-	assert(m_Data);
-	*(u_long *)m_Data = htonl(size+sizeof(u_long));
-}
-
-inline void BinaryPacket::MemCpy(char const *const data, size_t size, int destOffset)
-{
-	// BinaryPacket::MemCpy				- Chapter 16, page 607
-	assert(size+destOffset <= VGetSize()-sizeof(u_long));
-	memcpy(m_Data + destOffset + sizeof(u_long), data, size);
-}
-
-////////////////////////////////////////////////////
-//
-// TextPacket Description
-//
-//   A packet object that takes a text string.
-////////////////////////////////////////////////////
-
-class TextPacket : public BinaryPacket
-{
-public:
-	TextPacket(char const * const text);
-	virtual char const * const VGetType() const { return g_Type; }
-
-	static const char *g_Type;
-};
-
-
-////////////////////////////////////////////////////
-//
-// NetSocket Description
-//
-//   A base class for a socket connection.
-////////////////////////////////////////////////////
-
-class NetSocket 
-{
-	friend class BaseSocketManager;
-
-public:
-	NetSocket();
-	NetSocket(SOCKET new_sock, unsigned int hostIP);
-	virtual ~NetSocket();
-
-	virtual void HandleInput();
-	virtual void HandleOutput();
-	virtual int  HasOutput() { return !m_OutList.empty(); }
-	virtual void TimeOut() { m_timeOut=0; }
-
-	bool Connect(unsigned int ip, unsigned int port, int fCoalesce = 0);
-
-	void HandleException() { m_deleteFlag |= 1; }
-	void SetBlocking(int block);
-	void Send(shared_ptr<IPacket> pkt, bool clearTimeOut=1);
-
-	void SetTimeOut(int ms=45*1000) { m_timeOut = timeGetTime() + ms; }
-
-	int GetIpAddress() { return m_ipaddr; }
-
-
-protected:
-    SOCKET m_sock;
-	int m_id;				// a unique ID given by the socket manager
-
-	// note: if deleteFlag has bit 2 set, exceptions only close the
-	//   socket and set to INVALID_SOCKET, and do not delete the NetSocket
-    int m_deleteFlag;
- 
-	PacketList m_OutList;
-	PacketList m_InList;
-
-	char m_recvBuf[RECV_BUFFER_SIZE];
-	unsigned int m_recvOfs, m_recvBegin;
-	bool m_bBinaryProtocol;
-
-    int m_sendOfs;
-	unsigned int m_timeOut;
-	unsigned int m_ipaddr;
-
-	int m_internal;
-	int m_timeCreated;
-};
-
-
-
-class BaseSocketManager
-{
-	friend class NetSocket;
-
-protected:
-	WSADATA m_WsaData;
-
-	SocketList m_SockList;
-	SocketIdMap m_SockMap;
-
-	int m_NextSocketId;
-	int m_Inbound;
-	int m_Outbound;
-	int m_MaxOpenSockets;
-	unsigned int m_SubnetMask;
-	unsigned int m_Subnet;
-
-	NetSocket *FindSocket(int sockId);
-
-public:
-	BaseSocketManager();
-	virtual ~BaseSocketManager() { Shutdown(); }
-
-	void DoSelect(int pauseMicroSecs, int handleInput = 1);
-
-	bool Init();
-	void Shutdown();
-	void PrintError();
-
-	int AddSocket(NetSocket *socket); 
-	void RemoveSocket(NetSocket *socket);
-
-	unsigned int GetHostByName(const std::string &hostName);
-	const char *GetHostByAddr(unsigned int ip);
-
-	int GetIpAddress(int sockId);
-
-	void SetSubnet(unsigned int subnet, unsigned int subnetMask)
-	{
-		m_Subnet = subnet;
-		m_SubnetMask = subnetMask;
-	}
-	bool IsInternal(unsigned int ipaddr);
-
-	bool Send(int sockId, shared_ptr<IPacket> packet);
-};
-
-extern BaseSocketManager *g_pSocketManager;
 
+// An actor's matrix to what a snapshot sends, and back. Only the
+// position and rotation go - not any scale.
+void BuildActorNetState(ActorId id, Mat4x4 const &mat, ActorNetState &state);
+void BuildActorMat(ActorNetState const &state, Mat4x4 &mat);
 
+class GameInstance;
 
 
 class ClientSocketManager : public BaseSocketManager
@@ -282,30 +78,18 @@ public:
 
 
 
-
-
-class NetListenSocket: public NetSocket
-{
-public:
-	NetListenSocket() { };
-	NetListenSocket(int portnum);
-
-	void Init(int portnum);
-	void InitScan(int portnum_min, int portnum_max);
-	SOCKET AcceptConnection(unsigned int *pAddr);
-
-	unsigned short port;
-};
-
-
-
-
+// pInstance is the game the clients it accepts are playing, when
+// there's more than one in the process - see GameInstancePool. NULL
+// is g_pApp's.
 class GameServerListenSocket: public NetListenSocket 
 {
 public:
-	GameServerListenSocket(int portnum) { Init(portnum); }
+	GameServerListenSocket(int portnum, GameInstance *pInstance = NULL) : m_pInstance(pInstance) { Init(portnum); }
 
 	void HandleInput();
+
+protected:
+	GameInstance *m_pInstance;
 };
 
 
@@ -314,44 +98,55 @@ class RemoteEventSocket: public NetSocket
 public:
 	enum
 	{
-		NetMsg_Event,
-		NetMsg_PlayerLoginOk,
+		NetMsg_Event = EventWire::kMsgEvent,
+		NetMsg_PlayerLoginOk = EventWire::kMsgPlayerLoginOk,
+		NetMsg_Snapshot = EventWire::kMsgSnapshot,
+		NetMsg_SnapshotAck = EventWire::kMsgSnapshotAck,
+		NetMsg_Ping = EventWire::kMsgPing,
+		NetMsg_Pong = EventWire::kMsgPong,
+		NetMsg_Compressed = EventWire::kMsgCompressed,
 	};
 
+	// how often each end pings the other, for GetStats().m_RoundTrip
+	enum { kPingIntervalMs = 1000 };
+
 	// server accepting a client
 	RemoteEventSocket(SOCKET new_sock, unsigned int hostIP)		
-	: NetSocket(new_sock, hostIP)
+	: NetSocket(new_sock, hostIP), m_pInstance(NULL), m_Compressor(m_Stats)
 	{
+		SetTimeOut(kPingIntervalMs);
 	}
 
 	// client attach to server
-	RemoteEventSocket() { };										
+	RemoteEventSocket() : m_pInstance(NULL), m_Compressor(m_Stats) { SetTimeOut(kPingIntervalMs); };										
+
+	// The game whose event manager gets what this reads - see
+	// GameServerListenSocket. Before it's added to the socket manager.
+	void SetInstance(GameInstance *pInstance) { m_pInstance = pInstance; }
 
-	virtual void HandleInput();
+	virtual void SendOnChannel(shared_ptr<IPacket> pkt, NetChannel channel);
+	virtual void TimeOut();
 
 protected:
-	void CreateEvent(std::istrstream &in);
-};
+	virtual void HandlePacket(IPacket const &packet);
+	void HandleBinaryMessage(char const *pData, unsigned int size);
+	void HandleTextMessage(char const *pData, unsigned int size);
+	void HandleSnapshot(BinaryInStream &in);
+	void CreateEvent(char const *pData, unsigned int size);
+	void QueueEvent(IEventDataPtr const &event);
 
+	GameInstance *m_pInstance;
 
+	SnapshotReceiver m_Snapshots;				// the client end of the server's snapshots
+	std::vector<ActorNetState> m_Moved;			// reused for every snapshot
 
+	NetCompressor m_Compressor;					// the big messages, both ways
+	BinaryOutStream m_Compressed;
+	std::vector<char> m_Decompressed;
+};
 
-// The only thing a network game view does is 
-// act as an intermediary between the server and the 'real' remote view
-// it listens to the same messages as a a game view
-// and sends them along via TCP/IP
 
-class NetworkEventForwarder : public IEventListener
-{
-public:
-	// IEventListener
-	NetworkEventForwarder(int sockId) { m_sockId = sockId; }
-	bool HandleEvent( IEventData const & event );
-	char const * GetName(void) { return "NetworkEventForwarder"; }
 
-protected:
-	int m_sockId;
-};
 
 class NetworkGameView : public IGameView
 {
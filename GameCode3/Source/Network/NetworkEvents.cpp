@@ -0,0 +1,402 @@
+//========================================================================
+// NetworkEvents.cpp : Events on the wire
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventWire					- not in the book
+//  class NetworkEventForwarder		- Chapter 16, page 617
+//  class NetworkEventBroadcaster	- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include <algorithm>
+#include <boost/make_shared.hpp>
+
+#include "NetworkEvents.h"
+#include "InterestManager.h"
+#include "Snapshot.h"
+#include "../EventManager/EventFactory.h"
+
+
+bool EventWire::s_bTextMode = false;
+
+
+//
+// EventWire::GetDecoders
+//
+//   Function statics, like the EventFactory's, so registering from a
+//   static initializer can't get there before they exist.
+//
+EventWire::DecoderTable & EventWire::GetDecoders( void )
+{
+	static DecoderTable s_Decoders;
+	return s_Decoders;
+}
+
+//
+// EventWire::GetWireIds
+//
+EventWire::WireIdList & EventWire::GetWireIds( void )
+{
+	static WireIdList s_WireIds;
+	return s_WireIds;
+}
+
+//
+// EventWire::AddDecoder
+//
+void EventWire::AddDecoder( unsigned short wireId, EventType const & eventType, Decoder decoder, NetChannel channel, eDecode decode )
+{
+	assert( wireId != kNoWireId && "Wire id 0 means no wire id!" );
+
+	DecoderTable & decoders = GetDecoders();
+	if ( wireId >= decoders.size() )
+	{
+		DecoderEntry const none = { 0, NULL, kDecodeAnywhere };
+		decoders.resize( wireId + 1, none );
+	}
+
+	DecoderEntry & entry = decoders[wireId];
+	if ( entry.m_Decoder )
+	{
+		assert( entry.m_EventType == eventType.getHashValue() && "Two event types given the same wire id!" );
+		return;
+	}
+
+	entry.m_EventType = eventType.getHashValue();
+	entry.m_Decoder = decoder;
+	entry.m_Decode = decode;
+
+	WireIdList & wireIds = GetWireIds();
+	WireIdEntry const id = { eventType.getHashValue(), wireId, channel };
+	WireIdList::iterator it = std::lower_bound( wireIds.begin(), wireIds.end(), id );
+	assert( ( it == wireIds.end() || it->m_EventType != id.m_EventType ) && "One event type given two wire ids!" );
+	wireIds.insert( it, id );
+}
+
+//
+// EventWire::FindWireId
+//
+EventWire::WireIdEntry const * EventWire::FindWireId( unsigned long eventType )
+{
+	WireIdList const & wireIds = GetWireIds();
+
+	WireIdEntry const id = { eventType, kNoWireId, NetChannel_ReliableOrdered };
+	WireIdList::const_iterator it = std::lower_bound( wireIds.begin(), wireIds.end(), id );
+	if ( it == wireIds.end() || it->m_EventType != eventType )
+		return NULL;
+
+	return &*it;
+}
+
+//
+// EventWire::GetWireId
+//
+unsigned short EventWire::GetWireId( unsigned long eventType )
+{
+	WireIdEntry const * pEntry = FindWireId( eventType );
+	return pEntry ? pEntry->m_WireId : static_cast< unsigned short >( kNoWireId );
+}
+
+//
+// EventWire::GetChannel
+//
+NetChannel EventWire::GetChannel( unsigned long eventType )
+{
+	WireIdEntry const * pEntry = FindWireId( eventType );
+	return pEntry ? pEntry->m_Channel : NetChannel_ReliableOrdered;
+}
+
+//
+// EventWire::WriteEvent
+//
+bool EventWire::WriteEvent( IEventData const & event, BinaryOutStream & out )
+{
+	if ( s_bTextMode )
+	{
+		// NetworkEventForwarder::HandleEvent		- Chapter 16, page 617
+		std::ostrstream text;
+
+		text << static_cast<int>( kMsgEvent ) << " ";
+		text << event.VGetEventType().getStr() << " ";
+		event.VSerialize( text );
+		text << "\r\n";
+
+		out.WriteBytes( text.rdbuf()->str(), static_cast<unsigned int>( text.pcount() ) );
+		text.rdbuf()->freeze( false );
+		return true;
+	}
+
+	unsigned short const wireId = GetWireId( event.VGetEventType().getHashValue() );
+	if ( wireId == kNoWireId )
+		return false;
+
+	out.WriteU8( kMsgEvent );
+	out.WriteU16( wireId );
+	event.VSerializeBinary( out );
+	return true;
+}
+
+//
+// EventWire::WritePlayerLoginOk
+//
+void EventWire::WritePlayerLoginOk( int serverSockId, int actorId, BinaryOutStream & out )
+{
+	if ( s_bTextMode )
+	{
+		// NetworkGameView::VOnAttach				- Chapter 16, page 619
+		std::ostrstream text;
+
+		text << static_cast<int>( kMsgPlayerLoginOk ) << " ";
+		text << serverSockId << " ";
+		text << actorId << " ";
+		text << "\r\n";
+
+		out.WriteBytes( text.rdbuf()->str(), static_cast<unsigned int>( text.pcount() ) );
+		text.rdbuf()->freeze( false );
+		return;
+	}
+
+	out.WriteU8( kMsgPlayerLoginOk );
+	out.WriteI32( serverSockId );
+	out.WriteI32( actorId );
+}
+
+//
+// EventWire::WritePing
+//
+void EventWire::WritePing( eMessage kind, unsigned int stamp, BinaryOutStream & out )
+{
+	out.WriteU8( static_cast< unsigned char >( kind ) );
+	out.WriteU32( stamp );
+}
+
+//
+// EventWire::ReadEvent
+//
+IEventDataPtr EventWire::ReadEvent( BinaryInStream & in )
+{
+	unsigned short const wireId = in.ReadU16();
+
+	DecoderTable const & decoders = GetDecoders();
+	if ( !in.IsOk() || wireId >= decoders.size() || !decoders[wireId].m_Decoder )
+		return IEventDataPtr();
+
+	IEventDataPtr event = ( *decoders[wireId].m_Decoder )( in );
+	if ( !in.IsOk() )
+		return IEventDataPtr();
+
+	return event;
+}
+
+//
+// EventWire::ReadEvent
+//
+//   This was RemoteEventSocket::CreateEvent(), with a string compare
+//   for every event type, in the book.
+//
+IEventDataPtr EventWire::ReadEvent( std::istrstream & in )
+{
+	std::string eventType;
+	in >> eventType;
+
+	unsigned long const hash = reinterpret_cast<unsigned long>( HashedString::hash_name( eventType.c_str() ) );
+	return EventFactory::CreateFromStream( hash, in );
+}
+
+//
+// EventWire::ReadEvent
+//
+IEventDataPtr EventWire::ReadEvent( char const * pData, unsigned int size )
+{
+	if ( IsBinaryMessage( pData, size ) )
+	{
+		BinaryInStream in( pData, size );
+		in.ReadU8();
+		return ReadEvent( in );
+	}
+
+	std::istrstream in( pData, size );
+	int kind;
+	in >> kind;
+	return ReadEvent( in );
+}
+
+//
+// EventWire::DecodesOnGameThread
+//
+bool EventWire::DecodesOnGameThread( char const * pData, unsigned int size )
+{
+	if ( !IsBinaryMessage( pData, size ) )
+		return true;
+
+	BinaryInStream in( pData, size );
+	in.ReadU8();
+	unsigned short const wireId = in.ReadU16();
+
+	DecoderTable const & decoders = GetDecoders();
+	return in.IsOk() && wireId < decoders.size() && decoders[wireId].m_Decode == kDecodeOnGameThread;
+}
+
+
+//
+// EventWire::CreatePacket
+//
+shared_ptr< IPacket > EventWire::CreatePacket( IEventData const & event, BinaryOutStream & scratch )
+{
+	scratch.Clear();
+	if ( !WriteEvent( event, scratch ) )
+	{
+		// the other end couldn't rebuild it anyway
+		return shared_ptr< IPacket >();
+	}
+
+	if ( scratch.GetSize() + sizeof(u_long) > MAX_PACKET_SIZE )
+	{
+		// the other end would drop the connection over it
+		char debugMessage[256];
+		_snprintf( debugMessage, sizeof(debugMessage)-1, "EventWire: %s is too big to send\n", event.VGetEventType().getStr().c_str() );
+		debugMessage[sizeof(debugMessage)-1] = 0;
+		OutputDebugStringA( debugMessage );
+		return shared_ptr< IPacket >();
+	}
+
+	// one allocation for the packet and its count - the bytes come
+	// from the PacketPool
+	return boost::make_shared< BinaryPacket >( scratch.GetData(), static_cast< u_long >( scratch.GetSize() ) );
+}
+
+
+//
+// NetworkEventForwarder::HandleEvent			- Chapter 16, page 617
+//
+//   Never eats the event - the book's returned true, so a queued
+//   event only ever reached the first of several forwarders.
+//
+bool NetworkEventForwarder::HandleEvent( IEventData const & event )
+{
+	unsigned int actorId;
+	if ( m_pInterest && event.VGetInterestActor( actorId ) && !m_pInterest->IsRelevant( m_sockId, actorId ) )
+		return false;
+
+	assert( ( !m_bParallelSafe || g_pSocketManager->IsThreaded() ) && "A parallel-safe forwarder needs the socket manager's thread!" );
+
+	shared_ptr< IPacket > eventMsg = EventWire::CreatePacket( event, m_Out );
+	if ( eventMsg )
+		g_pSocketManager->Send( m_sockId, eventMsg, EventWire::GetChannel( event.VGetEventType().getHashValue() ) );
+
+	return false;
+}
+
+
+//
+// NetworkEventBroadcaster::AddSocket
+//
+void NetworkEventBroadcaster::AddSocket( int sockId )
+{
+	if ( std::find( m_SockIds.begin(), m_SockIds.end(), sockId ) == m_SockIds.end() )
+		m_SockIds.push_back( sockId );
+}
+
+//
+// NetworkEventBroadcaster::RemoveSocket
+//
+void NetworkEventBroadcaster::RemoveSocket( int sockId )
+{
+	std::vector< int >::iterator it = std::find( m_SockIds.begin(), m_SockIds.end(), sockId );
+	if ( it != m_SockIds.end() )
+		m_SockIds.erase( it );
+
+	ForgetClient( sockId );
+}
+
+//
+// NetworkEventBroadcaster::ForgetClient
+//
+//   Nothing else finds out a remote player's gone, so it's done here.
+//
+void NetworkEventBroadcaster::ForgetClient( int sockId )
+{
+	if ( m_pInterest )
+		m_pInterest->RemoveClient( sockId );
+	if ( m_pSnapshots )
+		m_pSnapshots->RemoveClient( sockId );
+}
+
+//
+// NetworkEventBroadcaster::HandleEvent
+//
+bool NetworkEventBroadcaster::HandleEvent( IEventData const & event )
+{
+	if ( m_SockIds.empty() )
+		return false;
+
+	unsigned int actorId;
+	bool const bScoped = m_pInterest && event.VGetInterestActor( actorId );
+
+	shared_ptr< IPacket > eventMsg;
+	NetChannel const channel = EventWire::GetChannel( event.VGetEventType().getHashValue() );
+
+	unsigned int kept = 0;
+	for ( unsigned int i = 0; i < m_SockIds.size(); ++i )
+	{
+		int const sockId = m_SockIds[i];
+		m_SockIds[kept++] = sockId;
+
+		if ( bScoped && !m_pInterest->IsRelevant( sockId, actorId ) )
+			continue;
+
+		if ( !eventMsg )
+		{
+			// written out the first time someone wants it - nobody's
+			// been dropped yet if it can't be
+			eventMsg = EventWire::CreatePacket( event, m_Out );
+			if ( !eventMsg )
+				return false;
+		}
+
+		if ( !g_pSocketManager->Send( sockId, eventMsg, channel ) )
+		{
+			--kept;
+			ForgetClient( sockId );
+		}
+	}
+	m_SockIds.resize( kept );
+
+	return false;
+}
@@ -0,0 +1,298 @@
+#pragma once
+//========================================================================
+// NetworkEvents.h : Events on the wire
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class EventWire					- not in the book
+//  class NetworkEventForwarder		- Chapter 16, page 617
+//  class NetworkEventBroadcaster	- not in the book
+//========================================================================
+
+// How events are written to and read from the network, and the
+// listeners that send them. Like SocketManager.h, nothing here knows
+// about the game, so it builds headless too.
+
+#include <strstream>
+#include <vector>
+
+#include "SocketManager.h"
+#include "../EventManager/EventManager.h"
+
+class InterestManager;
+class SnapshotReplicator;
+
+
+////////////////////////////////////////////////////
+//
+// EventWire Description
+//
+//   Every packet a RemoteEventSocket gets starts with what kind of
+//   message it is. In binary form an event message is
+//
+//		u8		kMsgEvent
+//		u16		the event type's wire id
+//		...		the event's VSerializeBinary() bytes
+//
+//   Wire ids are small numbers given to each event type that goes
+//   over the network - the same at both ends - and the decoder for
+//   each is found by indexing a table with it:
+//
+//		EventWire::Register< EvtData_Move_Actor >( 3 );
+//
+//   next to where the type is registered with the EventFactory. The
+//   event class needs the same constructor taking a BinaryInStream
+//   that the EventFactory does. Ids below kFirstGameWireId are for
+//   the engine's events, the rest for the game's.
+//
+//   The type's NetChannel goes with it - reliable and ordered unless
+//   it's something like a position, where only the newest matters
+//   and a lost one is soon replaced. Only a UdpSocket makes any
+//   difference between them.
+//
+//   A message is read as soon as it arrives, on the socket manager's
+//   network thread if it has one. Types whose constructor makes Lua
+//   tables are registered kDecodeOnGameThread instead - a Lua state
+//   belongs to its game's thread - and their messages are left whole
+//   until they're handed over to it:
+//
+//		EventWire::Register< EvtData_UpdateActorParams >( 70,
+//			NetChannel_ReliableOrdered, EventWire::kDecodeOnGameThread );
+//
+//   Text mode is the book's protocol - the message kind, the event's
+//   name and its VSerialize() text - and is only there for debugging.
+//   A text message starts with a digit and a binary one with a byte
+//   below it, so a reader takes either whatever the sender was set to.
+//
+////////////////////////////////////////////////////
+
+class EventWire
+{
+public:
+	enum eMessage
+	{
+		kMsgEvent,
+		kMsgPlayerLoginOk,
+		kMsgSnapshot,					// see SnapshotReplicator
+		kMsgSnapshotAck,
+		kMsgPing,						// u32 the sender's timeGetTime()
+		kMsgPong,						// u32 the same, sent straight back
+		kMsgCompressed,					// another message, deflated - see NetCompressor
+	};
+
+	enum
+	{
+		kNoWireId = 0,
+		kFirstGameWireId = 64,
+	};
+
+	enum eDecode
+	{
+		kDecodeAnywhere,
+		kDecodeOnGameThread,			// it makes Lua tables
+	};
+
+	typedef IEventDataPtr (*Decoder)( BinaryInStream & in );
+
+	template <class T>
+	static void Register( unsigned short wireId, NetChannel channel = NetChannel_ReliableOrdered, eDecode decode = kDecodeAnywhere )
+	{
+		AddDecoder( wireId, T::sk_EventType, &DecodeFor<T>, channel, decode );
+	}
+
+	// kNoWireId if the type isn't registered.
+	static unsigned short GetWireId( unsigned long eventType );
+
+	// NetChannel_ReliableOrdered if the type isn't registered.
+	static NetChannel GetChannel( unsigned long eventType );
+
+	// The debug option - send text instead of binary.
+	static void SetTextMode( bool bText ) { s_bTextMode = bText; }
+	static bool IsTextMode( void ) { return s_bTextMode; }
+
+	static bool IsBinaryMessage( char const * pData, unsigned int size )
+	{
+		return size > 0 && static_cast<unsigned char>( pData[0] ) < '0';
+	}
+
+	// Writes a whole kMsgEvent message, in whichever form is set.
+	// Returns false if the event can't be sent in binary because its
+	// type has no wire id.
+	static bool WriteEvent( IEventData const & event, BinaryOutStream & out );
+
+	static void WritePlayerLoginOk( int serverSockId, int actorId, BinaryOutStream & out );
+
+	// A kMsgPing or kMsgPong. They're always binary - a reader in
+	// text mode takes either.
+	static void WritePing( eMessage kind, unsigned int stamp, BinaryOutStream & out );
+
+	// The whole event message as a packet, ready to Send() to as
+	// many sockets as want it - empty if it can't be sent. 'scratch'
+	// is where it's written first; keep one around to reuse.
+	static shared_ptr< IPacket > CreatePacket( IEventData const & event, BinaryOutStream & scratch );
+
+	// Rebuild an event from a message with its kind already read -
+	// binary or text. Empty if the type is unknown or the message
+	// didn't hold a whole event.
+	static IEventDataPtr ReadEvent( BinaryInStream & in );
+	static IEventDataPtr ReadEvent( std::istrstream & in );
+
+	// The same from a whole kMsgEvent message, its kind and all.
+	static IEventDataPtr ReadEvent( char const * pData, unsigned int size );
+
+	// Whether a whole kMsgEvent message has to wait for the game's own
+	// thread to be read. Text ones always do - they're only for
+	// debugging, and finding the type means reading its name.
+	static bool DecodesOnGameThread( char const * pData, unsigned int size );
+
+private:
+	template <class T>
+	static IEventDataPtr DecodeFor( BinaryInStream & in )
+	{
+		return IEventDataPtr( GCC_NEW T( in ) );
+	}
+
+	static void AddDecoder( unsigned short wireId, EventType const & eventType, Decoder decoder, NetChannel channel, eDecode decode );
+
+	struct DecoderEntry
+	{
+		unsigned long m_EventType;
+		Decoder m_Decoder;
+		eDecode m_Decode;
+	};
+
+	// indexed by wire id
+	typedef std::vector< DecoderEntry > DecoderTable;
+	static DecoderTable & GetDecoders( void );
+
+	struct WireIdEntry
+	{
+		unsigned long m_EventType;
+		unsigned short m_WireId;
+		NetChannel m_Channel;
+
+		bool operator<( WireIdEntry const & other ) const { return m_EventType < other.m_EventType; }
+	};
+
+	// event type to wire id, sorted by event type
+	typedef std::vector< WireIdEntry > WireIdList;
+	static WireIdList & GetWireIds( void );
+	static WireIdEntry const * FindWireId( unsigned long eventType );
+
+	static bool s_bTextMode;
+};
+
+
+// The only thing a network game view does is
+// act as an intermediary between the server and the 'real' remote view
+// it listens to the same messages as a a game view
+// and sends them along via TCP/IP
+//
+// With an InterestManager, events about an actor the remote player
+// is too far away to see aren't sent - see IEventData::VGetInterestActor().
+//
+// A forwarder made parallelSafe writes out queued events on the event
+// manager's worker pool - see IEventListener::IsParallelSafe(). That's
+// only for a socket manager with a thread of its own, where Send() just
+// queues the packet under the manager's lock and the PacketPool is
+// locked, and never with an InterestManager, which the game thread
+// changes as it goes.
+
+class NetworkEventForwarder : public IEventListener
+{
+public:
+	// IEventListener
+	NetworkEventForwarder(int sockId, bool parallelSafe = false) { m_sockId = sockId; m_bParallelSafe = parallelSafe; }
+	bool HandleEvent( IEventData const & event );
+	char const * GetName(void) { return "NetworkEventForwarder"; }
+	bool IsParallelSafe(void) const { return m_bParallelSafe; }
+
+	void SetInterest( shared_ptr< InterestManager > pInterest )
+	{
+		assert( !( pInterest && m_bParallelSafe ) && "A parallel-safe forwarder can't read the InterestManager!" );
+		m_pInterest = pInterest;
+	}
+
+protected:
+	int m_sockId;
+	bool m_bParallelSafe;
+	BinaryOutStream m_Out;			// reused for every event
+	shared_ptr< InterestManager > m_pInterest;
+};
+
+
+////////////////////////////////////////////////////
+//
+// NetworkEventBroadcaster Description
+//
+//   A NetworkEventForwarder for every socket in a list. Where a
+//   forwarder per client writes each event out and makes a packet
+//   of it once for every client, this does it once, and the one
+//   packet is queued on all the sockets.
+//
+//   Sockets that have gone away are dropped from the list the first
+//   time an event can't be sent to them, and their player from the
+//   InterestManager and SnapshotReplicator. With an InterestManager,
+//   sockets whose player can't see the event's actor are skipped,
+//   and if none can, the event isn't even written out.
+////////////////////////////////////////////////////
+
+class NetworkEventBroadcaster : public IEventListener
+{
+public:
+	NetworkEventBroadcaster() : m_pSnapshots(NULL) { }
+
+	void AddSocket( int sockId );
+	void RemoveSocket( int sockId );
+	bool HasSockets( void ) const { return !m_SockIds.empty(); }
+	unsigned int GetSocketCount( void ) const { return static_cast< unsigned int >( m_SockIds.size() ); }
+
+	void SetInterest( shared_ptr< InterestManager > pInterest ) { m_pInterest = pInterest; }
+	void SetSnapshots( SnapshotReplicator * pSnapshots ) { m_pSnapshots = pSnapshots; }
+
+	// IEventListener
+	bool HandleEvent( IEventData const & event );
+	char const * GetName(void) { return "NetworkEventBroadcaster"; }
+
+protected:
+	void ForgetClient( int sockId );
+
+	std::vector< int > m_SockIds;
+	BinaryOutStream m_Out;			// reused for every event
+	shared_ptr< InterestManager > m_pInterest;
+	SnapshotReplicator * m_pSnapshots;		// the game's - not owned
+};
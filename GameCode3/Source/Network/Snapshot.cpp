@@ -0,0 +1,724 @@
+//========================================================================
+// Snapshot.cpp : Actor movement replicated as delta-compressed snapshots
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  struct ActorNetState			- not in the book
+//  class Snapshot					- not in the book
+//  class SnapshotReplicator		- not in the book
+//  class SnapshotReceiver			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include <algorithm>
+#include <math.h>
+#include <boost/make_shared.hpp>
+
+#include "Snapshot.h"
+
+
+namespace
+{
+	enum
+	{
+		kPartX = 1,
+		kPartY = 2,
+		kPartZ = 4,
+		kPartRot = 8,
+
+		kMaxStep = (1 << Snapshot::kRotationBits) - 1,
+
+		// the message, up to the count of actors that follow
+		kHeaderSize = 1 + 4 + 4 + 1,
+	};
+
+	// the biggest the three smallest parts of a unit quaternion can be
+	const float kMaxPart = 0.70710678f;
+
+	void WriteVar( BinaryOutStream & out, unsigned int value )
+	{
+		while ( value >= 0x80 )
+		{
+			out.WriteU8( static_cast< unsigned char >( value | 0x80 ) );
+			value >>= 7;
+		}
+		out.WriteU8( static_cast< unsigned char >( value ) );
+	}
+
+	unsigned int ReadVar( BinaryInStream & in )
+	{
+		unsigned int value = 0;
+		for ( unsigned int shift = 0; shift < 35; shift += 7 )
+		{
+			unsigned char const byte = in.ReadU8();
+			value |= static_cast< unsigned int >( byte & 0x7f ) << shift;
+			if ( !( byte & 0x80 ) )
+				return value;
+		}
+
+		in.SetFailed();
+		return 0;
+	}
+
+	unsigned int VarSize( unsigned int value )
+	{
+		unsigned int size = 1;
+		while ( value >= 0x80 )
+		{
+			value >>= 7;
+			++size;
+		}
+		return size;
+	}
+
+	// small negative numbers to small positive ones, so they're
+	// short as vars too
+	inline unsigned int ZigZag( int value )
+	{
+		return ( static_cast< unsigned int >( value ) << 1 ) ^ static_cast< unsigned int >( value >> 31 );
+	}
+
+	inline int UnZigZag( unsigned int value )
+	{
+		return static_cast< int >( value >> 1 ) ^ -static_cast< int >( value & 1 );
+	}
+
+	// b - a, without overflowing
+	inline int Delta( int a, int b )
+	{
+		return static_cast< int >( static_cast< unsigned int >( b ) - static_cast< unsigned int >( a ) );
+	}
+
+	Snapshot::Entry const g_ZeroEntry = { 0, { 0, 0, 0 }, 0 };
+
+	unsigned char ChangedParts( Snapshot::Entry const & entry, Snapshot::Entry const & base )
+	{
+		unsigned char parts = 0;
+		if ( entry.m_Pos[0] != base.m_Pos[0] )
+			parts |= kPartX;
+		if ( entry.m_Pos[1] != base.m_Pos[1] )
+			parts |= kPartY;
+		if ( entry.m_Pos[2] != base.m_Pos[2] )
+			parts |= kPartZ;
+		if ( entry.m_Rot != base.m_Rot )
+			parts |= kPartRot;
+		return parts;
+	}
+
+	// what WriteEntry() will write, less the id
+	unsigned int EntrySize( Snapshot::Entry const & entry, Snapshot::Entry const & base, unsigned char parts )
+	{
+		unsigned int size = 1;
+		for ( int i = 0; i < 3; ++i )
+		{
+			if ( parts & ( kPartX << i ) )
+				size += VarSize( ZigZag( Delta( base.m_Pos[i], entry.m_Pos[i] ) ) );
+		}
+		if ( parts & kPartRot )
+			size += 4;
+		return size;
+	}
+
+	void WriteEntry( BinaryOutStream & out, Snapshot::Entry const & entry, Snapshot::Entry const & base, unsigned char parts )
+	{
+		out.WriteU8( parts );
+		for ( int i = 0; i < 3; ++i )
+		{
+			if ( parts & ( kPartX << i ) )
+				WriteVar( out, ZigZag( Delta( base.m_Pos[i], entry.m_Pos[i] ) ) );
+		}
+		if ( parts & kPartRot )
+			out.WriteU32( entry.m_Rot );
+	}
+}
+
+
+//-------------------------------------------------------------------
+// Snapshot Implementation
+
+//
+// Snapshot::Quantize
+//
+void Snapshot::Quantize( ActorNetState const & state, Entry & entry )
+{
+	entry.m_ActorId = state.m_ActorId;
+
+	for ( int i = 0; i < 3; ++i )
+		entry.m_Pos[i] = static_cast< int >( floorf( state.m_Pos[i] * kPositionScale + 0.5f ) );
+
+	float q[4];
+	float length = 0.0f;
+	for ( int i = 0; i < 4; ++i )
+	{
+		q[i] = state.m_Rot[i];
+		length += q[i] * q[i];
+	}
+	length = length > 0.0f ? sqrtf( length ) : 1.0f;
+
+	int largest = 0;
+	for ( int i = 1; i < 4; ++i )
+	{
+		if ( fabsf( q[i] ) > fabsf( q[largest] ) )
+			largest = i;
+	}
+
+	// q and -q are the same rotation - make the one left out positive,
+	// so only its size needs working out again
+	float const scale = ( q[largest] < 0.0f ? -1.0f : 1.0f ) / length;
+
+	unsigned int packed = largest;
+	for ( int i = 0; i < 4; ++i )
+	{
+		if ( i == largest )
+			continue;
+
+		float const part = q[i] * scale;
+		int step = static_cast< int >( floorf( ( part + kMaxPart ) / ( 2.0f * kMaxPart ) * kMaxStep + 0.5f ) );
+		if ( step < 0 )
+			step = 0;
+		else if ( step > kMaxStep )
+			step = kMaxStep;
+
+		packed = ( packed << kRotationBits ) | static_cast< unsigned int >( step );
+	}
+	entry.m_Rot = packed;
+}
+
+//
+// Snapshot::Dequantize
+//
+void Snapshot::Dequantize( Entry const & entry, ActorNetState & state )
+{
+	state.m_ActorId = entry.m_ActorId;
+
+	for ( int i = 0; i < 3; ++i )
+		state.m_Pos[i] = static_cast< float >( entry.m_Pos[i] ) / kPositionScale;
+
+	unsigned int packed = entry.m_Rot;
+	int const largest = static_cast< int >( packed >> ( 3 * kRotationBits ) );
+
+	float sum = 0.0f;
+	for ( int i = 3; i >= 0; --i )
+	{
+		if ( i == largest )
+			continue;
+
+		float const step = static_cast< float >( packed & kMaxStep );
+		packed >>= kRotationBits;
+
+		state.m_Rot[i] = step / kMaxStep * ( 2.0f * kMaxPart ) - kMaxPart;
+		sum += state.m_Rot[i] * state.m_Rot[i];
+	}
+
+	state.m_Rot[largest] = sum < 1.0f ? sqrtf( 1.0f - sum ) : 0.0f;
+}
+
+
+//-------------------------------------------------------------------
+// SnapshotReplicator Implementation
+
+//
+// SnapshotReplicator::SnapshotReplicator
+//
+SnapshotReplicator::SnapshotReplicator()
+ : m_Acks( kAckQueueSize )
+{
+	m_Tick = 0;
+	m_BytesSent = 0;
+}
+
+//
+// SnapshotReplicator::AddClient
+//
+void SnapshotReplicator::AddClient( int sockId )
+{
+	for ( unsigned int i = 0; i < m_Clients.size(); ++i )
+	{
+		if ( m_Clients[i].m_SockId == sockId )
+			return;
+	}
+
+	Client const client = { sockId, 0 };
+	m_Clients.push_back( client );
+}
+
+//
+// SnapshotReplicator::RemoveClient
+//
+void SnapshotReplicator::RemoveClient( int sockId )
+{
+	for ( unsigned int i = 0; i < m_Clients.size(); ++i )
+	{
+		if ( m_Clients[i].m_SockId == sockId )
+		{
+			m_Clients.erase( m_Clients.begin() + i );
+			return;
+		}
+	}
+}
+
+//
+// SnapshotReplicator::BeginSnapshot
+//
+void SnapshotReplicator::BeginSnapshot( void )
+{
+	if ( ++m_Tick == 0 )
+		m_Tick = 1;			// 0 is no tick at all
+
+	Snapshot & snapshot = m_History[m_Tick % kHistory];
+	snapshot.m_Tick = m_Tick;
+	snapshot.m_Entries.clear();
+}
+
+//
+// SnapshotReplicator::AddActor
+//
+void SnapshotReplicator::AddActor( ActorNetState const & state )
+{
+	Snapshot & snapshot = m_History[m_Tick % kHistory];
+	snapshot.m_Entries.push_back( Snapshot::Entry() );
+	Snapshot::Quantize( state, snapshot.m_Entries.back() );
+}
+
+//
+// SnapshotReplicator::SendSnapshot
+//
+void SnapshotReplicator::SendSnapshot( void )
+{
+	TakeAcks();
+
+	Snapshot & current = m_History[m_Tick % kHistory];
+
+	// the game's ActorMap is already in id order, so this costs
+	// nothing there
+	std::sort( current.m_Entries.begin(), current.m_Entries.end() );
+
+	m_Packets.clear();
+
+	unsigned int kept = 0;
+	for ( unsigned int i = 0; i < m_Clients.size(); ++i )
+	{
+		Client const & client = m_Clients[i];
+
+		// a tick that's gone from the history is as good as none
+		unsigned int baseTick = client.m_AckedTick;
+		if ( baseTick && m_History[baseTick % kHistory].m_Tick != baseTick )
+			baseTick = 0;
+
+		shared_ptr< IPacket > packet;
+		for ( unsigned int p = 0; p < m_Packets.size(); ++p )
+		{
+			if ( m_Packets[p].first == baseTick )
+			{
+				packet = m_Packets[p].second;
+				break;
+			}
+		}
+
+		if ( !packet )
+		{
+			Encode( current, baseTick ? &m_History[baseTick % kHistory] : NULL );
+			packet = boost::make_shared< BinaryPacket >( m_Out.GetData(), static_cast< u_long >( m_Out.GetSize() ) );
+			m_Packets.push_back( std::make_pair( baseTick, packet ) );
+		}
+
+		if ( VSend( client.m_SockId, packet ) )
+		{
+			m_BytesSent += packet->VGetSize();
+			m_Clients[kept++] = client;
+		}
+	}
+	m_Clients.resize( kept );
+
+	// don't keep the packets until the next tick
+	m_Packets.clear();
+}
+
+//
+// SnapshotReplicator::OnAck
+//
+//   If the queue's full the ack's dropped - which costs no more than
+//   a lost one would.
+//
+void SnapshotReplicator::OnAck( int sockId, unsigned int tick )
+{
+	m_Acks.TryPush( std::make_pair( sockId, tick ) );
+}
+
+//
+// SnapshotReplicator::TakeAcks
+//
+void SnapshotReplicator::TakeAcks( void )
+{
+	std::pair< int, unsigned int > ack;
+	while ( m_Acks.TryPop( ack ) )
+	{
+		// nothing newer than what's been sent, and acks that arrive
+		// out of order don't go backwards
+		unsigned int const tick = ack.second;
+		if ( tick == 0 || tick > m_Tick )
+			continue;
+
+		for ( unsigned int i = 0; i < m_Clients.size(); ++i )
+		{
+			if ( m_Clients[i].m_SockId == ack.first )
+			{
+				if ( tick > m_Clients[i].m_AckedTick )
+					m_Clients[i].m_AckedTick = tick;
+				break;
+			}
+		}
+	}
+}
+
+//
+// SnapshotReplicator::VSend
+//
+bool SnapshotReplicator::VSend( int sockId, shared_ptr< IPacket > packet )
+{
+	return g_pSocketManager->Send( sockId, packet, NetChannel_UnreliableSequenced );
+}
+
+//
+// SnapshotReplicator::Encode
+//
+void SnapshotReplicator::Encode( Snapshot const & current, Snapshot const * pBaseline )
+{
+	Snapshot::EntryList const & entries = current.m_Entries;
+
+	// what's changed and what's gone, walking the two lists together
+	m_Changes.clear();
+	m_Removed.clear();
+
+	Snapshot::EntryList::const_iterator base, baseEnd;
+	if ( pBaseline )
+	{
+		base = pBaseline->m_Entries.begin();
+		baseEnd = pBaseline->m_Entries.end();
+	}
+
+	for ( unsigned int i = 0; i < entries.size(); ++i )
+	{
+		Snapshot::Entry const & entry = entries[i];
+
+		if ( pBaseline )
+		{
+			for ( ; base != baseEnd && base->m_ActorId < entry.m_ActorId; ++base )
+				m_Removed.push_back( base->m_ActorId );
+		}
+
+		Snapshot::Entry const & was = ( pBaseline && base != baseEnd && base->m_ActorId == entry.m_ActorId ) ? *base : g_ZeroEntry;
+		unsigned char const parts = ChangedParts( entry, was );
+
+		// something new with nothing to say - say so anyway, so the
+		// client knows it's there
+		if ( parts || &was == &g_ZeroEntry )
+		{
+			Change const change = { i, parts, EntrySize( entry, was, parts ) };
+			m_Changes.push_back( change );
+		}
+
+		if ( &was != &g_ZeroEntry )
+			++base;
+	}
+
+	if ( pBaseline )
+	{
+		for ( ; base != baseEnd; ++base )
+			m_Removed.push_back( base->m_ActorId );
+	}
+
+	// how much fits
+	unsigned int size = sizeof( u_long ) + kHeaderSize + VarSize( static_cast< unsigned int >( m_Removed.size() ) );
+	unsigned int lastId = 0;
+	for ( unsigned int i = 0; i < m_Removed.size(); ++i )
+	{
+		size += VarSize( m_Removed[i] - lastId );
+		lastId = m_Removed[i];
+	}
+
+	// so much has gone that saying so won't fit - send a keyframe
+	// instead, which has no removed list at all; the client drops
+	// whatever isn't in it
+	if ( pBaseline && size + VarSize( 0 ) > MAX_PACKET_SIZE )
+	{
+		Encode( current, NULL );
+		return;
+	}
+
+	unsigned int const count = static_cast< unsigned int >( m_Changes.size() );
+	unsigned int first = 0;
+	unsigned int fits = count;
+
+	unsigned int total = size + VarSize( count );
+	lastId = 0;
+	for ( unsigned int i = 0; i < count; ++i )
+	{
+		unsigned int const id = entries[m_Changes[i].m_Index].m_ActorId;
+		total += VarSize( ZigZag( Delta( lastId, id ) ) ) + m_Changes[i].m_Size;
+		lastId = id;
+	}
+
+	// a keyframe has no removed list, so the changes are what didn't fit
+	bool const bPartial = total > MAX_PACKET_SIZE && count > 0;
+	if ( bPartial )
+	{
+		// take turns at being left out
+		first = m_Tick % count;
+		size += VarSize( count );			// at most
+
+		lastId = 0;
+		for ( fits = 0; fits < count; ++fits )
+		{
+			Change const & change = m_Changes[( first + fits ) % count];
+			unsigned int const id = entries[change.m_Index].m_ActorId;
+			unsigned int const entrySize = VarSize( ZigZag( Delta( lastId, id ) ) ) + change.m_Size;
+			if ( size + entrySize > MAX_PACKET_SIZE )
+				break;
+
+			size += entrySize;
+			lastId = id;
+		}
+	}
+
+	m_Out.Clear();
+	m_Out.WriteU8( EventWire::kMsgSnapshot );
+	m_Out.WriteU32( current.m_Tick );
+	m_Out.WriteU32( pBaseline ? pBaseline->m_Tick : 0 );
+	m_Out.WriteU8( bPartial ? kPartial : 0 );
+
+	WriteVar( m_Out, static_cast< unsigned int >( m_Removed.size() ) );
+	lastId = 0;
+	for ( unsigned int i = 0; i < m_Removed.size(); ++i )
+	{
+		WriteVar( m_Out, m_Removed[i] - lastId );
+		lastId = m_Removed[i];
+	}
+
+	// the baseline's entries again, in step with the ones written
+	Snapshot::EntryList::const_iterator baseBegin;
+	if ( pBaseline )
+	{
+		baseBegin = pBaseline->m_Entries.begin();
+		baseEnd = pBaseline->m_Entries.end();
+	}
+
+	WriteVar( m_Out, fits );
+	lastId = 0;
+	for ( unsigned int i = 0; i < fits; ++i )
+	{
+		Change const & change = m_Changes[( first + i ) % count];
+		Snapshot::Entry const & entry = entries[change.m_Index];
+
+		Snapshot::Entry const * pWas = &g_ZeroEntry;
+		if ( pBaseline )
+		{
+			Snapshot::EntryList::const_iterator it = std::lower_bound( baseBegin, baseEnd, entry );
+			if ( it != baseEnd && it->m_ActorId == entry.m_ActorId )
+				pWas = &*it;
+		}
+
+		WriteVar( m_Out, ZigZag( Delta( lastId, entry.m_ActorId ) ) );
+		WriteEntry( m_Out, entry, *pWas, change.m_Parts );
+		lastId = entry.m_ActorId;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// SnapshotReceiver Implementation
+
+//
+// SnapshotReceiver::Read
+//
+bool SnapshotReceiver::Read( BinaryInStream & in, std::vector< ActorNetState > & moved, unsigned int & ackTick )
+{
+	moved.clear();
+	ackTick = 0;
+
+	unsigned int const tick = in.ReadU32();
+	unsigned int const baseTick = in.ReadU32();
+	bool const bPartial = ( in.ReadU8() & SnapshotReplicator::kPartial ) != 0;
+
+	// the channel may be unreliable - drop anything late
+	if ( !in.IsOk() || tick == 0 || tick <= m_LastApplied )
+		return false;
+
+	Snapshot const * pBaseline = NULL;
+	if ( baseTick )
+	{
+		pBaseline = &m_History[baseTick % kHistory];
+		if ( pBaseline->m_Tick != baseTick )
+			return false;		// we've lost it - wait for one against something newer
+	}
+
+	// what's gone
+	unsigned int const removedCount = ReadVar( in );
+	if ( removedCount > in.GetRemaining() )
+		return false;
+
+	m_Next.m_Tick = tick;
+	m_Next.m_Entries.clear();
+
+	Snapshot::EntryList::const_iterator base, baseEnd;
+	if ( pBaseline )
+	{
+		base = pBaseline->m_Entries.begin();
+		baseEnd = pBaseline->m_Entries.end();
+	}
+
+	unsigned int id = 0;
+	for ( unsigned int i = 0; i < removedCount; ++i )
+	{
+		id += ReadVar( in );
+		if ( !pBaseline )
+			continue;
+
+		for ( ; base != baseEnd && base->m_ActorId < id; ++base )
+			m_Next.m_Entries.push_back( *base );
+		if ( base != baseEnd && base->m_ActorId == id )
+			++base;
+	}
+
+	if ( pBaseline )
+		m_Next.m_Entries.insert( m_Next.m_Entries.end(), base, baseEnd );
+
+	// what's changed - a partial snapshot's are in no particular order
+	unsigned int const count = ReadVar( in );
+	if ( !in.IsOk() || count > in.GetRemaining() )
+		return false;
+
+	m_Changed.clear();
+	Snapshot::EntryList::iterator const nextBegin = m_Next.m_Entries.begin();
+	Snapshot::EntryList::iterator const nextEnd = m_Next.m_Entries.end();
+
+	id = 0;
+	for ( unsigned int i = 0; i < count; ++i )
+	{
+		Snapshot::Entry entry;
+		id += static_cast< unsigned int >( UnZigZag( ReadVar( in ) ) );
+		entry.m_ActorId = id;
+
+		Snapshot::EntryList::iterator it = std::lower_bound( nextBegin, nextEnd, entry );
+		Snapshot::Entry const & was = ( it != nextEnd && it->m_ActorId == id ) ? *it : g_ZeroEntry;
+
+		unsigned char const parts = in.ReadU8();
+		for ( int p = 0; p < 3; ++p )
+		{
+			entry.m_Pos[p] = was.m_Pos[p];
+			if ( parts & ( kPartX << p ) )
+				entry.m_Pos[p] = static_cast< int >( static_cast< unsigned int >( was.m_Pos[p] ) + static_cast< unsigned int >( UnZigZag( ReadVar( in ) ) ) );
+		}
+		entry.m_Rot = ( parts & kPartRot ) ? static_cast< unsigned int >( in.ReadU32() ) : was.m_Rot;
+
+		m_Changed.push_back( entry );
+	}
+
+	if ( !in.IsOk() )
+		return false;
+
+	m_LastApplied = tick;
+
+	if ( bPartial )
+	{
+		// move them, but this isn't a snapshot anything can be sent
+		// against
+		for ( unsigned int i = 0; i < m_Changed.size(); ++i )
+		{
+			moved.push_back( ActorNetState() );
+			Snapshot::Dequantize( m_Changed[i], moved.back() );
+		}
+		return !moved.empty();
+	}
+
+	// put the changes in their places - new actors at the end, then
+	// back in order
+	std::sort( m_Changed.begin(), m_Changed.end() );
+
+	unsigned int const unchanged = static_cast< unsigned int >( m_Next.m_Entries.size() );
+	for ( unsigned int i = 0; i < m_Changed.size(); ++i )
+	{
+		Snapshot::EntryList::iterator it = std::lower_bound( m_Next.m_Entries.begin(), m_Next.m_Entries.begin() + unchanged, m_Changed[i] );
+		if ( it != m_Next.m_Entries.begin() + unchanged && it->m_ActorId == m_Changed[i].m_ActorId )
+			*it = m_Changed[i];
+		else
+			m_Next.m_Entries.push_back( m_Changed[i] );
+	}
+	if ( m_Next.m_Entries.size() != unchanged )
+		std::sort( m_Next.m_Entries.begin(), m_Next.m_Entries.end() );
+
+	// what's moved is whatever's different to the last one kept - not
+	// just what's changed since the baseline, which may be older
+	Snapshot::EntryList::const_iterator last, lastEnd;
+	bool const bGotLast = m_LastTick && m_History[m_LastTick % kHistory].m_Tick == m_LastTick;
+	if ( bGotLast )
+	{
+		last = m_History[m_LastTick % kHistory].m_Entries.begin();
+		lastEnd = m_History[m_LastTick % kHistory].m_Entries.end();
+	}
+
+	for ( unsigned int i = 0; i < m_Next.m_Entries.size(); ++i )
+	{
+		Snapshot::Entry const & entry = m_Next.m_Entries[i];
+		if ( bGotLast )
+		{
+			while ( last != lastEnd && last->m_ActorId < entry.m_ActorId )
+				++last;
+			if ( last != lastEnd && last->m_ActorId == entry.m_ActorId && !ChangedParts( entry, *last ) )
+				continue;
+		}
+
+		moved.push_back( ActorNetState() );
+		Snapshot::Dequantize( entry, moved.back() );
+	}
+
+	// keep it, without giving up the storage of the one it replaces
+	std::swap( m_History[tick % kHistory], m_Next );
+	m_LastTick = tick;
+	ackTick = tick;
+	return true;
+}
+
+//
+// SnapshotReceiver::WriteAck
+//
+void SnapshotReceiver::WriteAck( unsigned int tick, BinaryOutStream & out )
+{
+	out.WriteU8( EventWire::kMsgSnapshotAck );
+	out.WriteU32( tick );
+}
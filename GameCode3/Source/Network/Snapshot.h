@@ -0,0 +1,270 @@
+#pragma once
+//========================================================================
+// Snapshot.h : Actor movement replicated as delta-compressed snapshots
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  struct ActorNetState			- not in the book
+//  class Snapshot					- not in the book
+//  class SnapshotReplicator		- not in the book
+//  class SnapshotReceiver			- not in the book
+//========================================================================
+
+// Actor movement sent as snapshots - where every actor is, once a
+// tick - instead of a Move_Actor event every time one moves. Nothing
+// here knows about Mat4x4 or the game, so it builds headless like
+// the rest of the network code; Network.h turns a matrix into an
+// ActorNetState and back.
+
+#include <vector>
+
+#include "SocketManager.h"
+#include "../Multicore/LockFreeQueue.h"
+#include "NetworkEvents.h"
+
+
+////////////////////////////////////////////////////
+//
+// ActorNetState Description
+//
+//   What a snapshot sends of an actor - where it is and which way
+//   it's facing, without the rest of its matrix.
+//
+////////////////////////////////////////////////////
+
+struct ActorNetState
+{
+	unsigned int m_ActorId;
+	float m_Pos[3];
+	float m_Rot[4];					// a unit quaternion - x, y, z, w
+};
+
+
+////////////////////////////////////////////////////
+//
+// Snapshot Description
+//
+//   Every actor's state at one tick, quantized: positions to
+//   1/kPositionScale of a unit, and rotations to the three smallest
+//   parts of the quaternion at kRotationBits each, with two bits
+//   saying which part was left out - 32 bits in all. The part left
+//   out is the biggest, so it's worked out again from the other
+//   three without losing much.
+//
+//   It's quantized before it's compared or sent, so both ends always
+//   agree on exactly what the last snapshot held.
+//
+////////////////////////////////////////////////////
+
+class Snapshot
+{
+public:
+	enum
+	{
+		kPositionScale = 512,			// steps to a world unit
+		kRotationBits = 10,
+	};
+
+	struct Entry
+	{
+		unsigned int m_ActorId;
+		int m_Pos[3];
+		unsigned int m_Rot;
+
+		bool operator<( Entry const & other ) const { return m_ActorId < other.m_ActorId; }
+	};
+
+	typedef std::vector< Entry > EntryList;
+
+	Snapshot() : m_Tick( 0 ) { }
+
+	static void Quantize( ActorNetState const & state, Entry & entry );
+	static void Dequantize( Entry const & entry, ActorNetState & state );
+
+	unsigned int m_Tick;			// 0 - there's nothing here
+	EntryList m_Entries;			// sorted by actor id
+};
+
+
+////////////////////////////////////////////////////
+//
+// SnapshotReplicator Description
+//
+//   The server end. Each tick the game hands it every actor's state,
+//   and each client gets one packet, holding only what's changed
+//   since the last snapshot that client acked:
+//
+//		u8		kMsgSnapshot
+//		u32		tick
+//		u32		the acked tick it's against - 0, against nothing
+//		u8		kPartial, or 0
+//		var		how many actors have gone
+//		...		their ids, as vars from the one before
+//		var		how many actors follow
+//		...		each one's id, as a zigzag var from the one before,
+//				and a byte with a bit for each part that's changed -
+//				the position's x, y and z, each a zigzag var from
+//				what it was, and the rotation's u32
+//
+//   'var' is 7 bits a byte, with the top bit set if there's more. An
+//   actor that's new to the client is sent against zero, which is
+//   the same as sending all of it.
+//
+//   If what's changed won't fit in MAX_PACKET_SIZE, as many actors
+//   as will are sent - starting somewhere different each tick, so
+//   none are left out for long - and the snapshot is marked
+//   kPartial. The client moves them, but doesn't keep or ack it, so
+//   the next one is still against the last whole one. If even the
+//   removed ids won't fit - a mass despawn - a keyframe is sent in
+//   their place; it has no removed list, and the client keeps only
+//   the actors in it.
+//
+//   A lost snapshot costs nothing - the next one is against whatever
+//   was acked, and holds everything since. The packets go on
+//   NetChannel_UnreliableSequenced, so over a UdpSocket nothing waits
+//   for them to be sent again. Clients with the same acked tick share
+//   the one packet.
+//
+//		replicator.BeginSnapshot();
+//		for each actor:
+//			replicator.AddActor(state);
+//		replicator.SendSnapshot();
+//
+////////////////////////////////////////////////////
+
+class SnapshotReplicator
+{
+public:
+	enum
+	{
+		kHistory = 32,				// ticks a client can go without acking and still get a delta
+		kPartial = 1,
+		kAckQueueSize = 1024,
+	};
+
+	SnapshotReplicator();
+	virtual ~SnapshotReplicator() { }
+
+	void AddClient( int sockId );
+	void RemoveClient( int sockId );
+	bool HasClients( void ) const { return !m_Clients.empty(); }
+	unsigned int GetClientCount( void ) const { return static_cast< unsigned int >( m_Clients.size() ); }
+
+	void BeginSnapshot( void );
+	void AddActor( ActorNetState const & state );
+	void SendSnapshot( void );
+
+	// From a client's kMsgSnapshotAck. It can come from the socket
+	// manager's network thread - it's only queued, and taken at the
+	// next SendSnapshot().
+	void OnAck( int sockId, unsigned int tick );
+
+	unsigned int GetTick( void ) const { return m_Tick; }
+	unsigned long GetBytesSent( void ) const { return m_BytesSent; }
+
+protected:
+	// Writes the kMsgSnapshot message for 'current' against
+	// 'pBaseline', which can be NULL, into m_Out.
+	void Encode( Snapshot const & current, Snapshot const * pBaseline );
+
+	// Sends on NetChannel_UnreliableSequenced. False if the socket's
+	// gone, and the client is dropped.
+	virtual bool VSend( int sockId, shared_ptr< IPacket > packet );
+
+	void TakeAcks( void );
+
+	struct Client
+	{
+		int m_SockId;
+		unsigned int m_AckedTick;
+	};
+
+	struct Change
+	{
+		unsigned int m_Index;			// in the current snapshot's entries
+		unsigned char m_Parts;
+		unsigned int m_Size;
+	};
+
+	Snapshot m_History[kHistory];
+	unsigned int m_Tick;
+	std::vector< Client > m_Clients;
+	LockFreeQueue< std::pair< int, unsigned int > > m_Acks;
+
+	// reused for every packet
+	BinaryOutStream m_Out;
+	std::vector< Change > m_Changes;
+	std::vector< unsigned int > m_Removed;
+	std::vector< std::pair< unsigned int, shared_ptr< IPacket > > > m_Packets;
+
+	unsigned long m_BytesSent;
+};
+
+
+////////////////////////////////////////////////////
+//
+// SnapshotReceiver Description
+//
+//   The client end - one for each connection to a server. It keeps
+//   the last kHistory snapshots read, which is as far back as the
+//   server will send a delta against.
+//
+////////////////////////////////////////////////////
+
+class SnapshotReceiver
+{
+public:
+	enum { kHistory = SnapshotReplicator::kHistory };
+
+	SnapshotReceiver() : m_LastTick( 0 ), m_LastApplied( 0 ) { }
+
+	// Reads a kMsgSnapshot with its kind already read. False if
+	// there's nothing to do: it's older than one already read, its
+	// baseline has gone, or it's garbled. Otherwise 'moved' holds
+	// every actor that's moved or appeared since the last one, and
+	// 'ackTick' is what to ack - 0 for a partial snapshot.
+	bool Read( BinaryInStream & in, std::vector< ActorNetState > & moved, unsigned int & ackTick );
+
+	static void WriteAck( unsigned int tick, BinaryOutStream & out );
+
+protected:
+	Snapshot m_History[kHistory];
+	Snapshot m_Next;					// read into, then swapped into m_History
+	Snapshot::EntryList m_Changed;
+	unsigned int m_LastTick;			// the newest whole one
+	unsigned int m_LastApplied;		// the newest, whole or partial
+};
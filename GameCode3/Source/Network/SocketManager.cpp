@@ -0,0 +1,1648 @@
+//========================================================================
+// SocketManager.cpp : Packets, sockets and the socket manager
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+// 
+//  class TextPacket				- Chapter 16, page 607
+//  class PacketPool				- not in the book
+//  class NetSocket					- Chapter 16, page 590
+//  class NetListenSocket			- Chapter 16, page 599
+//  class BaseSocketManager			- Chapter 16, page 601
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <assert.h>
+#include <algorithm>
+#include "SocketManager.h"
+#include "NetworkEvents.h"
+#include "../EventManager/EventManager.h"
+#include "../Multicore/CriticalSection.h"
+
+#ifdef WIN32
+#pragma comment(lib, "Ws2_32")
+#endif
+
+#define EXIT_ASSERT assert(0);
+
+const char *BinaryPacket::g_Type = "BinaryPacket";
+const char *TextPacket::g_Type = "TextPacket";
+
+PacketPool::Block *PacketPool::s_pFree = NULL;
+unsigned int PacketPool::s_BlocksInUse = 0;
+bool PacketPool::s_bLocked = false;
+
+static CriticalSection s_PacketPoolLock;
+
+
+BaseSocketManager *g_pSocketManager = NULL;
+
+
+////////////////////////////////////////////////////
+//
+// WakeSocket Description
+//
+//   Wakes the network thread up from its poll, so packets the game
+//   thread has queued go now rather than when the poll times out. It's
+//   a UDP socket on the loopback, connected to itself: Wake() sends
+//   it a byte, and the poller sees it readable like any other socket,
+//   select or epoll alike.
+//
+////////////////////////////////////////////////////
+
+class WakeSocket : public NetSocket
+{
+public:
+	WakeSocket();
+
+	bool IsOpen() const { return m_sock != INVALID_SOCKET; }
+
+	// Any thread - only the first since the last HandleInput() sends
+	// anything.
+	void Wake();
+
+	virtual void HandleInput();
+	virtual int  HasOutput() { return 0; }
+
+private:
+	volatile LONG m_bWoken;
+};
+
+
+//
+// TextPacket::TextPacket			- Chapter 16, page 607
+//
+TextPacket::TextPacket(char const * const text)
+ :BinaryPacket(static_cast<u_long>(strlen(text) + 2))
+{ 
+	MemCpy(text, strlen(text), 0);
+	MemCpy("\r\n", 2, 2);
+	*(u_long *)m_Data = 0;
+}
+
+
+//-------------------------------------------------------------------
+// PacketPool Implementation
+
+//
+// PacketPool::Alloc
+//
+char *PacketPool::Alloc(u_long size)
+{
+	if (size > kBlockSize)
+		return GCC_NEW char[size];
+
+	if (s_bLocked)
+	{
+		ScopedCriticalSection locked(s_PacketPoolLock);
+		return AllocBlock();
+	}
+	return AllocBlock();
+}
+
+//
+// PacketPool::Free
+//
+void PacketPool::Free(char *pData, u_long size)
+{
+	if (!pData)
+		return;
+
+	if (size > kBlockSize)
+	{
+		delete [] pData;
+		return;
+	}
+
+	if (s_bLocked)
+	{
+		ScopedCriticalSection locked(s_PacketPoolLock);
+		FreeBlock(pData);
+		return;
+	}
+	FreeBlock(pData);
+}
+
+//
+// PacketPool::AllocBlock
+//
+char *PacketPool::AllocBlock()
+{
+	if (!s_pFree)
+	{
+		// the chunk is never freed - its blocks live on the free list
+		char *pChunk = GCC_NEW char[kBlockSize * kBlocksPerChunk];
+		for (int i = kBlocksPerChunk - 1; i >= 0; --i)
+		{
+			Block *pBlock = reinterpret_cast<Block *>(pChunk + i * kBlockSize);
+			pBlock->m_pNext = s_pFree;
+			s_pFree = pBlock;
+		}
+	}
+
+	Block *pBlock = s_pFree;
+	s_pFree = pBlock->m_pNext;
+	++s_BlocksInUse;
+	return reinterpret_cast<char *>(pBlock);
+}
+
+//
+// PacketPool::FreeBlock
+//
+void PacketPool::FreeBlock(char *pData)
+{
+	Block *pBlock = reinterpret_cast<Block *>(pData);
+	pBlock->m_pNext = s_pFree;
+	s_pFree = pBlock;
+	--s_BlocksInUse;
+}
+
+
+//-------------------------------------------------------------------
+// NetSocket Implementation
+
+//
+// NetSocket::NetSocket				- Chapter 16, page 591
+//
+NetSocket::NetSocket() 
+{ 
+	m_sock = INVALID_SOCKET;
+	m_deleteFlag = 0;
+	m_sendOfs = 0;
+	m_timeOut = 0;
+
+	m_recvOfs = m_recvBegin = 0;
+	m_internal = 0;
+	m_bBinaryProtocol = 1;
+
+	m_PollReady = 0;
+	m_bPollActive = false;
+}
+
+
+//
+// NetSocket::NetSocket				- Chapter 16, page 591
+//
+NetSocket::NetSocket(SOCKET new_sock, unsigned int hostIP)
+{
+	m_sock = INVALID_SOCKET;
+	m_deleteFlag = 0;
+	m_sendOfs = 0;
+	m_timeOut = 0;
+
+	m_bBinaryProtocol = 1;
+
+	m_recvOfs = m_recvBegin = 0;
+	m_internal = 0;
+
+	m_PollReady = 0;
+	m_bPollActive = false;
+
+	m_timeCreated = timeGetTime();
+
+	m_sock = new_sock;
+	m_ipaddr = hostIP;
+
+	m_internal = g_pSocketManager->IsInternal(m_ipaddr);
+
+#ifdef SO_DONTLINGER
+	setsockopt (m_sock, SOL_SOCKET, SO_DONTLINGER, NULL, 0);
+#endif
+
+#ifdef SO_NOSIGPIPE
+	int x = 1;
+	setsockopt(m_sock, SOL_SOCKET, SO_NOSIGPIPE, (char *)&x, sizeof(x));
+#endif
+
+	if (m_ipaddr)
+	{
+		const char *ansiIpaddress = g_pSocketManager->GetHostByAddr(m_ipaddr);
+		if (ansiIpaddress)
+		{
+			char buffer[128];
+			_snprintf(buffer, sizeof(buffer)-1, "User connected: %s %s\n", ansiIpaddress, (m_internal) ? "(internal)" : "");
+			buffer[sizeof(buffer)-1] = 0;
+			OutputDebugStringA(buffer);
+		}
+	}
+}
+
+
+//
+// NetSocket::~NetSocket				- Chapter 16, page 593
+//
+NetSocket::~NetSocket() 
+{
+	if (m_sock != INVALID_SOCKET) 
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+	}
+ }
+
+
+
+//
+// NetSocket::Connect				- Chapter 16, page 593
+//
+bool NetSocket::Connect(unsigned int ip, unsigned int port, int fCoalesce) 
+{
+	struct sockaddr_in sa;
+	int x = 1;
+
+	if ((m_sock = socket(PF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET)
+		return false;
+
+	if (!fCoalesce)
+	{
+		setsockopt(m_sock, IPPROTO_TCP, TCP_NODELAY, (char *)&x, sizeof(x));
+	}
+
+	//	setsockopt(m_sock, SOL_SOCKET, SO_KEEPALIVE, (char *)&x, sizeof(x));
+
+#ifdef SO_NOSIGPIPE
+	setsockopt(m_sock, SOL_SOCKET, SO_NOSIGPIPE, (char *)&x, sizeof(x));
+#endif
+
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(ip);
+	sa.sin_port = htons(port);
+
+	if (connect(m_sock, (struct sockaddr *)&sa, sizeof(sa))) 
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		return false;
+	}
+
+	return true;
+ }
+
+//
+// NetSocket::Send							- Chapter 16, page 594
+//
+void NetSocket::Send(shared_ptr<IPacket> pkt, bool clearTimeOut)
+{
+	if (clearTimeOut)
+		m_timeOut = 0;
+
+	bool const wasEmpty = m_OutList.empty();
+	m_OutList.push_back(pkt);
+	m_Stats.Queued(pkt->VGetSize());
+
+	if (wasEmpty)
+		OutputQueued();
+}
+
+//
+// NetSocket::OutputQueued
+//
+void NetSocket::OutputQueued()
+{
+	if (!g_pSocketManager)
+		return;
+
+	g_pSocketManager->m_OutputQueued.push_back(m_id);
+	if (g_pSocketManager->m_pPoller)
+		g_pSocketManager->m_pPoller->VOutputQueued(this);
+}
+
+//
+// NetSocket::SetBlocking				- Chapter 16, page 594
+//
+void NetSocket::SetBlocking(int block) 
+{
+	#ifdef WIN32
+		unsigned long val = block ? 0 : 1;
+		ioctlsocket(m_sock, FIONBIO, &val);
+	#else
+		int val = fcntl(m_sock, F_GETFL, 0);
+		if (block)
+			val &= ~(O_NONBLOCK);
+		else
+			val |= O_NONBLOCK;
+
+		fcntl(m_sock, F_SETFL, val);
+	#endif
+}
+
+
+//
+// NetSocket::HandleOutput				- Chapter 16, page 595
+//
+//   The book sent one packet per send(). Now up to MAX_SEND_BUFFERS
+//   queued packets go in one gathered send, and m_sendOfs is how much
+//   of the first of them went out last time.
+//
+void NetSocket::HandleOutput() 
+{
+	int fSent = 0;
+	do 
+	{
+		assert(!m_OutList.empty());
+
+#ifdef WIN32
+		WSABUF buffers[MAX_SEND_BUFFERS];
+#else
+		struct iovec buffers[MAX_SEND_BUFFERS];
+#endif
+		int count = 0;
+		int ofs = m_sendOfs;
+
+		for (PacketQueue::iterator i = m_OutList.begin(); i != m_OutList.end() && count < MAX_SEND_BUFFERS; ++i)
+		{
+			char *buf = const_cast<char *>((*i)->VGetData()) + ofs;
+			u_long len = (*i)->VGetSize() - ofs;
+#ifdef WIN32
+			buffers[count].buf = buf;
+			buffers[count].len = len;
+#else
+			buffers[count].iov_base = buf;
+			buffers[count].iov_len = len;
+#endif
+			++count;
+			ofs = 0;
+		}
+
+#ifdef WIN32
+		DWORD sent = 0;
+		int rc = (WSASend(m_sock, buffers, count, &sent, 0, NULL, NULL) == 0) ? static_cast<int>(sent) : SOCKET_ERROR;
+#else
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = buffers;
+		msg.msg_iovlen = count;
+		int rc = static_cast<int>(sendmsg(m_sock, &msg, MSG_NOSIGNAL));
+#endif
+
+		if (rc > 0) 
+		{
+			g_pSocketManager->m_Outbound += rc;
+			m_Stats.Sent(rc, timeGetTime());
+			m_Stats.Dequeued(rc);
+			fSent = 1;
+
+			// take off what went - the last of it may only have gone part way
+			while (rc > 0)
+			{
+				int const left = static_cast<int>(m_OutList.front()->VGetSize()) - m_sendOfs;
+				if (rc < left)
+				{
+					m_sendOfs += rc;
+					break;
+				}
+
+				rc -= left;
+				m_sendOfs = 0;
+				m_OutList.pop_front();
+				++m_Stats.m_PacketsOut;
+			}
+		}
+		else if (WSAGetLastError() != WSAEWOULDBLOCK)
+		{
+			HandleException();
+			fSent = 0;
+		}
+		else
+		{
+			// the send buffer is full - wait to be told there's room
+			m_PollReady &= ~ISocketPoller::kWritable;
+			m_Stats.SendBlocked(timeGetTime());
+			fSent = 0;
+		}
+
+	} while ( fSent && !m_OutList.empty() );
+}
+
+
+
+//
+// NetSocket::HandleInput				- Chapter 16, page 596
+//
+//   m_recvBuf is a ring, and whole packets are handed to HandlePacket()
+//   right where they arrived - nothing is allocated, and nothing is
+//   copied except a packet that wraps past the end of the ring, which
+//   is put back together in the spare bytes after it.
+//
+void NetSocket::HandleInput() 
+{
+	if (m_recvOfs == 0)
+		m_recvBegin = 0;
+
+	// read into the free part of the ring, as far as the end of it
+	unsigned int recvEnd = m_recvBegin + m_recvOfs;
+	if (recvEnd >= RECV_BUFFER_SIZE)
+		recvEnd -= RECV_BUFFER_SIZE;
+
+	unsigned int room = RECV_BUFFER_SIZE - m_recvOfs;
+	if (room > RECV_BUFFER_SIZE - recvEnd)
+		room = RECV_BUFFER_SIZE - recvEnd;
+
+	int rc = recv(m_sock, m_recvBuf+recvEnd, room, 0);
+
+#ifdef NET_TRACE_PACKETS
+	char metrics[128];
+	_snprintf(metrics, sizeof(metrics)-1, "Incoming: %6d bytes. Begin %6d Offset %4d\n", rc, m_recvBegin, m_recvOfs);
+	metrics[sizeof(metrics)-1] = 0;
+	OutputDebugStringA(metrics);
+#endif
+
+	if (rc==0)
+	{
+		// the other end has closed - there won't be any more, and
+		// anything sent would only be reset, so it goes like a socket
+		// that's failed
+		m_PollReady &= ~ISocketPoller::kReadable;
+		m_deleteFlag = 1;
+		return;
+	}
+
+	if (rc < 0)
+	{
+		if (WSAGetLastError() == WSAEWOULDBLOCK)
+		{
+			// read it all - wait to be told there's more
+			m_PollReady &= ~ISocketPoller::kReadable;
+			return;
+		}
+
+		m_deleteFlag = 1;
+		return;
+	}
+
+	g_pSocketManager->m_Inbound += rc;
+	m_Stats.Received(rc);
+	m_recvOfs += rc;
+
+	const unsigned int hdrSize = sizeof(u_long);
+
+	while (m_recvOfs > 0)
+	{
+		// no packet is bigger than MAX_PACKET_SIZE, so that much is all
+		// that ever has to be in one piece
+		unsigned int const available = (m_recvOfs < MAX_PACKET_SIZE) ? m_recvOfs : MAX_PACKET_SIZE;
+		unsigned int const toEnd = RECV_BUFFER_SIZE - m_recvBegin;
+		if (toEnd < available)
+			memcpy(m_recvBuf + RECV_BUFFER_SIZE, m_recvBuf, available - toEnd);
+
+		char const *pData = m_recvBuf + m_recvBegin;
+		u_long packetSize = 0;
+
+		// There are two types of packets at the lowest level of our design:
+		// BinaryPacket - Sends the size as a positive 4 byte integer
+		// TextPacket - Sends 0 for the size, the parser will search for a CR
+
+		if (m_bBinaryProtocol)
+		{
+			if (available < hdrSize)
+				break;
+
+			memcpy(&packetSize, pData, sizeof(packetSize));
+			packetSize = ntohl(packetSize);
+
+			if (packetSize > MAX_PACKET_SIZE || packetSize < hdrSize)
+			{
+				// prevent nasty buffer overruns!
+				HandleException();
+				return;
+			}
+
+			// we don't have enough new data to grab the next packet
+			if (m_recvOfs < packetSize)
+				break;
+
+#ifdef NET_TRACE_PACKETS
+			char trace[MAX_PACKET_SIZE + 3];
+			memcpy(trace, pData+hdrSize, packetSize-hdrSize);
+			memcpy(trace+packetSize-hdrSize, "\r\n", 3);
+			OutputDebugStringA(trace);
+#endif
+
+			PacketView packet(BinaryPacket::g_Type, pData, packetSize);
+			++m_Stats.m_PacketsIn;
+			HandlePacket(packet);
+		}
+		else
+		{
+			// the text protocol waits for a line feed
+			char const *lf = static_cast<char const *>(memchr(pData, 0x0a, available));
+			if (!lf)
+			{
+				if (available == MAX_PACKET_SIZE)
+				{
+					// a line too long to ever fit
+					HandleException();
+					return;
+				}
+				break;
+			}
+
+			packetSize = static_cast<u_long>(lf - pData) + 1;
+
+			// copied out behind a header, like a BinaryPacket, so it can
+			// end with a 0
+			char line[sizeof(u_long) + MAX_PACKET_SIZE + 1];
+			*(u_long *)line = htonl(hdrSize+packetSize);
+			memcpy(line+hdrSize, pData, packetSize);
+			line[hdrSize+packetSize] = 0;
+
+			PacketView packet(TextPacket::g_Type, line, hdrSize+packetSize);
+			++m_Stats.m_PacketsIn;
+			HandlePacket(packet);
+		}
+
+		m_recvOfs -= packetSize;
+		m_recvBegin += packetSize;
+		if (m_recvBegin >= RECV_BUFFER_SIZE)
+			m_recvBegin -= RECV_BUFFER_SIZE;
+	}
+}
+
+
+//
+// NetSocket::HandlePacket				- not in the book
+//
+void NetSocket::HandlePacket(IPacket const &packet)
+{
+	char const *pData = packet.VGetData()+sizeof(u_long);
+	u_long size = packet.VGetSize()-sizeof(u_long);
+
+	if (!strcmp(packet.VGetType(), TextPacket::g_Type))
+		m_InList.push_back(shared_ptr<IPacket>(GCC_NEW TextPacket(pData)));
+	else
+		m_InList.push_back(shared_ptr<IPacket>(GCC_NEW BinaryPacket(pData, size)));
+}
+
+
+//-------------------------------------------------------------------
+// NetListenSocket Implementation
+
+
+
+NetListenSocket::NetListenSocket(int portnum) 
+{
+	port = 0;
+	Init(portnum);
+}
+
+
+//
+// NetListenSocket::Init				- Chapter 16, page 599
+//
+void NetListenSocket::Init(int portnum)
+{
+	struct sockaddr_in sa;
+	int x = 1;
+
+	if ((m_sock = socket(PF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET)
+	{
+		perror("NetListenSocket::Init: socket");
+		EXIT_ASSERT
+		exit(1);
+	}
+
+	if (setsockopt(m_sock, SOL_SOCKET, SO_REUSEADDR, (char *)&x, sizeof(x))== SOCKET_ERROR) 
+	{
+		perror("NetListenSocket::Init: setsockopt");
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		EXIT_ASSERT
+		exit(1);
+	}
+	
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = ADDR_ANY;
+	sa.sin_port = htons(portnum);
+
+	// bind to port
+	if (bind(m_sock, (struct sockaddr *)&sa, sizeof(sa)) == SOCKET_ERROR) 
+	{
+		perror("NetListenSocket::Init: bind");
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		EXIT_ASSERT
+		exit(1);
+	}
+
+	// set nonblocking - accept() blocks under some odd circumstances otherwise
+	SetBlocking(0);
+
+	// start listening
+	if (listen(m_sock, 256) == SOCKET_ERROR) 
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		EXIT_ASSERT
+		exit(1);
+	}
+
+	port = portnum;
+}
+
+//
+// NetListenSocket::InitScan			- added post press
+//   Opens multiple ports to listen for connections.
+//
+void NetListenSocket::InitScan(int portnum_min, int portnum_max) 
+{
+	struct sockaddr_in sa;
+	int portnum, x = 1;
+
+	if ((m_sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET)
+	{
+		EXIT_ASSERT
+		exit(1);
+	}
+
+	if (setsockopt(m_sock, SOL_SOCKET, SO_REUSEADDR, (char *)&x, sizeof(x)) == SOCKET_ERROR) 
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		EXIT_ASSERT
+		exit(1);
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	for (portnum = portnum_min; portnum < portnum_max; portnum++) 
+	{
+		sa.sin_port = htons(portnum);
+		// bind to port
+		if (bind(m_sock, (struct sockaddr *)&sa, sizeof(sa)) != SOCKET_ERROR)
+			break;
+	}
+
+	if (portnum == portnum_max) 
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		EXIT_ASSERT
+		exit(1);
+	}
+
+	// set nonblocking - accept() blocks under some odd circumstances otherwise
+	SetBlocking(0);
+
+	// start listening
+	if (listen(m_sock, 8) == SOCKET_ERROR) 
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		EXIT_ASSERT
+		exit(1);
+	}
+
+	port = portnum;
+ }
+
+//
+// NetListenSocket::AcceptConnection				- Chapter 16, page 600
+//
+SOCKET NetListenSocket::AcceptConnection(unsigned int *pAddr)
+{
+	SOCKET new_sock;
+	struct sockaddr_in sock;
+	socklen_t size;
+
+	size = sizeof(sock);
+
+	if ((new_sock = accept(m_sock, (struct sockaddr *)&sock, &size))== INVALID_SOCKET)
+	{
+		// nobody else is waiting to connect
+		m_PollReady &= ~ISocketPoller::kReadable;
+		return INVALID_SOCKET;
+	}
+
+	if (getpeername(new_sock, (struct sockaddr *)&sock, &size) == SOCKET_ERROR)
+	{
+		closesocket(new_sock);
+		return INVALID_SOCKET;
+	}
+	*pAddr = ntohl(sock.sin_addr.s_addr);
+	return new_sock;
+ }
+
+
+//-------------------------------------------------------------------
+// WakeSocket Implementation
+
+//
+// WakeSocket::WakeSocket					- not in the book
+//
+WakeSocket::WakeSocket()
+{
+	m_bWoken = 0;
+
+	m_sock = socket(PF_INET, SOCK_DGRAM, 0);
+	if (m_sock == INVALID_SOCKET)
+		return;
+
+	// bound to whatever port's free, then connected to that same port
+	struct sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sa.sin_port = 0;
+
+	socklen_t size = sizeof(sa);
+	if (   bind(m_sock, (struct sockaddr *)&sa, sizeof(sa)) == SOCKET_ERROR
+		|| getsockname(m_sock, (struct sockaddr *)&sa, &size) == SOCKET_ERROR
+		|| connect(m_sock, (struct sockaddr *)&sa, sizeof(sa)) == SOCKET_ERROR)
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		return;
+	}
+
+	SetBlocking(0);
+}
+
+//
+// WakeSocket::Wake							- not in the book
+//
+void WakeSocket::Wake()
+{
+	if (InterlockedExchange(&m_bWoken, 1) == 0)
+	{
+		char const wake = 0;
+		send(m_sock, &wake, 1, MSG_NOSIGNAL);
+	}
+}
+
+//
+// WakeSocket::HandleInput					- not in the book
+//
+//   Cleared before it's drained - a Wake() from now on sends another
+//   byte, so none is missed.
+//
+void WakeSocket::HandleInput()
+{
+	InterlockedExchange(&m_bWoken, 0);
+
+	char buffer[64];
+	while (recv(m_sock, buffer, sizeof(buffer), 0) > 0)
+		;
+	m_PollReady &= ~ISocketPoller::kReadable;
+}
+
+
+
+
+//
+// BaseSocketManager::BaseSocketManager				- Chapter 16, page 603
+//
+BaseSocketManager::BaseSocketManager() 
+{ 
+	m_Inbound = 0;
+	m_Outbound = 0;
+	m_MaxOpenSockets = 0;
+	m_SubnetMask = 0;
+	m_Subnet = 0xffffffff;
+	m_NextSocketId = 0;
+
+	m_bThreaded = false;
+	m_bQuitThread = false;
+	m_ThreadId = 0;
+	m_hThread = NULL;
+	m_ThreadPollMicroSecs = kThreadPollMicroSecs;
+	m_pWake = NULL;
+	m_pPacketsOut = NULL;
+	m_pEventsIn = NULL;
+	m_pSocketsClosed = NULL;
+	m_EventStalls = 0;
+
+	m_pPoller = CreateSocketPoller();
+	m_LastSweep = timeGetTime();
+
+	m_pGameLock = GCC_NEW CriticalSection;
+	m_pStatsLock = GCC_NEW CriticalSection;
+	m_LastStatsRoll = m_LastSweep;
+
+	g_pSocketManager = this; 
+#ifdef WIN32
+	ZeroMemory(&m_WsaData, sizeof(WSADATA)); 
+#endif
+}
+
+//
+// BaseSocketManager::~BaseSocketManager
+//
+BaseSocketManager::~BaseSocketManager()
+{
+	Shutdown();
+	SAFE_DELETE(m_pPoller);
+	SAFE_DELETE(m_pStatsLock);
+	SAFE_DELETE(m_pGameLock);
+}
+
+
+//
+// BaseSocketManager::Init						- Chapter 16, page 603
+//
+bool BaseSocketManager::Init()
+{
+#ifdef WIN32
+	int errorCode = WSAStartup(0x0202, &m_WsaData);
+	if (errorCode==0)
+		return true;
+	else
+	{
+		assert(0 && "WSAStartup failure!");
+		return false;
+	}
+#else
+	return true;
+#endif
+}
+
+
+//
+// BaseSocketManager::Shutdown					- Chapter 16, page 604
+//
+void BaseSocketManager::Shutdown()
+{
+	StopThread();
+
+	// Get rid of all those pesky kids...
+	while (!m_SockList.empty())
+	{
+		m_pPoller->VRemoveSocket(*m_SockList.begin());
+		delete *m_SockList.begin();
+		m_SockList.pop_front();
+	}
+	m_SockMap.clear();
+	m_ReadySockets.clear();
+	m_OutputQueued.clear();
+	m_HandedOver.clear();
+
+#ifdef WIN32
+	WSACleanup();
+#endif
+}
+
+//
+// BaseSocketManager::SetPoller					- not in the book
+//
+bool BaseSocketManager::SetPoller(ISocketPoller *pPoller)
+{
+	if (!m_SockList.empty())
+	{
+		assert(0 && "Set the poller before adding any sockets!");
+		return false;
+	}
+
+	SAFE_DELETE(m_pPoller);
+	m_pPoller = pPoller;
+	return true;
+}
+
+//
+// BaseSocketManager::AddSocket					- Chapter 16, page 604
+//
+int BaseSocketManager::AddSocket(NetSocket *socket) 
+{ 
+	assert(!m_bThreaded || OnNetworkThread());
+
+	socket->m_id = m_NextSocketId;
+	socket->m_Stats.m_SockId = m_NextSocketId;
+	m_SockList.push_front(socket); 
+	
+	int openSockets = static_cast<int>(m_SockList.size());
+	
+	if (openSockets > m_MaxOpenSockets)
+		++m_MaxOpenSockets;
+
+	m_SockMap[m_NextSocketId] = socket;
+	++m_NextSocketId; 
+
+	m_pPoller->VAddSocket(socket);
+
+	return socket->m_id; 
+}
+
+//
+// BaseSocketManager::RemoveSocket					- Chapter 16, page 604
+//
+void BaseSocketManager::RemoveSocket(NetSocket *socket) 
+{ 
+	// the game thread has to know, so it stops sending to it
+	if (OnNetworkThread())
+	{
+		while (!m_pSocketsClosed->TryPush(socket->m_id) && !m_bQuitThread)
+			Sleep(1);
+	}
+
+	m_pPoller->VRemoveSocket(socket);
+	m_SockList.remove(socket); 
+	m_SockMap.erase(socket->m_id);
+	SAFE_DELETE(socket);
+}
+
+//
+// BaseSocketManager::FindSocket					- Chapter 16, page 605
+//
+NetSocket *BaseSocketManager::FindSocket(int sockId)
+{
+	SocketIdMap::iterator i = m_SockMap.find(sockId);
+	if (i==m_SockMap.end())
+	{
+		return NULL;
+	}
+
+	return (*i).second;
+}
+
+
+
+int BaseSocketManager::GetIpAddress(int sockId)
+{
+	NetSocket *socket = FindSocket(sockId);
+	if (socket)
+	{
+		return socket->GetIpAddress();
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+
+
+//
+// BaseSocketManager::Send							- Chapter 16, page 605
+//
+bool BaseSocketManager::Send(int sockId, shared_ptr<IPacket> packet, NetChannel channel)
+{
+	if (m_bThreaded && !OnNetworkThread())
+		return QueuePacket(sockId, packet, channel);
+
+	NetSocket *sock = FindSocket(sockId);
+	if (!sock)
+		return false;
+	sock->SendOnChannel(packet, channel);
+	return true;
+}
+
+//
+// BaseSocketManager::DoSelect					- Chapter 16, page 605
+//
+//   With a network thread, the sockets are its business; all that's
+//   left here is to hand over what it's read.
+//
+void BaseSocketManager::DoSelect(int pauseMicroSecs, int handleInput) 
+{
+	if (m_bThreaded && !OnNetworkThread())
+	{
+		HandOver();
+		return;
+	}
+
+	Select(pauseMicroSecs, handleInput);
+}
+
+//
+// BaseSocketManager::Select					- not in the book
+//
+//   What DoSelect() was. The poller only hands back the sockets that
+//   have something to do - see SocketPoller.h - so those are all
+//   that's looked at each frame. The rest are only checked for time
+//   outs every kSweepIntervalMs.
+//
+void BaseSocketManager::Select(int pauseMicroSecs, int handleInput) 
+{
+	NetSocket *pSock;
+
+	// everything queued so far is about to be sent, or is waiting for
+	// the socket to be writable again - FlushOutput() has nothing to do
+	m_OutputQueued.clear();
+
+	if (!m_pPoller->VPoll(pauseMicroSecs, handleInput != 0, m_ReadySockets))
+	{
+		PrintError();
+		return;
+	}
+
+	// handle input, output, and exceptions
+
+	for (ReadySocketList::iterator i = m_ReadySockets.begin(); i != m_ReadySockets.end(); ++i)
+	{
+		pSock = *i;
+
+		if ((pSock->m_deleteFlag&1) || pSock->m_sock == INVALID_SOCKET)
+			continue;
+
+		if (pSock->m_PollReady & ISocketPoller::kException)
+		{
+			pSock->HandleException();
+		}
+
+		if (   !(pSock->m_deleteFlag&1) && pSock->HasOutput()
+			&& (pSock->m_PollReady & ISocketPoller::kWritable))
+		{
+			pSock->HandleOutput();
+		}
+
+		if (   handleInput
+			&& !(pSock->m_deleteFlag&1) && (pSock->m_PollReady & ISocketPoller::kReadable))
+		{
+			pSock->HandleInput();
+		}
+	}
+
+	// handle deleting any sockets - only the ones just handled can
+	// have been marked
+
+	for (ReadySocketList::iterator i = m_ReadySockets.begin(); i != m_ReadySockets.end(); ++i)
+	{
+		ReapSocket(*i);
+	}
+	m_ReadySockets.clear();
+
+	unsigned int timeNow = timeGetTime();
+
+	if (timeNow - m_LastSweep < kSweepIntervalMs)
+		return;
+
+	m_LastSweep = timeNow;
+
+	// handle time outs, and anything marked for deletion from outside
+
+	for (SocketList::iterator i = m_SockList.begin(); i != m_SockList.end(); )
+	{
+		pSock = *i;
+		++i;			// ReapSocket() might take it out of the list
+
+		if (pSock->m_timeOut) 
+		{
+			if (pSock->m_timeOut < timeNow)
+			{
+				pSock->TimeOut();
+			}
+		}
+
+		ReapSocket(pSock);
+	}
+
+	if (timeNow - m_LastStatsRoll >= kStatsWindowMs)
+	{
+		PublishStats(timeNow);
+		m_LastStatsRoll = timeNow;
+	}
+}
+
+//
+// BaseSocketManager::FlushOutput				- not in the book
+//
+void BaseSocketManager::FlushOutput()
+{
+	if (m_bThreaded && !OnNetworkThread())
+	{
+		// what's been held back, if there's room for it yet
+		ScopedCriticalSection locked(*m_pGameLock);
+		while (!m_PacketsHeld.empty() && m_pPacketsOut->TryPush(m_PacketsHeld.front()))
+			m_PacketsHeld.pop_front();
+
+		m_pWake->Wake();
+		return;
+	}
+
+	SendQueued();
+}
+
+//
+// BaseSocketManager::SendQueued				- not in the book
+//
+void BaseSocketManager::SendQueued()
+{
+	// a socket can be on the list more than once, or be gone by now
+	for (std::vector<int>::iterator i = m_OutputQueued.begin(); i != m_OutputQueued.end(); ++i)
+	{
+		NetSocket *pSock = FindSocket(*i);
+		if (!pSock || (pSock->m_deleteFlag&1) || pSock->m_sock == INVALID_SOCKET || !pSock->HasOutput())
+			continue;
+
+		// if it's full this finds out, and the poller hands it back
+		// when there's room
+		pSock->HandleOutput();
+		ReapSocket(pSock);
+	}
+	m_OutputQueued.clear();
+}
+
+//
+// BaseSocketManager::PublishStats				- not in the book
+//
+//   Rolls every socket's stats over to a new window, and copies them
+//   where any thread can read them. The copy's made outside the lock,
+//   so a reader only ever waits for a swap.
+//
+void BaseSocketManager::PublishStats(unsigned int now)
+{
+	m_StatsScratch.clear();
+	for (SocketList::iterator i = m_SockList.begin(); i != m_SockList.end(); ++i)
+	{
+		NetSocket *pSock = *i;
+		if (pSock == m_pWake)
+			continue;
+
+		pSock->m_Stats.Roll(now);
+		m_StatsScratch.push_back(pSock->m_Stats);
+	}
+
+	// new sockets go on the front of the list
+	std::reverse(m_StatsScratch.begin(), m_StatsScratch.end());
+
+	ScopedCriticalSection locked(*m_pStatsLock);
+	m_PublishedStats.swap(m_StatsScratch);
+}
+
+//
+// BaseSocketManager::GetSocketStats			- not in the book
+//
+bool BaseSocketManager::GetSocketStats(int sockId, NetSocketStats &stats) const
+{
+	ScopedCriticalSection locked(*m_pStatsLock);
+
+	for (std::vector<NetSocketStats>::const_iterator i = m_PublishedStats.begin(); i != m_PublishedStats.end(); ++i)
+	{
+		if (i->m_SockId == sockId)
+		{
+			stats = *i;
+			return true;
+		}
+	}
+	return false;
+}
+
+//
+// BaseSocketManager::GetAllSocketStats			- not in the book
+//
+void BaseSocketManager::GetAllSocketStats(std::vector<NetSocketStats> &stats) const
+{
+	ScopedCriticalSection locked(*m_pStatsLock);
+	stats = m_PublishedStats;
+}
+
+//
+// BaseSocketManager::DumpStats					- not in the book
+//
+void BaseSocketManager::DumpStats(std::string &out) const
+{
+	ScopedCriticalSection locked(*m_pStatsLock);
+
+	for (std::vector<NetSocketStats>::const_iterator i = m_PublishedStats.begin(); i != m_PublishedStats.end(); ++i)
+	{
+		i->WriteJson(out);
+		out += "\n";
+	}
+}
+
+//
+// BaseSocketManager::StartThread				- not in the book
+//
+//   pollMicroSecs is the longest the network thread waits for a
+//   socket to have something to do, and so how often time outs are
+//   checked when nothing's happening.
+//
+bool BaseSocketManager::StartThread(int pollMicroSecs)
+{
+	if (m_bThreaded)
+		return true;
+
+	WakeSocket *pWake = GCC_NEW WakeSocket;
+	if (!pWake->IsOpen())
+	{
+		SAFE_DELETE(pWake);
+		return false;
+	}
+	m_pWake = pWake;
+	AddSocket(m_pWake);
+
+	m_pPacketsOut = GCC_NEW LockFreeQueue<OutboundPacket>(kThreadQueueSize);
+	m_pEventsIn = GCC_NEW LockFreeQueue<InboundEvent>(kThreadQueueSize);
+	m_pSocketsClosed = GCC_NEW LockFreeQueue<int>(kThreadQueueSize);
+	m_ThreadPollMicroSecs = pollMicroSecs;
+	m_bQuitThread = false;
+	m_ThreadId = 0;
+
+	PacketPool::SetLocked(true);
+	m_bThreaded = true;
+
+	m_hThread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE) ThreadProc, this, 0, NULL);
+	if (!m_hThread)
+	{
+		m_bThreaded = false;
+		StopThread();
+		return false;
+	}
+
+	// the thread's id, before anything asks OnNetworkThread()
+	while (!m_ThreadId)
+		Sleep(0);
+
+	return true;
+}
+
+//
+// BaseSocketManager::StopThread				- not in the book
+//
+//   The sockets are the game thread's again, with whatever was still
+//   on its way between the two threads where it would have been
+//   without one.
+//
+void BaseSocketManager::StopThread()
+{
+	if (m_hThread)
+	{
+		m_bQuitThread = true;
+		m_pWake->Wake();
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	if (!m_pWake)
+		return;
+
+	m_bThreaded = false;
+	m_ThreadId = 0;
+
+	// there's only the one thread now - it can pop from both ends
+	TakePackets();
+	for (std::deque<OutboundPacket>::iterator i = m_PacketsHeld.begin(); i != m_PacketsHeld.end(); ++i)
+		Send(i->m_SockId, i->m_Packet, i->m_Channel);
+	m_PacketsHeld.clear();
+
+	InboundEvent in;
+	while (m_pEventsIn->TryPop(in))
+		Deliver(in);
+
+	m_ClosedIds.clear();
+
+	RemoveSocket(m_pWake);
+	m_pWake = NULL;
+
+	SAFE_DELETE(m_pPacketsOut);
+	SAFE_DELETE(m_pEventsIn);
+	SAFE_DELETE(m_pSocketsClosed);
+
+	PacketPool::SetLocked(false);
+}
+
+//
+// BaseSocketManager::OnNetworkThread			- not in the book
+//
+bool BaseSocketManager::OnNetworkThread() const
+{
+	return m_bThreaded && GetCurrentThreadId() == m_ThreadId;
+}
+
+//
+// BaseSocketManager::QueueEvent				- not in the book
+//
+void BaseSocketManager::QueueEvent(IEventDataPtr const &event, IEventManager *pTo)
+{
+	InboundEvent const in = { event, shared_ptr<IPacket>(), pTo };
+	QueueInbound(in);
+}
+
+//
+// BaseSocketManager::QueueMessage				- not in the book
+//
+//   The message is copied - it's usually still in the socket's
+//   receive buffer.
+//
+void BaseSocketManager::QueueMessage(char const *pData, unsigned int size, IEventManager *pTo)
+{
+	InboundEvent const in = { IEventDataPtr(), shared_ptr<IPacket>(GCC_NEW BinaryPacket(pData, size)), pTo };
+	QueueInbound(in);
+}
+
+//
+// BaseSocketManager::QueueInbound				- not in the book
+//
+//   If the game thread's so far behind the queue's full, this waits -
+//   and nothing more is read from any socket - until it's caught up.
+//
+void BaseSocketManager::QueueInbound(InboundEvent const &in)
+{
+	if (!OnNetworkThread())
+	{
+		Deliver(in);
+		return;
+	}
+
+	if (m_pEventsIn->TryPush(in))
+		return;
+
+	++m_EventStalls;
+	while (!m_pEventsIn->TryPush(in) && !m_bQuitThread)
+		Sleep(1);
+}
+
+//
+// BaseSocketManager::Deliver					- not in the book
+//
+//   A game's own event manager may be ticking on another thread, and
+//   its events have to be built in its own Lua state, so they're set
+//   aside for its HandOverTo().
+//
+void BaseSocketManager::Deliver(InboundEvent const &in)
+{
+	if (in.m_pTo)
+	{
+		ScopedCriticalSection locked(*m_pGameLock);
+		m_HandedOver[in.m_pTo].push_back(in);
+		return;
+	}
+
+	IEventDataPtr const event = Build(in);
+	if (event)
+		safeQueEvent(event);
+}
+
+//
+// BaseSocketManager::Build						- not in the book
+//
+//   The event, or the one its message holds - on the thread of the
+//   game it's for.
+//
+IEventDataPtr BaseSocketManager::Build(InboundEvent const &in)
+{
+	if (in.m_Event)
+		return in.m_Event;
+
+	IEventDataPtr const event = EventWire::ReadEvent(in.m_Message->VGetData() + sizeof(u_long), in.m_Message->VGetSize() - sizeof(u_long));
+	if (!event)
+		OutputDebugStringA("ERROR Unknown event type from remote\n");
+	return event;
+}
+
+//
+// BaseSocketManager::HandOverTo				- not in the book
+//
+//   Built outside the lock, so one game's events don't hold up
+//   another's Send()s.
+//
+void BaseSocketManager::HandOverTo(IEventManager *pTo)
+{
+	std::vector<InboundEvent> handedOver;
+	{
+		ScopedCriticalSection locked(*m_pGameLock);
+		InboundEventMap::iterator it = m_HandedOver.find(pTo);
+		if (it == m_HandedOver.end() || it->second.empty())
+			return;
+		handedOver.swap(it->second);
+	}
+
+	for (std::vector<InboundEvent>::const_iterator i = handedOver.begin(); i != handedOver.end(); ++i)
+	{
+		IEventDataPtr const event = Build(*i);
+		if (event)
+			pTo->VQueueEvent(event);
+	}
+}
+
+//
+// BaseSocketManager::DropHandedOver			- not in the book
+//
+void BaseSocketManager::DropHandedOver(IEventManager *pTo)
+{
+	ScopedCriticalSection locked(*m_pGameLock);
+	m_HandedOver.erase(pTo);
+}
+
+//
+// BaseSocketManager::QueuePacket				- not in the book
+//
+//   The game thread's Send(). It never waits for the network thread -
+//   once a packet's held back, so is every one after it, so they still
+//   go in order.
+//
+bool BaseSocketManager::QueuePacket(int sockId, shared_ptr<IPacket> const &packet, NetChannel channel)
+{
+	ScopedCriticalSection locked(*m_pGameLock);
+
+	// ids are never used twice, so a socket on this list is gone for good
+	if (std::binary_search(m_ClosedIds.begin(), m_ClosedIds.end(), sockId))
+		return false;
+
+	OutboundPacket const out = { sockId, packet, channel };
+	if (!m_PacketsHeld.empty() || !m_pPacketsOut->TryPush(out))
+		m_PacketsHeld.push_back(out);
+	return true;
+}
+
+//
+// BaseSocketManager::TakePackets				- not in the book
+//
+//   The network thread's end of QueuePacket().
+//
+void BaseSocketManager::TakePackets()
+{
+	OutboundPacket out;
+	while (m_pPacketsOut->TryPop(out))
+	{
+		NetSocket *pSock = FindSocket(out.m_SockId);
+		if (pSock)
+			pSock->SendOnChannel(out.m_Packet, out.m_Channel);
+	}
+}
+
+//
+// BaseSocketManager::HandOver					- not in the book
+//
+//   The game thread's end of QueueEvent() and RemoveSocket().
+//
+void BaseSocketManager::HandOver()
+{
+	{
+		ScopedCriticalSection locked(*m_pGameLock);
+		int sockId;
+		while (m_pSocketsClosed->TryPop(sockId))
+			m_ClosedIds.insert(std::upper_bound(m_ClosedIds.begin(), m_ClosedIds.end(), sockId), sockId);
+	}
+
+	InboundEvent in;
+	while (m_pEventsIn->TryPop(in))
+		Deliver(in);
+}
+
+//
+// BaseSocketManager::ThreadProc				- not in the book
+//
+//   Sends what the game's queued first, then waits in the poll until
+//   there's something to read or the game wakes it with more.
+//
+DWORD WINAPI BaseSocketManager::ThreadProc(LPVOID lpParam)
+{
+	BaseSocketManager *pManager = static_cast<BaseSocketManager *>(lpParam);
+	pManager->m_ThreadId = GetCurrentThreadId();
+
+	while (!pManager->m_bQuitThread)
+	{
+		pManager->TakePackets();
+		pManager->SendQueued();
+		pManager->Select(pManager->m_ThreadPollMicroSecs, 1);
+	}
+
+	return 0;
+}
+
+//
+// BaseSocketManager::ReapSocket				- Chapter 16, page 605
+//
+//   This was the end of DoSelect() in the book.
+//
+void BaseSocketManager::ReapSocket(NetSocket *pSock)
+{
+	if (pSock->m_deleteFlag&1) 
+	{
+		switch (pSock->m_deleteFlag) 
+		{
+			case 1:
+				g_pSocketManager->RemoveSocket(pSock);
+				break;
+			case 3:
+				pSock->m_deleteFlag = 2;
+				if (pSock->m_sock != INVALID_SOCKET) 
+				{
+					m_pPoller->VRemoveSocket(pSock);
+					closesocket(pSock->m_sock);
+					pSock->m_sock = INVALID_SOCKET;
+				}
+				break;
+		}
+	}
+}
+
+
+//
+// BaseSocketManager::IsInternal					- Chapter 16, page 609
+//
+bool BaseSocketManager::IsInternal(unsigned int ipaddr)
+{
+	bool internal = false;
+	if (m_SubnetMask)
+	{
+	    unsigned int hostSubnet = ipaddr & m_SubnetMask;
+		if (hostSubnet == m_Subnet)
+		{
+			internal = 1;
+		}
+	}
+	return internal;
+}
+
+
+//
+// BaseSocketManager::GetHostByName					- Chapter 16, page 609
+//
+unsigned int BaseSocketManager::GetHostByName(const std::string &hostName)
+{
+	struct hostent *pHostEnt; 
+    struct sockaddr_in tmpSockAddr; //placeholder for the ip address
+
+    //This will retrieve the ip details and put it into pHostEnt structure
+	pHostEnt = gethostbyname(hostName.c_str());
+
+    if(pHostEnt == NULL)
+    {
+        assert(0 && _T("Error occured"));
+        return 0;
+    }
+
+    memcpy(&tmpSockAddr.sin_addr,pHostEnt->h_addr,pHostEnt->h_length);
+	return ntohl(tmpSockAddr.sin_addr.s_addr);
+}
+
+//
+// BaseSocketManager::GetHostByAddr					- Chapter 16, page 609
+//
+const char *BaseSocketManager::GetHostByAddr(unsigned int ip)
+{
+	static char host[32];
+
+	int netip = htonl(ip);
+	struct hostent *lpHostEnt = gethostbyaddr((const char *)&netip, 4, PF_INET);
+
+	if (lpHostEnt)
+	{
+		strncpy(host, lpHostEnt->h_name, sizeof(host)-1);
+		host[sizeof(host)-1] = 0;
+		return host;
+	}
+
+	return NULL;
+}
+
+//
+// BaseSocketManager::PrintError					- not in the book
+//
+void BaseSocketManager::PrintError()
+{
+	int realError = WSAGetLastError();
+
+#ifndef WIN32
+	char buffer[256];
+	_snprintf(buffer, sizeof(buffer)-1, "SOCKET error: %s\n", strerror(realError));
+	buffer[sizeof(buffer)-1] = 0;
+	OutputDebugStringA(buffer);
+#else
+	TCHAR *reason;
+
+	switch(realError)
+	{
+		case WSANOTINITIALISED: reason = _T("A successful WSAStartup must occur before using this API."); break;
+		case WSAEFAULT: reason = _T("The Windows Sockets implementation was unable to allocated needed resources for its internal operations, or the readfds, writefds, exceptfds, or timeval parameters are not part of the user address space."); break;
+		case WSAENETDOWN: reason = _T("The network subsystem has failed."); break;
+		case WSAEINVAL: reason = _T("The timeout value is not valid, or all three descriptor parameters were NULL."); break;
+		case WSAEINTR: reason = _T("The (blocking) call was canceled via WSACancelBlockingCall."); break;
+		case WSAEINPROGRESS: reason = _T("A blocking Windows Sockets 1.1 call is in progress, or the service provider is still processing a callback function."); break;
+		case WSAENOTSOCK: reason = _T("One of the descriptor sets contains an entry which is not a socket."); break;
+		default: reason = _T("Unknown."); 
+	}
+
+	TCHAR buffer[256];
+	_tcssprintf(buffer, _T("SOCKET error: %s\n"), reason);
+	OutputDebugString(buffer);
+#endif
+}
@@ -0,0 +1,680 @@
+#pragma once
+//========================================================================
+// SocketManager.h : Packets, sockets and the socket manager
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+// 
+//  class IPacket					- Chapter 16, page 587
+//  class PacketPool				- not in the book
+//  class BinaryPacket				- Chapter 16, page 588
+//  class TextPacket				- Chapter 16, page 589
+//  class PacketView				- not in the book
+//  class PacketQueue				- not in the book
+//  class NetSocket					- Chapter 16, page 590
+//  class NetListenSocket			- Chapter 16, page 599
+//  class BaseSocketManager			- Chapter 16, page 601
+//========================================================================
+
+// The socket layer of Network.h, on its own - nothing here knows about
+// the game, so it also builds headless ( see ..\Headless ). Events read
+// off the network are only handed over to the game, never looked at.
+
+
+#include <sys/types.h>
+
+#ifdef WIN32
+
+#include <Winsock2.h>
+
+typedef int socklen_t;
+
+#else
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+// The Winsock names for what BSD sockets already have, so the code
+// reads the same everywhere.
+typedef int SOCKET;
+
+#define INVALID_SOCKET		(-1)
+#define SOCKET_ERROR		(-1)
+#define WSAEWOULDBLOCK		EWOULDBLOCK
+#define ADDR_ANY			INADDR_ANY
+#define closesocket			close
+
+inline int WSAGetLastError() { return errno; }
+
+#endif
+
+// Writing to a connection the other end has reset raises SIGPIPE,
+// and that kills the process - so everything's sent with this. Where
+// there's no MSG_NOSIGNAL, the socket's SO_NOSIGPIPE does the same.
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL		0
+#endif
+
+#include <deque>
+
+#include "SocketPoller.h"
+#include "NetStats.h"
+#include "../Multicore/LockFreeQueue.h"
+
+
+#define MAX_PACKET_SIZE (1024)				// room for a whole snapshot - see Snapshot.h
+#define RECV_BUFFER_SIZE (MAX_PACKET_SIZE * 128)
+#define MAX_QUEUE_PER_PLAYER (10000)
+#define MAX_SEND_BUFFERS (64)				// packets gathered into one send
+
+// Define NET_TRACE_PACKETS to have every recv() and every packet that
+// arrives written to the debug output. It's slow, and only there for
+// chasing protocol problems.
+//#define NET_TRACE_PACKETS
+
+#define MAGIC_NUMBER		(0x1f2e3d4c)
+#define IPMANGLE(a,b,c,d) (((a)<<24)|((b)<<16)|((c)<<8)|((d)))
+
+class NetSocket;
+class WakeSocket;
+class CriticalSection;
+class IEventData;
+typedef boost::shared_ptr<IEventData> IEventDataPtr;
+class IEventManager;
+
+typedef std::list<NetSocket *> SocketList;
+typedef std::map<int, NetSocket *> SocketIdMap;
+
+
+////////////////////////////////////////////////////
+//
+// IPacket Description
+//
+//    The interface class that defines a public API for 
+//    packet objects - data that is either about to be
+//    sent to or just been recieved from the network
+//
+////////////////////////////////////////////////////
+
+class IPacket
+{
+public:
+	virtual char const * const VGetType() const=0;
+	virtual char const * const VGetData() const=0;
+	virtual u_long VGetSize() const =0;
+	virtual ~IPacket() { }
+};
+
+typedef std::list< shared_ptr <IPacket> > PacketList;
+
+
+////////////////////////////////////////////////////
+//
+// PacketPool Description
+//
+//   Where BinaryPacket gets its bytes. Anything up to
+//   MAX_PACKET_SIZE comes off a free list of blocks that size,
+//   carved out kBlocksPerChunk at a time and never given back, so
+//   once a game has been running a while making a packet doesn't
+//   touch the heap. Bigger ones are new[]ed as before.
+//
+//   It's only locked while the socket manager has a thread of its
+//   own ( see BaseSocketManager::StartThread() ) - then the game
+//   thread makes packets the network thread frees, and the other way
+//   around. Otherwise one thread does it all, and a lock would only
+//   cost time.
+////////////////////////////////////////////////////
+
+class PacketPool
+{
+public:
+	enum { kBlockSize = MAX_PACKET_SIZE, kBlocksPerChunk = 64 };
+
+	static char *Alloc(u_long size);
+	static void Free(char *pData, u_long size);
+
+	// Only while no packets are being made or freed on another thread.
+	static void SetLocked(bool bLocked) { s_bLocked = bLocked; }
+
+	// blocks handed out and never given back, for leak checks
+	static unsigned int GetBlocksInUse() { return s_BlocksInUse; }
+
+private:
+	struct Block { Block *m_pNext; };
+
+	static char *AllocBlock();
+	static void FreeBlock(char *pData);
+
+	static Block *s_pFree;
+	static unsigned int s_BlocksInUse;
+	static bool s_bLocked;
+};
+
+
+////////////////////////////////////////////////////
+//
+// BinaryPacket Description
+//
+//   A packet object that can be constructed all at once,
+//   or with repeated calls to MemCpy
+////////////////////////////////////////////////////
+
+class BinaryPacket : public IPacket
+{
+protected:
+	char *m_Data;
+	u_long m_AllocSize;		// not VGetSize() - a TextPacket zeroes its header
+
+public:
+	inline BinaryPacket(char const * const data, u_long size);
+	inline BinaryPacket(u_long size);
+	virtual ~BinaryPacket() { PacketPool::Free(m_Data, m_AllocSize); }
+	virtual char const * const VGetType() const { return g_Type; }
+	virtual char const * const VGetData() const { return m_Data; }
+	virtual u_long VGetSize() const { return ntohl(*(u_long *)m_Data); }
+	inline void MemCpy(char const *const data, size_t size, int destOffset);
+
+	static const char *g_Type;
+};
+
+
+inline BinaryPacket::BinaryPacket(char const * const data, u_long size)
+{
+	// BinaryPacket::BinaryPacket		- Chapter 16, page 606
+	m_AllocSize = size + sizeof(u_long);
+	m_Data = PacketPool::Alloc(m_AllocSize);
+	assert(m_Data);
+	*(u_long *)m_Data = htonl(size+sizeof(u_long));
+	memcpy(m_Data+sizeof(u_long), data, size);
+}
+
+inline BinaryPacket::BinaryPacket(u_long size)
+{
+	// BinaryPacket::BinaryPacket		- Chapter 16, page 607
+	m_AllocSize = size + sizeof(u_long);
+	m_Data = PacketPool::Alloc(m_AllocSize);
+	assert(m_Data);
+	*(u_long *)m_Data = htonl(size+sizeof(u_long));
+}
+
+inline void BinaryPacket::MemCpy(char const *const data, size_t size, int destOffset)
+{
+	// BinaryPacket::MemCpy				- Chapter 16, page 607
+	assert(size+destOffset <= VGetSize()-sizeof(u_long));
+	memcpy(m_Data + destOffset + sizeof(u_long), data, size);
+}
+
+////////////////////////////////////////////////////
+//
+// TextPacket Description
+//
+//   A packet object that takes a text string.
+////////////////////////////////////////////////////
+
+class TextPacket : public BinaryPacket
+{
+public:
+	TextPacket(char const * const text);
+	virtual char const * const VGetType() const { return g_Type; }
+
+	static const char *g_Type;
+};
+
+
+////////////////////////////////////////////////////
+//
+// PacketView Description
+//
+//   A packet that's still sitting in the buffer it arrived in.
+//   It's laid out like a BinaryPacket, but it's only good until
+//   the call it was handed to returns - copy it to keep it.
+////////////////////////////////////////////////////
+
+class PacketView : public IPacket
+{
+protected:
+	char const *m_pType;
+	char const *m_pData;
+	u_long m_Size;
+
+public:
+	PacketView(char const *pType, char const *pData, u_long size)
+		: m_pType(pType), m_pData(pData), m_Size(size) { }
+	virtual char const * const VGetType() const { return m_pType; }
+	virtual char const * const VGetData() const { return m_pData; }
+	virtual u_long VGetSize() const { return m_Size; }
+};
+
+
+////////////////////////////////////////////////////
+//
+// PacketQueue Description
+//
+//   A socket's send queue. It was a PacketList, which cost a heap
+//   allocation for every packet queued; this is a vector used from
+//   m_Head on, that's only cleared - keeping its storage - when it
+//   empties, and only shuffled down when the dead space at the
+//   front is more than what's live.
+////////////////////////////////////////////////////
+
+class PacketQueue
+{
+	typedef std::vector< shared_ptr<IPacket> > Packets;
+
+	Packets m_Packets;
+	size_t m_Head;
+
+public:
+	typedef Packets::iterator iterator;
+
+	PacketQueue() : m_Head(0) { }
+
+	bool empty() const { return m_Head == m_Packets.size(); }
+	size_t size() const { return m_Packets.size() - m_Head; }
+	shared_ptr<IPacket> const &front() const { return m_Packets[m_Head]; }
+	iterator begin() { return m_Packets.begin() + m_Head; }
+	iterator end() { return m_Packets.end(); }
+
+	void push_back(shared_ptr<IPacket> const &packet)
+	{
+		if (m_Head > 0 && m_Head >= m_Packets.size() - m_Head)
+		{
+			m_Packets.erase(m_Packets.begin(), m_Packets.begin() + m_Head);
+			m_Head = 0;
+		}
+		m_Packets.push_back(packet);
+	}
+
+	void pop_front()
+	{
+		m_Packets[m_Head].reset();
+		if (++m_Head == m_Packets.size())
+		{
+			m_Packets.clear();
+			m_Head = 0;
+		}
+	}
+};
+
+
+
+// What a packet needs from the connection it's sent on. A NetSocket
+// is TCP, so everything it sends is reliable and ordered whichever is
+// asked for; a UdpSocket ( see UdpSocket.h ) has a channel of each.
+enum NetChannel
+{
+	NetChannel_ReliableOrdered,			// arrives, and in the order sent
+	NetChannel_UnreliableSequenced,		// may not arrive; anything older than what has is dropped
+};
+
+
+////////////////////////////////////////////////////
+//
+// NetSocket Description
+//
+//   A base class for a socket connection.
+////////////////////////////////////////////////////
+
+class NetSocket 
+{
+	friend class BaseSocketManager;
+	friend class SelectSocketPoller;
+	friend class EpollSocketPoller;
+
+public:
+	NetSocket();
+	NetSocket(SOCKET new_sock, unsigned int hostIP);
+	virtual ~NetSocket();
+
+	virtual void HandleInput();
+	virtual void HandleOutput();
+	virtual int  HasOutput() { return !m_OutList.empty(); }
+	virtual void TimeOut() { m_timeOut=0; }
+
+	bool Connect(unsigned int ip, unsigned int port, int fCoalesce = 0);
+
+	void HandleException() { m_deleteFlag |= 1; }
+	void SetBlocking(int block);
+	void Send(shared_ptr<IPacket> pkt, bool clearTimeOut=1);
+	virtual void SendOnChannel(shared_ptr<IPacket> pkt, NetChannel channel) { Send(pkt); }
+
+	void SetTimeOut(int ms=45*1000) { m_timeOut = timeGetTime() + ms; }
+
+	int GetIpAddress() { return m_ipaddr; }
+
+	// Only on the thread that has the sockets - anywhere else, see
+	// BaseSocketManager::GetSocketStats().
+	NetSocketStats const &GetStats() const { return m_Stats; }
+
+
+protected:
+	// HandleInput() calls this for each whole packet it finds, with
+	// the packet where it lies in the receive buffer. By default it's
+	// copied onto m_InList, as the book did; override it to use the
+	// packet in place.
+	virtual void HandlePacket(IPacket const &packet);
+
+	// Puts the socket on the socket manager's list for FlushOutput(),
+	// and wakes up the poller for it. Call it when something's been
+	// queued to a socket that had nothing queued before.
+	void OutputQueued();
+
+    SOCKET m_sock;
+	int m_id;				// a unique ID given by the socket manager
+
+	// note: if deleteFlag has bit 2 set, exceptions only close the
+	//   socket and set to INVALID_SOCKET, and do not delete the NetSocket
+    int m_deleteFlag;
+ 
+	PacketQueue m_OutList;
+	PacketList m_InList;
+
+	// a ring - m_recvOfs bytes not yet parsed, starting at m_recvBegin -
+	// with MAX_PACKET_SIZE spare at the end to straighten out a packet
+	// that wraps
+	char m_recvBuf[RECV_BUFFER_SIZE + MAX_PACKET_SIZE];
+	unsigned int m_recvOfs, m_recvBegin;
+	bool m_bBinaryProtocol;
+
+    int m_sendOfs;
+	unsigned int m_timeOut;
+	unsigned int m_ipaddr;
+
+	int m_internal;
+	int m_timeCreated;
+
+	// ISocketPoller::eReady bits - set by the poller, and cleared
+	// here when a call would block
+	unsigned int m_PollReady;
+	bool m_bPollActive;			// on EpollSocketPoller's active list
+
+	NetSocketStats m_Stats;
+};
+
+
+
+////////////////////////////////////////////////////
+//
+// BaseSocketManager Description
+//
+//   Every socket, and the poller that says which have something to
+//   do. Once a frame the game calls DoSelect(), which reads and
+//   writes whatever's ready, then FlushOutput() after its update.
+//
+//   StartThread() moves all of that onto a network thread of its
+//   own, so a slow client or a big burst of packets no longer costs
+//   the game's frame anything. The network thread owns the sockets
+//   from then on, and reads, frames and decodes on its own time. The
+//   two threads meet only at lock-free queues:
+//
+//		game thread								network thread
+//		Send()		 -- packets --------->		to the sockets
+//		FlushOutput() -- a wake up -------->	sends them now
+//		DoSelect()	 <-- events ----------		QueueEvent(), QueueMessage()
+//					 <-- sockets closed ---
+//
+//   so the game thread's DoSelect() only hands what's been read to
+//   the event manager. The few event types that make Lua tables are
+//   the exception: a Lua state belongs to its game's thread, so their
+//   messages come over whole, and are only made into events there -
+//   see EventWire::kDecodeOnGameThread. The game thread never waits on
+//   the network thread: if the packet queue's full, Send() holds on
+//   to what doesn't fit until there's room. The network thread does
+//   wait if the game's fallen so far behind that the event queue's
+//   full, and stops reading until it's caught up.
+//
+//   Add the sockets the game starts with before StartThread(); from
+//   then on only the network thread - a listen socket accepting, say
+//   - adds or removes them.
+//
+//   With a network thread, several games can share one socket
+//   manager, each on a thread of its own - see GameInstancePool. Their
+//   Send()s take turns at the packet queue, and each socket's events
+//   go to its own game's event manager rather than the global one.
+//   DoSelect() and FlushOutput() stay with the one thread that runs
+//   them all; DoSelect() only sets a game's events aside, and each
+//   game takes its own with HandOverTo(), on its own thread, so
+//   they're built in its own Lua state.
+//
+////////////////////////////////////////////////////
+
+class BaseSocketManager
+{
+	friend class NetSocket;
+	friend class UdpSocket;
+	friend class UdpListenSocket;
+
+protected:
+#ifdef WIN32
+	WSADATA m_WsaData;
+#endif
+
+	SocketList m_SockList;
+	SocketIdMap m_SockMap;
+
+	ISocketPoller *m_pPoller;
+	ReadySocketList m_ReadySockets;
+	unsigned int m_LastSweep;
+
+	// ids of sockets whose send queues have filled since DoSelect()
+	std::vector<int> m_OutputQueued;
+
+	int m_NextSocketId;
+	int m_Inbound;
+	int m_Outbound;
+	int m_MaxOpenSockets;
+	unsigned int m_SubnetMask;
+	unsigned int m_Subnet;
+
+	// the network thread, if there is one
+	struct OutboundPacket
+	{
+		int m_SockId;
+		shared_ptr<IPacket> m_Packet;
+		NetChannel m_Channel;
+	};
+
+	struct InboundEvent
+	{
+		IEventDataPtr m_Event;
+		shared_ptr<IPacket> m_Message;				// or the kMsgEvent message to build it from
+		IEventManager *m_pTo;						// NULL for the global one
+	};
+
+	typedef std::map<IEventManager *, std::vector<InboundEvent> > InboundEventMap;
+
+	volatile bool m_bThreaded;
+	volatile bool m_bQuitThread;
+	volatile DWORD m_ThreadId;
+	HANDLE m_hThread;
+	int m_ThreadPollMicroSecs;
+	WakeSocket *m_pWake;
+	LockFreeQueue<OutboundPacket> *m_pPacketsOut;	// game thread to network thread
+	LockFreeQueue<InboundEvent> *m_pEventsIn;		// network thread to game thread
+	LockFreeQueue<int> *m_pSocketsClosed;			// network thread to game thread
+	std::deque<OutboundPacket> m_PacketsHeld;		// what didn't fit in m_pPacketsOut - game thread only
+	std::vector<int> m_ClosedIds;					// sorted - game thread only
+	InboundEventMap m_HandedOver;					// each game's, until its HandOverTo() or DropHandedOver()
+	CriticalSection *m_pGameLock;					// the game threads' turns at the four above
+	unsigned int m_EventStalls;
+
+	// every socket's NetSocketStats as of the last window, sorted by id
+	CriticalSection *m_pStatsLock;
+	std::vector<NetSocketStats> m_PublishedStats;
+	std::vector<NetSocketStats> m_StatsScratch;
+	unsigned int m_LastStatsRoll;
+
+	NetSocket *FindSocket(int sockId);
+
+	// Deletes or closes the socket if it has been marked for it.
+	void ReapSocket(NetSocket *pSock);
+
+	// What DoSelect() and FlushOutput() do on whichever thread has
+	// the sockets.
+	void Select(int pauseMicroSecs, int handleInput);
+	void SendQueued();
+	void PublishStats(unsigned int now);
+
+	bool QueuePacket(int sockId, shared_ptr<IPacket> const &packet, NetChannel channel);
+	void TakePackets();
+	void HandOver();
+	void QueueInbound(InboundEvent const &in);
+	void Deliver(InboundEvent const &in);
+	static IEventDataPtr Build(InboundEvent const &in);
+
+	static DWORD WINAPI ThreadProc(LPVOID lpParam);
+
+public:
+	enum
+	{
+		// Sockets that aren't busy are only checked for time outs
+		// this often.
+		kSweepIntervalMs = 100,
+
+		// The longest the network thread waits for something to
+		// happen - it's woken sooner for packets to send.
+		kThreadPollMicroSecs = 10000,
+		kThreadQueueSize = 16384,
+
+		// How often each socket's stats roll over to a new window, and
+		// are published for GetSocketStats().
+		kStatsWindowMs = 1000,
+	};
+
+	BaseSocketManager();
+	virtual ~BaseSocketManager();
+
+	void DoSelect(int pauseMicroSecs, int handleInput = 1);
+
+	// Sends everything queued since the last DoSelect() now, one
+	// gathered write per socket, instead of waiting for the next one.
+	// Call it once a frame, after the game has had its update, and all
+	// a frame's packets for a socket leave together.
+	void FlushOutput();
+
+	// Takes ownership of the poller. Only while there are no sockets.
+	bool SetPoller(ISocketPoller *pPoller);
+	ISocketPoller const *GetPoller() const { return m_pPoller; }
+
+	bool Init();
+	void Shutdown();
+	void PrintError();
+
+	bool StartThread(int pollMicroSecs = kThreadPollMicroSecs);
+	void StopThread();
+	bool IsThreaded() const { return m_bThreaded; }
+	bool OnNetworkThread() const;
+
+	// Where sockets put the events they've read. On the network thread
+	// they wait for the game thread's DoSelect(); otherwise they go
+	// straight to the global event manager. If the socket belongs to a
+	// game with an event manager of its own - pTo - they wait for its
+	// HandOverTo() instead.
+	void QueueEvent(IEventDataPtr const &event, IEventManager *pTo = NULL);
+
+	// The same for a whole EventWire kMsgEvent message, which is only
+	// made into an event when it's handed over - for the types that
+	// have to be built on the game's own thread.
+	void QueueMessage(char const *pData, unsigned int size, IEventManager *pTo = NULL);
+
+	// A game with an event manager of its own calls this at the start
+	// of its frame, on its own thread, for the events that have come
+	// for it.
+	void HandOverTo(IEventManager *pTo);
+
+	// Throws away what's been set aside for an event manager that's
+	// going away - otherwise its entry would stay, keyed by the deleted
+	// manager, until Shutdown(), and a new one made at the same address
+	// would be handed its events.
+	void DropHandedOver(IEventManager *pTo);
+
+	// times the network thread had to wait for the game to take its
+	// events
+	unsigned int GetEventStalls() const { return m_EventStalls; }
+
+	// Every socket's NetSocketStats as they were at the end of the
+	// last kStatsWindowMs, from any thread. GetSocketStats() is false
+	// for a socket that hadn't been made by then.
+	bool GetSocketStats(int sockId, NetSocketStats &stats) const;
+	void GetAllSocketStats(std::vector<NetSocketStats> &stats) const;
+
+	// The same as a JSON line for each socket, for a dashboard to
+	// pick up.
+	void DumpStats(std::string &out) const;
+
+	int AddSocket(NetSocket *socket); 
+	void RemoveSocket(NetSocket *socket);
+
+	unsigned int GetHostByName(const std::string &hostName);
+	const char *GetHostByAddr(unsigned int ip);
+
+	int GetIpAddress(int sockId);
+
+	void SetSubnet(unsigned int subnet, unsigned int subnetMask)
+	{
+		m_Subnet = subnet;
+		m_SubnetMask = subnetMask;
+	}
+	bool IsInternal(unsigned int ipaddr);
+
+	// False if there's no such socket. From the game thread while
+	// there's a network thread, the packet is queued for it, and it's
+	// only false once the socket's known to have gone.
+	bool Send(int sockId, shared_ptr<IPacket> packet, NetChannel channel = NetChannel_ReliableOrdered);
+};
+
+extern BaseSocketManager *g_pSocketManager;
+
+
+class NetListenSocket: public NetSocket
+{
+public:
+	NetListenSocket() { };
+	NetListenSocket(int portnum);
+
+	void Init(int portnum);
+	void InitScan(int portnum_min, int portnum_max);
+	SOCKET AcceptConnection(unsigned int *pAddr);
+
+	unsigned short port;
+};
@@ -0,0 +1,327 @@
+//========================================================================
+// SocketPoller.cpp : Ways of finding out which sockets are ready
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class SelectSocketPoller	- not in the book
+//  class EpollSocketPoller		- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+#include "SocketManager.h"
+
+#include <algorithm>
+
+
+//-------------------------------------------------------------------
+// SelectSocketPoller Implementation
+
+//
+// SelectSocketPoller::VAddSocket
+//
+bool SelectSocketPoller::VAddSocket(NetSocket *pSocket)
+{
+	m_Sockets.push_back(pSocket);
+	return true;
+}
+
+//
+// SelectSocketPoller::VRemoveSocket
+//
+void SelectSocketPoller::VRemoveSocket(NetSocket *pSocket)
+{
+	std::vector<NetSocket *>::iterator i = std::find(m_Sockets.begin(), m_Sockets.end(), pSocket);
+	if (i != m_Sockets.end())
+		m_Sockets.erase(i);
+}
+
+//
+// SelectSocketPoller::VPoll
+//
+//   This was the start of BaseSocketManager::DoSelect() in the book.
+//
+bool SelectSocketPoller::VPoll(int pauseMicroSecs, bool handleInput, ReadySocketList &ready)
+{
+	timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = pauseMicroSecs;    // 100 microseconds is 0.1 milliseconds or .0001 seconds
+
+	fd_set inp_set, out_set, exc_set;
+	int maxdesc;
+	NetSocket *pSock;
+
+	FD_ZERO(&inp_set);
+	FD_ZERO(&out_set);
+	FD_ZERO(&exc_set);
+
+	maxdesc = 0;
+
+	ready.clear();
+
+	// set everything up for the select
+	for (std::vector<NetSocket *>::iterator i = m_Sockets.begin(); i != m_Sockets.end(); ++i)
+	{
+		pSock = *i;
+		if ((pSock->m_deleteFlag&1) || pSock->m_sock == INVALID_SOCKET)
+			continue;
+
+#ifndef WIN32
+		if (pSock->m_sock >= FD_SETSIZE)
+		{
+			assert(0 && "Socket is past FD_SETSIZE - select() can't wait on it!");
+			continue;
+		}
+#endif
+
+		if (handleInput)
+			FD_SET(pSock->m_sock, &inp_set);
+
+		FD_SET(pSock->m_sock, &exc_set);
+
+		if (pSock->HasOutput())
+			FD_SET(pSock->m_sock, &out_set);
+
+		if ((int)pSock->m_sock > maxdesc)
+			maxdesc = (int)pSock->m_sock;
+	}
+
+	// do the select (duration passed in as tv, NULL to block until event)
+	int selRet = select(maxdesc+1, &inp_set, &out_set, &exc_set, &tv);
+	if (selRet == SOCKET_ERROR)
+		return false;
+
+	if (selRet == 0)
+		return true;
+
+	for (std::vector<NetSocket *>::iterator i = m_Sockets.begin(); i != m_Sockets.end(); ++i)
+	{
+		pSock = *i;
+		if ((pSock->m_deleteFlag&1) || pSock->m_sock == INVALID_SOCKET)
+			continue;
+
+		// level-triggered, so what select() says is the whole story
+		pSock->m_PollReady = 0;
+
+		if (FD_ISSET(pSock->m_sock, &exc_set))
+			pSock->m_PollReady |= kException;
+		if (FD_ISSET(pSock->m_sock, &out_set))
+			pSock->m_PollReady |= kWritable;
+		if (FD_ISSET(pSock->m_sock, &inp_set))
+			pSock->m_PollReady |= kReadable;
+
+		if (pSock->m_PollReady)
+			ready.push_back(pSock);
+	}
+
+	return true;
+}
+
+
+#ifdef __linux__
+
+//-------------------------------------------------------------------
+// EpollSocketPoller Implementation
+
+//
+// EpollSocketPoller::EpollSocketPoller
+//
+EpollSocketPoller::EpollSocketPoller()
+{
+	m_Epoll = epoll_create1(0);
+	assert(m_Epoll >= 0 && "epoll_create1 failed!");
+
+	m_Events.resize(256);
+}
+
+//
+// EpollSocketPoller::~EpollSocketPoller
+//
+EpollSocketPoller::~EpollSocketPoller()
+{
+	if (m_Epoll >= 0)
+		close(m_Epoll);
+}
+
+//
+// EpollSocketPoller::VAddSocket
+//
+bool EpollSocketPoller::VAddSocket(NetSocket *pSocket)
+{
+	if (pSocket->m_sock == INVALID_SOCKET)
+		return false;
+
+	pSocket->SetBlocking(0);
+	pSocket->m_PollReady = 0;
+	pSocket->m_bPollActive = false;
+
+	struct epoll_event event;
+	event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	event.data.ptr = pSocket;
+
+	if (epoll_ctl(m_Epoll, EPOLL_CTL_ADD, pSocket->m_sock, &event) != 0)
+	{
+		assert(0 && "epoll_ctl couldn't add a socket!");
+		return false;
+	}
+
+	return true;
+}
+
+//
+// EpollSocketPoller::VRemoveSocket
+//
+void EpollSocketPoller::VRemoveSocket(NetSocket *pSocket)
+{
+	if (pSocket->m_bPollActive)
+	{
+		m_Active.erase(std::find(m_Active.begin(), m_Active.end(), pSocket));
+		pSocket->m_bPollActive = false;
+	}
+
+	// closing the socket would take it out of the set as well, but
+	// only once every copy of the descriptor is closed
+	if (pSocket->m_sock != INVALID_SOCKET)
+		epoll_ctl(m_Epoll, EPOLL_CTL_DEL, pSocket->m_sock, NULL);
+
+	pSocket->m_PollReady = 0;
+}
+
+//
+// EpollSocketPoller::VOutputQueued
+//
+//   No edge will come for a socket that was already writable, so
+//   it has to be woken up here.
+//
+void EpollSocketPoller::VOutputQueued(NetSocket *pSocket)
+{
+	if (pSocket->m_PollReady & kWritable)
+		Activate(pSocket);
+}
+
+//
+// EpollSocketPoller::Activate
+//
+void EpollSocketPoller::Activate(NetSocket *pSocket)
+{
+	if (!pSocket->m_bPollActive)
+	{
+		pSocket->m_bPollActive = true;
+		m_Active.push_back(pSocket);
+	}
+}
+
+//
+// EpollSocketPoller::VPoll
+//
+bool EpollSocketPoller::VPoll(int pauseMicroSecs, bool handleInput, ReadySocketList &ready)
+{
+	ready.clear();
+
+	// don't sleep if there's work left over from last time
+	int const timeoutMs = m_Active.empty() ? (pauseMicroSecs + 999) / 1000 : 0;
+
+	int count = epoll_wait(m_Epoll, &m_Events[0], static_cast<int>(m_Events.size()), timeoutMs);
+	if (count < 0)
+	{
+		if (errno != EINTR)
+			return false;
+		count = 0;
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		NetSocket *pSocket = static_cast<NetSocket *>(m_Events[i].data.ptr);
+		unsigned int const events = m_Events[i].events;
+
+		if (events & (EPOLLIN | EPOLLRDHUP))
+			pSocket->m_PollReady |= kReadable;
+		if (events & EPOLLOUT)
+			pSocket->m_PollReady |= kWritable;
+		if (events & (EPOLLERR | EPOLLHUP))
+			pSocket->m_PollReady |= kException;
+
+		Activate(pSocket);
+	}
+
+	// a full buffer means there may be more waiting - take more next time
+	if (count == static_cast<int>(m_Events.size()))
+		m_Events.resize(m_Events.size() * 2);
+
+	// Hand back the active sockets with something to do. Ones left
+	// with nothing to do drop off the list - their ready bits stay,
+	// so a writable socket comes back as soon as VOutputQueued() is
+	// called for it.
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < m_Active.size(); ++i)
+	{
+		NetSocket *pSocket = m_Active[i];
+		unsigned int const pollReady = pSocket->m_PollReady;
+
+		bool const canWrite = (pollReady & kWritable) && pSocket->HasOutput();
+		bool const canRead = (pollReady & kReadable) != 0;
+		bool const failed = (pollReady & kException) != 0;
+
+		if (!canWrite && !canRead && !failed)
+		{
+			pSocket->m_bPollActive = false;
+			continue;
+		}
+
+		m_Active[kept++] = pSocket;
+
+		if (canWrite || failed || (canRead && handleInput))
+			ready.push_back(pSocket);
+	}
+	m_Active.resize(kept);
+
+	return true;
+}
+
+#endif
+
+
+//
+// CreateSocketPoller
+//
+ISocketPoller *CreateSocketPoller()
+{
+#ifdef __linux__
+	return GCC_NEW EpollSocketPoller;
+#else
+	return GCC_NEW SelectSocketPoller;
+#endif
+}
@@ -0,0 +1,170 @@
+#pragma once
+//========================================================================
+// SocketPoller.h : Ways of finding out which sockets are ready
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class ISocketPoller			- not in the book
+//  class SelectSocketPoller	- not in the book
+//  class EpollSocketPoller		- not in the book
+//========================================================================
+
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+class NetSocket;
+
+typedef std::vector<NetSocket *> ReadySocketList;
+
+
+////////////////////////////////////////////////////
+//
+// ISocketPoller Description
+//
+//   How BaseSocketManager::DoSelect() finds out which sockets
+//   can be read, written or have failed. The manager tells the
+//   poller about every socket it adds and removes, and each frame
+//   asks it for the ones with something to do.
+//
+//   What a socket can do is kept in NetSocket::m_PollReady, which
+//   the poller sets and the socket clears again when a recv(),
+//   send() or accept() would block. A level-triggered poller just
+//   sets it afresh every time; an edge-triggered one only hears
+//   about a socket when its state changes, so it keeps handing the
+//   socket back until the socket says it's done.
+//
+////////////////////////////////////////////////////
+
+class ISocketPoller
+{
+public:
+	enum eReady
+	{
+		kReadable = 1,
+		kWritable = 2,
+		kException = 4
+	};
+
+	virtual ~ISocketPoller() { }
+
+	virtual char const * VGetName() const = 0;
+
+	virtual bool VAddSocket(NetSocket *pSocket) = 0;
+	virtual void VRemoveSocket(NetSocket *pSocket) = 0;
+
+	// The socket's send queue was empty and isn't any more.
+	virtual void VOutputQueued(NetSocket *pSocket) = 0;
+
+	// Waits up to pauseMicroSecs for something to happen, then fills
+	// ready with the sockets that have something to do, each once.
+	// Returns false if the wait itself failed.
+	virtual bool VPoll(int pauseMicroSecs, bool handleInput, ReadySocketList &ready) = 0;
+};
+
+
+////////////////////////////////////////////////////
+//
+// SelectSocketPoller Description
+//
+//   The book's DoSelect(): three fd_sets built from every socket,
+//   every frame, then select(). It costs the same however few
+//   sockets are busy, and can't take more sockets than FD_SETSIZE -
+//   a count of sockets on Windows, the highest descriptor elsewhere.
+//
+////////////////////////////////////////////////////
+
+class SelectSocketPoller : public ISocketPoller
+{
+public:
+	virtual char const * VGetName() const { return "select"; }
+
+	virtual bool VAddSocket(NetSocket *pSocket);
+	virtual void VRemoveSocket(NetSocket *pSocket);
+	virtual void VOutputQueued(NetSocket *pSocket) { }
+	virtual bool VPoll(int pauseMicroSecs, bool handleInput, ReadySocketList &ready);
+
+protected:
+	std::vector<NetSocket *> m_Sockets;
+};
+
+
+#ifdef __linux__
+
+////////////////////////////////////////////////////
+//
+// EpollSocketPoller Description
+//
+//   Each socket is registered with epoll once, edge-triggered, for
+//   reading and writing both, and epoll_wait() only returns the
+//   ones whose state changed. Sockets that are still ready from an
+//   earlier frame are kept on an active list, so a frame costs what
+//   the busy sockets cost and nothing for the idle ones.
+//
+//   Edge-triggered sockets must not block, so they're switched to
+//   non-blocking when they're added.
+//
+////////////////////////////////////////////////////
+
+class EpollSocketPoller : public ISocketPoller
+{
+public:
+	EpollSocketPoller();
+	virtual ~EpollSocketPoller();
+
+	virtual char const * VGetName() const { return "epoll"; }
+
+	virtual bool VAddSocket(NetSocket *pSocket);
+	virtual void VRemoveSocket(NetSocket *pSocket);
+	virtual void VOutputQueued(NetSocket *pSocket);
+	virtual bool VPoll(int pauseMicroSecs, bool handleInput, ReadySocketList &ready);
+
+protected:
+	void Activate(NetSocket *pSocket);
+
+	int m_Epoll;
+	std::vector<struct epoll_event> m_Events;
+	std::vector<NetSocket *> m_Active;
+};
+
+#endif
+
+
+// The best poller there is for this platform.
+ISocketPoller *CreateSocketPoller();
@@ -0,0 +1,928 @@
+//========================================================================
+// UdpSocket.cpp : A connection over UDP, with reliable and unreliable channels
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class NetSimulator				- not in the book
+//  class UdpSocket					- not in the book
+//  class UdpListenSocket			- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include "UdpSocket.h"
+
+
+// What every datagram starts with:
+//
+//		u32		MAGIC_NUMBER
+//		u8		kind, with kAcksValid set once there's something to ack
+//
+// and a data datagram goes on with
+//
+//		u16		sequence number
+//		u16		the newest sequence number from the other end
+//		u32		a bit for each of the 32 before it that arrived
+//
+// then its messages, each
+//
+//		u8		NetChannel
+//		u16		message id
+//		u16		size
+//		...		the packet, without its u_long size
+
+namespace
+{
+	enum
+	{
+		kDatagramHello = 1,
+		kDatagramWelcome = 2,
+		kDatagramData = 3,
+
+		kAcksValid = 0x80,
+
+		kControlSize = 5,
+		kDataHeaderSize = kControlSize + 8,
+		kMessageHeaderSize = 5,
+
+		// UdpListenSocket doesn't look for gone clients until it's had
+		// at least this many
+		kMinPeersToPrune = 64,
+	};
+
+	inline void PutU16(char *p, unsigned short value)
+	{
+		value = htons(value);
+		memcpy(p, &value, sizeof(value));
+	}
+
+	inline void PutU32(char *p, unsigned int value)
+	{
+		value = htonl(value);
+		memcpy(p, &value, sizeof(value));
+	}
+
+	inline unsigned short GetU16(char const *p)
+	{
+		unsigned short value;
+		memcpy(&value, p, sizeof(value));
+		return ntohs(value);
+	}
+
+	inline unsigned int GetU32(char const *p)
+	{
+		unsigned int value;
+		memcpy(&value, p, sizeof(value));
+		return ntohl(value);
+	}
+
+	// is a after b, allowing for the numbers wrapping around
+	inline bool SequenceMoreRecent(unsigned short a, unsigned short b)
+	{
+		unsigned short const diff = static_cast<unsigned short>(a - b);
+		return diff != 0 && diff < 0x8000;
+	}
+
+	inline bool SameAddress(struct sockaddr_in const &a, struct sockaddr_in const &b)
+	{
+		return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// NetSimulator Implementation
+
+//
+// NetSimulator::NetSimulator
+//
+NetSimulator::NetSimulator(unsigned int seed)
+{
+	m_LossPercent = 0.0f;
+	m_LatencyMs = 0;
+	m_JitterMs = 0;
+	m_Seed = seed ? seed : 1;
+	m_Dropped = 0;
+}
+
+//
+// NetSimulator::Random
+//
+//   Not rand() - that's shared with everything else, and the point
+//   is to be able to run the same loss again.
+//
+unsigned int NetSimulator::Random()
+{
+	m_Seed = m_Seed * 1103515245 + 12345;
+	return (m_Seed >> 16) & 0x7fff;
+}
+
+//
+// NetSimulator::VDeliver
+//
+bool NetSimulator::VDeliver(unsigned int &delayMs)
+{
+	if (m_LossPercent > 0.0f && Random() * 100.0f / 32768.0f < m_LossPercent)
+	{
+		++m_Dropped;
+		return false;
+	}
+
+	delayMs = m_LatencyMs;
+	if (m_JitterMs)
+		delayMs += Random() % (m_JitterMs + 1);
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// UdpSocket Implementation
+
+//
+// UdpSocket::UdpSocket
+//
+UdpSocket::UdpSocket()
+{
+	m_State = kHandshaking;
+	memset(&m_PeerAddr, 0, sizeof(m_PeerAddr));
+
+	m_LastSendTime = m_LastRecvTime = m_LastHelloTime = timeGetTime();
+	m_timeCreated = m_LastSendTime;
+
+	m_LocalSeq = 0;
+	m_NextReliableOut = 0;
+	m_NextUnreliableOut = 0;
+	memset(m_Sent, 0, sizeof(m_Sent));
+
+	m_bGotRemote = false;
+	m_bAckOwed = false;
+	m_RemoteSeq = 0;
+	m_AckBits = 0;
+	m_NextReliableIn = 0;
+	for (int i = 0; i < kReliableWindow; ++i)
+		m_ReliableIn[i].m_bUsed = false;
+	m_bGotUnreliable = false;
+	m_LastUnreliableIn = 0;
+
+	m_RoundTripMs = 100;
+	m_bGotRoundTrip = false;
+	m_DatagramsSent = 0;
+	m_DatagramsReceived = 0;
+	m_Resends = 0;
+}
+
+//
+// UdpSocket::Connect
+//
+bool UdpSocket::Connect(unsigned int ip, unsigned int port)
+{
+	if ((m_sock = socket(PF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET)
+		return false;
+
+	SetBlocking(0);
+
+	m_PeerAddr.sin_family = AF_INET;
+	m_PeerAddr.sin_addr.s_addr = htonl(ip);
+	m_PeerAddr.sin_port = htons(port);
+	m_ipaddr = ip;
+
+	m_State = kHandshaking;
+	m_LastHelloTime = timeGetTime() - kHelloIntervalMs;		// say hello straight away
+	m_LastRecvTime = timeGetTime();
+	ArmTimer();
+	return true;
+}
+
+//
+// UdpSocket::Accept
+//
+//   The server end, for a client that's said hello to a
+//   UdpListenSocket.
+//
+bool UdpSocket::Accept(struct sockaddr_in const &peer)
+{
+	if ((m_sock = socket(PF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET)
+		return false;
+
+	struct sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = ADDR_ANY;
+	sa.sin_port = 0;
+
+	if (bind(m_sock, (struct sockaddr *)&sa, sizeof(sa)) == SOCKET_ERROR)
+	{
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		return false;
+	}
+
+	SetBlocking(0);
+
+	m_PeerAddr = peer;
+	m_ipaddr = ntohl(peer.sin_addr.s_addr);
+
+	m_State = kWelcoming;
+	m_LastHelloTime = timeGetTime() - kHelloIntervalMs;
+	m_LastRecvTime = timeGetTime();
+	ArmTimer();
+	return true;
+}
+
+//
+// UdpSocket::SendOnChannel
+//
+void UdpSocket::SendOnChannel(shared_ptr<IPacket> pkt, NetChannel channel)
+{
+	u_long const size = pkt->VGetSize();
+	if (size < sizeof(u_long) || size > MAX_PACKET_SIZE)
+	{
+		assert(0 && "Only binary packets up to MAX_PACKET_SIZE can go over UDP!");
+		return;
+	}
+
+	if (channel == NetChannel_ReliableOrdered)
+	{
+		// it waits on m_OutList for room in the window
+		Send(pkt);
+		return;
+	}
+
+	bool const wasEmpty = m_UnreliableOut.empty();
+	m_UnreliableOut.push_back(pkt);
+	m_Stats.Queued(size);
+	if (wasEmpty)
+		OutputQueued();
+}
+
+//
+// UdpSocket::HasOutput
+//
+//   True while anything is waiting to go, or waiting to be acked - it
+//   keeps HandleOutput() being called, to send things again.
+//
+int UdpSocket::HasOutput()
+{
+	if (!m_Delayed.empty() || m_State != kConnected)
+		return 1;
+
+	return !m_OutList.empty() || !m_UnreliableOut.empty() || !m_ReliableOut.empty() || m_bAckOwed;
+}
+
+//
+// UdpSocket::HandleOutput
+//
+void UdpSocket::HandleOutput()
+{
+	unsigned int const now = timeGetTime();
+
+	ReleaseDelayed(now);
+
+	switch (m_State)
+	{
+		case kHandshaking:
+		case kWelcoming:
+			if (now - m_LastHelloTime >= kHelloIntervalMs)
+			{
+				SendControl(m_State == kHandshaking ? kDatagramHello : kDatagramWelcome);
+				m_LastHelloTime = now;
+			}
+			break;
+
+		case kConnected:
+			SendData(now);
+			break;
+	}
+
+	ArmTimer();
+}
+
+//
+// UdpSocket::TimeOut
+//
+//   The socket manager calls this when m_timeOut passes - see
+//   ArmTimer().
+//
+void UdpSocket::TimeOut()
+{
+	unsigned int const now = timeGetTime();
+	if (now - m_LastRecvTime >= kConnectionTimeOutMs)
+	{
+		HandleException();
+		return;
+	}
+
+	HandleOutput();
+}
+
+//
+// UdpSocket::ArmTimer
+//
+//   The next time there's a keep alive due, or the connection will
+//   have timed out - whichever's first.
+//
+void UdpSocket::ArmTimer()
+{
+	unsigned int const keepAlive = m_LastSendTime + kKeepAliveMs;
+	unsigned int const timeOut = m_LastRecvTime + kConnectionTimeOutMs;
+
+	m_timeOut = (static_cast<int>(keepAlive - timeOut) < 0) ? keepAlive : timeOut;
+}
+
+//
+// UdpSocket::SendData
+//
+//   As many datagrams as it takes to send what's new, what's due to
+//   be sent again, and any ack that's owed.
+//
+void UdpSocket::SendData(unsigned int now)
+{
+	// reliable packets get an id when there's room in the window
+	while (!m_OutList.empty() && m_ReliableOut.size() < kReliableWindow)
+	{
+		ReliableMessage msg;
+		msg.m_Id = m_NextReliableOut++;
+		msg.m_bSent = false;
+		msg.m_bAcked = false;
+		msg.m_LastSent = 0;
+		msg.m_Packet = m_OutList.front();
+		m_ReliableOut.push_back(msg);
+		m_OutList.pop_front();
+	}
+
+	// a round trip and a half, and a frame or two for the ack to be sent
+	unsigned int const resendMs = m_RoundTripMs + m_RoundTripMs / 2 + kMinResendMs;
+
+	bool bKeepAlive = now - m_LastSendTime >= kKeepAliveMs;
+	size_t reliable = 0;
+	size_t unreliable = 0;
+
+	for (;;)
+	{
+		char datagram[MAX_DATAGRAM_SIZE];
+		int size = kDataHeaderSize;
+		int messages = 0;
+
+		SentDatagram &sent = m_Sent[m_LocalSeq % kSentHistory];
+		sent.m_bValid = false;
+		sent.m_ReliableCount = 0;
+
+		for (; reliable < m_ReliableOut.size() && sent.m_ReliableCount < kMaxReliablePerDatagram; ++reliable)
+		{
+			ReliableMessage &msg = m_ReliableOut[reliable];
+			if (msg.m_bAcked || (msg.m_bSent && now - msg.m_LastSent < resendMs))
+				continue;
+
+			u_long const packetSize = msg.m_Packet->VGetSize() - sizeof(u_long);
+			if (size + kMessageHeaderSize + static_cast<int>(packetSize) > MAX_DATAGRAM_SIZE)
+				break;			// the next datagram
+
+			datagram[size] = static_cast<char>(NetChannel_ReliableOrdered);
+			PutU16(datagram + size + 1, msg.m_Id);
+			PutU16(datagram + size + 3, static_cast<unsigned short>(packetSize));
+			memcpy(datagram + size + kMessageHeaderSize, msg.m_Packet->VGetData() + sizeof(u_long), packetSize);
+			size += kMessageHeaderSize + packetSize;
+
+			if (msg.m_bSent)
+				++m_Resends;
+			msg.m_bSent = true;
+			msg.m_LastSent = now;
+
+			sent.m_Reliable[sent.m_ReliableCount++] = msg.m_Id;
+			++messages;
+		}
+
+		for (; unreliable < m_UnreliableOut.size(); ++unreliable)
+		{
+			IPacket const &packet = *m_UnreliableOut[unreliable];
+			u_long const packetSize = packet.VGetSize() - sizeof(u_long);
+			if (size + kMessageHeaderSize + static_cast<int>(packetSize) > MAX_DATAGRAM_SIZE)
+				break;
+
+			datagram[size] = static_cast<char>(NetChannel_UnreliableSequenced);
+			PutU16(datagram + size + 1, m_NextUnreliableOut++);
+			PutU16(datagram + size + 3, static_cast<unsigned short>(packetSize));
+			memcpy(datagram + size + kMessageHeaderSize, packet.VGetData() + sizeof(u_long), packetSize);
+			size += kMessageHeaderSize + packetSize;
+
+			++messages;
+		}
+
+		if (!messages && !m_bAckOwed && !bKeepAlive)
+			break;
+
+		PutU32(datagram, MAGIC_NUMBER);
+		datagram[4] = static_cast<char>(kDatagramData | (m_bGotRemote ? kAcksValid : 0));
+		PutU16(datagram + 5, m_LocalSeq);
+		PutU16(datagram + 7, m_RemoteSeq);
+		PutU32(datagram + 9, m_AckBits);
+
+		sent.m_bValid = true;
+		sent.m_bAcked = false;
+		sent.m_Seq = m_LocalSeq;
+		sent.m_TimeSent = now;
+		++m_LocalSeq;
+
+		SendDatagram(datagram, size);
+
+		m_bAckOwed = false;
+		bKeepAlive = false;
+
+		if (!messages)
+			break;
+	}
+
+	// sent or not, an unreliable packet only gets the one chance
+	for (unsigned int i = 0; i < m_UnreliableOut.size(); ++i)
+		m_Stats.Dequeued(m_UnreliableOut[i]->VGetSize());
+	m_Stats.m_PacketsOut += unreliable;
+	m_UnreliableOut.clear();
+}
+
+//
+// UdpSocket::SendControl
+//
+void UdpSocket::SendControl(unsigned char kind)
+{
+	char datagram[kControlSize];
+	PutU32(datagram, MAGIC_NUMBER);
+	datagram[4] = static_cast<char>(kind);
+	SendDatagram(datagram, sizeof(datagram));
+}
+
+//
+// UdpSocket::SendDatagram
+//
+void UdpSocket::SendDatagram(char const *pData, int size)
+{
+	m_LastSendTime = timeGetTime();
+	++m_DatagramsSent;
+
+	if (m_pSimulator)
+	{
+		unsigned int delayMs = 0;
+		if (!m_pSimulator->VDeliver(delayMs))
+			return;
+
+		if (delayMs)
+		{
+			DelayedDatagram delayed;
+			delayed.m_ReleaseTime = m_LastSendTime + delayMs;
+			m_Delayed.push_back(delayed);
+			m_Delayed.back().m_Data.assign(pData, pData + size);
+			return;
+		}
+	}
+
+	SendNow(pData, size);
+}
+
+//
+// UdpSocket::SendNow
+//
+void UdpSocket::SendNow(char const *pData, int size)
+{
+	int rc = sendto(m_sock, pData, size, 0, (struct sockaddr *)&m_PeerAddr, sizeof(m_PeerAddr));
+	if (rc > 0)
+	{
+		g_pSocketManager->m_Outbound += rc;
+		m_Stats.Sent(rc, timeGetTime());
+	}
+	else if (WSAGetLastError() == WSAEWOULDBLOCK)
+	{
+		// the datagram's lost - as far as the other end's concerned
+		// it's no different to one lost on the way
+		m_PollReady &= ~ISocketPoller::kWritable;
+		m_Stats.SendBlocked(timeGetTime());
+	}
+}
+
+//
+// UdpSocket::ReleaseDelayed
+//
+void UdpSocket::ReleaseDelayed(unsigned int now)
+{
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < m_Delayed.size(); ++i)
+	{
+		if (static_cast<int>(now - m_Delayed[i].m_ReleaseTime) >= 0)
+		{
+			SendNow(&m_Delayed[i].m_Data[0], static_cast<int>(m_Delayed[i].m_Data.size()));
+			continue;
+		}
+
+		if (kept != i)
+			m_Delayed[kept].m_Data.swap(m_Delayed[i].m_Data);
+		m_Delayed[kept].m_ReleaseTime = m_Delayed[i].m_ReleaseTime;
+		++kept;
+	}
+	m_Delayed.resize(kept);
+}
+
+//
+// UdpSocket::HandleInput
+//
+//   m_recvBuf isn't a ring here - each datagram is read into the
+//   start of it, and dealt with before the next.
+//
+void UdpSocket::HandleInput()
+{
+	for (;;)
+	{
+		struct sockaddr_in from;
+		socklen_t fromSize = sizeof(from);
+
+		int rc = recvfrom(m_sock, m_recvBuf, MAX_DATAGRAM_SIZE, 0, (struct sockaddr *)&from, &fromSize);
+		if (rc < 0)
+		{
+			// read them all - wait to be told there's more
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+				m_PollReady &= ~ISocketPoller::kReadable;
+
+			// anything else is most likely the other end's port being
+			// closed, which the time out takes care of
+			return;
+		}
+
+		g_pSocketManager->m_Inbound += rc;
+		m_Stats.Received(rc);
+		HandleDatagram(from, m_recvBuf, rc);
+	}
+}
+
+//
+// UdpSocket::HandleDatagram
+//
+void UdpSocket::HandleDatagram(struct sockaddr_in const &from, char const *pData, int size)
+{
+	if (size < kControlSize || GetU32(pData) != MAGIC_NUMBER)
+		return;
+
+	unsigned int const now = timeGetTime();
+	unsigned char const kind = static_cast<unsigned char>(pData[4]) & ~kAcksValid;
+
+	if (m_State == kHandshaking)
+	{
+		// the answer comes from the port the server's made for us
+		if (kind != kDatagramWelcome || from.sin_addr.s_addr != m_PeerAddr.sin_addr.s_addr)
+			return;
+
+		m_PeerAddr = from;
+		m_State = kConnected;
+		m_LastRecvTime = now;
+		++m_DatagramsReceived;
+
+		// answer, so the server stops welcoming
+		m_bAckOwed = true;
+		OutputQueued();
+		return;
+	}
+
+	if (!SameAddress(from, m_PeerAddr))
+		return;
+
+	m_LastRecvTime = now;
+	++m_DatagramsReceived;
+
+	if (kind == kDatagramWelcome)
+	{
+		// the server didn't hear our answer - answer again
+		m_bAckOwed = true;
+		OutputQueued();
+		return;
+	}
+
+	if (kind != kDatagramData || size < kDataHeaderSize)
+		return;
+
+	if (m_State == kWelcoming)
+		m_State = kConnected;
+
+	unsigned short const seq = GetU16(pData + 5);
+	if (pData[4] & kAcksValid)
+	{
+		unsigned short const ack = GetU16(pData + 7);
+		unsigned int const ackBits = GetU32(pData + 9);
+
+		AckDatagram(ack, now);
+		for (unsigned int i = 0; i < 32; ++i)
+		{
+			if (ackBits & (1u << i))
+				AckDatagram(static_cast<unsigned short>(ack - 1 - i), now);
+		}
+
+		// a reliable packet's only out of the queue once it's acked
+		while (!m_ReliableOut.empty() && m_ReliableOut.front().m_bAcked)
+		{
+			m_Stats.Dequeued(m_ReliableOut.front().m_Packet->VGetSize());
+			++m_Stats.m_PacketsOut;
+			m_ReliableOut.pop_front();
+		}
+	}
+
+	if (!NoteReceived(seq))
+		return;			// a copy of one that's been seen
+
+	bool bGotMessages = false;
+	int ofs = kDataHeaderSize;
+	while (ofs + kMessageHeaderSize <= size)
+	{
+		NetChannel const channel = static_cast<NetChannel>(pData[ofs]);
+		unsigned short const id = GetU16(pData + ofs + 1);
+		unsigned short const messageSize = GetU16(pData + ofs + 3);
+		ofs += kMessageHeaderSize;
+
+		if (ofs + messageSize > size || messageSize + sizeof(u_long) > MAX_PACKET_SIZE)
+			break;			// not something we sent
+
+		ReceiveMessage(channel, id, pData + ofs, messageSize);
+		ofs += messageSize;
+		bGotMessages = true;
+	}
+
+	// only datagrams with something in them are acked straight away -
+	// otherwise two ends with nothing to say would ack each other's
+	// acks forever
+	if (bGotMessages && !m_bAckOwed)
+	{
+		m_bAckOwed = true;
+		OutputQueued();
+	}
+}
+
+//
+// UdpSocket::NoteReceived
+//
+//   Records seq for the acks sent back. False if it's already been
+//   received.
+//
+bool UdpSocket::NoteReceived(unsigned short seq)
+{
+	if (!m_bGotRemote)
+	{
+		m_bGotRemote = true;
+		m_RemoteSeq = seq;
+		m_AckBits = 0;
+		return true;
+	}
+
+	if (SequenceMoreRecent(seq, m_RemoteSeq))
+	{
+		unsigned int const shift = static_cast<unsigned short>(seq - m_RemoteSeq);
+		m_AckBits = (shift < 32) ? (m_AckBits << shift) : 0;
+		if (shift <= 32)
+			m_AckBits |= 1u << (shift - 1);			// the old newest
+		m_RemoteSeq = seq;
+		return true;
+	}
+
+	unsigned int const age = static_cast<unsigned short>(m_RemoteSeq - seq);
+	if (age == 0)
+		return false;
+
+	if (age <= 32)
+	{
+		unsigned int const bit = 1u << (age - 1);
+		if (m_AckBits & bit)
+			return false;
+		m_AckBits |= bit;
+	}
+
+	// too old to ack, but the messages in it can still count
+	return true;
+}
+
+//
+// UdpSocket::AckDatagram
+//
+void UdpSocket::AckDatagram(unsigned short seq, unsigned int now)
+{
+	SentDatagram &sent = m_Sent[seq % kSentHistory];
+	if (!sent.m_bValid || sent.m_bAcked || sent.m_Seq != seq)
+		return;
+
+	sent.m_bAcked = true;
+
+	unsigned int const sample = now - sent.m_TimeSent;
+	m_Stats.RoundTrip(sample);
+	if (m_bGotRoundTrip)
+	{
+		m_RoundTripMs = (m_RoundTripMs * 7 + sample) / 8;
+	}
+	else
+	{
+		m_RoundTripMs = sample;
+		m_bGotRoundTrip = true;
+	}
+
+	if (m_ReliableOut.empty())
+		return;
+
+	unsigned short const firstId = m_ReliableOut.front().m_Id;
+	for (unsigned int i = 0; i < sent.m_ReliableCount; ++i)
+	{
+		unsigned short const index = static_cast<unsigned short>(sent.m_Reliable[i] - firstId);
+		if (index < m_ReliableOut.size())
+			m_ReliableOut[index].m_bAcked = true;
+	}
+}
+
+//
+// UdpSocket::ReceiveMessage
+//
+void UdpSocket::ReceiveMessage(NetChannel channel, unsigned short id, char const *pData, unsigned short size)
+{
+	if (channel == NetChannel_UnreliableSequenced)
+	{
+		if (m_bGotUnreliable && !SequenceMoreRecent(id, m_LastUnreliableIn))
+			return;			// something newer's already arrived
+
+		m_bGotUnreliable = true;
+		m_LastUnreliableIn = id;
+		Deliver(pData, size);
+		return;
+	}
+
+	if (channel != NetChannel_ReliableOrdered)
+		return;
+
+	unsigned short const ahead = static_cast<unsigned short>(id - m_NextReliableIn);
+	if (ahead >= kReliableWindow)
+		return;			// delivered already - the ack for it was lost
+
+	if (ahead > 0)
+	{
+		// early - keep it until the ones before it get here
+		ReliableSlot &slot = m_ReliableIn[id % kReliableWindow];
+		if (!slot.m_bUsed)
+		{
+			slot.m_bUsed = true;
+			slot.m_Data.assign(pData, pData + size);
+		}
+		return;
+	}
+
+	Deliver(pData, size);
+	++m_NextReliableIn;
+
+	for (;;)
+	{
+		ReliableSlot &slot = m_ReliableIn[m_NextReliableIn % kReliableWindow];
+		if (!slot.m_bUsed)
+			break;
+
+		slot.m_bUsed = false;
+		Deliver(slot.m_Data.empty() ? NULL : &slot.m_Data[0], static_cast<unsigned short>(slot.m_Data.size()));
+		++m_NextReliableIn;
+	}
+}
+
+//
+// UdpSocket::Deliver
+//
+void UdpSocket::Deliver(char const *pData, unsigned short size)
+{
+	// put back the size it came without
+	char packet[MAX_PACKET_SIZE];
+	u_long const packetSize = size + sizeof(u_long);
+	*(u_long *)packet = htonl(packetSize);
+	memcpy(packet + sizeof(u_long), pData, size);
+
+	++m_Stats.m_PacketsIn;
+	HandlePacket(PacketView(BinaryPacket::g_Type, packet, packetSize));
+}
+
+
+//-------------------------------------------------------------------
+// UdpListenSocket Implementation
+
+//
+// UdpListenSocket::Init
+//
+void UdpListenSocket::Init(int portnum)
+{
+	struct sockaddr_in sa;
+
+	if ((m_sock = socket(PF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET)
+	{
+		perror("UdpListenSocket::Init: socket");
+		assert(0);
+		exit(1);
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = ADDR_ANY;
+	sa.sin_port = htons(portnum);
+
+	if (bind(m_sock, (struct sockaddr *)&sa, sizeof(sa)) == SOCKET_ERROR)
+	{
+		perror("UdpListenSocket::Init: bind");
+		closesocket(m_sock);
+		m_sock = INVALID_SOCKET;
+		assert(0);
+		exit(1);
+	}
+
+	SetBlocking(0);
+
+	socklen_t size = sizeof(sa);
+	getsockname(m_sock, (struct sockaddr *)&sa, &size);
+	port = ntohs(sa.sin_port);
+}
+
+//
+// UdpListenSocket::HandleInput
+//
+void UdpListenSocket::HandleInput()
+{
+	for (;;)
+	{
+		char datagram[kControlSize];
+		struct sockaddr_in from;
+		socklen_t fromSize = sizeof(from);
+
+		int rc = recvfrom(m_sock, datagram, sizeof(datagram), 0, (struct sockaddr *)&from, &fromSize);
+		if (rc < 0)
+		{
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+				m_PollReady &= ~ISocketPoller::kReadable;
+			return;
+		}
+
+		if (rc < kControlSize || GetU32(datagram) != MAGIC_NUMBER || datagram[4] != kDatagramHello)
+			continue;
+
+		// a client whose welcome hasn't got there yet - its socket
+		// keeps sending it
+		std::pair<unsigned int, unsigned short> const peer(from.sin_addr.s_addr, from.sin_port);
+		PeerMap::iterator it = m_Peers.find(peer);
+		if (it != m_Peers.end() && g_pSocketManager->FindSocket(it->second))
+			continue;
+
+		UdpSocket *pSocket = VCreateSocket();
+		if (!pSocket->Accept(from))
+		{
+			SAFE_DELETE(pSocket);
+			continue;
+		}
+
+		m_Peers[peer] = g_pSocketManager->AddSocket(pSocket);
+		pSocket->OutputQueued();
+
+		// only once the map's doubled, so a hello costs the same
+		// however many clients there have been
+		if (m_Peers.size() >= 2 * m_PeersAfterPrune + kMinPeersToPrune)
+			PrunePeers();
+	}
+}
+
+//
+// UdpListenSocket::PrunePeers
+//
+void UdpListenSocket::PrunePeers()
+{
+	for (PeerMap::iterator it = m_Peers.begin(); it != m_Peers.end(); )
+	{
+		if (g_pSocketManager->FindSocket(it->second))
+			++it;
+		else
+			m_Peers.erase(it++);
+	}
+
+	m_PeersAfterPrune = m_Peers.size();
+}
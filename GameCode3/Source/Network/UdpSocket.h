@@ -0,0 +1,295 @@
+#pragma once
+//========================================================================
+// UdpSocket.h : A connection over UDP, with reliable and unreliable channels
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class NetSimulator				- not in the book
+//  class UdpSocket					- not in the book
+//  class UdpListenSocket			- not in the book
+//========================================================================
+
+// A connection over UDP, for the socket manager. Over TCP one lost
+// segment holds up everything sent after it until it's been sent
+// again; here each packet is sent on a NetChannel, and only the
+// reliable ones wait for anything.
+
+#include <deque>
+#include <map>
+
+#include "SocketManager.h"
+
+
+#define MAX_DATAGRAM_SIZE (1200)				// comfortably under any path's MTU
+
+
+////////////////////////////////////////////////////
+//
+// NetSimulator Description
+//
+//   Loses and holds back a UdpSocket's outgoing datagrams, so the
+//   reliability can be tried out over loopback. What it does is
+//   worked out from a seed, so the same seed loses the same
+//   datagrams every time. Override VDeliver() for a pattern of loss
+//   of your own.
+//
+//		shared_ptr<NetSimulator> sim(GCC_NEW NetSimulator(42));
+//		sim->SetLoss(10.0f);
+//		sim->SetLatency(50, 10);
+//		pSocket->SetSimulator(sim);
+//
+////////////////////////////////////////////////////
+
+class NetSimulator
+{
+public:
+	NetSimulator(unsigned int seed = 1);
+	virtual ~NetSimulator() { }
+
+	void SetLoss(float lossPercent) { m_LossPercent = lossPercent; }
+	void SetLatency(unsigned int latencyMs, unsigned int jitterMs = 0) { m_LatencyMs = latencyMs; m_JitterMs = jitterMs; }
+
+	// false if the datagram is lost, otherwise how long it takes
+	virtual bool VDeliver(unsigned int &delayMs);
+
+	unsigned int GetDropped() const { return m_Dropped; }
+
+protected:
+	unsigned int Random();
+
+	float m_LossPercent;
+	unsigned int m_LatencyMs;
+	unsigned int m_JitterMs;
+	unsigned int m_Seed;
+	unsigned int m_Dropped;
+};
+
+
+////////////////////////////////////////////////////
+//
+// UdpSocket Description
+//
+//   One end of a connection over UDP. Every datagram has a sequence
+//   number, and acks the last one it got from the other end along
+//   with a bit for each of the 32 before it. Packets ride in
+//   datagrams as messages, on one of two channels:
+//
+//   NetChannel_ReliableOrdered - what Send() does, and what a
+//   NetSocket always does. Each message is sent again if the
+//   datagram it was in isn't acked within about a round trip, and
+//   the other end hands them to HandlePacket() in order, holding on
+//   to any that get there early.
+//
+//   NetChannel_UnreliableSequenced - each message is sent once, and
+//   the other end drops any older than the newest it's seen.
+//
+//   The client end calls Connect() and is added to the socket
+//   manager like any other socket; it says hello to the server's
+//   UdpListenSocket until it's answered from the port of the
+//   UdpSocket made for it there. From then on the two just talk.
+//   Nothing heard for kConnectionTimeOutMs and the connection's
+//   dropped; a datagram goes every kKeepAliveMs whether there's
+//   anything to say or not.
+//
+//   Packets arrive at HandlePacket() laid out like a BinaryPacket,
+//   as over TCP, so a subclass can treat them the same. Only binary
+//   packets up to MAX_PACKET_SIZE can be sent.
+////////////////////////////////////////////////////
+
+class UdpSocket : public NetSocket
+{
+	friend class UdpListenSocket;
+
+public:
+	enum
+	{
+		kHelloIntervalMs = 250,
+		kKeepAliveMs = 1000,
+		kConnectionTimeOutMs = 10000,
+		kMinResendMs = 30,
+		kReliableWindow = 256,				// reliable messages in flight at once
+		kSentHistory = 256,					// datagrams remembered until they're acked
+		kMaxReliablePerDatagram = 32,
+	};
+
+	UdpSocket();
+
+	// The client end - ip and port are the server's UdpListenSocket.
+	bool Connect(unsigned int ip, unsigned int port);
+	bool IsConnected() const { return m_State == kConnected; }
+
+	void SetSimulator(shared_ptr<NetSimulator> pSimulator) { m_pSimulator = pSimulator; }
+
+	// NetSocket
+	virtual void HandleInput();
+	virtual void HandleOutput();
+	virtual int  HasOutput();
+	virtual void TimeOut();
+	virtual void SendOnChannel(shared_ptr<IPacket> pkt, NetChannel channel);
+
+	unsigned int GetRoundTripMs() const { return m_RoundTripMs; }
+	unsigned int GetDatagramsSent() const { return m_DatagramsSent; }
+	unsigned int GetDatagramsReceived() const { return m_DatagramsReceived; }
+	unsigned int GetResends() const { return m_Resends; }
+
+protected:
+	enum eState
+	{
+		kHandshaking,			// the client, until the server answers
+		kWelcoming,				// the server, until the client answers
+		kConnected,
+	};
+
+	struct ReliableMessage
+	{
+		unsigned short m_Id;
+		bool m_bSent;
+		bool m_bAcked;
+		unsigned int m_LastSent;
+		shared_ptr<IPacket> m_Packet;
+	};
+
+	struct SentDatagram
+	{
+		bool m_bValid;
+		bool m_bAcked;
+		unsigned short m_Seq;
+		unsigned int m_TimeSent;
+		unsigned int m_ReliableCount;
+		unsigned short m_Reliable[kMaxReliablePerDatagram];
+	};
+
+	struct ReliableSlot
+	{
+		bool m_bUsed;
+		std::vector<char> m_Data;			// only filled when there's been a loss
+	};
+
+	struct DelayedDatagram
+	{
+		unsigned int m_ReleaseTime;
+		std::vector<char> m_Data;
+	};
+
+	bool Accept(struct sockaddr_in const &peer);
+
+	void HandleDatagram(struct sockaddr_in const &from, char const *pData, int size);
+	bool NoteReceived(unsigned short seq);
+	void AckDatagram(unsigned short seq, unsigned int now);
+	void ReceiveMessage(NetChannel channel, unsigned short id, char const *pData, unsigned short size);
+	void Deliver(char const *pData, unsigned short size);
+
+	void SendData(unsigned int now);
+	void SendControl(unsigned char kind);
+	void SendDatagram(char const *pData, int size);
+	void SendNow(char const *pData, int size);
+	void ReleaseDelayed(unsigned int now);
+	void ArmTimer();
+
+	eState m_State;
+	struct sockaddr_in m_PeerAddr;
+	shared_ptr<NetSimulator> m_pSimulator;
+
+	unsigned int m_LastSendTime;
+	unsigned int m_LastRecvTime;
+	unsigned int m_LastHelloTime;
+
+	// sending - m_OutList holds reliable packets waiting for room
+	// in the window
+	unsigned short m_LocalSeq;
+	unsigned short m_NextReliableOut;
+	unsigned short m_NextUnreliableOut;
+	std::deque<ReliableMessage> m_ReliableOut;
+	std::vector< shared_ptr<IPacket> > m_UnreliableOut;
+	SentDatagram m_Sent[kSentHistory];
+	std::vector<DelayedDatagram> m_Delayed;
+
+	// receiving
+	bool m_bGotRemote;
+	bool m_bAckOwed;
+	unsigned short m_RemoteSeq;
+	unsigned int m_AckBits;
+	unsigned short m_NextReliableIn;
+	ReliableSlot m_ReliableIn[kReliableWindow];
+	bool m_bGotUnreliable;
+	unsigned short m_LastUnreliableIn;
+
+	unsigned int m_RoundTripMs;
+	bool m_bGotRoundTrip;
+	unsigned int m_DatagramsSent;
+	unsigned int m_DatagramsReceived;
+	unsigned int m_Resends;
+};
+
+
+////////////////////////////////////////////////////
+//
+// UdpListenSocket Description
+//
+//   Where clients say hello. Each new one gets a UdpSocket of its
+//   own, on a port of its own, which answers it; override
+//   VCreateSocket() to make them something that knows what to do
+//   with the packets. A client's entry goes once its socket has -
+//   it's timed out, or been closed.
+////////////////////////////////////////////////////
+
+class UdpListenSocket : public NetSocket
+{
+public:
+	UdpListenSocket() : m_PeersAfterPrune(0) { }
+
+	// 0 for whatever port's free - 'port' says which it got
+	void Init(int portnum);
+
+	virtual void HandleInput();
+	virtual int  HasOutput() { return 0; }
+
+	unsigned short port;
+
+	unsigned int GetPeerCount() const { return static_cast<unsigned int>(m_Peers.size()); }
+
+protected:
+	virtual UdpSocket *VCreateSocket() { return GCC_NEW UdpSocket; }
+
+	// Drops the clients whose sockets have gone.
+	void PrunePeers();
+
+	// the client's address and port, to the id of its UdpSocket
+	typedef std::map< std::pair<unsigned int, unsigned short>, int > PeerMap;
+	PeerMap m_Peers;
+	size_t m_PeersAfterPrune;
+};
@@ -526,7 +526,7 @@ void BulletPhysics::VSyncVisibleScene()
 		ActorMotionState const * const actorMotionState = static_cast<ActorMotionState*>(it->second->m_pRigidBody->getMotionState());
 		assert( actorMotionState );
 		
-		shared_ptr<IActor> gameActor = g_pApp->m_pGame->VGetActor( id );
+		shared_ptr<IActor> gameActor = g_pApp->GetCurrentGame()->VGetActor( id );
 		if ( gameActor )
 		{
 			if ( gameActor->VGetMat() != actorMotionState->m_worldToPositionTransform )
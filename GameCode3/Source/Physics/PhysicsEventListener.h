@@ -66,6 +66,21 @@ struct EvtData_PhysTrigger_Enter : public BaseEventData
 		  m_other(other)
 	{}
 
+	explicit EvtData_PhysTrigger_Enter( BinaryInStream & in )
+	{
+		m_triggerID = in.ReadI32();
+		if ( in.ReadBool() )
+			m_other = static_cast<ActorId>( in.ReadU32() );
+	}
+
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		out.WriteI32( m_triggerID );
+		out.WriteBool( m_other.valid() );
+		if ( m_other.valid() )
+			out.WriteU32( *m_other );
+	}
+
 	IEventDataPtr VCopy() const 
 	{
 		return IEventDataPtr(GCC_NEW EvtData_PhysTrigger_Enter(m_triggerID, m_other));
@@ -82,7 +97,7 @@ struct EvtData_PhysTrigger_Enter : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//TODO JWC:  Alter this to make it work with new physics.
@@ -112,6 +127,21 @@ struct EvtData_PhysTrigger_Leave : public BaseEventData
 		  m_other(other)
 	{}
 
+	explicit EvtData_PhysTrigger_Leave( BinaryInStream & in )
+	{
+		m_triggerID = in.ReadI32();
+		if ( in.ReadBool() )
+			m_other = static_cast<ActorId>( in.ReadU32() );
+	}
+
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		out.WriteI32( m_triggerID );
+		out.WriteBool( m_other.valid() );
+		if ( m_other.valid() )
+			out.WriteU32( *m_other );
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_PhysTrigger_Leave(m_triggerID, m_other) );
@@ -128,7 +158,7 @@ struct EvtData_PhysTrigger_Leave : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//TODO JWC:  Alter this to make it work with new physics.
@@ -163,6 +193,36 @@ struct EvtData_PhysCollision : public BaseEventData
 		m_CollisionPoints(collisionPoints)
 	{}
 
+	explicit EvtData_PhysCollision( BinaryInStream & in )
+	{
+		m_ActorA = in.ReadU32();
+		m_ActorB = in.ReadU32();
+		in.ReadFloats( &m_SumNormalForce.x, 3 );
+		in.ReadFloats( &m_SumFrictionForce.x, 3 );
+
+		// stops where the bytes run out, so a bad count can't make a
+		// huge list
+		unsigned long points = in.ReadU32();
+		while ( points-- > 0 && in.IsOk() )
+		{
+			Vec3 point;
+			in.ReadFloats( &point.x, 3 );
+			m_CollisionPoints.push_back( point );
+		}
+	}
+
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		out.WriteU32( m_ActorA );
+		out.WriteU32( m_ActorB );
+		out.WriteFloats( &m_SumNormalForce.x, 3 );
+		out.WriteFloats( &m_SumFrictionForce.x, 3 );
+
+		out.WriteU32( static_cast<unsigned long>( m_CollisionPoints.size() ) );
+		for ( Vec3List::const_iterator i = m_CollisionPoints.begin(); i != m_CollisionPoints.end(); ++i )
+			out.WriteFloats( &i->x, 3 );
+	}
+
 
 	virtual IEventDataPtr VCopy() const
 	{
@@ -180,7 +240,7 @@ struct EvtData_PhysCollision : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Now provide the event data necessary.
@@ -225,6 +285,18 @@ struct EvtData_PhysSeparation : public BaseEventData
 		, m_ActorB(actorB)
 	{}
 
+	explicit EvtData_PhysSeparation( BinaryInStream & in )
+	{
+		m_ActorA = in.ReadU32();
+		m_ActorB = in.ReadU32();
+	}
+
+	virtual void VSerializeBinary( BinaryOutStream & out ) const
+	{
+		out.WriteU32( m_ActorA );
+		out.WriteU32( m_ActorB );
+	}
+
 	virtual IEventDataPtr VCopy() const
 	{
 		return IEventDataPtr ( GCC_NEW EvtData_PhysSeparation(m_ActorA, m_ActorB) );
@@ -241,7 +313,7 @@ struct EvtData_PhysSeparation : public BaseEventData
 		assert( ( false == m_bHasLuaEventData ) && "Already built lua event data!" );
 
 		//Get the global state.
-		LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
+		LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
 		m_LuaEventData.AssignNewTable( pState );
 
 		//Now provide the event data necessary.
@@ -124,6 +124,7 @@ ResCache::ResCache(const unsigned int sizeInMb, IResourceFile *resFile )
 
 ResCache::~ResCache()
 {
+	ScopedCriticalSection locked(m_cs);
 	while (!m_lru.empty())
 	{
 		FreeOneResource();
@@ -136,6 +137,8 @@ ResCache::~ResCache()
 
 shared_ptr<ResHandle> ResCache::GetHandle(Resource * r)
 {
+	ScopedCriticalSection locked(m_cs);
+
 	shared_ptr<ResHandle> handle(Find(r));
 	if (handle==NULL)
 	{
@@ -220,6 +223,8 @@ void ResCache::FreeOneResource()
 
 void ResCache::Flush()
 {
+	ScopedCriticalSection locked(m_cs);
+
 	while (!m_lru.empty())
 	{
 		shared_ptr<ResHandle> handle = *(m_lru.begin());
@@ -266,6 +271,7 @@ void ResCache::Free(shared_ptr<ResHandle> gonner)
 
 void ResCache::MemoryHasBeenFreed(unsigned int size)
 {
+	ScopedCriticalSection locked(m_cs);
 	m_allocated -= size;
 }
 
@@ -45,6 +45,8 @@
 //
 //========================================================================
 
+#include "..\Multicore\CriticalSection.h"
+
 
 // Note: this was renamed from struct Resource in the book.
 
@@ -111,6 +113,11 @@ class ResCache
 	unsigned int			m_cacheSize;			// total memory size
 	unsigned int			m_allocated;			// total memory allocated
 
+	// Several games in one process share the one cache, each on a
+	// thread of its own - see GameInstance. It's recursive, so a handle
+	// let go of while it's held can still say it's gone.
+	CriticalSection			m_cs;
+
 protected:
 
 	bool MakeRoom(unsigned int size);
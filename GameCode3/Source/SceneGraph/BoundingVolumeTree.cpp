@@ -0,0 +1,499 @@
+//========================================================================
+// BoundingVolumeTree.cpp : What the camera can see, for the whole scene at once
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class BoundingVolumeTree		- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include "BoundingVolumeTree.h"
+
+
+namespace
+{
+	// Half the surface area - what a box costs to be in, since that's
+	// about how likely anything is to touch it.
+	template <class B>
+	float Perimeter(B const &box)
+	{
+		float const x = box.m_Max[0] - box.m_Min[0];
+		float const y = box.m_Max[1] - box.m_Min[1];
+		float const z = box.m_Max[2] - box.m_Min[2];
+		return x * y + y * z + z * x;
+	}
+
+	template <class B>
+	void Combine(B &out, B const &a, B const &b)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			out.m_Min[i] = std::min(a.m_Min[i], b.m_Min[i]);
+			out.m_Max[i] = std::max(a.m_Max[i], b.m_Max[i]);
+		}
+	}
+
+	template <class B>
+	bool Encloses(B const &outer, B const &inner)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			if (inner.m_Min[i] < outer.m_Min[i] || inner.m_Max[i] > outer.m_Max[i])
+				return false;
+		}
+		return true;
+	}
+}
+
+
+//
+// BoundingVolumeTree::BoundingVolumeTree	- not in the book
+//
+BoundingVolumeTree::BoundingVolumeTree(float margin)
+{
+	m_Root = kNull;
+	m_FreeNodes = kNull;
+	m_Count = 0;
+	m_Margin = margin;
+	m_CullCount = 1;
+	m_CullTests = 0;
+}
+
+//
+// BoundingVolumeTree::Insert				- not in the book
+//
+void BoundingVolumeTree::Insert(int id, float const center[3], float radius)
+{
+	if (id >= static_cast<int>(m_LeafOf.size()))
+		m_LeafOf.resize(id + 1, kNull);
+	assert(m_LeafOf[id] == kNull && "BoundingVolumeTree::Insert() - it's in already");
+
+	int const leaf = AllocNode();
+	Node &node = m_Nodes[leaf];
+	memcpy(node.m_Center, center, sizeof(node.m_Center));
+	node.m_Radius = radius;
+	node.m_Id = id;
+	FattenedBox(node);
+	m_LeafOf[id] = leaf;
+
+	InsertLeaf(leaf);
+	++m_Count;
+}
+
+//
+// BoundingVolumeTree::Remove				- not in the book
+//
+void BoundingVolumeTree::Remove(int id)
+{
+	int const leaf = m_LeafOf[id];
+	assert(leaf != kNull && "BoundingVolumeTree::Remove() - it isn't in");
+
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	m_LeafOf[id] = kNull;
+	--m_Count;
+}
+
+//
+// BoundingVolumeTree::Move					- not in the book
+//
+void BoundingVolumeTree::Move(int id, float const center[3])
+{
+	int const leaf = m_LeafOf[id];
+	memcpy(m_Nodes[leaf].m_Center, center, sizeof(m_Nodes[leaf].m_Center));
+	Refit(leaf);
+}
+
+//
+// BoundingVolumeTree::Resize				- not in the book
+//
+void BoundingVolumeTree::Resize(int id, float radius)
+{
+	int const leaf = m_LeafOf[id];
+	m_Nodes[leaf].m_Radius = radius;
+	Refit(leaf);
+}
+
+//
+// BoundingVolumeTree::Cull					- not in the book
+//
+//   Each box is tested only against the planes its parent wasn't
+//   wholly inside - with none left, everything under it is in view.
+//   A leaf that's still across a plane has its sphere tested, as
+//   Frustum::Inside() would, since its box is bigger.
+//
+unsigned int BoundingVolumeTree::Cull(Plane const *pPlanes, int numPlanes)
+{
+	assert(numPlanes <= kMaxPlanes);
+
+	++m_CullCount;
+	m_CullTests = 0;
+	if (m_Root == kNull)
+		return 0;
+
+	unsigned int visible = 0;
+	unsigned int const allPlanes = numPlanes == kMaxPlanes ? 0xffffffff : (1u << numPlanes) - 1;
+
+	m_Stack.clear();
+	m_Stack.push_back(std::make_pair(m_Root, allPlanes));
+	while (!m_Stack.empty())
+	{
+		int const index = m_Stack.back().first;
+		unsigned int planes = m_Stack.back().second;
+		m_Stack.pop_back();
+
+		Node const &node = m_Nodes[index];
+		bool outside = false;
+		for (int p = 0; p < numPlanes; ++p)
+		{
+			if (!(planes & (1u << p)))
+				continue;
+
+			// the corners furthest along the normal and furthest against it
+			Plane const &plane = pPlanes[p];
+			Box const &box = node.m_Box;
+			float const nearest = plane.a * (plane.a >= 0.0f ? box.m_Max[0] : box.m_Min[0])
+				+ plane.b * (plane.b >= 0.0f ? box.m_Max[1] : box.m_Min[1])
+				+ plane.c * (plane.c >= 0.0f ? box.m_Max[2] : box.m_Min[2]) + plane.d;
+			++m_CullTests;
+			if (nearest < 0.0f)
+			{
+				outside = true;
+				break;
+			}
+
+			float const furthest = plane.a * (plane.a >= 0.0f ? box.m_Min[0] : box.m_Max[0])
+				+ plane.b * (plane.b >= 0.0f ? box.m_Min[1] : box.m_Max[1])
+				+ plane.c * (plane.c >= 0.0f ? box.m_Min[2] : box.m_Max[2]) + plane.d;
+			if (furthest >= 0.0f)
+				planes &= ~(1u << p);
+		}
+
+		if (outside)
+			continue;
+
+		if (!node.IsLeaf())
+		{
+			m_Stack.push_back(std::make_pair(node.m_Child[0], planes));
+			m_Stack.push_back(std::make_pair(node.m_Child[1], planes));
+			continue;
+		}
+
+		for (int p = 0; p < numPlanes; ++p)
+		{
+			if (!(planes & (1u << p)))
+				continue;
+
+			Plane const &plane = pPlanes[p];
+			++m_CullTests;
+			if (plane.a * node.m_Center[0] + plane.b * node.m_Center[1] + plane.c * node.m_Center[2] + plane.d < -node.m_Radius)
+			{
+				outside = true;
+				break;
+			}
+		}
+
+		if (!outside)
+		{
+			m_Nodes[index].m_Culled = m_CullCount;
+			++visible;
+		}
+	}
+
+	return visible;
+}
+
+//
+// BoundingVolumeTree::AllocNode			- not in the book
+//
+//   The free ones are a list through m_Parent. m_Nodes can move, so
+//   nothing holds on to a Node & across one of these.
+//
+int BoundingVolumeTree::AllocNode()
+{
+	int index = m_FreeNodes;
+	if (index == kNull)
+	{
+		index = static_cast<int>(m_Nodes.size());
+		m_Nodes.push_back(Node());
+	}
+	else
+	{
+		m_FreeNodes = m_Nodes[index].m_Parent;
+	}
+
+	Node &node = m_Nodes[index];
+	node.m_Parent = kNull;
+	node.m_Child[0] = node.m_Child[1] = kNull;
+	node.m_Height = 0;
+	node.m_Id = kNull;
+	node.m_Culled = 0;
+	return index;
+}
+
+//
+// BoundingVolumeTree::FreeNode				- not in the book
+//
+void BoundingVolumeTree::FreeNode(int node)
+{
+	m_Nodes[node].m_Parent = m_FreeNodes;
+	m_Nodes[node].m_Height = -1;
+	m_FreeNodes = node;
+}
+
+//
+// BoundingVolumeTree::InsertLeaf			- not in the book
+//
+//   Goes down the side where the boxes grow least, and stops where
+//   pairing it with the node it's at would cost less than going on.
+//   The new leaf and that node get a new parent between them.
+//
+void BoundingVolumeTree::InsertLeaf(int leaf)
+{
+	if (m_Root == kNull)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].m_Parent = kNull;
+		return;
+	}
+
+	Box const leafBox = m_Nodes[leaf].m_Box;
+
+	int sibling = m_Root;
+	while (!m_Nodes[sibling].IsLeaf())
+	{
+		Node const &node = m_Nodes[sibling];
+
+		Box combined;
+		Combine(combined, node.m_Box, leafBox);
+		float const area = Perimeter(node.m_Box);
+		float const combinedArea = Perimeter(combined);
+
+		// pairing it with this node, and what going on down costs above
+		float const cost = 2.0f * combinedArea;
+		float const inherited = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		for (int c = 0; c < 2; ++c)
+		{
+			Node const &child = m_Nodes[node.m_Child[c]];
+			Combine(combined, child.m_Box, leafBox);
+			childCost[c] = child.IsLeaf() ? Perimeter(combined) + inherited
+				: Perimeter(combined) - Perimeter(child.m_Box) + inherited;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		sibling = node.m_Child[childCost[0] < childCost[1] ? 0 : 1];
+	}
+
+	int const oldParent = m_Nodes[sibling].m_Parent;
+	int const newParent = AllocNode();
+
+	Node &parent = m_Nodes[newParent];
+	parent.m_Parent = oldParent;
+	Combine(parent.m_Box, leafBox, m_Nodes[sibling].m_Box);
+	parent.m_Height = m_Nodes[sibling].m_Height + 1;
+	parent.m_Child[0] = sibling;
+	parent.m_Child[1] = leaf;
+
+	if (oldParent == kNull)
+		m_Root = newParent;
+	else if (m_Nodes[oldParent].m_Child[0] == sibling)
+		m_Nodes[oldParent].m_Child[0] = newParent;
+	else
+		m_Nodes[oldParent].m_Child[1] = newParent;
+
+	m_Nodes[sibling].m_Parent = newParent;
+	m_Nodes[leaf].m_Parent = newParent;
+
+	FixUpwards(newParent);
+}
+
+//
+// BoundingVolumeTree::RemoveLeaf			- not in the book
+//
+//   Its parent goes too, and its sibling takes the parent's place.
+//
+void BoundingVolumeTree::RemoveLeaf(int leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root = kNull;
+		return;
+	}
+
+	int const parent = m_Nodes[leaf].m_Parent;
+	int const grandParent = m_Nodes[parent].m_Parent;
+	int const sibling = m_Nodes[parent].m_Child[m_Nodes[parent].m_Child[0] == leaf ? 1 : 0];
+
+	if (grandParent == kNull)
+	{
+		m_Root = sibling;
+		m_Nodes[sibling].m_Parent = kNull;
+	}
+	else
+	{
+		if (m_Nodes[grandParent].m_Child[0] == parent)
+			m_Nodes[grandParent].m_Child[0] = sibling;
+		else
+			m_Nodes[grandParent].m_Child[1] = sibling;
+		m_Nodes[sibling].m_Parent = grandParent;
+	}
+
+	FreeNode(parent);
+	m_Nodes[leaf].m_Parent = kNull;
+
+	FixUpwards(grandParent);
+}
+
+//
+// BoundingVolumeTree::Refit				- not in the book
+//
+//   Only when the sphere's no longer inside its leaf's box - a leaf
+//   that's only moved a little is left where it is.
+//
+void BoundingVolumeTree::Refit(int leaf)
+{
+	Node &node = m_Nodes[leaf];
+
+	Box tight;
+	for (int i = 0; i < 3; ++i)
+	{
+		tight.m_Min[i] = node.m_Center[i] - node.m_Radius;
+		tight.m_Max[i] = node.m_Center[i] + node.m_Radius;
+	}
+
+	// a box that's got much too big for a sphere that's shrunk is as
+	// bad as one it's outgrown
+	if (Encloses(node.m_Box, tight) && node.m_Box.m_Max[0] - node.m_Box.m_Min[0] <= 2.0f * (node.m_Radius + 2.0f * m_Margin))
+		return;
+
+	RemoveLeaf(leaf);
+	FattenedBox(node);
+	InsertLeaf(leaf);
+}
+
+//
+// BoundingVolumeTree::FixUpwards			- not in the book
+//
+void BoundingVolumeTree::FixUpwards(int node)
+{
+	while (node != kNull)
+	{
+		node = Balance(node);
+
+		Node &parent = m_Nodes[node];
+		Node const &left = m_Nodes[parent.m_Child[0]];
+		Node const &right = m_Nodes[parent.m_Child[1]];
+		parent.m_Height = 1 + std::max(left.m_Height, right.m_Height);
+		Combine(parent.m_Box, left.m_Box, right.m_Box);
+
+		node = parent.m_Parent;
+	}
+}
+
+//
+// BoundingVolumeTree::Balance				- not in the book
+//
+//   If one side's two deeper than the other, its child comes up into
+//   this node's place and this node goes down under it, taking the
+//   shallower of that child's children with it. What's now in this
+//   node's place is returned.
+//
+int BoundingVolumeTree::Balance(int a)
+{
+	Node &nodeA = m_Nodes[a];
+	if (nodeA.IsLeaf() || nodeA.m_Height < 2)
+		return a;
+
+	int const balance = m_Nodes[nodeA.m_Child[1]].m_Height - m_Nodes[nodeA.m_Child[0]].m_Height;
+	if (balance >= -1 && balance <= 1)
+		return a;
+
+	// the deeper side comes up, the other stays under a
+	int const up = balance > 0 ? 1 : 0;
+	int const b = nodeA.m_Child[up];
+	int const stays = nodeA.m_Child[1 - up];
+	Node &nodeB = m_Nodes[b];
+
+	int const f = nodeB.m_Child[0];
+	int const g = nodeB.m_Child[1];
+
+	// b takes a's place
+	nodeB.m_Child[0] = a;
+	nodeB.m_Parent = nodeA.m_Parent;
+	nodeA.m_Parent = b;
+
+	if (nodeB.m_Parent == kNull)
+		m_Root = b;
+	else if (m_Nodes[nodeB.m_Parent].m_Child[0] == a)
+		m_Nodes[nodeB.m_Parent].m_Child[0] = b;
+	else
+		m_Nodes[nodeB.m_Parent].m_Child[1] = b;
+
+	// the deeper of b's children stays with b, the other goes to a
+	int const keep = m_Nodes[f].m_Height > m_Nodes[g].m_Height ? f : g;
+	int const give = keep == f ? g : f;
+
+	nodeB.m_Child[1] = keep;
+	nodeA.m_Child[up] = give;
+	m_Nodes[give].m_Parent = a;
+
+	Combine(nodeA.m_Box, m_Nodes[stays].m_Box, m_Nodes[give].m_Box);
+	nodeA.m_Height = 1 + std::max(m_Nodes[stays].m_Height, m_Nodes[give].m_Height);
+
+	Combine(nodeB.m_Box, nodeA.m_Box, m_Nodes[keep].m_Box);
+	nodeB.m_Height = 1 + std::max(nodeA.m_Height, m_Nodes[keep].m_Height);
+
+	return b;
+}
+
+//
+// BoundingVolumeTree::FattenedBox			- not in the book
+//
+void BoundingVolumeTree::FattenedBox(Node &leaf) const
+{
+	float const reach = leaf.m_Radius + m_Margin;
+	for (int i = 0; i < 3; ++i)
+	{
+		leaf.m_Box.m_Min[i] = leaf.m_Center[i] - reach;
+		leaf.m_Box.m_Max[i] = leaf.m_Center[i] + reach;
+	}
+}
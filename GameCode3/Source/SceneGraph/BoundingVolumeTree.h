@@ -0,0 +1,171 @@
+#pragma once
+//========================================================================
+// BoundingVolumeTree.h : What the camera can see, for the whole scene at once
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class BoundingVolumeTree		- not in the book
+//========================================================================
+
+// What the camera can see, worked out for the whole scene at once
+// rather than asked of one scene node at a time. Like
+// TransformHierarchy nothing here needs DirectX - see
+// Headless/SceneBench.
+
+#include <vector>
+
+
+////////////////////////////////////////////////////
+//
+// BoundingVolumeTree Description
+//
+//   A dynamic bounding volume hierarchy - a binary tree of boxes, each
+//   around the two under it - over the scene nodes' bounding spheres.
+//   Cull() walks it from the top, so a box that's wholly outside the
+//   frustum throws away everything in it with one test, and a box
+//   that's wholly inside takes everything in it without any more.
+//   Each box also remembers which planes it was already inside, so
+//   the ones under it don't test those again.
+//
+//   A leaf's box is its sphere's, and a margin bigger, so a sphere
+//   that moves a little stays inside it and nothing has to change.
+//   One that moves out of its box is taken out and put back in,
+//   beside whatever it makes the smallest box with; the boxes above it
+//   are then refitted, and turned about where one side's got deeper
+//   than the other, so the tree stays balanced as the actors move.
+//
+//   Each sphere's known by an id the caller picks - the Scene uses its
+//   nodes' TransformHierarchy handles - and they're kept in an array
+//   by id, so use small ones.
+//
+//		bounds.Insert(id, center, radius);
+//		...
+//		bounds.Move(id, newCenter);
+//		bounds.Cull(planes, 6);
+//		if (bounds.IsVisible(id))
+//			... draw it
+//
+//   A Plane is laid out as a D3DXPLANE is, and a point's inside it if
+//   a*x + b*y + c*z + d >= 0 - as Plane::Inside() has it - so a
+//   Frustum's planes can be cast to them.
+//
+////////////////////////////////////////////////////
+
+class BoundingVolumeTree
+{
+public:
+	enum { kMaxPlanes = 32 };
+
+	struct Plane
+	{
+		float a, b, c, d;
+	};
+
+	// 'margin' is how far a leaf's box is outside its sphere, in world
+	// units - how far it can move before the tree changes.
+	explicit BoundingVolumeTree(float margin = 1.0f);
+
+	void Insert(int id, float const center[3], float radius);
+	void Remove(int id);
+	void Move(int id, float const center[3]);
+	void Resize(int id, float radius);
+	bool Contains(int id) const { return id < static_cast<int>(m_LeafOf.size()) && m_LeafOf[id] != kNull; }
+
+	// Marks every sphere that's at least partly inside all the planes,
+	// for IsVisible() - up to kMaxPlanes of them. How many it marked.
+	unsigned int Cull(Plane const *pPlanes, int numPlanes);
+
+	// As of the last Cull().
+	bool IsVisible(int id) const { return m_Nodes[m_LeafOf[id]].m_Culled == m_CullCount; }
+
+	unsigned int GetCount() const { return m_Count; }
+	int GetHeight() const { return m_Root == kNull ? 0 : m_Nodes[m_Root].m_Height; }
+
+	// How many boxes and spheres the last Cull() tested against a plane.
+	unsigned int GetLastCullTests() const { return m_CullTests; }
+
+private:
+	enum { kNull = -1 };
+
+	struct Box
+	{
+		float m_Min[3];
+		float m_Max[3];
+	};
+
+	// A leaf has its sphere in it, so Cull() only has the one node to
+	// read for it - 64 bytes, a cache line.
+	struct Node
+	{
+		Box m_Box;
+		int m_Parent;						// or the next free one
+		int m_Child[2];						// both kNull for a leaf
+		int m_Height;						// 0 for a leaf
+
+		// a leaf's
+		float m_Center[3];
+		float m_Radius;
+		int m_Id;
+		unsigned int m_Culled;				// the Cull() that last saw it
+
+		bool IsLeaf() const { return m_Child[0] == kNull; }
+	};
+
+	int AllocNode();
+	void FreeNode(int node);
+
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	void Refit(int leaf);
+	void FixUpwards(int node);
+	int Balance(int node);
+
+	void FattenedBox(Node &leaf) const;
+
+	std::vector<Node> m_Nodes;
+	int m_Root;
+	int m_FreeNodes;
+
+	std::vector<int> m_LeafOf;				// by id
+	unsigned int m_Count;
+
+	float m_Margin;
+
+	unsigned int m_CullCount;
+	unsigned int m_CullTests;
+	std::vector<std::pair<int, unsigned int> > m_Stack;		// node, the planes it isn't inside yet
+};
@@ -147,6 +147,19 @@ void SceneNodeProperties::Transform(Mat4x4 *toWorld, Mat4x4 *fromWorld) const
 // SceneNode Implementation
 ////////////////////////////////////////////////////
 
+namespace
+{
+	// A Mat4x4 is laid out just as TransformHierarchy::Matrix is.
+	TransformHierarchy::Matrix const &AsTransform(Mat4x4 const &mat)
+	{
+		return reinterpret_cast<TransformHierarchy::Matrix const &>(mat);
+	}
+
+	Mat4x4 const &AsMat4x4(TransformHierarchy::Matrix const &mat)
+	{
+		return reinterpret_cast<Mat4x4 const &>(mat);
+	}
+}
 
 
 SceneNode::~SceneNode()
@@ -160,6 +173,8 @@ SceneNode::~SceneNode()
 	//	{
 	//		m_Children.pop_front();
 	//	}
+
+	DetachFromScene();
 }
 
 //
@@ -197,14 +212,93 @@ void SceneNode::VSetTransform(const Mat4x4 *toWorld, const Mat4x4 *fromWorld)
 	{
 		m_Props.m_FromWorld = *fromWorld;
 	}
+
+	if (m_pScene)
+		m_pScene->GetTransforms().SetLocal(m_Transform, AsTransform(m_Props.m_ToWorld));
+}
+
+//
+// SceneNode::SetPosition					- not in the book
+//
+void SceneNode::SetPosition(const Vec3 &pos)
+{
+	m_Props.m_ToWorld.SetPosition(pos);
+
+	if (m_pScene)
+		m_pScene->GetTransforms().SetLocal(m_Transform, AsTransform(m_Props.m_ToWorld));
+}
+
+//
+// SceneNode::SetRadius						- not in the book
+//
+void SceneNode::SetRadius(const float radius)
+{
+	m_Props.m_Radius = radius;
+
+	if (m_pScene)
+		m_pScene->GetBounds().Resize(m_Transform, radius);
+}
+
+//
+// SceneNode::AttachToScene					- not in the book
+//
+//   Puts it and everything under it in the scene's hierarchy, parents
+//   first, and their spheres in its bounds. Where a sphere is in the
+//   world isn't known until the hierarchy's next updated, which moves
+//   it there.
+//
+void SceneNode::AttachToScene(Scene *pScene, int parent)
+{
+	assert(!m_pScene && _T("Scene node is in a scene already"));
+
+	m_pScene = pScene;
+	m_Transform = pScene->GetTransforms().Add(parent, AsTransform(m_Props.m_ToWorld));
+	pScene->GetBounds().Insert(m_Transform, m_Props.m_ToWorld.m[3], m_Props.m_Radius);
+
+	for (SceneNodeList::iterator i = m_Children.begin(); i != m_Children.end(); ++i)
+	{
+		SceneNode *pKid = dynamic_cast<SceneNode *>(i->get());
+		if (pKid)
+			pKid->AttachToScene(pScene, m_Transform);
+	}
+}
+
+//
+// SceneNode::DetachFromScene				- not in the book
+//
+//   Children first - the hierarchy never has a node without its parent.
+//
+void SceneNode::DetachFromScene()
+{
+	if (!m_pScene)
+		return;
+
+	for (SceneNodeList::iterator i = m_Children.begin(); i != m_Children.end(); ++i)
+	{
+		SceneNode *pKid = dynamic_cast<SceneNode *>(i->get());
+		if (pKid)
+			pKid->DetachFromScene();
+	}
+
+	m_pScene->GetBounds().Remove(m_Transform);
+	m_pScene->GetTransforms().Remove(m_Transform);
+	m_pScene = NULL;
+	m_Transform = -1;
 }
 
 //
 // SceneNode::VPreRender					- Chapter 14, page 476
 //
+//   Scene::OnRender() has brought the hierarchy up to date, so what's
+//   in it is this node's transform times everything above it - unless
+//   it's been moved since, as SkyNode moves itself here.
+//
 HRESULT SceneNode::VPreRender(Scene *pScene) 
 {
-	pScene->PushAndSetMatrix(m_Props.m_ToWorld);
+	if (m_pScene == pScene && !pScene->GetTransforms().IsDirty(m_Transform))
+		pScene->PushAndLoadMatrix(AsMat4x4(pScene->GetTransforms().GetWorld(m_Transform)));
+	else
+		pScene->PushAndSetMatrix(m_Props.m_ToWorld);
 	return S_OK;
 }
 
@@ -224,6 +318,10 @@ HRESULT SceneNode::VPostRender(Scene *pScene)
 //	
 bool SceneNode::VIsVisible(Scene *pScene) const
 {
+	// Scene::OnRender() has culled all of it at once - see Scene::Cull()
+	if (m_pScene == pScene)
+		return pScene->GetBounds().IsVisible(m_Transform);
+
 	// transform the location of this node into the camera space 
 	// of the camera attached to the scene
 
@@ -346,12 +444,16 @@ bool SceneNode::VAddChild(shared_ptr<ISceneNode> kid)
 {
 	m_Children.push_back(kid); 
 
+	SceneNode *pKid = dynamic_cast<SceneNode *>(kid.get());
+	if (m_pScene && pKid)
+		pKid->AttachToScene(m_pScene, m_Transform);
+
 	// The radius of the sphere should be fixed right here
 	Vec3 kidPos = kid->VGet()->ToWorld().GetPosition();
 	Vec3 dir = kidPos - m_Props.ToWorld().GetPosition();
 	float newRadius = dir.Length() + kid->VGet()->Radius();
 	if (newRadius > m_Props.m_Radius)
-		m_Props.m_Radius = newRadius;
+		SetRadius(newRadius);
 	return true; 
 }
 
@@ -370,6 +472,10 @@ bool SceneNode::VRemoveChild(ActorId id)
 		const SceneNodeProperties* pProps = (*i)->VGet();
 		if(pProps->ActorId().valid() && id==*pProps->ActorId())
 		{
+			SceneNode *pKid = dynamic_cast<SceneNode *>(i->get());
+			if (pKid)
+				pKid->DetachFromScene();
+
 			i = m_Children.erase(i);	//this can be expensive for vectors
 			return true;
 		}
@@ -405,6 +511,7 @@ HRESULT SceneNode::VPick(Scene *pScene, RayCast *raycast)
 Scene::Scene()
 {
 	m_Root.reset(GCC_NEW RootNode());
+	m_Root->AttachToScene(this, TransformHierarchy::kNoParent);
 	D3DXCreateMatrixStack(0, &m_MatrixStack);
 }
 
@@ -413,6 +520,9 @@ Scene::Scene()
 //
 Scene::~Scene()
 {
+	// A node can outlive the scene - the view has the camera - so
+	// none of them can be left pointing at it.
+	m_Root->DetachFromScene();
 	SAFE_RELEASE(m_MatrixStack);
 }
 
@@ -443,6 +553,7 @@ HRESULT Scene::OnRender()
 		// matrix
 
 		m_Camera->SetViewTransform(this);
+		Cull();
 
 		if (m_Root->VPreRender(this)==S_OK)
 		{
@@ -511,6 +622,35 @@ HRESULT Scene::OnUpdate(const int deltaMilliseconds)
 	return m_Root->VOnUpdate(this, elapsedTime);
 }
 
+//
+// Scene::Cull						- not in the book
+//
+//   Brings the transforms up to date - everything that's moved since
+//   the last frame, and the camera - moves the bounding spheres of
+//   what's changed, and culls all of them at once. The frustum's
+//   planes are in camera space, so they're taken into world space once
+//   here, rather than every node into camera space.
+//
+void Scene::Cull()
+{
+	m_Moved.clear();
+	m_Transforms.Update(&m_Moved);
+	for (std::vector<int>::const_iterator i = m_Moved.begin(); i != m_Moved.end(); ++i)
+		m_Bounds.Move(*i, m_Transforms.GetWorld(*i).m[3]);
+
+	// D3DXPlaneTransform() wants the inverse transpose of the camera's
+	// transform, and the inverse is FromWorld()
+	Mat4x4 planeTransform;
+	D3DXMatrixTranspose(&planeTransform, &m_Camera->VGet()->FromWorld());
+
+	Frustum const &frustum = m_Camera->GetFrustum();
+	Plane planes[Frustum::NumPlanes];
+	for (int i = 0; i < Frustum::NumPlanes; ++i)
+		D3DXPlaneTransform(&planes[i], &frustum.m_Planes[i], &planeTransform);
+
+	m_Bounds.Cull(reinterpret_cast<BoundingVolumeTree::Plane const *>(planes), Frustum::NumPlanes);
+}
+
 //
 // Scene::FindActor					- Chapter 14, page 487
 //
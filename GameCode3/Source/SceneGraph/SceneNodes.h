@@ -53,6 +53,8 @@
 //  class ShaderMeshNode		- Chapter 14, page 516
 
 #include "Geometry.h"
+#include "TransformHierarchy.h"
+#include "BoundingVolumeTree.h"
 
 
 // Forward declarations
@@ -199,6 +201,13 @@ typedef std::vector<shared_ptr<ISceneNode> > SceneNodeList;
 //   Implements ISceneNode. Forms the base class for any node
 //   that can exist in the 3D scene graph managed by class Scene.
 //
+//   Once it's in a Scene its transform is in the Scene's
+//   TransformHierarchy too, which works out where it is in the
+//   world before the scene's drawn - VPreRender() puts that on the
+//   matrix stack instead of multiplying its own onto the top. Its
+//   bounding sphere's in the Scene's BoundingVolumeTree, under the
+//   same handle, and VIsVisible() asks that.
+//
 //////////////////////////////////////////////////////////////
 
 class SceneNode : public ISceneNode
@@ -210,10 +219,18 @@ protected:
 	SceneNode				*m_pParent;
 	SceneNodeProperties		m_Props;
 
+	Scene					*m_pScene;			// the one it's in, if it's in one
+	int						m_Transform;		// its handle in the scene's TransformHierarchy and BoundingVolumeTree
+
+	void AttachToScene(Scene *pScene, int parent);
+	void DetachFromScene();
+
 public:
 	SceneNode(optional<ActorId> actorId, std::string name, RenderPass renderPass, const Mat4x4 *to, const Mat4x4 *from=NULL) 
 	{ 
 		m_pParent= NULL;
+		m_pScene = NULL;
+		m_Transform = -1;
 		m_Props.m_ActorId = actorId;
 		m_Props.m_Name = name;
 		m_Props.m_RenderPass = renderPass;
@@ -244,9 +261,9 @@ public:
 	virtual void SetAlpha(float alpha) { return m_Props.SetAlpha(alpha); }
 
 	Vec3 GetPosition() const { return m_Props.m_ToWorld.GetPosition(); }
-	void SetPosition(const Vec3 &pos) { m_Props.m_ToWorld.SetPosition(pos); }
+	void SetPosition(const Vec3 &pos);
 
-	void SetRadius(const float radius) { m_Props.m_Radius = radius; }
+	void SetRadius(const float radius);
 	void SetMaterial(const Material &mat) { m_Props.m_Material = mat; }
 
 	// Most scene nodes will not have actor params, so they return a NULL pointer.
@@ -326,6 +343,9 @@ class SkyNode;
 class Scene
 {
 protected:
+	TransformHierarchy		m_Transforms;		// these before m_Root, so they go after it
+	BoundingVolumeTree		m_Bounds;
+	std::vector<int>		m_Moved;			// what m_Transforms last updated
 	shared_ptr<SceneNode>  	m_Root;
 	shared_ptr<CameraNode> 	m_Camera;
 	ID3DXMatrixStack 		*m_MatrixStack;
@@ -335,6 +355,7 @@ protected:
 	D3DLIGHT9				m_Light;
 
 	void RenderAlphaPass();
+	void Cull();
 
 public:
 
@@ -375,6 +396,18 @@ public:
 		DXUTGetD3D9Device()->SetTransform(D3DTS_WORLD, m_MatrixStack->GetTop());
 	}
 
+	void PushAndLoadMatrix(const Mat4x4 &world)
+	{
+		// Scene::PushAndLoadMatrix - not in the book
+		//   For a matrix that's already been multiplied down from the
+		//   root - a TransformHierarchy's - so it replaces the top
+		//   rather than going on to it.
+
+		m_MatrixStack->Push();
+		m_MatrixStack->LoadMatrix(&world);
+		DXUTGetD3D9Device()->SetTransform(D3DTS_WORLD, m_MatrixStack->GetTop());
+	}
+
 	void PopMatrix() 
 	{
 		// Scene::PopMatrix - Chapter 14, page 486
@@ -394,6 +427,9 @@ public:
 
 	HRESULT Pick(RayCast *pRayCast) { return m_Root->VPick(this, pRayCast); }
 
+	TransformHierarchy &GetTransforms() { return m_Transforms; }
+	BoundingVolumeTree &GetBounds() { return m_Bounds; }
+
 };
 
 ////////////////////////////////////////////////////
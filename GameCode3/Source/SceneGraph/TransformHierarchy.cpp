@@ -0,0 +1,231 @@
+//========================================================================
+// TransformHierarchy.cpp : Every scene node's world transform, kept up to date
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class TransformHierarchy		- not in the book
+//========================================================================
+
+#include "GameCodeStd.h"
+
+#include "TransformHierarchy.h"
+
+
+namespace
+{
+	// m_Parent's for a hole Remove() has left
+	const int kRemoved = -2;
+}
+
+
+//
+// TransformHierarchy::TransformHierarchy	- not in the book
+//
+TransformHierarchy::TransformHierarchy()
+{
+	m_FirstDirty = 0;
+	m_Removed = 0;
+}
+
+//
+// TransformHierarchy::Add					- not in the book
+//
+int TransformHierarchy::Add(int parent, Matrix const &local)
+{
+	assert((parent == kNoParent || m_IndexOf[parent] >= 0) && "TransformHierarchy::Add() - no such parent");
+
+	int const index = static_cast<int>(m_Parent.size());
+
+	int handle;
+	if (m_FreeHandles.empty())
+	{
+		handle = static_cast<int>(m_IndexOf.size());
+		m_IndexOf.push_back(index);
+	}
+	else
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+		m_IndexOf[handle] = index;
+	}
+
+	m_Local.push_back(local);
+	m_World.push_back(local);
+	m_Parent.push_back(parent == kNoParent ? kNoParent : m_IndexOf[parent]);
+	m_Handle.push_back(handle);
+	m_Dirty.push_back(1);
+
+	if (static_cast<unsigned int>(index) < m_FirstDirty)
+		m_FirstDirty = index;
+	return handle;
+}
+
+//
+// TransformHierarchy::Remove				- not in the book
+//
+void TransformHierarchy::Remove(int handle)
+{
+	int const index = m_IndexOf[handle];
+	assert(index >= 0 && "TransformHierarchy::Remove() - removed already");
+
+	m_Parent[index] = kRemoved;
+	m_Dirty[index] = 0;
+	m_IndexOf[handle] = -1;
+	m_FreeHandles.push_back(handle);
+	++m_Removed;
+}
+
+//
+// TransformHierarchy::SetLocal				- not in the book
+//
+void TransformHierarchy::SetLocal(int handle, Matrix const &local)
+{
+	int const index = m_IndexOf[handle];
+	m_Local[index] = local;
+	m_Dirty[index] = 1;
+
+	if (static_cast<unsigned int>(index) < m_FirstDirty)
+		m_FirstDirty = index;
+}
+
+//
+// TransformHierarchy::Update				- not in the book
+//
+//   A node's dirty flag is set on the way past if its parent's is, so
+//   the flags are what's changed this pass as well as what was set -
+//   and all of them are cleared together at the end.
+//
+unsigned int TransformHierarchy::Update(std::vector<int> *pMoved)
+{
+	if (m_Removed)
+		Compact();
+
+	unsigned int const count = static_cast<unsigned int>(m_Parent.size());
+	if (m_FirstDirty >= count)
+		return 0;
+
+	unsigned int updated = 0;
+	for (unsigned int i = m_FirstDirty; i < count; ++i)
+	{
+		int const parent = m_Parent[i];
+		if (parent == kNoParent)
+		{
+			if (!m_Dirty[i])
+				continue;
+			m_World[i] = m_Local[i];
+		}
+		else if (m_Dirty[i] || m_Dirty[parent])
+		{
+			Multiply(m_World[i], m_Local[i], m_World[parent]);
+			m_Dirty[i] = 1;
+		}
+		else
+		{
+			continue;
+		}
+
+		++updated;
+		if (pMoved)
+			pMoved->push_back(m_Handle[i]);
+	}
+
+	memset(&m_Dirty[m_FirstDirty], 0, count - m_FirstDirty);
+	m_FirstDirty = count;
+	return updated;
+}
+
+//
+// TransformHierarchy::Compact				- not in the book
+//
+//   Everything that's left moves up over the holes, in the order it
+//   was in, so parents still come first. A node's parent is never
+//   removed before it is, so m_Parent only has to be moved up by the
+//   same amount as the parent was.
+//
+void TransformHierarchy::Compact()
+{
+	unsigned int const count = static_cast<unsigned int>(m_Parent.size());
+
+	std::vector<int> moved(count);
+	unsigned int to = 0;
+	for (unsigned int from = 0; from < count; ++from)
+	{
+		if (m_Parent[from] == kRemoved)
+			continue;
+
+		moved[from] = to;
+		if (to != from)
+		{
+			m_Local[to] = m_Local[from];
+			m_World[to] = m_World[from];
+			m_Handle[to] = m_Handle[from];
+			m_Dirty[to] = m_Dirty[from];
+			m_IndexOf[m_Handle[to]] = to;
+		}
+		m_Parent[to] = m_Parent[from] == kNoParent ? kNoParent : moved[m_Parent[from]];
+
+		if (m_Dirty[to] && to < m_FirstDirty)
+			m_FirstDirty = to;
+		++to;
+	}
+
+	m_Local.resize(to);
+	m_World.resize(to);
+	m_Parent.resize(to);
+	m_Handle.resize(to);
+	m_Dirty.resize(to);
+
+	if (m_FirstDirty > to)
+		m_FirstDirty = to;
+	m_Removed = 0;
+}
+
+//
+// TransformHierarchy::Multiply				- not in the book
+//
+//   out = a * b, as D3DXMatrixMultiply() does it. out mustn't be
+//   either of them.
+//
+void TransformHierarchy::Multiply(Matrix &out, Matrix const &a, Matrix const &b)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		float const a0 = a.m[row][0], a1 = a.m[row][1], a2 = a.m[row][2], a3 = a.m[row][3];
+		for (int col = 0; col < 4; ++col)
+			out.m[row][col] = a0 * b.m[0][col] + a1 * b.m[1][col] + a2 * b.m[2][col] + a3 * b.m[3][col];
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+//========================================================================
+// TransformHierarchy.h : Every scene node's world transform, kept up to date
+//
+// Part of the GameCode3 Application
+//
+// GameCode3 is the sample application that encapsulates much of the source code
+// discussed in "Game Coding Complete - 3rd Edition" by Mike McShaffry, published by
+// Charles River Media. ISBN-10: 1-58450-680-6   ISBN-13: 978-1-58450-680-5
+//
+// If this source code has found it's way to you, and you think it has helped you
+// in any way, do the author a favor and buy a new copy of the book - there are 
+// detailed explanations in it that compliment this code well. Buy a copy at Amazon.com
+// by clicking here: 
+//    http://www.amazon.com/gp/product/1584506806?ie=UTF8&tag=gamecodecompl-20&linkCode=as2&camp=1789&creative=390957&creativeASIN=1584506806
+//
+// There's a companion web site at http://www.mcshaffry.com/GameCode/
+// 
+// The source code is managed and maintained through Google Code: http://gamecode3.googlecode.com/svn/trunk/
+//
+// (c) Copyright 2009 Michael L. McShaffry
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License v2
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//========================================================================
+
+//========================================================================
+//  Content References in Game Coding Complete 3rd Edition
+//
+//  class TransformHierarchy		- not in the book
+//========================================================================
+
+// Where every scene node is in the world, worked out once a frame and
+// kept, rather than multiplied down the matrix stack every time the
+// scene is drawn. Nothing here needs DirectX - see Headless/SceneBench.
+
+#include <vector>
+
+
+////////////////////////////////////////////////////
+//
+// TransformHierarchy Description
+//
+//   The transforms of a tree of nodes, each as it is to its parent -
+//   what SceneNode::VSetTransform() is handed - and as it is to the
+//   world. They're kept an array of each, not an array of nodes, and
+//   in an order where every node comes after its parent, so
+//
+//		world[i] = local[i] * world[parent[i]]
+//
+//   can be worked out for every node in one pass from the front. A
+//   node is dirty once its transform's been set; Update() only does
+//   the sum for the dirty ones and everything under them, and only
+//   from the first dirty one on. With nothing moving it costs nothing.
+//
+//   A node is added after its parent, at the back, so the order's
+//   always right. A node that's removed leaves a hole that the next
+//   Update() closes up, keeping everything else in the same order.
+//   That's why a node's known by a handle and not where it is.
+//
+//		int root = transforms.Add(TransformHierarchy::kNoParent, identity);
+//		int kid = transforms.Add(root, offset);
+//		...
+//		transforms.SetLocal(kid, moved);
+//		transforms.Update();
+//		pDevice->SetTransform(D3DTS_WORLD, transforms.GetWorld(kid));
+//
+//   A Matrix is laid out as a D3DXMATRIX - and so a Mat4x4 - is, row
+//   by row, and they're multiplied the same way, so one can be cast to
+//   the other.
+//
+////////////////////////////////////////////////////
+
+class TransformHierarchy
+{
+public:
+	enum { kNoParent = -1 };
+
+	struct Matrix
+	{
+		float m[4][4];
+	};
+
+	TransformHierarchy();
+
+	// The new node's handle. It's dirty until the next Update().
+	int Add(int parent, Matrix const &local);
+
+	// Only the node - any children it has have to go first, or with it
+	// before the next Update().
+	void Remove(int handle);
+
+	void SetLocal(int handle, Matrix const &local);
+	Matrix const &GetLocal(int handle) const { return m_Local[m_IndexOf[handle]]; }
+
+	// As of the last Update().
+	Matrix const &GetWorld(int handle) const { return m_World[m_IndexOf[handle]]; }
+
+	// Set since the last Update(), so its world transform is out of
+	// date - though one under a dirty node isn't dirty itself.
+	bool IsDirty(int handle) const { return m_Dirty[m_IndexOf[handle]] != 0; }
+
+	// Closes up anything removed, then brings every world transform up
+	// to date. How many it had to work out - and which, on the end of
+	// pMoved if there is one.
+	unsigned int Update(std::vector<int> *pMoved = NULL);
+
+	unsigned int GetCount() const { return static_cast<unsigned int>(m_Parent.size() - m_Removed); }
+
+	static void Multiply(Matrix &out, Matrix const &a, Matrix const &b);
+
+private:
+	void Compact();
+
+	// by where each node is, parents first
+	std::vector<Matrix> m_Local;
+	std::vector<Matrix> m_World;
+	std::vector<int> m_Parent;					// where its parent is, or kNoParent
+	std::vector<int> m_Handle;
+	std::vector<unsigned char> m_Dirty;
+
+	// by handle
+	std::vector<int> m_IndexOf;					// -1 for a free one
+	std::vector<int> m_FreeHandles;
+
+	unsigned int m_FirstDirty;					// nothing before it is
+	unsigned int m_Removed;						// holes waiting for Compact()
+};
@@ -101,7 +101,7 @@ bool ScriptActorEventListener::VCallLuaFunction( LuaObject & eventData )
 	
 	// This is more sanity checking than anything, to ensure that the actor
 	// still exists.
-	shared_ptr< IActor > gameActor = g_pApp->m_pGame->VGetActor( m_SrcActorID );
+	shared_ptr< IActor > gameActor = g_pApp->GetCurrentGame()->VGetActor( m_SrcActorID );
 	if ( !gameActor )
 	{
 		assert( 0 && "Attempted to call a script listener for an actor that couldn't be found!  Did you delete the actor without removing all listeners?" );
@@ -109,8 +109,8 @@ bool ScriptActorEventListener::VCallLuaFunction( LuaObject & eventData )
 	}
 
 	// Get ahold of the actor's script data.
-	LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
-	LuaObject globalActorTable = g_pApp->m_pLuaStateManager->GetGlobalActorTable();
+	LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
+	LuaObject globalActorTable = g_pApp->GetCurrentLuaStateManager()->GetGlobalActorTable();
 	assert( globalActorTable.IsTable() && "Global actor table is NOT a table!" );
 	LuaObject actorData = globalActorTable[ m_SrcActorID ];
 
@@ -63,9 +63,9 @@ const float AI_TEAPOT_ATTACK_MAX = 30.0f;
 void MoveState::RotateAndMove(const int deltaMilliseconds)
 {
 	// grab the necessary interfaces
-	shared_ptr<IGamePhysics> pPhysics = g_pApp->m_pGame->VGetGamePhysics();
+	shared_ptr<IGamePhysics> pPhysics = g_pApp->GetCurrentGame()->VGetGamePhysics();
 	assert(pPhysics);
-	shared_ptr<IActor> pActor = g_pApp->m_pGame->VGetActor(m_actorId);
+	shared_ptr<IActor> pActor = g_pApp->GetCurrentGame()->VGetActor(m_actorId);
 	assert(pActor);
 
 	// calculate orientation
@@ -116,7 +116,7 @@ AttackState::AttackState(const ActorId& actorId, StateMachine* pStateMachine) :
 void AttackState::VOnInitialize(void)
 {
 	AiState::VOnInitialize();
-	m_victim = g_pApp->m_pGame->GetRandomActor(m_actorId);
+	m_victim = g_pApp->GetCurrentGame()->GetRandomActor(m_actorId);
 	m_timer = AI_TEAPOT_FIRE_TIMER;
 }
 
@@ -134,11 +134,11 @@ void AttackState::VOnUpdate(const int deltaMilliseconds)
 	
 	// Grab the actors.  If we can't find the victim actor, it means he was destroyed so we 
 	// go about our business.
-	shared_ptr<IGamePhysics> pPhysics = g_pApp->m_pGame->VGetGamePhysics();
+	shared_ptr<IGamePhysics> pPhysics = g_pApp->GetCurrentGame()->VGetGamePhysics();
 	assert(pPhysics);
-	shared_ptr<IActor> pActor = g_pApp->m_pGame->VGetActor(m_actorId);
+	shared_ptr<IActor> pActor = g_pApp->GetCurrentGame()->VGetActor(m_actorId);
 	assert(pActor);
-	shared_ptr<IActor> pVictim = g_pApp->m_pGame->VGetActor(m_victim);
+	shared_ptr<IActor> pVictim = g_pApp->GetCurrentGame()->VGetActor(m_victim);
 	if (!pVictim)
 	{
 		m_pStateMachine->SetState("wander");
@@ -199,7 +199,7 @@ void AttackState::AttemptToFireWeapon(void)
 void ChaseTargetState::VOnInitialize(void)
 {
 	AiState::VOnInitialize();
-	m_victim = g_pApp->m_pGame->GetRandomActor(m_actorId);
+	m_victim = g_pApp->GetCurrentGame()->GetRandomActor(m_actorId);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -212,13 +212,13 @@ void ChaseTargetState::VOnUpdate(const int deltaMilliseconds)
 	m_pathingTimer += deltaMilliseconds;
 
 	// grab the necessary interfaces
-	shared_ptr<IGamePhysics> pPhysics = g_pApp->m_pGame->VGetGamePhysics();
+	shared_ptr<IGamePhysics> pPhysics = g_pApp->GetCurrentGame()->VGetGamePhysics();
 	assert(pPhysics);
-	shared_ptr<IActor> pActor = g_pApp->m_pGame->VGetActor(m_actorId);
+	shared_ptr<IActor> pActor = g_pApp->GetCurrentGame()->VGetActor(m_actorId);
 	assert(pActor);
 	
 	// Try to grab the victim.  If we can't, he's probably dead already so switch to wander.
-	shared_ptr<IActor> pVictim = g_pApp->m_pGame->VGetActor(m_victim);
+	shared_ptr<IActor> pVictim = g_pApp->GetCurrentGame()->VGetActor(m_victim);
 	if (!pVictim)
 	{
 		m_pStateMachine->SetState("wander");
@@ -293,7 +293,7 @@ void WanderState::VOnInitialize(void)
 	AiState::VOnInitialize();
 
 	// grab the actor
-	shared_ptr<IActor> pActor = g_pApp->m_pGame->VGetActor(m_actorId);
+	shared_ptr<IActor> pActor = g_pApp->GetCurrentGame()->VGetActor(m_actorId);
 	assert(pActor);
 
 	// build a path to a random node
@@ -316,9 +316,9 @@ void WanderState::VOnUpdate(const int deltaMilliseconds)
 	AiState::VOnUpdate(deltaMilliseconds);
 
 	// grab the necessary interfaces
-	shared_ptr<IGamePhysics> pPhysics = g_pApp->m_pGame->VGetGamePhysics();
+	shared_ptr<IGamePhysics> pPhysics = g_pApp->GetCurrentGame()->VGetGamePhysics();
 	assert(pPhysics);
-	shared_ptr<IActor> pActor = g_pApp->m_pGame->VGetActor(m_actorId);
+	shared_ptr<IActor> pActor = g_pApp->GetCurrentGame()->VGetActor(m_actorId);
 	assert(pActor);
 
 	// grab the actor's position
@@ -359,7 +359,7 @@ void SpinState::VOnUpdate(const int deltaMilliseconds)
 
 	if (m_turnTimer <= 0)
 	{
-		shared_ptr<IActor> pActor = g_pApp->m_pGame->VGetActor(m_actorId);
+		shared_ptr<IActor> pActor = g_pApp->GetCurrentGame()->VGetActor(m_actorId);
 		assert(pActor);
 
 		static bool flip = true;
@@ -379,7 +379,7 @@ void SpinState::DumpOrientation(void)
 {
 	wchar_t str[64];  // I'm sure this is overkill
 	memset(str,0,sizeof(wchar_t));
-	shared_ptr<IGamePhysics> pPhysics = g_pApp->m_pGame->VGetGamePhysics();
+	shared_ptr<IGamePhysics> pPhysics = g_pApp->GetCurrentGame()->VGetGamePhysics();
 	float deg = pPhysics->VGetOrientationY(m_actorId) * (180.0f / D3DX_PI);
 	swprintf_s(str,64,_T("Turn: %f\n"),deg);
 	OutputDebugString(str);
@@ -58,6 +58,7 @@
 
 #include "EventManager\Events.h"
 #include "EventManager\EventManagerImpl.h"
+#include "EventManager\EventFactory.h"
 
 TeapotWarsGameApp g_TeapotWarsApp;
 
@@ -97,6 +98,23 @@ void TeapotWarsGameApp::RegisterGameSpecificEvents( void )
 	m_pEventManager->RegisterCodeOnlyEvent( EvtData_Request_Start_Game::sk_EventType );
 	m_pEventManager->RegisterEvent< EvtData_Request_New_Actor >( EvtData_Request_New_Actor::sk_EventType );
 	m_pEventManager->RegisterEvent< EvtData_UpdateActorParams >( EvtData_UpdateActorParams::sk_EventType );
+
+	EventFactory::Register< EvtData_Fire_Weapon >();
+	EventFactory::Register< EvtData_Thrust >();
+	EventFactory::Register< EvtData_Steer >();
+	EventFactory::Register< EvtData_New_Game >();
+	EventFactory::Register< EvtData_Request_Start_Game >();
+	EventFactory::RegisterBinaryCreator< EvtData_Request_New_Actor >();
+	EventFactory::RegisterBinaryCreator< EvtData_UpdateActorParams >();
+
+	EventWire::Register< EvtData_Fire_Weapon >( EventWire::kFirstGameWireId + 0 );
+	EventWire::Register< EvtData_Thrust >( EventWire::kFirstGameWireId + 1 );
+	EventWire::Register< EvtData_Steer >( EventWire::kFirstGameWireId + 2 );
+	EventWire::Register< EvtData_New_Game >( EventWire::kFirstGameWireId + 3 );
+	EventWire::Register< EvtData_Request_Start_Game >( EventWire::kFirstGameWireId + 4 );
+	// these two make Lua tables - see EventWire
+	EventWire::Register< EvtData_Request_New_Actor >( EventWire::kFirstGameWireId + 5, NetChannel_ReliableOrdered, EventWire::kDecodeOnGameThread );
+	EventWire::Register< EvtData_UpdateActorParams >( EventWire::kFirstGameWireId + 6, NetChannel_ReliableOrdered, EventWire::kDecodeOnGameThread );
 }
 
 //
@@ -118,7 +136,9 @@ BaseGameLogic *TeapotWarsGameApp::VCreateGameAndView()
 	{
 		game = GCC_NEW TeapotWarsGameProxy(*m_pOptions);
 
-		EventListenerPtr listener ( GCC_NEW NetworkEventForwarder( 0 ) );
+		// with the sockets on their own thread, writing out the
+		// player's commands can go to a worker too
+		EventListenerPtr listener ( GCC_NEW NetworkEventForwarder( 0, m_pOptions->m_networkThread ) );
 		extern void ListenForTeapotGameCommands(EventListenerPtr listener);
 		ListenForTeapotGameCommands(listener);
 
@@ -130,6 +150,17 @@ BaseGameLogic *TeapotWarsGameApp::VCreateGameAndView()
 	return game;
 }
 
+//
+// TeapotWarsGameApp::VCreateGameInstance		- not in the book
+//
+//   A server's other games are only ever servers, and nobody sees them
+//   but their remote players - so there's no menu view.
+//
+BaseGameLogic *TeapotWarsGameApp::VCreateGameInstance()
+{
+	assert(m_pOptions && m_pOptions->m_gameHost.empty() && _T("Only a server runs more than one game."));
+	return GCC_NEW TeapotWarsGame(*m_pOptions);
+}
 
 
 
@@ -141,7 +172,7 @@ bool TeapotWarsGameApp::VLoadGame()
 	// Ordinarilly you'd read the game options and see what the current game
 	// needs to be - or perhaps pop up a dialog box and ask which game
 	// needed loading. All of the game graphics are initialized by now, too...
-	return m_pGame->VLoadGame("NewGame");
+	return GetCurrentGame()->VLoadGame("NewGame");
 }
 
 HICON TeapotWarsGameApp::VGetIcon()
@@ -215,10 +246,31 @@ bool TeapotWarsEventListener::HandleEvent( IEventData const & event )
 			shared_ptr<IGameView> gameView(netGameView);
 			m_TeapotWars->VAddView(gameView, actor->VGetID());
 
-			extern void ListenForTeapotViewEvents(EventListenerPtr listener);
+			// The book gave each remote player a NetworkEventForwarder
+			// of their own. One broadcaster for all of them writes each
+			// event out once, however many players there are.
+			if (!m_TeapotWars->m_remoteViewBroadcaster)
+			{
+				extern void ListenForTeapotViewEvents(EventListenerPtr listener);
 
-			EventListenerPtr listener ( GCC_NEW NetworkEventForwarder( sockID ) );
-			ListenForTeapotViewEvents( listener );
+				m_TeapotWars->m_remoteViewBroadcaster.reset( GCC_NEW NetworkEventBroadcaster );
+				ListenForTeapotViewEvents( m_TeapotWars->m_remoteViewBroadcaster );
+
+				// with snapshots, movement goes in those instead
+				if (m_TeapotWars->GetSnapshotReplicator())
+					safeDelListener( m_TeapotWars->m_remoteViewBroadcaster, EvtData_Move_Actor::sk_EventType );
+
+				m_TeapotWars->m_remoteViewBroadcaster->SetInterest( m_TeapotWars->GetInterestManager() );
+				m_TeapotWars->m_remoteViewBroadcaster->SetSnapshots( m_TeapotWars->GetSnapshotReplicator() );
+			}
+			m_TeapotWars->m_remoteViewBroadcaster->AddSocket( sockID );
+
+			// they see what's around their teapot
+			if (m_TeapotWars->GetInterestManager())
+				m_TeapotWars->GetInterestManager()->SetViewer( sockID, actor->VGetID() );
+
+			if (m_TeapotWars->GetSnapshotReplicator())
+				m_TeapotWars->GetSnapshotReplicator()->AddClient( sockID );
 		}
 	}
 
@@ -390,7 +442,7 @@ bool TeapotWarsEventListener::HandleEvent( IEventData const & event )
 	{
 		//Update the parameters for the specified actor.
 		const EvtData_UpdateActorParams & castEvent = static_cast< const EvtData_UpdateActorParams & >( event );
-		shared_ptr< IActor > destActor = g_pApp->m_pGame->VGetActor( castEvent.m_ActorID );
+		shared_ptr< IActor > destActor = g_pApp->GetCurrentGame()->VGetActor( castEvent.m_ActorID );
 
 		//Re-jigger the actor params.
 		BaseActor * pBaseActor = static_cast< BaseActor * >( destActor.get() );
@@ -433,8 +485,8 @@ void TeapotWarsBaseGame::VRemoveActor(ActorId aid)
 	}
 
 	//Call any script-related destructor.
-	LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
-	LuaObject globalActorTable = g_pApp->m_pLuaStateManager->GetGlobalActorTable();
+	LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
+	LuaObject globalActorTable = g_pApp->GetCurrentLuaStateManager()->GetGlobalActorTable();
 	assert( globalActorTable.IsTable() && "Global actor table is NOT a table!" );
 	LuaObject actorData = globalActorTable[ aid ];
 
@@ -442,7 +494,7 @@ void TeapotWarsBaseGame::VRemoveActor(ActorId aid)
 	if ( 0 != strlen( actorParams->m_OnDestroyLuaFunctionName ) )
 	{
 		//First attempt to FIND the function specified.
-		LuaObject foundObj = g_pApp->m_pLuaStateManager->GetGlobalState()->GetGlobal( actorParams->m_OnDestroyLuaFunctionName );
+		LuaObject foundObj = g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->GetGlobal( actorParams->m_OnDestroyLuaFunctionName );
 		if ( foundObj.IsNil() )
 		{
 			assert( 0 && "Unable to find specified OnDestroyFunc function!" );
@@ -485,8 +537,8 @@ void TeapotWarsBaseGame::VAddActor(shared_ptr<IActor> actor, ActorParams *p)
 	}
 
 	//Ensure script knows about this actor, too.
-	LuaState * pState = g_pApp->m_pLuaStateManager->GetGlobalState().Get();
-	LuaObject globalActorTable = g_pApp->m_pLuaStateManager->GetGlobalActorTable();
+	LuaState * pState = g_pApp->GetCurrentLuaStateManager()->GetGlobalState().Get();
+	LuaObject globalActorTable = g_pApp->GetCurrentLuaStateManager()->GetGlobalActorTable();
 	assert( globalActorTable.IsTable() && "Global actor table is NOT a table!" );
 	LuaObject addedActorData = globalActorTable.CreateTable( *p->m_Id );	//The actor ID is the key.
 	addedActorData.SetInteger( "ActorID", *p->m_Id );
@@ -505,7 +557,7 @@ void TeapotWarsBaseGame::VAddActor(shared_ptr<IActor> actor, ActorParams *p)
 	if ( 0 != strlen( p->m_OnCreateLuaFunctionName ) )
 	{
 		//First attempt to FIND the function specified.
-		LuaObject foundObj = g_pApp->m_pLuaStateManager->GetGlobalState()->GetGlobal( p->m_OnCreateLuaFunctionName );
+		LuaObject foundObj = g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->GetGlobal( p->m_OnCreateLuaFunctionName );
 		if ( foundObj.IsNil() )
 		{
 			assert( 0 && "Unable to find specified OnCreateFunc function!" );
@@ -566,15 +618,15 @@ TeapotWarsGame::TeapotWarsGame(GameOptions const &options)
 	//Open up access to script.
 	{
 		//Create our metatable...
-		m_MetaTable = g_pApp->m_pLuaStateManager->GetGlobalState()->GetGlobals().CreateTable("TeapotWarsGame");
+		m_MetaTable = g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->GetGlobals().CreateTable("TeapotWarsGame");
 		m_MetaTable.SetObject("__index", m_MetaTable);
 		
 //		m_MetaTable.RegisterObjectDirect( "SetCameraOffset", (TeapotWarsGame *)0, &TeapotWarsGame::SetCameraOffset);
 		m_MetaTable.RegisterObjectDirect< TeapotWarsGame > ( "SetCameraOffset", NULL, &TeapotWarsGame::SetCameraOffset); 
 
-		LuaObject luaStateManObj = g_pApp->m_pLuaStateManager->GetGlobalState()->BoxPointer(this);
+		LuaObject luaStateManObj = g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->BoxPointer(this);
 		luaStateManObj.SetMetaTable(m_MetaTable);
-		g_pApp->m_pLuaStateManager->GetGlobalState()->GetGlobals().SetObject("TeapotWarsGame", luaStateManObj);
+		g_pApp->GetCurrentLuaStateManager()->GetGlobalState()->GetGlobals().SetObject("TeapotWarsGame", luaStateManObj);
 	}
 }
 
@@ -655,6 +707,9 @@ void TeapotWarsGame::VOnUpdate(float time, float elapsedTime)
 		m_pPhysics->VOnUpdate(elapsedTime);
 		m_pPhysics->VSyncVisibleScene();
 	}
+
+	UpdateInterest();
+	UpdateSnapshots(deltaMilliseconds);
 }
 
 
@@ -50,6 +50,7 @@
 
 class TeapotWarsBaseGame;
 class PathingGraph;
+class NetworkEventBroadcaster;
 
 
 // Note: Don't put anything in this class that needs to be destructed
@@ -61,6 +62,7 @@ private:
 
 protected:
 	virtual BaseGameLogic *VCreateGameAndView();
+	virtual BaseGameLogic *VCreateGameInstance();
 	virtual bool VLoadGame();
 
 public:
@@ -124,6 +126,7 @@ protected:
 	int m_HumanPlayersAttached;
 	int m_AIPlayersAttached;
 	EventListenerPtr m_teapotWarsEventListener;
+	shared_ptr<NetworkEventBroadcaster> m_remoteViewBroadcaster;	// sends the view events to every remote player
 
 public:
 	TeapotWarsGame(struct GameOptions const &options);
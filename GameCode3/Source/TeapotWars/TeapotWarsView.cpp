@@ -58,6 +58,7 @@
 
 #include "EventManager\Events.h"
 #include "EventManager\EventManagerImpl.h"
+#include "EventManager\EventChannel.h"
 #include "ai\AiEvents.h"
 
 #include "Physics\PhysicsEventListener.h"
@@ -442,6 +443,7 @@ TeapotWarsGameView::TeapotWarsGameView()
 { 
 	m_BaseGameState = BGS_Initializing;
 	m_bShowUI = true; 
+	m_Interpolation.SetDelay(g_pApp->m_pOptions->m_interpolationDelay);
 
 	m_pScene.reset(GCC_NEW ScreenElementScene());
 
@@ -454,8 +456,8 @@ TeapotWarsGameView::TeapotWarsGameView()
 	m_pScene->SetCamera(m_pCamera);
 
 
-	EventListenerPtr listener ( GCC_NEW TeapotWarsGameViewListener( this ) );
-	ListenForTeapotViewEvents(listener);
+	shared_ptr<TeapotWarsGameViewListener> listener ( GCC_NEW TeapotWarsGameViewListener( this ) );
+	TeapotWarsGameViewListener::Subscribe(listener);
 }
 
 
@@ -515,6 +517,37 @@ LRESULT CALLBACK TeapotWarsGameView::VOnMsgProc( AppMsg msg )
 			extern void testRealtimeDecompression(CProcessManager *procMgr);
 			testRealtimeDecompression(m_pProcessManager);
 		}
+		else if (msg.m_wParam==VK_F6)
+		{
+			// text against binary event serialization, per event type
+			extern void testEventSerialization();
+			testEventSerialization();
+			return 1;
+		}
+		else if (msg.m_wParam==VK_F5)
+		{
+			// scheduling, cancelling and ticking 100k pending timers
+			extern void testTimerWheel();
+			testTimerWheel();
+			return 1;
+		}
+		else if (msg.m_wParam==VK_F7)
+		{
+			// start or stop an event trace - load EventTrace.json
+			// in chrome://tracing
+			EventProfiler & profiler = g_pApp->m_pEventManager->GetProfiler();
+			if (profiler.IsCapturing())
+			{
+				profiler.EndCapture();
+				profiler.WriteTrace("EventTrace.json");
+				profiler.DumpStats();
+			}
+			else
+			{
+				profiler.BeginCapture();
+			}
+			return 1;
+		}
 		else if (msg.m_wParam==VK_F8)
 		{
 			TeapotWarsGame *twg = static_cast<TeapotWarsGame *>(g_pApp->m_pGame);
@@ -679,6 +712,8 @@ void TeapotWarsGameView::VOnUpdate( int deltaMilliseconds )
 		m_pTeapotController->OnUpdate(deltaMilliseconds);
 	}
 
+	MoveInterpolatedActors();
+
 	//Send out a tick to script listeners.
 	const EvtData_Update_Tick tickEvent( deltaMilliseconds );
 	safeTriggerEvent( tickEvent );
@@ -711,6 +746,29 @@ void TeapotWarsGameView::MoveActor(ActorId id, Mat4x4 const &mat)
 	}
 }
 
+//
+// TeapotWarsGameView::MoveInterpolatedActors	- not in the book
+//
+//   A remote player's actors only move when the server says so. With
+//   an Interpolation_Delay they're drawn that far in the past (our own
+//   teapot never goes through here - see OnMoveActor), in
+//   between the updates either side, so they move smoothly however
+//   often and however unevenly the updates come in.
+//
+void TeapotWarsGameView::MoveInterpolatedActors()
+{
+	if (!m_Interpolation.GetDelay())
+		return;
+
+	m_Interpolation.Sample(timeGetTime(), m_Interpolated);
+	for (unsigned int i = 0; i < m_Interpolated.size(); ++i)
+	{
+		Mat4x4 mat;
+		BuildActorMat(m_Interpolated[i], mat);
+		MoveActor(m_Interpolated[i].m_ActorId, mat);
+	}
+}
+
 //
 // TeapotWarsGameView::HandleGameState			- Chapter 19, page 731
 //
@@ -766,149 +824,182 @@ TeapotWarsGameViewListener::TeapotWarsGameViewListener( TeapotWarsGameView *view
 
 
 //
-// TeapotWarsGameViewListener::HandleEvent					- Chapter 19, page 731
+// TeapotWarsGameViewListener::Subscribe					- not in the book
 //
-bool TeapotWarsGameViewListener::HandleEvent( IEventData const & event )
+//   This used to be one HandleEvent() with an if-chain over the event
+//   type. Each event now goes straight to its own handler.
+//
+void TeapotWarsGameViewListener::Subscribe( shared_ptr<TeapotWarsGameViewListener> const & listener )
 {
-	// [rez] removing event spew
-	//if ( EvtData_Move_Actor::sk_EventType.getHashValue() != event.VGetEventType().getHashValue() )
-	//{
-	//	OutputDebugStringA( event.VGetEventType().getStr().c_str() );
-	//	OutputDebugStringA("\n");
-	//}
-
-	if ( EvtData_PhysCollision::sk_EventType == event.VGetEventType() )
-	{
-		EvtData_PhysCollision const & ed = static_cast< const EvtData_PhysCollision & >( event );
-		shared_ptr<IActor> pGameActorA = g_pApp->m_pGame->VGetActor(ed.m_ActorA);
-		shared_ptr<IActor> pGameActorB = g_pApp->m_pGame->VGetActor(ed.m_ActorB);
-		if (!pGameActorA || !pGameActorB)
-			return false;
-			
-		int typeA = pGameActorA->VGetType();
-		int typeB = pGameActorB->VGetType();
+	char const * const name = "TeapotWarsGameViewListener";
+
+	EventChannel<EvtData_PhysCollision>::Subscribe( listener, &TeapotWarsGameViewListener::OnPhysCollision, name );
+	EventChannel<EvtData_Destroy_Actor>::Subscribe( listener, &TeapotWarsGameViewListener::OnDestroyActor, name );
+	EventChannel<EvtData_Fire_Weapon>::Subscribe( listener, &TeapotWarsGameViewListener::OnFireWeapon, name );
+	EventChannel<EvtData_New_Actor>::Subscribe( listener, &TeapotWarsGameViewListener::OnNewActor, name );
+	EventChannel<EvtData_Move_Actor>::Subscribe( listener, &TeapotWarsGameViewListener::OnMoveActor, name );
+	EventChannel<EvtData_Game_State>::Subscribe( listener, &TeapotWarsGameViewListener::OnGameState, name );
+	EventChannel<EvtData_Debug_String>::Subscribe( listener, &TeapotWarsGameViewListener::OnDebugString, name );
+	EventChannel<EvtData_UpdateActorParams>::Subscribe( listener, &TeapotWarsGameViewListener::OnUpdateActorParams, name );
+}
 
-		if(	(AT_Teapot==typeA && AT_Sphere==typeB)
-			|| (AT_Sphere==typeA && AT_Teapot==typeB) )
-		{
-			// play the sound a bullet makes when it hits a teapot
+//
+// TeapotWarsGameViewListener::OnPhysCollision				- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnPhysCollision( EvtData_PhysCollision const & ed )
+{
+	shared_ptr<IActor> pGameActorA = g_pApp->m_pGame->VGetActor(ed.m_ActorA);
+	shared_ptr<IActor> pGameActorB = g_pApp->m_pGame->VGetActor(ed.m_ActorB);
+	if (!pGameActorA || !pGameActorB)
+		return false;
+		
+	int typeA = pGameActorA->VGetType();
+	int typeB = pGameActorB->VGetType();
 
-			SoundResource resource("computerbeep3.wav");
-			shared_ptr<SoundResHandle> srh = boost::static_pointer_cast<SoundResHandle>(g_pApp->m_ResCache->GetHandle(&resource));
-			shared_ptr<SoundProcess> sfx(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 100, false));
-			m_pView->m_pProcessManager->Attach(sfx);
-		}
-	}
-	else
-	if ( EvtData_Destroy_Actor::sk_EventType == event.VGetEventType() )
-	{
-		const EvtData_Destroy_Actor & castEvent = static_cast< const EvtData_Destroy_Actor & >( event );
-		ActorId aid = castEvent.m_id;
-		m_pView->m_pScene->RemoveChild(aid);
-	}
-	else if ( EvtData_Fire_Weapon::sk_EventType == event.VGetEventType() )
+	if(	(AT_Teapot==typeA && AT_Sphere==typeB)
+		|| (AT_Sphere==typeA && AT_Teapot==typeB) )
 	{
-		// play a weapon fire sound
-		SoundResource resource("blip.wav");
+		// play the sound a bullet makes when it hits a teapot
+
+		SoundResource resource("computerbeep3.wav");
 		shared_ptr<SoundResHandle> srh = boost::static_pointer_cast<SoundResHandle>(g_pApp->m_ResCache->GetHandle(&resource));
-		shared_ptr<SoundProcess> sfx1(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 100, false));
-		shared_ptr<SoundProcess> sfx2(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 60, false));
-		shared_ptr<SoundProcess> sfx3(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 40, false));
-		m_pView->m_pProcessManager->Attach(sfx1);
-		sfx1->SetNext(sfx2);
-		sfx2->SetNext(sfx3);
-	}
-	else if ( EvtData_New_Game::sk_EventType == event.VGetEventType() )
-	{
-		// do nothing
+		shared_ptr<SoundProcess> sfx(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 100, false));
+		m_pView->m_pProcessManager->Attach(sfx);
 	}
-	else if ( EvtData_Move_Actor::sk_EventType == event.VGetEventType() )
+	return false;
+}
+
+//
+// TeapotWarsGameViewListener::OnDestroyActor				- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnDestroyActor( EvtData_Destroy_Actor const & castEvent )
+{
+	ActorId aid = castEvent.m_id;
+	m_pView->m_pScene->RemoveChild(aid);
+	m_pView->m_Interpolation.Remove(aid);
+	return false;
+}
+
+//
+// TeapotWarsGameViewListener::OnFireWeapon				- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnFireWeapon( EvtData_Fire_Weapon const & )
+{
+	// play a weapon fire sound
+	SoundResource resource("blip.wav");
+	shared_ptr<SoundResHandle> srh = boost::static_pointer_cast<SoundResHandle>(g_pApp->m_ResCache->GetHandle(&resource));
+	shared_ptr<SoundProcess> sfx1(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 100, false));
+	shared_ptr<SoundProcess> sfx2(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 60, false));
+	shared_ptr<SoundProcess> sfx3(GCC_NEW SoundProcess(srh, PROC_SOUNDFX, 40, false));
+	m_pView->m_pProcessManager->Attach(sfx1);
+	sfx1->SetNext(sfx2);
+	sfx2->SetNext(sfx3);
+	return false;
+}
+
+//
+// TeapotWarsGameViewListener::OnMoveActor					- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnMoveActor( EvtData_Move_Actor const & ed )
+{
+	// a remote player's are drawn a little later - see MoveInterpolatedActors() -
+	// but our own teapot has to answer the controls straight away
+	bool const ownTeapot = m_pView->m_pTeapot && m_pView->m_pTeapot->VGet()->ActorId().valid()
+		&& *m_pView->m_pTeapot->VGet()->ActorId() == ed.m_Id;
+	if (!ownTeapot && m_pView->m_Interpolation.GetDelay() && g_pApp->m_pGame && g_pApp->m_pGame->IsProxy())
 	{
-		const EvtData_Move_Actor & ed = static_cast< const EvtData_Move_Actor & >( event );
-		m_pView->MoveActor(ed.m_Id, ed.m_Mat);
+		ActorNetState state;
+		BuildActorNetState(ed.m_Id, ed.m_Mat, state);
+		m_pView->m_Interpolation.Add(state, timeGetTime());
+		return false;
 	}
-	else if ( EvtData_New_Actor::sk_EventType == event.VGetEventType() )
-	{
-		const EvtData_New_Actor & ed = static_cast< const EvtData_New_Actor & >( event );
 
-		shared_ptr<SceneNode> node = ed.m_pActorParams->VCreateSceneNode(m_pView->m_pScene);
-		m_pView->m_pScene->VAddChild(ed.m_pActorParams->m_Id, node);
-		node->VOnRestore(&(*(m_pView->m_pScene)));
+	m_pView->MoveActor(ed.m_Id, ed.m_Mat);
+	return false;
+}
+
+//
+// TeapotWarsGameViewListener::OnNewActor					- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnNewActor( EvtData_New_Actor const & ed )
+{
+	shared_ptr<SceneNode> node = ed.m_pActorParams->VCreateSceneNode(m_pView->m_pScene);
+	m_pView->m_pScene->VAddChild(ed.m_pActorParams->m_Id, node);
+	node->VOnRestore(&(*(m_pView->m_pScene)));
 
-		if (ed.m_pActorParams->m_Type == AT_Teapot)
+	if (ed.m_pActorParams->m_Type == AT_Teapot)
+	{
+		TeapotParams *p = static_cast<TeapotParams *>(ed.m_pActorParams);
+		//shared_ptr<SceneNode> teapot = m_pView->CreateTeapot(*p);
+		//assert(teapot);
+		if (p->m_ViewId == m_pView->m_ViewId)
 		{
-			TeapotParams *p = static_cast<TeapotParams *>(ed.m_pActorParams);
-			//shared_ptr<SceneNode> teapot = m_pView->CreateTeapot(*p);
-			//assert(teapot);
-			if (p->m_ViewId == m_pView->m_ViewId)
-			{
-				m_pView->m_pTeapot = node;
-				m_pView->m_pTeapotController.reset(GCC_NEW TeapotController(m_pView->m_pTeapot, 0, 0));
-				m_pView->m_KeyboardHandler = m_pView->m_pTeapotController;
-				m_pView->m_MouseHandler = m_pView->m_pTeapotController;
-				m_pView->m_pCamera->SetTarget(m_pView->m_pTeapot);
-				m_pView->m_pTeapot->SetAlpha(0.8f);	
-			}
+			m_pView->m_pTeapot = node;
+			m_pView->m_pTeapotController.reset(GCC_NEW TeapotController(m_pView->m_pTeapot, 0, 0));
+			m_pView->m_KeyboardHandler = m_pView->m_pTeapotController;
+			m_pView->m_MouseHandler = m_pView->m_pTeapotController;
+			m_pView->m_pCamera->SetTarget(m_pView->m_pTeapot);
+			m_pView->m_pTeapot->SetAlpha(0.8f);	
 		}
 	}
-	else if ( EvtData_Game_State::sk_EventType == event.VGetEventType() )
-	{
-		const EvtData_Game_State & ed = static_cast< const EvtData_Game_State & >( event );
-		BaseGameState gameState = ed.m_gameState;
-		m_pView->HandleGameState(gameState);
-	}
-	else if ( EvtData_Debug_String::sk_EventType == event.VGetEventType() )
+	return false;
+}
+
+//
+// TeapotWarsGameViewListener::OnGameState					- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnGameState( EvtData_Game_State const & ed )
+{
+	BaseGameState gameState = ed.m_gameState;
+	m_pView->HandleGameState(gameState);
+	return false;
+}
+
+//
+// TeapotWarsGameViewListener::OnDebugString				- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnDebugString( EvtData_Debug_String const & castEvent )
+{
+	switch( castEvent.m_Type )
 	{
-		const EvtData_Debug_String & castEvent = static_cast< const EvtData_Debug_String & >( event );
-		switch( castEvent.m_Type )
+		case EvtData_Debug_String::kDST_ScriptMsg:
 		{
-			case EvtData_Debug_String::kDST_ScriptMsg:
-			{
-				OutputDebugStringA( "LUA DEBUG: " );
-				OutputDebugStringA( castEvent.m_DebugMessage.c_str() );
-				OutputDebugStringA( "\n" );
-
-				// If our parent's console is open, tell it as well.
-				HumanView::Console & console = m_pView->GetConsole();
-				if (console.IsActive())
-					console.AddDisplayText(castEvent.m_DebugMessage);
-				break;
-			}
-			
-			default:
-			{
-				assert( 0 && "Unknown/unsupported debug string encountered!" );
-				break;
-			}
+			OutputDebugStringA( "LUA DEBUG: " );
+			OutputDebugStringA( castEvent.m_DebugMessage.c_str() );
+			OutputDebugStringA( "\n" );
+
+			// If our parent's console is open, tell it as well.
+			HumanView::Console & console = m_pView->GetConsole();
+			if (console.IsActive())
+				console.AddDisplayText(castEvent.m_DebugMessage);
+			break;
 		}
-	}
-	else if ( EvtData_UpdateActorParams::sk_EventType == event.VGetEventType() )
-	{
-		// Commenting this is leaks HUGE memory!!!! Not sure why....
-		const EvtData_UpdateActorParams & castEvent = static_cast< const EvtData_UpdateActorParams & >( event );
-
-		//Update the params in the scene node.
-		shared_ptr< ISceneNode > sceneNode = m_pView->m_pScene->FindActor( castEvent.m_ActorID );
-		SceneNode * pSceneNode = static_cast< SceneNode * >( sceneNode.get() );
-		ActorParams * pParams = pSceneNode->VGetActorParams();
-		if ( NULL != pParams )
+		
+		default:
 		{
-			//Update the params, restore the actor.
-			ActorParams::TErrorMessageList errorMessages;
-			pParams->VInit( castEvent.VGetLuaEventData(), errorMessages );
-			sceneNode->VOnRestore( m_pView->m_pScene.get() );
+			assert( 0 && "Unknown/unsupported debug string encountered!" );
+			break;
 		}
 	}
-/**	else if ( EvtData_Decompression_Progress::sk_EventType == event.VGetEventType() )
+	return false;
+}
+
+//
+// TeapotWarsGameViewListener::OnUpdateActorParams			- Chapter 19, page 731
+//
+bool TeapotWarsGameViewListener::OnUpdateActorParams( EvtData_UpdateActorParams const & castEvent )
+{
+	//Update the params in the scene node.
+	shared_ptr< ISceneNode > sceneNode = m_pView->m_pScene->FindActor( castEvent.m_ActorID );
+	SceneNode * pSceneNode = static_cast< SceneNode * >( sceneNode.get() );
+	ActorParams * pParams = pSceneNode->VGetActorParams();
+	if ( NULL != pParams )
 	{
-		const EvtData_Decompression_Progress & castEvent = static_cast< const EvtData_Decompression_Progress & >( event );
-		if (castEvent.m_buffer != NULL)
-		{
-			const void *buffer = castEvent.m_buffer;
-			SAFE_DELETE_ARRAY(buffer);
-		}
+		//Update the params, restore the actor.
+		ActorParams::TErrorMessageList errorMessages;
+		pParams->VInit( castEvent.VGetLuaEventData(), errorMessages );
+		sceneNode->VOnRestore( m_pView->m_pScene.get() );
 	}
-**/
 	return false;
 }
 
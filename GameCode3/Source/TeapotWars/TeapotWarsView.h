@@ -48,6 +48,7 @@
 
 #include "SceneGraph\SceneNodes.h"
 #include "EventManager\EventManager.h"
+#include "Network\Interpolation.h"
 
 
 
@@ -135,9 +136,15 @@ protected:
 	shared_ptr<SceneNode> m_pTeapot;
 	shared_ptr<StandardHUD> m_StandardHUD; 
 
+	// On a remote player's machine, where the actors the server moves
+	// are drawn - see InterpolationBuffer.
+	InterpolationBuffer m_Interpolation;
+	std::vector<ActorNetState> m_Interpolated;			// reused every frame
+
 	void BuildInitialScene();
 
 	void MoveActor(ActorId id, Mat4x4 const &mat);
+	void MoveInterpolatedActors();
 	void HandleGameState(BaseGameState newState);
 public:
 
@@ -153,13 +160,33 @@ public:
 };
 
 
-class TeapotWarsGameViewListener : public IEventListener
+struct EvtData_PhysCollision;
+struct EvtData_Destroy_Actor;
+class EvtData_Fire_Weapon;
+struct EvtData_New_Actor;
+struct EvtData_Move_Actor;
+struct EvtData_Game_State;
+struct EvtData_Debug_String;
+struct EvtData_UpdateActorParams;
+
+// Each handler is hooked to its own event type through an
+// EventChannel, so there's no if-chain over the event type.
+class TeapotWarsGameViewListener
 {
 	TeapotWarsGameView *m_pView;
 public:
 	explicit TeapotWarsGameViewListener( TeapotWarsGameView *view);
-	virtual char const * GetName(void) { return "TeapotWarsGameViewListener"; }
-	virtual bool HandleEvent( IEventData const & event );
+
+	static void Subscribe( shared_ptr<TeapotWarsGameViewListener> const & listener );
+
+	bool OnPhysCollision( EvtData_PhysCollision const & event );
+	bool OnDestroyActor( EvtData_Destroy_Actor const & event );
+	bool OnFireWeapon( EvtData_Fire_Weapon const & event );
+	bool OnNewActor( EvtData_New_Actor const & event );
+	bool OnMoveActor( EvtData_Move_Actor const & event );
+	bool OnGameState( EvtData_Game_State const & event );
+	bool OnDebugString( EvtData_Debug_String const & event );
+	bool OnUpdateActorParams( EvtData_UpdateActorParams const & event );
 };
 
 